@@ -0,0 +1,190 @@
+// Counts heap allocations in the steady-state per-frame work: model input
+// conversion (full and by changed rects) into the arena-backed tensors,
+// block matching, optical flow, flow extrapolation, the cross-fade, and
+// the scene-cut and duplicate checks. Each stage gets a few frames to size
+// its buffers, after which a frame must not allocate at all. Global
+// operator new is replaced to count; malloc from C code is not seen. Exits
+// non-zero if any stage allocated in steady state.
+//
+//   alloc_bench [--width 640] [--height 360] [--frames 30] [--threads 2]
+
+#include "../compute/Blend.h"
+#include "../compute/BlockMatchInterpolator.h"
+#include "../compute/FlowInterpolator.h"
+#include "../compute/FrameFingerprint.h"
+#include "../compute/MemoryLedger.h"
+#include "../compute/SceneCutDetector.h"
+#include "../compute/ThreadPool.h"
+#include "../inference/OnnxSession.h"
+#include "BenchUtil.h"
+#include "SyntheticScene.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <vector>
+
+using namespace DeepFrame;
+using namespace DeepFrame::Bench;
+
+namespace {
+
+std::atomic<uint64_t> g_allocations{0};
+std::atomic<uint64_t> g_bytes{0};
+
+void *Allocate(size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  g_bytes.fetch_add(size, std::memory_order_relaxed);
+  if (void *p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+} // namespace
+
+void *operator new(size_t size) { return Allocate(size); }
+void *operator new[](size_t size) { return Allocate(size); }
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+  try {
+    return Allocate(size);
+  } catch (...) {
+    return nullptr;
+  }
+}
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+  return operator new(size, std::nothrow);
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+void operator delete[](void *p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+constexpr uint32_t kWarmupFrames = 3;
+
+struct Stage {
+  const char *name;
+  std::function<bool(uint32_t frame)> run;
+};
+
+struct StageResult {
+  uint64_t allocations = 0;
+  uint64_t bytes = 0;
+  double ms = 0.0;
+  bool ok = true;
+};
+
+StageResult Measure(const Stage &stage, uint32_t frames) {
+  StageResult result;
+  for (uint32_t i = 0; i < kWarmupFrames; i++)
+    result.ok &= stage.run(i);
+  const uint64_t allocations = g_allocations.load();
+  const uint64_t bytes = g_bytes.load();
+  const auto start = Clock::now();
+  for (uint32_t i = kWarmupFrames; i < kWarmupFrames + frames; i++)
+    result.ok &= stage.run(i);
+  result.ms = ElapsedMs(start) / frames;
+  result.allocations = g_allocations.load() - allocations;
+  result.bytes = g_bytes.load() - bytes;
+  return result;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const Args args(argc, argv);
+  const uint32_t width = static_cast<uint32_t>(args.GetInt("--width", 640));
+  const uint32_t height = static_cast<uint32_t>(args.GetInt("--height", 360));
+  const uint32_t frames = static_cast<uint32_t>(args.GetInt("--frames", 30));
+  const uint32_t threads = static_cast<uint32_t>(args.GetInt("--threads", 2));
+
+  // A loop of rendered frames; the stages cycle through them.
+  constexpr uint32_t kLoop = 6;
+  const uint32_t pitch = width * 4;
+  std::vector<std::vector<uint8_t>> pixels(
+      kLoop, std::vector<uint8_t>(static_cast<size_t>(pitch) * height));
+  std::vector<FrameView> loop;
+  const SyntheticScene scene(width, height);
+  for (uint32_t i = 0; i < kLoop; i++) {
+    loop.push_back({pixels[i].data(), width, height, pitch,
+                    PixelFormat::BGRA8});
+    scene.Render(i, loop.back());
+  }
+  std::vector<uint8_t> outPixels(static_cast<size_t>(pitch) * height);
+  const FrameView out{outPixels.data(), width, height, pitch,
+                      PixelFormat::BGRA8};
+  auto prev = [&](uint32_t i) { return loop[i % kLoop]; };
+  auto curr = [&](uint32_t i) { return loop[(i + 1) % kLoop]; };
+
+  ThreadPool pool(threads);
+  OnnxSession session;
+  BlockMatchInterpolator blockMatch(&pool);
+  FlowInterpolator flow(&pool);
+  SceneCutDetector sceneCuts;
+  DuplicateDetector duplicates;
+  SceneThumbnail thumbs[2];
+  RectList changed;
+  changed.Add({width / 4, height / 4, width / 2, height / 2}, width, height);
+
+  const Stage stages[] = {
+      {"tensor input",
+       [&](uint32_t i) {
+         return session.SetInput(i & 1, curr(i), &thumbs[i & 1], &pool);
+       }},
+      {"tensor update",
+       [&](uint32_t i) {
+         return session.UpdateInput(i & 1, curr(i), changed, &pool);
+       }},
+      {"block match",
+       [&](uint32_t i) {
+         return blockMatch.Interpolate(prev(i), curr(i), out, 0.5f);
+       }},
+      {"optical flow",
+       [&](uint32_t i) {
+         return flow.Interpolate(prev(i), curr(i), out, 0.5f);
+       }},
+      {"extrapolation",
+       [&](uint32_t i) {
+         return flow.Extrapolate(prev(i), curr(i), out, 0.5f);
+       }},
+      {"blend",
+       [&](uint32_t i) {
+         return BlendFrames(prev(i), curr(i), out, 0.5f, 1.f, &pool);
+       }},
+      {"scene cut + dup",
+       [&](uint32_t i) {
+         SceneCutDetector::Thumbnail(curr(i), thumbs[i & 1]);
+         (void)sceneCuts.IsCut(thumbs[(i + 1) & 1], thumbs[i & 1]);
+         (void)duplicates.IsDuplicate(prev(i), curr(i));
+         return true;
+       }},
+  };
+
+  printf("%ux%u, %u steady-state frames after %u warm-up, %u threads\n",
+         width, height, frames, kWarmupFrames, pool.ThreadCount());
+  printf("%-16s %10s %12s %10s\n", "stage", "allocs", "bytes", "ms/frame");
+  bool clean = true;
+  for (const Stage &stage : stages) {
+    const StageResult r = Measure(stage, frames);
+    printf("%-16s %10llu %12llu %10.3f%s\n", stage.name,
+           static_cast<unsigned long long>(r.allocations),
+           static_cast<unsigned long long>(r.bytes), r.ms,
+           r.ok ? "" : "  (failed)");
+    clean &= r.allocations == 0 && r.ok;
+  }
+
+  const MemoryUsage usage = MemoryLedger::Snapshot();
+  printf("\nledger:");
+  for (size_t i = 0; i < kMemorySubsystems; i++) {
+    if (usage.cpuBytes[i]) {
+      printf(" %s %.1f MB",
+             MemorySubsystemName(static_cast<MemorySubsystem>(i)),
+             usage.cpuBytes[i] / 1e6);
+    }
+  }
+  printf("\n%s\n", clean ? "no steady-state allocations"
+                         : "STEADY-STATE ALLOCATIONS FOUND");
+  return clean ? 0 : 1;
+}
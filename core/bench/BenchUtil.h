@@ -0,0 +1,126 @@
+#pragma once
+
+#include "../compute/FrameView.h"
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace DeepFrame::Bench {
+
+using Clock = std::chrono::steady_clock;
+
+[[nodiscard]] inline double ElapsedMs(Clock::time_point start) noexcept {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+// PSNR over the colour channels of two BGRA frames; alpha is ignored.
+[[nodiscard]] inline double Psnr(const FrameView &a,
+                                 const FrameView &b) noexcept {
+  double sse = 0.0;
+  for (uint32_t y = 0; y < a.height; y++) {
+    const uint8_t *ra = a.Row(y);
+    const uint8_t *rb = b.Row(y);
+    for (uint32_t x = 0; x < a.width; x++) {
+      for (int c = 0; c < 3; c++) {
+        const double d = static_cast<double>(ra[x * 4 + c]) - rb[x * 4 + c];
+        sse += d * d;
+      }
+    }
+  }
+  const double mse = sse / (3.0 * a.width * a.height);
+  return mse <= 1e-10 ? 99.0 : 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+// Mean SSIM of the BT.601 luma of two BGRA frames over 8x8 windows at a
+// stride of 4 (the libvpx "fast SSIM" layout), K1 = 0.01, K2 = 0.03.
+[[nodiscard]] inline double Ssim(const FrameView &a, const FrameView &b) {
+  auto luma = [](const FrameView &f) {
+    std::vector<uint8_t> y(static_cast<size_t>(f.width) * f.height);
+    for (uint32_t row = 0; row < f.height; row++) {
+      const uint8_t *p = f.Row(row);
+      for (uint32_t x = 0; x < f.width; x++) {
+        y[static_cast<size_t>(row) * f.width + x] = static_cast<uint8_t>(
+            (p[x * 4 + 2] * 77 + p[x * 4 + 1] * 150 + p[x * 4 + 0] * 29 +
+             128) >>
+            8);
+      }
+    }
+    return y;
+  };
+  const std::vector<uint8_t> la = luma(a);
+  const std::vector<uint8_t> lb = luma(b);
+
+  constexpr double kC1 = (0.01 * 255) * (0.01 * 255);
+  constexpr double kC2 = (0.03 * 255) * (0.03 * 255);
+  constexpr uint32_t kWindow = 8;
+  double total = 0.0;
+  uint64_t windows = 0;
+  for (uint32_t y0 = 0; y0 + kWindow <= a.height; y0 += 4) {
+    for (uint32_t x0 = 0; x0 + kWindow <= a.width; x0 += 4) {
+      uint64_t sa = 0, sb = 0, saa = 0, sbb = 0, sab = 0;
+      for (uint32_t y = y0; y < y0 + kWindow; y++) {
+        const uint8_t *ra = la.data() + static_cast<size_t>(y) * a.width;
+        const uint8_t *rb = lb.data() + static_cast<size_t>(y) * a.width;
+        for (uint32_t x = x0; x < x0 + kWindow; x++) {
+          sa += ra[x];
+          sb += rb[x];
+          saa += ra[x] * ra[x];
+          sbb += rb[x] * rb[x];
+          sab += ra[x] * rb[x];
+        }
+      }
+      const double n = kWindow * kWindow;
+      const double ma = sa / n;
+      const double mb = sb / n;
+      const double va = saa / n - ma * ma;
+      const double vb = sbb / n - mb * mb;
+      const double cov = sab / n - ma * mb;
+      total += ((2 * ma * mb + kC1) * (2 * cov + kC2)) /
+               ((ma * ma + mb * mb + kC1) * (va + vb + kC2));
+      windows++;
+    }
+  }
+  return windows ? total / windows : 1.0;
+}
+
+// Minimal "--name value" argument lookup.
+class Args {
+public:
+  Args(int argc, char **argv) : argc_(argc), argv_(argv) {}
+
+  [[nodiscard]] const char *Get(const char *name,
+                                const char *fallback) const noexcept {
+    for (int i = 1; i + 1 < argc_; i++) {
+      if (std::strcmp(argv_[i], name) == 0)
+        return argv_[i + 1];
+    }
+    return fallback;
+  }
+  [[nodiscard]] long GetInt(const char *name, long fallback) const noexcept {
+    const char *v = Get(name, nullptr);
+    return v ? std::strtol(v, nullptr, 10) : fallback;
+  }
+  [[nodiscard]] double GetDouble(const char *name,
+                                 double fallback) const noexcept {
+    const char *v = Get(name, nullptr);
+    return v ? std::strtod(v, nullptr) : fallback;
+  }
+  [[nodiscard]] bool Has(const char *name) const noexcept {
+    for (int i = 1; i < argc_; i++) {
+      if (std::strcmp(argv_[i], name) == 0)
+        return true;
+    }
+    return false;
+  }
+
+private:
+  int argc_;
+  char **argv_;
+};
+
+} // namespace DeepFrame::Bench
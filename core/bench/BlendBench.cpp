@@ -0,0 +1,119 @@
+// Throughput of the BGRA blend kernels against a memcpy of the same traffic
+// (two frames read, one written), plus a check that every SIMD variant
+// matches the scalar reference byte for byte.
+//
+//   blend_bench [--width 1920] [--height 1080] [--iterations 200]
+
+#include "../compute/Blend.h"
+#include "BenchUtil.h"
+#include "SyntheticScene.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace DeepFrame;
+using namespace DeepFrame::Bench;
+
+namespace {
+
+struct Kernel {
+  const char *name;
+  BlendRowFn fn;
+};
+
+// Frames much larger than the last-level cache, so every pass streams
+// from memory like the pipeline does.
+constexpr uint32_t kFrameSets = 4;
+
+double BlendGBps(const Kernel &kernel, const std::vector<FrameBuffer> &a,
+                 const std::vector<FrameBuffer> &b, FrameBuffer &out,
+                 uint32_t iterations) {
+  const size_t rowBytes = static_cast<size_t>(out.view.width) * 4;
+  auto start = Clock::now();
+  for (uint32_t i = 0; i < iterations; i++) {
+    const FrameView &va = a[i % kFrameSets].view;
+    const FrameView &vb = b[i % kFrameSets].view;
+    const uint32_t weight = 1 + i % 255;
+    for (uint32_t y = 0; y < out.view.height; y++)
+      kernel.fn(va.Row(y), vb.Row(y), out.view.Row(y), rowBytes, weight);
+#if defined(DEEPFRAME_SSE2)
+    _mm_sfence();
+#endif
+  }
+  const double seconds = ElapsedMs(start) / 1000.0;
+  return 3.0 * rowBytes * out.view.height * iterations / seconds / 1e9;
+}
+
+double CopyGBps(const std::vector<FrameBuffer> &a, FrameBuffer &out,
+                uint32_t iterations) {
+  const size_t bytes = out.pixels.size();
+  auto start = Clock::now();
+  for (uint32_t i = 0; i < iterations; i++) {
+    // Two passes read as much as a blend does and write twice as much.
+    std::memcpy(out.pixels.data(), a[i % kFrameSets].pixels.data(), bytes);
+    std::memcpy(out.pixels.data(), a[(i + 1) % kFrameSets].pixels.data(),
+                bytes);
+  }
+  const double seconds = ElapsedMs(start) / 1000.0;
+  return 4.0 * bytes * iterations / seconds / 1e9;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Args args(argc, argv);
+  const uint32_t width = static_cast<uint32_t>(args.GetInt("--width", 1920));
+  const uint32_t height = static_cast<uint32_t>(args.GetInt("--height", 1080));
+  const uint32_t iterations =
+      static_cast<uint32_t>(std::max(1L, args.GetInt("--iterations", 200)));
+
+  SyntheticScene scene(width, height);
+  std::vector<FrameBuffer> a, b;
+  for (uint32_t i = 0; i < kFrameSets; i++) {
+    a.emplace_back(width, height);
+    b.emplace_back(width, height);
+    scene.Render(2 * i, a.back().view);
+    scene.Render(2 * i + 1, b.back().view);
+  }
+  FrameBuffer out(width, height);
+  FrameBuffer reference(width, height);
+
+  std::vector<Kernel> kernels = {{"scalar", BlendRowScalar}};
+#if defined(DEEPFRAME_SSE2)
+  kernels.push_back({"sse2", BlendRowSse2});
+  kernels.push_back({"sse2-nt", BlendRowSse2Stream});
+  if (CpuSupportsAvx2()) {
+    kernels.push_back({"avx2", BlendRowAvx2});
+    kernels.push_back({"avx2-nt", BlendRowAvx2Stream});
+  }
+#elif defined(DEEPFRAME_NEON)
+  kernels.push_back({"neon", BlendRowNeon});
+#endif
+
+  // Odd widths exercise the scalar tails of the SIMD loops.
+  bool mismatch = false;
+  const size_t checkBytes = (static_cast<size_t>(width) - 1) * 4 + 3;
+  for (const Kernel &kernel : kernels) {
+    for (uint32_t weight : {0u, 1u, 77u, 128u, 200u, 255u, 256u}) {
+      BlendRowScalar(a[0].view.Row(0), b[0].view.Row(0),
+                     reference.view.Row(0), checkBytes, weight);
+      kernel.fn(a[0].view.Row(0), b[0].view.Row(0), out.view.Row(0),
+                checkBytes, weight);
+      if (std::memcmp(reference.view.Row(0), out.view.Row(0), checkBytes)) {
+        printf("%-8s mismatch at weight %u\n", kernel.name, weight);
+        mismatch = true;
+      }
+    }
+  }
+
+  printf("%ux%u, dispatch selects %s\n", width, height, BlendRowIsa());
+  const double copy = CopyGBps(a, out, iterations);
+  printf("%-8s %7.2f GB/s\n", "memcpy", copy);
+  for (const Kernel &kernel : kernels) {
+    const double gbps = BlendGBps(kernel, a, b, out, iterations);
+    const double msPerFrame = 3.0 * width * height * 4 / (gbps * 1e6);
+    printf("%-8s %7.2f GB/s %7.3f ms/frame  %5.1f%% of memcpy\n", kernel.name,
+           gbps, msPerFrame, 100.0 * gbps / copy);
+  }
+  return mismatch ? 1 : 0;
+}
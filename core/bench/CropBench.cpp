@@ -0,0 +1,218 @@
+// Target-window crop: the cost of interpolating and converting the whole
+// desktop against only a window on it, plus checks of the crop and pad
+// helpers. The window's tensors are padded to the desktop size as for a
+// model exported at a fixed size; the padded conversion must match a
+// conversion of the edge-replicated frame, a rect update of the padded
+// planes must match a full one, the window's share of the desktop's dirty
+// rects must cover every pixel that changed inside it, and reading the
+// padded planes back must reproduce the window. Exits non-zero on any
+// mismatch.
+//
+//   crop_bench [--width 1920] [--height 1080] [--window-width 1280]
+//              [--window-height 720] [--left 200] [--top 150]
+//              [--iterations 20] [--seed 1] [--threads 0]
+
+#include "../compute/BlockMatchInterpolator.h"
+#include "../compute/FrameCrop.h"
+#include "../compute/RectList.h"
+#include "../compute/TensorConvert.h"
+#include "../compute/ThreadPool.h"
+#include "BenchUtil.h"
+#include "SyntheticScene.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace DeepFrame;
+using namespace DeepFrame::Bench;
+
+namespace {
+
+void CopyFrame(const FrameView &src, const FrameView &dst) {
+  for (uint32_t y = 0; y < src.height; y++)
+    std::memcpy(dst.Row(y), src.Row(y), static_cast<size_t>(src.width) * 4);
+}
+
+bool SameFrame(const FrameView &a, const FrameView &b) {
+  for (uint32_t y = 0; y < a.height; y++)
+    if (std::memcmp(a.Row(y), b.Row(y), static_cast<size_t>(a.width) * 4))
+      return false;
+  return true;
+}
+
+// Interpolates prev -> curr `iterations` times; ms per frame.
+double InterpolateMs(const FrameView &prev, const FrameView &curr,
+                     const FrameView &out, uint32_t iterations,
+                     ThreadPool *pool, bool &ok) {
+  BlockMatchInterpolator engine(pool);
+  ok &= engine.Interpolate(prev, curr, out, 0.5f);
+  const auto start = Clock::now();
+  for (uint32_t i = 0; i < iterations; i++)
+    ok &= engine.Interpolate(prev, curr, out, 0.5f);
+  return ElapsedMs(start) / iterations;
+}
+
+// Converts both frames of a pair `iterations` times; ms per pair.
+double ConvertMs(const FrameView &prev, const FrameView &curr,
+                 std::vector<float> &planes, uint32_t iterations,
+                 ThreadPool *pool, bool &ok) {
+  const auto start = Clock::now();
+  for (uint32_t i = 0; i < iterations; i++) {
+    ok &= BgraToPlanarRgb(prev, planes.data(), pool);
+    ok &= BgraToPlanarRgb(curr, planes.data(), pool);
+  }
+  return ElapsedMs(start) / iterations;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Args args(argc, argv);
+  const uint32_t width = static_cast<uint32_t>(args.GetInt("--width", 1920));
+  const uint32_t height = static_cast<uint32_t>(args.GetInt("--height", 1080));
+  const uint32_t iterations =
+      static_cast<uint32_t>(std::max(1L, args.GetInt("--iterations", 20)));
+  const uint32_t seed = static_cast<uint32_t>(args.GetInt("--seed", 1));
+  const uint32_t threads =
+      static_cast<uint32_t>(std::max(0L, args.GetInt("--threads", 0)));
+  // Where the target window's client area sits on the desktop; it may
+  // hang off the edge like a real window.
+  const int64_t left = args.GetInt("--left", 200);
+  const int64_t top = args.GetInt("--top", 150);
+  const TileRect crop =
+      ClipToOutput(left, top, left + args.GetInt("--window-width", 1280),
+                   top + args.GetInt("--window-height", 720), width, height);
+  if (crop.Empty()) {
+    fprintf(stderr, "window does not meet the %ux%u desktop\n", width, height);
+    return 1;
+  }
+  const uint32_t cropWidth = crop.right - crop.left;
+  const uint32_t cropHeight = crop.bottom - crop.top;
+
+  std::unique_ptr<ThreadPool> pool;
+  if (threads != 1)
+    pool = std::make_unique<ThreadPool>(threads);
+
+  SyntheticScene scene(width, height);
+  FrameBuffer desktop[2] = {{width, height}, {width, height}};
+  scene.Render(0.0, desktop[0].view);
+  scene.Render(1.0, desktop[1].view);
+  const FrameView prevWindow = CropView(desktop[0].view, crop);
+  const FrameView currWindow = CropView(desktop[1].view, crop);
+
+  bool ok = true;
+  FrameBuffer fullOut(width, height);
+  FrameBuffer windowOut(cropWidth, cropHeight);
+  const double fullMs = InterpolateMs(desktop[0].view, desktop[1].view,
+                                      fullOut.view, iterations, pool.get(),
+                                      ok);
+  const double windowMs = InterpolateMs(prevWindow, currWindow,
+                                        windowOut.view, iterations,
+                                        pool.get(), ok);
+  std::vector<float> planes(PlanarRgbSize(width, height));
+  const double fullConvertMs =
+      ConvertMs(desktop[0].view, desktop[1].view, planes, iterations,
+                pool.get(), ok);
+  const double windowConvertMs = ConvertMs(prevWindow, currWindow, planes,
+                                           iterations, pool.get(), ok);
+
+  // Padded to the desktop size, as for a model exported at 1080p.
+  uint64_t padMismatches = 0;
+  std::vector<float> padded(PlanarRgbSize(width, height));
+  std::vector<float> expected(PlanarRgbSize(width, height));
+  FrameBuffer paddedFrame(width, height);
+  ok &= BgraToPlanarRgbPadded(currWindow, padded.data(), width, height,
+                              pool.get());
+  ok &= PadFrame(currWindow, paddedFrame.view, pool.get());
+  ok &= BgraToPlanarRgb(paddedFrame.view, expected.data(), pool.get());
+  padMismatches += padded != expected;
+
+  FrameBuffer readBack(cropWidth, cropHeight);
+  ok &= PlanarRgbToBgraCropped(padded.data(), width, height, readBack.view,
+                               pool.get());
+  padMismatches += !SameFrame(readBack.view, currWindow);
+
+  // Desktop dirty rects, some inside the window, some across its edges
+  // and some outside it.
+  uint64_t rectMismatches = 0;
+  uint64_t uncoveredPixels = 0;
+  FrameBuffer before(width, height);
+  FrameBuffer staging(cropWidth, cropHeight);
+  std::vector<uint8_t> covered(static_cast<size_t>(cropWidth) * cropHeight);
+  std::mt19937 rng(seed);
+  const auto uniform = [&](uint32_t lo, uint32_t hi) {
+    return std::uniform_int_distribution<uint32_t>(lo, hi)(rng);
+  };
+  for (uint32_t round = 0; round < 50; round++) {
+    CopyFrame(desktop[1].view, before.view);
+    RectList changes;
+    const uint32_t count = uniform(1, 6);
+    for (uint32_t i = 0; i < count; i++) {
+      const uint32_t w = uniform(1, std::min(400u, width));
+      const uint32_t h = uniform(1, std::min(300u, height));
+      const uint32_t x = uniform(0, width - w);
+      const uint32_t y = uniform(0, height - h);
+      const TileRect rect = {x, y, x + w, y + h};
+      for (uint32_t row = y; row < y + h; row++)
+        for (uint32_t col = x; col < x + w; col++)
+          desktop[1].view.Row(row)[col * 4 + uniform(0, 2)] ^= 0x5a;
+      changes.Add(rect, width, height);
+    }
+
+    RectList windowChanges;
+    CropRects(changes, crop, windowChanges);
+    std::fill(covered.begin(), covered.end(), windowChanges.IsFull());
+    for (const TileRect &rect : windowChanges)
+      for (uint32_t y = rect.top; y < rect.bottom; y++)
+        std::fill_n(covered.begin() + static_cast<size_t>(y) * cropWidth +
+                        rect.left,
+                    rect.right - rect.left, uint8_t{1});
+    const FrameView window = CropView(desktop[1].view, crop);
+    const FrameView windowBefore = CropView(before.view, crop);
+    for (uint32_t y = 0; y < cropHeight; y++) {
+      const uint32_t *a =
+          reinterpret_cast<const uint32_t *>(windowBefore.Row(y));
+      const uint32_t *b = reinterpret_cast<const uint32_t *>(window.Row(y));
+      for (uint32_t x = 0; x < cropWidth; x++)
+        uncoveredPixels +=
+            a[x] != b[x] && !covered[static_cast<size_t>(y) * cropWidth + x];
+    }
+
+    // The consumer's copy only receives what the window's rects report.
+    CopyFrame(windowBefore, staging.view);
+    for (const TileRect &rect : windowChanges)
+      for (uint32_t y = rect.top; y < rect.bottom; y++)
+        std::memcpy(staging.view.Row(y) + rect.left * 4,
+                    window.Row(y) + rect.left * 4,
+                    static_cast<size_t>(rect.right - rect.left) * 4);
+    ok &= BgraRectsToPlanarRgbPadded(staging.view, padded.data(), width,
+                                     height, windowChanges, pool.get());
+    ok &= BgraToPlanarRgbPadded(window, expected.data(), width, height,
+                                pool.get());
+    rectMismatches += padded != expected;
+  }
+
+  const double areaShare =
+      static_cast<double>(cropWidth) * cropHeight / (static_cast<double>(width) * height);
+  printf("desktop %ux%u  window %ux%u at (%u, %u)  %.1f%% of the area  "
+         "threads=%u\n",
+         width, height, cropWidth, cropHeight, crop.left, crop.top,
+         100.0 * areaShare, pool ? pool->ThreadCount() : 1u);
+  printf("%-22s %8.3f ms  window %8.3f ms  (%.2fx)\n", "interpolate desktop",
+         fullMs, windowMs, fullMs / std::max(windowMs, 1e-6));
+  printf("%-22s %8.3f ms  window %8.3f ms  (%.2fx)\n", "convert desktop",
+         fullConvertMs, windowConvertMs,
+         fullConvertMs / std::max(windowConvertMs, 1e-6));
+  printf("mismatches: pad %llu  rects %llu  uncovered pixels %llu%s\n",
+         static_cast<unsigned long long>(padMismatches),
+         static_cast<unsigned long long>(rectMismatches),
+         static_cast<unsigned long long>(uncoveredPixels),
+         ok ? "" : "  (a call failed)");
+
+  const bool failed = !ok || padMismatches || rectMismatches ||
+                      uncoveredPixels;
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace DeepFrame::Bench {
+
+// Cycles spent by the calling thread. Uses the core cycle counter through
+// perf_event_open where the kernel allows it, otherwise the x86 time-stamp
+// counter (reference cycles, so frequency scaling skews it), otherwise
+// nothing.
+class CycleCounter {
+public:
+  CycleCounter() noexcept {
+#if defined(__linux__)
+    perf_event_attr attr{};
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CPU_CYCLES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd_ = static_cast<int>(
+        syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+  }
+  ~CycleCounter() noexcept {
+#if defined(__linux__)
+    if (fd_ >= 0)
+      close(fd_);
+#endif
+  }
+
+  CycleCounter(const CycleCounter &) = delete;
+  CycleCounter &operator=(const CycleCounter &) = delete;
+
+  // "perf", "tsc" or "none".
+  [[nodiscard]] const char *Source() const noexcept {
+    if (fd_ >= 0)
+      return "perf";
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) ||            \
+    defined(__i386__)
+    return "tsc";
+#else
+    return "none";
+#endif
+  }
+  [[nodiscard]] bool Available() const noexcept {
+    return Source()[0] != 'n';
+  }
+
+  void Start() noexcept {
+#if defined(__linux__)
+    if (fd_ >= 0) {
+      ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+      return;
+    }
+#endif
+    start_ = Tsc();
+  }
+
+  [[nodiscard]] uint64_t Stop() noexcept {
+#if defined(__linux__)
+    if (fd_ >= 0) {
+      ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+      uint64_t cycles = 0;
+      if (read(fd_, &cycles, sizeof(cycles)) != sizeof(cycles))
+        return 0;
+      return cycles;
+    }
+#endif
+    return Tsc() - start_;
+  }
+
+private:
+  static uint64_t Tsc() noexcept {
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) ||            \
+    defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+  }
+
+  int fd_ = -1;
+  uint64_t start_ = 0;
+};
+
+} // namespace DeepFrame::Bench
@@ -0,0 +1,201 @@
+// Duplicate-frame detection on synthetic streams with known repeats: a
+// static desktop, continuous motion, a game rendering at a third of the
+// capture rate and a static frame with one pixel blinking between the
+// fingerprint's samples (every pair must survive the byte comparison).
+// Each stream runs with and without compositor rects. The detector's
+// verdicts then drive an IdleTracker on the stream's 60 Hz timeline, which
+// has to go idle exactly once the content has been static long enough.
+// Exits non-zero on any misclassified frame or idle transition.
+//
+//   dup_bench [--width 1920] [--height 1080] [--frames 90] [--fps 60]
+//             [--idle-ms 250]
+
+#include "../compute/FrameFingerprint.h"
+#include "../compute/IdleTracker.h"
+#include "BenchUtil.h"
+#include "SyntheticScene.h"
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+using namespace DeepFrame;
+using namespace DeepFrame::Bench;
+
+namespace {
+
+enum class Stream { Static, Animated, Every3rd, Blink };
+
+const char *StreamName(Stream stream) {
+  switch (stream) {
+  case Stream::Static:
+    return "static";
+  case Stream::Animated:
+    return "animated";
+  case Stream::Every3rd:
+    return "every 3rd frame";
+  case Stream::Blink:
+    return "1-pixel blink";
+  }
+  return "";
+}
+
+// Scene time of frame i and whether it repeats frame i - 1.
+double SceneTime(Stream stream, uint32_t i) {
+  switch (stream) {
+  case Stream::Animated:
+    return i;
+  case Stream::Every3rd:
+    return i / 3;
+  default:
+    return 0.0;
+  }
+}
+
+bool Repeats(Stream stream, uint32_t i) {
+  if (i == 0)
+    return false;
+  switch (stream) {
+  case Stream::Static:
+    return true;
+  case Stream::Every3rd:
+    return i % 3 != 0;
+  default:
+    return false;
+  }
+}
+
+// Row 0 lies above the first sampled row, so the fingerprint cannot see
+// this pixel.
+constexpr uint32_t kBlinkX = 1;
+constexpr uint32_t kBlinkY = 0;
+
+void Render(const SyntheticScene &scene, Stream stream, uint32_t i,
+            const FrameView &out) {
+  scene.Render(SceneTime(stream, i), out);
+  if (stream == Stream::Blink)
+    out.Row(kBlinkY)[kBlinkX * 4] ^= static_cast<uint8_t>(1 + (i & 1));
+}
+
+// What a compositor would report between frames i - 1 and i.
+void Changes(Stream stream, uint32_t i, uint32_t width, uint32_t height,
+             RectList &rects) {
+  rects.Clear();
+  if (Repeats(stream, i))
+    return;
+  if (stream == Stream::Blink)
+    rects.Add({kBlinkX, kBlinkY, kBlinkX + 1, kBlinkY + 1}, width, height);
+  else
+    rects.SetFull();
+}
+
+struct Result {
+  uint32_t expected = 0;
+  uint32_t found = 0;
+  uint32_t falsePositives = 0;
+  uint32_t misses = 0;
+  uint64_t collisions = 0;
+  uint32_t idleMismatches = 0;
+  uint64_t idleEntries = 0;
+  double checkMs = 0.0;
+};
+
+Result RunStream(Stream stream, bool withRects, uint32_t width,
+                 uint32_t height, uint32_t count, uint32_t fps,
+                 std::chrono::milliseconds idleAfter) {
+  SyntheticScene scene(width, height);
+  FrameBuffer frames[2] = {{width, height}, {width, height}};
+  DuplicateDetector detector;
+  IdleTracker idle(idleAfter);
+  RectList rects;
+  Result result;
+
+  const auto frameTime = std::chrono::microseconds(1000000 / fps);
+  const IdleTracker::Clock::time_point origin{};
+  uint32_t lastNew = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    FrameBuffer &curr = frames[i % 2];
+    Render(scene, stream, i, curr.view);
+    const bool expected = Repeats(stream, i);
+    bool duplicate = false;
+    if (i > 0) {
+      Changes(stream, i, width, height, rects);
+      const auto start = Clock::now();
+      duplicate = detector.IsDuplicate(frames[(i + 1) % 2].view, curr.view,
+                                       withRects ? &rects : nullptr);
+      result.checkMs += ElapsedMs(start);
+    }
+    result.expected += expected;
+    result.found += duplicate;
+    result.falsePositives += duplicate && !expected;
+    result.misses += expected && !duplicate;
+
+    // Idle once the last new frame is idleAfter in the past.
+    if (!expected)
+      lastNew = i;
+    idle.Update(!duplicate, origin + frameTime * i);
+    const bool shouldIdle = frameTime * (i - lastNew) >= idleAfter;
+    result.idleMismatches += idle.IsIdle() != shouldIdle;
+  }
+  result.collisions = detector.Stats().collisions;
+  result.idleEntries = idle.Entries();
+  return result;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Args args(argc, argv);
+  const uint32_t width = static_cast<uint32_t>(args.GetInt("--width", 1920));
+  const uint32_t height = static_cast<uint32_t>(args.GetInt("--height", 1080));
+  const uint32_t frames =
+      static_cast<uint32_t>(std::max(2L, args.GetInt("--frames", 90)));
+  const uint32_t fps =
+      static_cast<uint32_t>(std::max(1L, args.GetInt("--fps", 60)));
+  const std::chrono::milliseconds idleAfter(
+      std::max(1L, args.GetInt("--idle-ms", 250)));
+
+  printf("%ux%u, %u frames at %u Hz, idle after %lld ms\n", width, height,
+         frames, fps, static_cast<long long>(idleAfter.count()));
+  printf("%-16s %-6s %9s %6s %6s %6s %6s %5s %6s %10s\n", "stream", "rects",
+         "expected", "found", "false", "missed", "colli.", "idle", "idle?",
+         "ms/check");
+
+  bool failed = false;
+  for (Stream stream :
+       {Stream::Static, Stream::Animated, Stream::Every3rd, Stream::Blink}) {
+    for (bool withRects : {false, true}) {
+      const Result r = RunStream(stream, withRects, width, height, frames,
+                                 fps, idleAfter);
+      printf("%-16s %-6s %9u %6u %6u %6u %6llu %5llu %6u %10.3f\n",
+             StreamName(stream), withRects ? "yes" : "no", r.expected,
+             r.found, r.falsePositives, r.misses,
+             static_cast<unsigned long long>(r.collisions),
+             static_cast<unsigned long long>(r.idleEntries),
+             r.idleMismatches, r.checkMs / (frames - 1));
+      failed |= r.falsePositives || r.misses || r.idleMismatches;
+    }
+  }
+
+  // What the fingerprint saves over comparing whole frames.
+  SyntheticScene scene(width, height);
+  FrameBuffer a(width, height), b(width, height);
+  scene.Render(0.0, a.view);
+  scene.Render(0.0, b.view);
+  const int reps = 50;
+  uint64_t sink = 0;
+  auto start = Clock::now();
+  for (int i = 0; i < reps; i++)
+    sink += Fingerprint(a.view).hash;
+  const double fingerprintMs = ElapsedMs(start) / reps;
+  start = Clock::now();
+  for (int i = 0; i < reps; i++)
+    sink += SameContent(a.view, b.view);
+  const double compareMs = ElapsedMs(start) / reps;
+  printf("fingerprint %.4f ms, full compare %.3f ms (%.0fx)  [%llu]\n",
+         fingerprintMs, compareMs, compareMs / std::max(fingerprintMs, 1e-6),
+         static_cast<unsigned long long>(sink));
+
+  if (failed)
+    printf("FAILED\n");
+  return failed ? 1 : 0;
+}
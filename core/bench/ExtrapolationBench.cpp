@@ -0,0 +1,160 @@
+// Latency and quality of extrapolated against interpolated generated
+// frames. Source frames are replayed at --fps and every other one is
+// "captured"; the dropped ones are ground truth for both paths, which run
+// dense flow on the same pair of captures:
+//   interpolate  rebuilds the dropped frame before the newest capture, so
+//                that capture is held back by the engine time plus half an
+//                interval while the generated frame is shown first;
+//   extrapolate  predicts the dropped frame after the newest capture, which
+//                is shown at once; the prediction is late, by what the
+//                engine takes beyond half an interval, if it takes more.
+// Repeating the newest capture is scored as the floor. On the synthetic
+// scene, exits non-zero if extrapolation fails or does not beat that floor.
+//
+//   extrapolation_bench [--width 1280] [--height 720] [--frames 41]
+//                       [--fps 60] [--threads 0]
+//                       [--input clip.y4m | --input clip.bgra --width W
+//                        --height H]
+
+#include "../compute/FlowInterpolator.h"
+#include "../compute/ThreadPool.h"
+#include "../compute/VideoFile.h"
+#include "BenchUtil.h"
+#include "SyntheticScene.h"
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace DeepFrame;
+using namespace DeepFrame::Bench;
+
+namespace {
+
+struct PathResult {
+  std::vector<double> engineMs;
+  double addedMs = 0.0;
+  uint64_t late = 0;
+  double psnr = 0.0;
+  double ssim = 0.0;
+  double repeatPsnr = 0.0;
+  bool ok = true;
+};
+
+void Print(const char *name, const PathResult &r, size_t count) {
+  std::vector<double> sorted = r.engineMs;
+  std::sort(sorted.begin(), sorted.end());
+  double sum = 0.0;
+  for (double ms : sorted)
+    sum += ms;
+  const double p99 = sorted[std::min(
+      sorted.size() - 1, static_cast<size_t>(sorted.size() * 0.99))];
+  printf("%-12s %8.2f %8.2f %10.2f %6llu %8.2f %8.4f %8.2f%s\n", name,
+         sum / count, p99, r.addedMs / count,
+         static_cast<unsigned long long>(r.late), r.psnr / count,
+         r.ssim / count, r.repeatPsnr / count, r.ok ? "" : "  (failed)");
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const Args args(argc, argv);
+  uint32_t width = static_cast<uint32_t>(args.GetInt("--width", 1280));
+  uint32_t height = static_cast<uint32_t>(args.GetInt("--height", 720));
+  const uint32_t frames =
+      static_cast<uint32_t>(std::max(5L, args.GetInt("--frames", 41)));
+  double fps = args.GetDouble("--fps", 60.0);
+  const uint32_t threads =
+      static_cast<uint32_t>(std::max(0L, args.GetInt("--threads", 0)));
+  const char *input = args.Get("--input", nullptr);
+
+  std::unique_ptr<ThreadPool> pool;
+  if (threads != 1)
+    pool = std::make_unique<ThreadPool>(threads);
+
+  std::vector<FrameBuffer> source;
+  if (input) {
+    const std::string path = input;
+    VideoFileSource file;
+    const bool y4m = path.size() > 4 && path.substr(path.size() - 4) == ".y4m";
+    if (!(y4m ? file.OpenY4m(path) : file.OpenRaw(path, width, height))) {
+      fprintf(stderr, "cannot open %s\n", input);
+      return 1;
+    }
+    width = file.Info().width;
+    height = file.Info().height;
+    if (!args.Has("--fps"))
+      fps = static_cast<double>(file.Info().fpsNum) / file.Info().fpsDen;
+    const uint64_t count = std::min<uint64_t>(frames, file.FrameCount());
+    for (uint64_t i = 0; i < count; i++) {
+      source.emplace_back(width, height);
+      VideoFrame frame;
+      if (!file.Read(i, frame) ||
+          !VideoFrameToBgra(frame, source.back().view, pool.get())) {
+        fprintf(stderr, "cannot read frame %llu\n",
+                static_cast<unsigned long long>(i));
+        return 1;
+      }
+    }
+  } else {
+    const SyntheticScene scene(width, height);
+    for (uint32_t i = 0; i < frames; i++) {
+      source.emplace_back(width, height);
+      scene.Render(i, source.back().view);
+    }
+  }
+  if (source.size() < 5) {
+    fprintf(stderr, "need at least 5 frames\n");
+    return 1;
+  }
+
+  // Captures are the even source frames; the pair ending at capture 2i is
+  // scored against 2i - 1 when interpolating and 2i + 1 when predicting.
+  const double intervalMs = 2000.0 / fps;
+  FlowInterpolator interpolator(pool.get());
+  FlowInterpolator extrapolator(pool.get());
+  FrameBuffer out(width, height);
+  PathResult interp;
+  PathResult extrap;
+  size_t count = 0;
+  for (size_t curr = 2; curr + 1 < source.size(); curr += 2) {
+    const FrameView &a = source[curr - 2].view;
+    const FrameView &b = source[curr].view;
+
+    auto start = Clock::now();
+    interp.ok &= interpolator.Interpolate(a, b, out.view, 0.5f);
+    const double interpMs = ElapsedMs(start);
+    interp.engineMs.push_back(interpMs);
+    interp.addedMs += interpMs + intervalMs / 2.0;
+    interp.psnr += Psnr(out.view, source[curr - 1].view);
+    interp.ssim += Ssim(out.view, source[curr - 1].view);
+    interp.repeatPsnr += Psnr(b, source[curr - 1].view);
+
+    start = Clock::now();
+    extrap.ok &= extrapolator.Extrapolate(a, b, out.view, 0.5f);
+    const double extrapMs = ElapsedMs(start);
+    extrap.engineMs.push_back(extrapMs);
+    extrap.late += extrapMs > intervalMs / 2.0;
+    extrap.addedMs += std::max(0.0, extrapMs - intervalMs / 2.0);
+    extrap.psnr += Psnr(out.view, source[curr + 1].view);
+    extrap.ssim += Ssim(out.view, source[curr + 1].view);
+    extrap.repeatPsnr += Psnr(b, source[curr + 1].view);
+    count++;
+  }
+
+  printf("%s %ux%u, %zu pairs, captures every %.2f ms, %u threads\n",
+         input ? input : "synthetic", width, height, count, intervalMs,
+         pool ? pool->ThreadCount() : 1u);
+  printf("%-12s %8s %8s %10s %6s %8s %8s %8s\n", "path", "ms", "p99 ms",
+         "latency+", "late", "PSNR", "SSIM", "repeat");
+  Print("interpolate", interp, count);
+  Print("extrapolate", extrap, count);
+
+  bool ok = interp.ok && extrap.ok;
+  if (!input && extrap.psnr <= extrap.repeatPsnr) {
+    printf("extrapolation does not beat repeating the frame\n");
+    ok = false;
+  }
+  return ok ? 0 : 1;
+}
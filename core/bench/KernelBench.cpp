@@ -0,0 +1,225 @@
+// Per-pixel and queue hot paths on CPU buffers: ns/pixel, GB/s of the
+// traffic each kernel must move, and cycles/pixel. Each kernel runs
+// --iterations times and the median is reported.
+//
+//   kernel_bench [--width 1920] [--height 1080] [--threads 1]
+//                [--iterations 50] [--kernel all|<name>]
+//                [--save baseline.tsv] [--compare baseline.tsv]
+//                [--threshold 10]
+//
+// --save writes the medians; --compare flags every kernel whose ns/pixel
+// grew by more than --threshold percent over the saved run and exits 1 if
+// any did. Cycles come from the calling thread's counter, so they are only
+// printed for --threads 1.
+
+#include "../compute/Blend.h"
+#include "../compute/LumaPyramid.h"
+#include "../compute/SceneCutDetector.h"
+#include "../compute/SpscRing.h"
+#include "../compute/TensorConvert.h"
+#include "../compute/ThreadPool.h"
+#include "../compute/TileChangeMap.h"
+#include "BenchUtil.h"
+#include "CycleCounter.h"
+#include "SyntheticScene.h"
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace DeepFrame;
+using namespace DeepFrame::Bench;
+
+namespace {
+
+struct Kernel {
+  const char *name;
+  // Bytes read plus written per pixel (or per item for queues).
+  double bytesPerUnit;
+  std::function<void()> run;
+};
+
+struct Measurement {
+  double nsPerUnit = 0.0;
+  double gbps = 0.0;
+  double cyclesPerUnit = 0.0;
+};
+
+Measurement Measure(const Kernel &kernel, double units, uint32_t iterations,
+                    CycleCounter &counter) {
+  kernel.run();
+
+  std::vector<double> ns;
+  std::vector<uint64_t> cycles;
+  ns.reserve(iterations);
+  cycles.reserve(iterations);
+  for (uint32_t i = 0; i < iterations; i++) {
+    counter.Start();
+    auto start = Clock::now();
+    kernel.run();
+    const double ms = ElapsedMs(start);
+    cycles.push_back(counter.Stop());
+    ns.push_back(ms * 1e6);
+  }
+  std::nth_element(ns.begin(), ns.begin() + ns.size() / 2, ns.end());
+  std::nth_element(cycles.begin(), cycles.begin() + cycles.size() / 2,
+                   cycles.end());
+
+  Measurement m;
+  m.nsPerUnit = ns[ns.size() / 2] / units;
+  m.gbps = kernel.bytesPerUnit / m.nsPerUnit;
+  m.cyclesPerUnit = static_cast<double>(cycles[cycles.size() / 2]) / units;
+  return m;
+}
+
+std::map<std::string, double> LoadBaseline(const char *path) {
+  std::map<std::string, double> baseline;
+  FILE *file = std::fopen(path, "r");
+  if (!file)
+    return baseline;
+  char name[64];
+  double ns;
+  while (std::fscanf(file, "%63s %lf", name, &ns) == 2)
+    baseline[name] = ns;
+  std::fclose(file);
+  return baseline;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Args args(argc, argv);
+  const uint32_t width = static_cast<uint32_t>(args.GetInt("--width", 1920));
+  const uint32_t height = static_cast<uint32_t>(args.GetInt("--height", 1080));
+  const uint32_t threads = static_cast<uint32_t>(args.GetInt("--threads", 1));
+  const uint32_t iterations =
+      static_cast<uint32_t>(std::max(3L, args.GetInt("--iterations", 50)));
+  const std::string which = args.Get("--kernel", "all");
+  const char *savePath = args.Get("--save", nullptr);
+  const char *comparePath = args.Get("--compare", nullptr);
+  const double threshold = args.GetDouble("--threshold", 10.0);
+
+  ThreadPool pool(threads);
+  ThreadPool *kernelPool = pool.ThreadCount() > 1 ? &pool : nullptr;
+
+  SyntheticScene scene(width, height);
+  FrameBuffer a(width, height), b(width, height), out(width, height);
+  scene.Render(0, a.view);
+  scene.Render(1, b.view);
+  std::vector<float> planes(PlanarRgbSize(width, height));
+  (void)BgraToPlanarRgb(a.view, planes.data());
+  LumaImage luma, half;
+  ExtractLuma(a.view, luma);
+  TileChangeMap tiles(kernelPool);
+  SceneThumbnail thumbnail;
+  SpscRing<uint64_t, 4> ring;
+  constexpr uint64_t kRingItems = 1 << 16;
+
+  const double pixels = static_cast<double>(width) * height;
+  std::vector<std::pair<Kernel, double>> kernels = {
+      {{"tensor_in", 16.0,
+        [&] { (void)BgraToPlanarRgb(a.view, planes.data(), kernelPool); }},
+       pixels},
+      {{"tensor_out", 16.0,
+        [&] { (void)PlanarRgbToBgra(planes.data(), out.view, kernelPool); }},
+       pixels},
+      {{"blend", 12.0,
+        [&] { (void)BlendFrames(a.view, b.view, out.view, 0.5f, 1.f,
+                                kernelPool); }},
+       pixels},
+      {{"luma", 5.0, [&] { ExtractLuma(a.view, luma, kernelPool); }}, pixels},
+      {{"downsample", 1.25,
+        [&] { DownsampleLuma(luma, half, kernelPool); }},
+       pixels},
+      // Identical frames: no tile can exit early, the worst case.
+      {{"tile_update", 8.0, [&] { (void)tiles.Update(a.view, a.view); }},
+       pixels},
+      {{"thumbnail", 0.0,
+        [&] { SceneCutDetector::Thumbnail(a.view, thumbnail); }},
+       pixels},
+      // Producer on a second thread, consumer here; per item handed over.
+      // Both sides yield when blocked so the test also completes on one
+      // core.
+      {{"spsc_ring", 2.0 * sizeof(uint64_t),
+        [&] {
+          std::thread producer([&] {
+            for (uint64_t i = 0; i < kRingItems;) {
+              if (ring.Push(i))
+                i++;
+              else
+                std::this_thread::yield();
+            }
+          });
+          uint64_t item = 0;
+          for (uint64_t received = 0; received < kRingItems;) {
+            if (ring.Pop(item))
+              received++;
+            else
+              std::this_thread::yield();
+          }
+          producer.join();
+        }},
+       static_cast<double>(kRingItems)},
+  };
+
+  CycleCounter counter;
+  const bool showCycles = counter.Available() && pool.ThreadCount() == 1;
+  printf("%ux%u threads=%u iterations=%u blend=%s cycles=%s\n", width, height,
+         pool.ThreadCount(), iterations, BlendRowIsa(),
+         showCycles ? counter.Source() : "off");
+  printf("%-12s %10s %9s %10s\n", "kernel", "ns/unit", "GB/s", "cycles");
+
+  const std::map<std::string, double> baseline =
+      comparePath ? LoadBaseline(comparePath) : std::map<std::string, double>{};
+  if (comparePath && baseline.empty()) {
+    printf("no baseline in %s\n", comparePath);
+    return 2;
+  }
+
+  FILE *save = savePath ? std::fopen(savePath, "w") : nullptr;
+  if (savePath && !save) {
+    printf("failed to write %s\n", savePath);
+    return 2;
+  }
+
+  int regressions = 0;
+  for (const auto &[kernel, units] : kernels) {
+    if (which != "all" && which != kernel.name)
+      continue;
+    const Measurement m = Measure(kernel, units, iterations, counter);
+
+    printf("%-12s %10.3f ", kernel.name, m.nsPerUnit);
+    if (kernel.bytesPerUnit > 0.0)
+      printf("%9.2f ", m.gbps);
+    else
+      printf("%9s ", "-");
+    if (showCycles)
+      printf("%10.2f", m.cyclesPerUnit);
+    else
+      printf("%10s", "-");
+
+    auto base = baseline.find(kernel.name);
+    if (base != baseline.end() && base->second > 0.0) {
+      const double change = 100.0 * (m.nsPerUnit / base->second - 1.0);
+      const bool regressed = change > threshold;
+      printf("  %+6.1f%%%s", change, regressed ? "  REGRESSION" : "");
+      regressions += regressed;
+    }
+    printf("\n");
+
+    if (save)
+      std::fprintf(save, "%s %.6f\n", kernel.name, m.nsPerUnit);
+  }
+
+  if (save)
+    std::fclose(save);
+  if (regressions) {
+    printf("%d kernel(s) regressed by more than %.1f%%\n", regressions,
+           threshold);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,165 @@
+// Per-call cost of the asynchronous logger against the stdio calls it
+// replaces, with the per-frame capture message as the payload. Calls are
+// timed in batches of half a thread ring; the logger is flushed between
+// batches, outside the timed region, so no call is dropped.
+//
+//   log_bench [--calls 100000] [--threads 1] [--batch 256]
+//
+// Exits non-zero if the logger dropped or lost a message.
+
+#include "../compute/Log.h"
+#include "BenchUtil.h"
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <thread>
+#include <vector>
+
+using namespace DeepFrame;
+using namespace DeepFrame::Bench;
+
+namespace {
+
+#if defined(_WIN32)
+constexpr const char *kNullDevice = "NUL";
+#else
+constexpr const char *kNullDevice = "/dev/null";
+#endif
+
+struct Measurement {
+  double medianNs = 0.0;
+  double worstNs = 0.0;
+};
+
+// Runs `call(i)` `calls` times on each thread in batches, with `between`
+// after every batch, and returns ns/call over the batches.
+Measurement Measure(uint32_t threads, uint64_t calls, uint64_t batch,
+                    const std::function<void(uint64_t)> &call,
+                    const std::function<void()> &between) {
+  std::vector<std::vector<double>> perThread(threads);
+  std::vector<std::thread> workers;
+  for (uint32_t t = 0; t < threads; t++) {
+    workers.emplace_back([&, t] {
+      std::vector<double> &samples = perThread[t];
+      for (uint64_t done = 0; done < calls; done += batch) {
+        const uint64_t n = std::min(batch, calls - done);
+        auto start = Clock::now();
+        for (uint64_t i = 0; i < n; i++)
+          call(done + i);
+        samples.push_back(ElapsedMs(start) * 1e6 / static_cast<double>(n));
+        between();
+      }
+    });
+  }
+  for (std::thread &worker : workers)
+    worker.join();
+
+  std::vector<double> all;
+  for (const std::vector<double> &samples : perThread)
+    all.insert(all.end(), samples.begin(), samples.end());
+  std::sort(all.begin(), all.end());
+  Measurement m;
+  m.medianNs = all[all.size() / 2];
+  m.worstNs = all.back();
+  return m;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Args args(argc, argv);
+  const uint64_t calls =
+      static_cast<uint64_t>(std::max(1L, args.GetInt("--calls", 100000)));
+  const uint32_t threads =
+      static_cast<uint32_t>(std::max(1L, args.GetInt("--threads", 1)));
+  const uint64_t batch = static_cast<uint64_t>(
+      std::clamp(args.GetInt("--batch", 256), 1L, 256L));
+
+  FILE *null = std::fopen(kNullDevice, "w");
+  FILE *file = std::tmpfile();
+  if (!null || !file) {
+    printf("failed to open the null device or a temporary file\n");
+    return 2;
+  }
+  Log::SetSink(null);
+  Log::SetLevel(LogLevel::Info);
+
+  const double latencyMs = 0.4321;
+  const auto nothing = [] {};
+  const auto flush = [] { Log::Flush(); };
+  Log::RateLimiter limiter(1000);
+
+  struct Case {
+    const char *name;
+    std::function<void(uint64_t)> call;
+    std::function<void()> between;
+  };
+  const std::vector<Case> cases = {
+      {"log",
+       [&](uint64_t i) {
+         Log::Info("[DxgiCapture] Pipeline latency %.4f ms | frame %llu\n",
+                   latencyMs, static_cast<unsigned long long>(i));
+       },
+       flush},
+      {"log_string",
+       [&](uint64_t i) {
+         Log::Info("[OnnxSession] Run failed: %s (%u)\n",
+                   "invalid input shape", static_cast<uint32_t>(i));
+       },
+       flush},
+      // Below the level: the call is a relaxed load and a compare.
+      {"log_filtered",
+       [&](uint64_t i) {
+         Log::Debug("[DxgiCapture] Pipeline latency %.4f ms | frame %llu\n",
+                    latencyMs, static_cast<unsigned long long>(i));
+       },
+       nothing},
+      {"log_limited",
+       [&](uint64_t i) {
+         limiter.Write(LogLevel::Info,
+                       "[DxgiCapture] Pipeline latency %.4f ms | frame %llu\n",
+                       latencyMs, static_cast<unsigned long long>(i));
+       },
+       flush},
+      {"fprintf_null",
+       [&](uint64_t i) {
+         std::fprintf(null,
+                      "[DxgiCapture] Pipeline latency %.4f ms | frame %llu\n",
+                      latencyMs, static_cast<unsigned long long>(i));
+       },
+       nothing},
+      // Line-buffered like stderr on a console or pipe.
+      {"fprintf_file",
+       [&](uint64_t i) {
+         std::fprintf(file,
+                      "[DxgiCapture] Pipeline latency %.4f ms | frame %llu\n",
+                      latencyMs, static_cast<unsigned long long>(i));
+         std::fflush(file);
+       },
+       nothing},
+  };
+
+  printf("calls=%llu threads=%u batch=%llu\n",
+         static_cast<unsigned long long>(calls), threads,
+         static_cast<unsigned long long>(batch));
+  printf("%-14s %10s %10s\n", "case", "ns/call", "worst");
+  for (const Case &c : cases) {
+    const Measurement m = Measure(threads, calls, batch, c.call, c.between);
+    printf("%-14s %10.1f %10.1f\n", c.name, m.medianNs, m.worstNs);
+  }
+
+  Log::Flush();
+  const LogStats stats = Log::GetStats();
+  // log and log_string write every call, log_limited about one a second.
+  const uint64_t expected = 2 * calls * threads;
+  printf("written %llu dropped %llu suppressed %llu\n",
+         static_cast<unsigned long long>(stats.written),
+         static_cast<unsigned long long>(stats.dropped),
+         static_cast<unsigned long long>(stats.suppressed));
+
+  std::fclose(file);
+  const bool lost = stats.dropped != 0 || stats.written < expected;
+  Log::SetSink(stderr);
+  std::fclose(null);
+  return lost ? 1 : 0;
+}
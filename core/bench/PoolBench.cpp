@@ -0,0 +1,203 @@
+// Stress test of ResourcePool shaped like capture -> interpolate: a
+// producer thread leases CPU frame buffers, stamps them and queues the
+// leases; the consumer keeps the previous and current frame leased, checks
+// their stamps and keeps a raw handle to every frame it lets go, which must
+// stop resolving once the slot is recycled. The same loop then runs with a
+// freshly allocated buffer per frame for comparison. Exits non-zero on any
+// corrupted frame or stale handle that still resolves.
+//
+//   pool_bench [--width 1920] [--height 1080] [--frames 2000]
+//              [--capacity 8]
+
+#include "../compute/ResourcePool.h"
+#include "../compute/SpscRing.h"
+#include "BenchUtil.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace DeepFrame;
+using namespace DeepFrame::Bench;
+
+namespace {
+
+using Buffer = std::vector<uint8_t>;
+using BufferLease = PoolLease<Buffer>;
+
+struct Queued {
+  BufferLease lease;
+  uint64_t frame = 0;
+};
+
+// The stamp is the frame number repeated at the start and end of the
+// buffer, plus one byte per row in between.
+void Stamp(Buffer &buffer, uint64_t frame, size_t rowBytes) {
+  std::memcpy(buffer.data(), &frame, sizeof(frame));
+  std::memcpy(buffer.data() + buffer.size() - sizeof(frame), &frame,
+              sizeof(frame));
+  for (size_t row = rowBytes; row + rowBytes <= buffer.size(); row += rowBytes)
+    buffer[row] = static_cast<uint8_t>(frame);
+}
+
+bool CheckStamp(const Buffer &buffer, uint64_t frame, size_t rowBytes) {
+  uint64_t head = 0, tail = 0;
+  std::memcpy(&head, buffer.data(), sizeof(head));
+  std::memcpy(&tail, buffer.data() + buffer.size() - sizeof(tail),
+              sizeof(tail));
+  if (head != frame || tail != frame)
+    return false;
+  for (size_t row = rowBytes; row + rowBytes <= buffer.size(); row += rowBytes)
+    if (buffer[row] != static_cast<uint8_t>(frame))
+      return false;
+  return true;
+}
+
+struct Result {
+  double msPerFrame = 0.0;
+  uint64_t corrupted = 0;
+  uint64_t staleResolved = 0;
+  uint64_t exhausted = 0;
+};
+
+Result RunPooled(size_t bytes, size_t rowBytes, uint64_t frames,
+                 size_t capacity) {
+  ResourcePool<Buffer> pool;
+  Result result;
+  if (!pool.Initialize(capacity, [&](Buffer &buffer) {
+        buffer.resize(bytes);
+        return true;
+      })) {
+    printf("pool: failed to build %zu buffers\n", capacity);
+    result.corrupted = 1;
+    return result;
+  }
+
+  SpscRing<Queued, 3> queue;
+  auto start = Clock::now();
+  std::thread producer([&] {
+    for (uint64_t frame = 1; frame <= frames;) {
+      BufferLease lease = pool.Acquire();
+      if (!lease) {
+        std::this_thread::yield();
+        continue;
+      }
+      Stamp(*lease, frame, rowBytes);
+      Queued queued;
+      queued.lease = std::move(lease);
+      queued.frame = frame;
+      while (!queue.Push(std::move(queued)))
+        std::this_thread::yield();
+      frame++;
+    }
+  });
+
+  Queued prev, curr;
+  std::vector<PoolHandle> released;
+  for (uint64_t received = 0; received < frames;) {
+    Queued next;
+    if (!queue.Pop(next)) {
+      std::this_thread::yield();
+      continue;
+    }
+    received++;
+    if (prev.lease)
+      released.push_back(prev.lease.Handle());
+    prev = std::move(curr);
+    curr = std::move(next);
+
+    // A second reference, as a presenter holding the frame would take.
+    const BufferLease shared = curr.lease;
+    if (!CheckStamp(*shared, curr.frame, rowBytes) ||
+        (prev.lease && !CheckStamp(*prev.lease, prev.frame, rowBytes))) {
+      result.corrupted++;
+    }
+  }
+  producer.join();
+  result.msPerFrame = ElapsedMs(start) / static_cast<double>(frames);
+
+  prev.lease.Reset();
+  curr.lease.Reset();
+  for (const PoolHandle &handle : released)
+    result.staleResolved += pool.Lookup(handle) != nullptr;
+
+  const PoolStats stats = pool.GetStats();
+  result.exhausted = stats.exhausted;
+  if (stats.inUse != 0)
+    result.corrupted++;
+  return result;
+}
+
+Result RunAllocating(size_t bytes, size_t rowBytes, uint64_t frames) {
+  struct Owned {
+    Buffer *buffer = nullptr;
+    uint64_t frame = 0;
+  };
+  SpscRing<Owned, 3> queue;
+  Result result;
+
+  auto start = Clock::now();
+  std::thread producer([&] {
+    for (uint64_t frame = 1; frame <= frames; frame++) {
+      Owned owned{new Buffer(bytes), frame};
+      Stamp(*owned.buffer, frame, rowBytes);
+      while (!queue.Push(owned))
+        std::this_thread::yield();
+    }
+  });
+
+  Owned prev, curr;
+  for (uint64_t received = 0; received < frames;) {
+    Owned next;
+    if (!queue.Pop(next)) {
+      std::this_thread::yield();
+      continue;
+    }
+    received++;
+    delete prev.buffer;
+    prev = curr;
+    curr = next;
+    if (!CheckStamp(*curr.buffer, curr.frame, rowBytes))
+      result.corrupted++;
+  }
+  producer.join();
+  result.msPerFrame = ElapsedMs(start) / static_cast<double>(frames);
+  delete prev.buffer;
+  delete curr.buffer;
+  return result;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Args args(argc, argv);
+  const uint32_t width = static_cast<uint32_t>(args.GetInt("--width", 1920));
+  const uint32_t height = static_cast<uint32_t>(args.GetInt("--height", 1080));
+  const uint64_t frames =
+      static_cast<uint64_t>(std::max(4L, args.GetInt("--frames", 2000)));
+  // Queue of 3, two held by the consumer and one being filled.
+  const size_t capacity =
+      static_cast<size_t>(std::max(1L, args.GetInt("--capacity", 8)));
+
+  const size_t rowBytes = static_cast<size_t>(width) * 4;
+  const size_t bytes = rowBytes * height;
+  printf("%ux%u frames=%llu capacity=%zu\n", width, height,
+         static_cast<unsigned long long>(frames), capacity);
+
+  const Result pooled = RunPooled(bytes, rowBytes, frames, capacity);
+  const Result allocating = RunAllocating(bytes, rowBytes, frames);
+
+  printf("%-10s %8.3f ms/frame  exhausted %llu  corrupted %llu  stale "
+         "handles resolved %llu\n",
+         "pooled", pooled.msPerFrame,
+         static_cast<unsigned long long>(pooled.exhausted),
+         static_cast<unsigned long long>(pooled.corrupted),
+         static_cast<unsigned long long>(pooled.staleResolved));
+  printf("%-10s %8.3f ms/frame  corrupted %llu\n", "allocating",
+         allocating.msPerFrame,
+         static_cast<unsigned long long>(allocating.corrupted));
+
+  return pooled.corrupted || pooled.staleResolved || allocating.corrupted ? 1
+                                                                          : 0;
+}
@@ -0,0 +1,270 @@
+// Quality against throughput of every interpolation path. A synthetic
+// sequence is rendered at twice the output rate, every other frame is
+// dropped, and each engine rebuilds the dropped frames from their kept
+// neighbours; the rebuilt frames are scored against the dropped originals.
+//
+//   quality_bench [--sizes 720p,1080p,4k] [--pairs 6] [--threads 0]
+//                 [--engines blend,block,flow,onnx] [--scene pan|fast|static]
+//                 [--model interp.onnx] [--label <commit>] [--json out.json]
+//
+// --json writes one record per engine and size so runs from different
+// commits can be diffed; --label is copied into it verbatim. The onnx
+// engine runs the model through OnnxSession on the CPU provider and is
+// skipped when the build has no ONNX Runtime.
+
+#include "../compute/Blend.h"
+#include "../compute/BlockMatchInterpolator.h"
+#include "../compute/FlowInterpolator.h"
+#include "../compute/TensorConvert.h"
+#include "../compute/ThreadPool.h"
+#include "../inference/OnnxSession.h"
+#include "BenchUtil.h"
+#include "SyntheticScene.h"
+#include <cstdio>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace DeepFrame;
+using namespace DeepFrame::Bench;
+
+namespace {
+
+struct Size {
+  std::string name;
+  uint32_t width;
+  uint32_t height;
+};
+
+struct Result {
+  std::string engine;
+  Size size;
+  double msPerFrame = 0.0;
+  double psnr = 0.0;
+  double ssim = 0.0;
+  double duplicatePsnr = 0.0;
+  double duplicateSsim = 0.0;
+};
+
+using InterpolateFn = std::function<bool(const FrameView &, const FrameView &,
+                                         const FrameView &, float)>;
+
+std::vector<std::string> Split(const std::string &list) {
+  std::vector<std::string> items;
+  std::stringstream stream(list);
+  std::string item;
+  while (std::getline(stream, item, ','))
+    if (!item.empty())
+      items.push_back(item);
+  return items;
+}
+
+bool ParseSize(const std::string &token, Size &size) {
+  if (token == "720p") {
+    size = {token, 1280, 720};
+  } else if (token == "1080p") {
+    size = {token, 1920, 1080};
+  } else if (token == "1440p") {
+    size = {token, 2560, 1440};
+  } else if (token == "4k") {
+    size = {token, 3840, 2160};
+  } else {
+    unsigned w = 0, h = 0;
+    if (std::sscanf(token.c_str(), "%ux%u", &w, &h) != 2 || w < 64 || h < 64)
+      return false;
+    size = {token, w, h};
+  }
+  return true;
+}
+
+
+bool RunEngine(const std::string &name, const InterpolateFn &interpolate,
+               const Size &size, const std::vector<FrameBuffer> &kept,
+               const std::vector<FrameBuffer> &dropped, Result &result) {
+  FrameBuffer out(size.width, size.height);
+
+  // Warm-up sizes internal buffers and faults in pages.
+  if (!interpolate(kept[0].view, kept[1].view, out.view, 0.5f)) {
+    printf("%-8s %-6s failed\n", name.c_str(), size.name.c_str());
+    return false;
+  }
+
+  result = {};
+  result.engine = name;
+  result.size = size;
+  double totalMs = 0.0;
+  const size_t pairs = dropped.size();
+  for (size_t i = 0; i < pairs; i++) {
+    auto start = Clock::now();
+    if (!interpolate(kept[i].view, kept[i + 1].view, out.view, 0.5f)) {
+      printf("%-8s %-6s failed\n", name.c_str(), size.name.c_str());
+      return false;
+    }
+    totalMs += ElapsedMs(start);
+    result.psnr += Psnr(out.view, dropped[i].view);
+    result.ssim += Ssim(out.view, dropped[i].view);
+    result.duplicatePsnr += Psnr(kept[i + 1].view, dropped[i].view);
+    result.duplicateSsim += Ssim(kept[i + 1].view, dropped[i].view);
+  }
+  result.msPerFrame = totalMs / pairs;
+  result.psnr /= pairs;
+  result.ssim /= pairs;
+  result.duplicatePsnr /= pairs;
+  result.duplicateSsim /= pairs;
+
+  printf("%-8s %-6s %9.2f ms/frame %8.1f fps  PSNR %5.2f dB  SSIM %.4f  "
+         "(duplicate %5.2f dB %.4f)\n",
+         name.c_str(), size.name.c_str(), result.msPerFrame,
+         1000.0 / result.msPerFrame, result.psnr, result.ssim,
+         result.duplicatePsnr, result.duplicateSsim);
+  return true;
+}
+
+bool WriteJson(const char *path, const std::string &label,
+               const std::string &scene, uint32_t threads, size_t pairs,
+               const std::vector<Result> &results) {
+  FILE *file = std::fopen(path, "w");
+  if (!file)
+    return false;
+  std::fprintf(file,
+               "{\n  \"bench\": \"quality\",\n  \"label\": \"%s\",\n"
+               "  \"scene\": \"%s\",\n  \"threads\": %u,\n  \"pairs\": %zu,\n"
+               "  \"blendIsa\": \"%s\",\n  \"results\": [",
+               label.c_str(), scene.c_str(), threads, pairs, BlendRowIsa());
+  for (size_t i = 0; i < results.size(); i++) {
+    const Result &r = results[i];
+    std::fprintf(file,
+                 "%s\n    {\"engine\": \"%s\", \"size\": \"%s\", "
+                 "\"width\": %u, \"height\": %u, \"msPerFrame\": %.3f, "
+                 "\"fps\": %.2f, \"psnr\": %.3f, \"ssim\": %.5f, "
+                 "\"duplicatePsnr\": %.3f, \"duplicateSsim\": %.5f}",
+                 i ? "," : "", r.engine.c_str(), r.size.name.c_str(),
+                 r.size.width, r.size.height, r.msPerFrame,
+                 1000.0 / r.msPerFrame, r.psnr, r.ssim, r.duplicatePsnr,
+                 r.duplicateSsim);
+  }
+  std::fprintf(file, "\n  ]\n}\n");
+  return std::fclose(file) == 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Args args(argc, argv);
+  const uint32_t threads = static_cast<uint32_t>(args.GetInt("--threads", 0));
+  const size_t pairs =
+      static_cast<size_t>(std::max(2L, args.GetInt("--pairs", 6)));
+  const std::string scene = args.Get("--scene", "pan");
+  const std::string label = args.Get("--label", "");
+  const char *jsonPath = args.Get("--json", nullptr);
+  const std::vector<std::string> engines =
+      Split(args.Get("--engines", "blend,block,flow,onnx"));
+
+  std::vector<Size> sizes;
+  for (const std::string &token : Split(args.Get("--sizes", "720p,1080p,4k"))) {
+    Size size;
+    if (!ParseSize(token, size)) {
+      printf("unknown size '%s' (720p, 1080p, 1440p, 4k or WxH)\n",
+             token.c_str());
+      return 2;
+    }
+    sizes.push_back(size);
+  }
+
+  // Motion per output frame, i.e. across each kept pair.
+  SceneMotion motion;
+  if (scene == "static") {
+    motion.panX = 0.f;
+    motion.panY = 0.f;
+  } else if (scene == "fast") {
+    motion.panX *= 2.f;
+    motion.panY *= 2.f;
+    motion.boxX *= 2.f;
+    motion.boxY *= 2.f;
+  } else if (scene != "pan") {
+    printf("unknown scene '%s' (pan, fast or static)\n", scene.c_str());
+    return 2;
+  }
+
+  ThreadPool pool(threads);
+  MotionParams params;
+  params.searchRadius = static_cast<int32_t>(args.GetInt("--radius", 16));
+  if (scene == "fast")
+    params.searchRadius *= 2;
+
+  OnnxSession onnx;
+  OnnxSessionOptions onnxOptions;
+  onnxOptions.gpu = false;
+  onnxOptions.intraOpThreads = static_cast<int>(pool.ThreadCount());
+  const char *model = args.Get("--model", nullptr);
+  const bool haveOnnx = model && onnx.Create(model, onnxOptions);
+
+  std::vector<Result> results;
+  for (const Size &size : sizes) {
+    // The source runs at twice the output rate: source frame s is shown at
+    // time s / 2, even frames are kept and odd frames dropped.
+    SyntheticScene synthetic(size.width, size.height, motion);
+    std::vector<FrameBuffer> kept;
+    std::vector<FrameBuffer> dropped;
+    kept.reserve(pairs + 1);
+    dropped.reserve(pairs);
+    for (size_t s = 0; s <= 2 * pairs; s++) {
+      std::vector<FrameBuffer> &target = s % 2 ? dropped : kept;
+      target.emplace_back(size.width, size.height);
+      synthetic.Render(0.5 * s, target.back().view);
+    }
+
+    BlockMatchInterpolator block(&pool);
+    block.SetParams(params);
+    FlowInterpolator flow(&pool);
+    flow.SetParams(params);
+
+    for (const std::string &name : engines) {
+      InterpolateFn fn;
+      if (name == "blend") {
+        fn = [&](const FrameView &a, const FrameView &b, const FrameView &o,
+                 float t) { return BlendFrames(a, b, o, t, 1.f, &pool); };
+      } else if (name == "block") {
+        fn = [&](const FrameView &a, const FrameView &b, const FrameView &o,
+                 float t) { return block.Interpolate(a, b, o, t); };
+      } else if (name == "flow") {
+        fn = [&](const FrameView &a, const FrameView &b, const FrameView &o,
+                 float t) { return flow.Interpolate(a, b, o, t); };
+      } else if (name == "onnx") {
+        if (!haveOnnx) {
+          printf("%-8s %-6s skipped (no --model or no ONNX Runtime)\n",
+                 name.c_str(), size.name.c_str());
+          continue;
+        }
+        // Models exported with a fixed input size only run at that size.
+        if ((onnx.InputWidth() && onnx.InputWidth() != size.width) ||
+            (onnx.InputHeight() && onnx.InputHeight() != size.height)) {
+          printf("%-8s %-6s skipped (model has a fixed input size)\n",
+                 name.c_str(), size.name.c_str());
+          continue;
+        }
+        fn = [&](const FrameView &a, const FrameView &b, const FrameView &o,
+                 float) {
+          return onnx.SetInput(0, a, nullptr, &pool) &&
+                 onnx.SetInput(1, b, nullptr, &pool) && onnx.Run() &&
+                 onnx.GetOutput(o, &pool);
+        };
+      } else {
+        printf("unknown engine '%s'\n", name.c_str());
+        return 2;
+      }
+
+      Result result;
+      if (RunEngine(name, fn, size, kept, dropped, result))
+        results.push_back(result);
+    }
+  }
+
+  if (jsonPath && !WriteJson(jsonPath, label, scene, pool.ThreadCount(),
+                             pairs, results)) {
+    printf("failed to write %s\n", jsonPath);
+    return 1;
+  }
+  return 0;
+}
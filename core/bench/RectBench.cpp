@@ -0,0 +1,332 @@
+// Dirty/move rect propagation on a synthetic desktop: a source frame is
+// edited the way a compositor reports it (small widget repaints, scrolls
+// as a move rect plus the revealed strip, idle frames and the odd full
+// repaint), frames are dropped at random before the consumer as a full
+// capture queue would, and the consumer keeps two staging buffers and two
+// input tensors up to date through FramePairTracker. Each pair is checked
+// against a full copy and conversion of both frames, every changed pixel
+// must lie inside the reported rects, and the rect-limited TileChangeMap
+// must flag the same tiles as a full compare. Exits non-zero on any
+// mismatch.
+//
+//   rect_bench [--width 1920] [--height 1080] [--frames 300] [--drop 0.1]
+//              [--seed 1] [--threads 0]
+
+#include "../compute/RectList.h"
+#include "../compute/TensorConvert.h"
+#include "../compute/ThreadPool.h"
+#include "../compute/TileChangeMap.h"
+#include "BenchUtil.h"
+#include "SyntheticScene.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace DeepFrame;
+using namespace DeepFrame::Bench;
+
+namespace {
+
+void Paint(const FrameView &frame, const TileRect &rect, uint64_t stamp) {
+  for (uint32_t y = rect.top; y < rect.bottom; y++) {
+    uint8_t *row = frame.Row(y);
+    for (uint32_t x = rect.left; x < rect.right; x++) {
+      const uint32_t v = static_cast<uint32_t>(x * 7 + y * 13 + stamp * 31);
+      row[x * 4 + 0] = static_cast<uint8_t>(v);
+      row[x * 4 + 1] = static_cast<uint8_t>(v >> 3);
+      row[x * 4 + 2] = static_cast<uint8_t>(v * 5);
+      row[x * 4 + 3] = 255;
+    }
+  }
+}
+
+void CopyRect(const FrameView &src, const FrameView &dst,
+              const TileRect &rect) {
+  for (uint32_t y = rect.top; y < rect.bottom; y++)
+    std::memcpy(dst.Row(y) + rect.left * 4, src.Row(y) + rect.left * 4,
+                (rect.right - rect.left) * 4);
+}
+
+void CopyFrame(const FrameView &src, const FrameView &dst) {
+  CopyRect(src, dst, {0, 0, src.width, src.height});
+}
+
+bool SameFrame(const FrameView &a, const FrameView &b) {
+  for (uint32_t y = 0; y < a.height; y++)
+    if (std::memcmp(a.Row(y), b.Row(y), static_cast<size_t>(a.width) * 4))
+      return false;
+  return true;
+}
+
+// Edits `desktop` for one compositor frame and reports the change.
+class DesktopStream {
+public:
+  DesktopStream(uint32_t width, uint32_t height, uint32_t seed)
+      : width_(width), height_(height), rng_(seed) {}
+
+  void Step(const FrameView &desktop, uint64_t frame, RectList &changes) {
+    const uint32_t roll = Uniform(0, 99);
+    if (roll < 10)
+      return;
+    if (roll < 14) {
+      Paint(desktop, {0, 0, width_, height_}, frame);
+      changes.SetFull();
+      return;
+    }
+    if (roll < 30) {
+      Scroll(desktop, frame, changes);
+      return;
+    }
+    const uint32_t count = Uniform(1, 6);
+    for (uint32_t i = 0; i < count; i++) {
+      const uint32_t w = Uniform(4, std::min(240u, width_));
+      const uint32_t h = Uniform(4, std::min(120u, height_));
+      const uint32_t x = Uniform(0, width_ - w);
+      const uint32_t y = Uniform(0, height_ - h);
+      const TileRect rect = {x, y, x + w, y + h};
+      Paint(desktop, rect, frame + i);
+      changes.Add(rect, width_, height_);
+    }
+  }
+
+private:
+  uint32_t Uniform(uint32_t lo, uint32_t hi) {
+    return std::uniform_int_distribution<uint32_t>(lo, hi)(rng_);
+  }
+
+  // A window's content moves up by `dy`: the move rect's destination and
+  // the strip uncovered at the bottom change.
+  void Scroll(const FrameView &desktop, uint64_t frame, RectList &changes) {
+    const uint32_t w = Uniform(std::min(64u, width_), std::min(900u, width_));
+    const uint32_t h =
+        Uniform(std::min(96u, height_), std::min(700u, height_));
+    const uint32_t x = Uniform(0, width_ - w);
+    const uint32_t y = Uniform(0, height_ - h);
+    const uint32_t dy = Uniform(1, h / 3);
+    for (uint32_t row = y; row + dy < y + h; row++)
+      std::memcpy(desktop.Row(row) + x * 4, desktop.Row(row + dy) + x * 4,
+                  static_cast<size_t>(w) * 4);
+    const TileRect moved = {x, y, x + w, y + h - dy};
+    const TileRect revealed = {x, y + h - dy, x + w, y + h};
+    Paint(desktop, revealed, frame);
+    changes.Add(moved, width_, height_);
+    changes.Add(revealed, width_, height_);
+  }
+
+  uint32_t width_;
+  uint32_t height_;
+  std::mt19937 rng_;
+};
+
+struct Totals {
+  uint64_t pairs = 0;
+  uint64_t fullPairs = 0;
+  uint64_t idlePairs = 0;
+  uint64_t rects = 0;
+  uint64_t changedPixels = 0;
+  uint64_t reportedPixels = 0;
+  uint64_t refreshedPixels = 0;
+  double incrementalMs = 0.0;
+  double fullMs = 0.0;
+  double tilesRectMs = 0.0;
+  double tilesFullMs = 0.0;
+  uint64_t stagingMismatches = 0;
+  uint64_t tensorMismatches = 0;
+  uint64_t uncoveredPixels = 0;
+  uint64_t tileMismatches = 0;
+};
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Args args(argc, argv);
+  const uint32_t width = static_cast<uint32_t>(args.GetInt("--width", 1920));
+  const uint32_t height = static_cast<uint32_t>(args.GetInt("--height", 1080));
+  const uint64_t frames =
+      static_cast<uint64_t>(std::max(2L, args.GetInt("--frames", 300)));
+  const double drop = std::clamp(args.GetDouble("--drop", 0.1), 0.0, 0.9);
+  const uint32_t seed = static_cast<uint32_t>(args.GetInt("--seed", 1));
+  const uint32_t threads =
+      static_cast<uint32_t>(std::max(0L, args.GetInt("--threads", 0)));
+
+  std::unique_ptr<ThreadPool> pool;
+  if (threads != 1)
+    pool = std::make_unique<ThreadPool>(threads);
+
+  FrameBuffer desktop(width, height);
+  Paint(desktop.view, {0, 0, width, height}, 0);
+  // Ground truth of the last two delivered frames, and the consumer's
+  // staging copies of them.
+  FrameBuffer truth[2] = {{width, height}, {width, height}};
+  FrameBuffer staging[2] = {{width, height}, {width, height}};
+  FrameBuffer reference[2] = {{width, height}, {width, height}};
+  const size_t tensorSize = PlanarRgbSize(width, height);
+  std::vector<float> inputs[2] = {std::vector<float>(tensorSize),
+                                  std::vector<float>(tensorSize)};
+  std::vector<float> expected[2] = {std::vector<float>(tensorSize),
+                                    std::vector<float>(tensorSize)};
+  std::vector<uint8_t> covered(static_cast<size_t>(width) * height);
+
+  DesktopStream stream(width, height, seed);
+  std::mt19937 dropRng(seed * 7919u + 1);
+  std::bernoulli_distribution dropped(drop);
+  FramePairTracker tracker;
+  TileChangeMap rectTiles(pool.get());
+  TileChangeMap fullTiles(pool.get());
+  Totals totals;
+
+  RectList carried;
+  carried.SetFull();
+  uint64_t delivered = 0;
+  uint64_t prevIndex = 0;
+  int currTruth = 0;
+  for (uint64_t frame = 1; frame <= frames; frame++) {
+    RectList changes;
+    stream.Step(desktop.view, frame, changes);
+    carried.Merge(changes, width, height);
+    if (frame > 1 && frame < frames && dropped(dropRng))
+      continue;
+
+    const uint64_t currIndex = frame;
+    currTruth = 1 - currTruth;
+    const FrameView &curr = truth[currTruth].view;
+    const FrameView &prev = truth[1 - currTruth].view;
+    CopyFrame(desktop.view, curr);
+    const RectList pairChanges = carried;
+    carried.Clear();
+    if (delivered++ == 0) {
+      prevIndex = currIndex;
+      continue;
+    }
+
+    totals.pairs++;
+    totals.fullPairs += pairChanges.IsFull();
+    totals.idlePairs += pairChanges.IsEmpty();
+    totals.rects += pairChanges.Count();
+    totals.reportedPixels += pairChanges.Area(width, height);
+
+    // What the interpolators do now: refresh only what changed.
+    auto start = Clock::now();
+    const FramePairPlan plan =
+        tracker.Next(prevIndex, currIndex, &pairChanges, width, height);
+    const FrameView &prevStaging = staging[plan.prevSlot].view;
+    const FrameView &currStaging = staging[plan.currSlot].view;
+    bool converted = true;
+    if (plan.prevFull) {
+      CopyFrame(prev, prevStaging);
+      converted &=
+          BgraToPlanarRgb(prevStaging, inputs[plan.prevSlot].data(), pool.get());
+    }
+    if (plan.currRefresh.IsFull()) {
+      CopyFrame(curr, currStaging);
+    } else {
+      for (const TileRect &rect : plan.currRefresh)
+        CopyRect(curr, currStaging, rect);
+    }
+    converted &= BgraRectsToPlanarRgb(currStaging, inputs[plan.currSlot].data(),
+                                      plan.currRefresh, pool.get());
+    totals.incrementalMs += ElapsedMs(start);
+    totals.refreshedPixels += plan.currRefresh.Area(width, height) +
+                              (plan.prevFull ? uint64_t{width} * height : 0);
+
+    // What they did before: read back and convert both frames whole.
+    start = Clock::now();
+    CopyFrame(prev, reference[0].view);
+    CopyFrame(curr, reference[1].view);
+    converted &= BgraToPlanarRgb(reference[0].view, expected[0].data(),
+                                 pool.get());
+    converted &= BgraToPlanarRgb(reference[1].view, expected[1].data(),
+                                 pool.get());
+    totals.fullMs += ElapsedMs(start);
+
+    if (!converted || !SameFrame(prevStaging, prev) ||
+        !SameFrame(currStaging, curr)) {
+      totals.stagingMismatches++;
+    }
+    if (inputs[plan.prevSlot] != expected[0] ||
+        inputs[plan.currSlot] != expected[1]) {
+      totals.tensorMismatches++;
+    }
+
+    // Every pixel that differs between the pair must be reported.
+    std::fill(covered.begin(), covered.end(), pairChanges.IsFull());
+    for (const TileRect &rect : pairChanges)
+      for (uint32_t y = rect.top; y < rect.bottom; y++)
+        std::fill_n(covered.begin() + static_cast<size_t>(y) * width +
+                        rect.left,
+                    rect.right - rect.left, uint8_t{1});
+    for (uint32_t y = 0; y < height; y++) {
+      const uint32_t *a = reinterpret_cast<const uint32_t *>(prev.Row(y));
+      const uint32_t *b = reinterpret_cast<const uint32_t *>(curr.Row(y));
+      for (uint32_t x = 0; x < width; x++) {
+        if (a[x] == b[x])
+          continue;
+        totals.changedPixels++;
+        totals.uncoveredPixels +=
+            !covered[static_cast<size_t>(y) * width + x];
+      }
+    }
+
+    start = Clock::now();
+    const bool rectOk =
+        pairChanges.IsFull()
+            ? rectTiles.Update(prevStaging, currStaging)
+            : rectTiles.Update(prevStaging, currStaging, pairChanges.begin(),
+                               pairChanges.Count());
+    totals.tilesRectMs += ElapsedMs(start);
+    start = Clock::now();
+    const bool fullOk = fullTiles.Update(prevStaging, currStaging);
+    totals.tilesFullMs += ElapsedMs(start);
+    if (!rectOk || !fullOk ||
+        rectTiles.ChangedTiles() != fullTiles.ChangedTiles()) {
+      totals.tileMismatches++;
+    } else {
+      for (uint32_t row = 0; row < fullTiles.Rows(); row++)
+        for (uint32_t col = 0; col < fullTiles.Cols(); col++)
+          if (rectTiles.IsChanged(col, row) != fullTiles.IsChanged(col, row)) {
+            totals.tileMismatches++;
+            row = fullTiles.Rows() - 1;
+            break;
+          }
+    }
+
+    prevIndex = currIndex;
+  }
+
+  const double pairs = static_cast<double>(std::max<uint64_t>(totals.pairs, 1));
+  const double framePixels = static_cast<double>(width) * height;
+  printf("%ux%u frames=%llu delivered=%llu drop=%.2f threads=%u\n", width,
+         height, static_cast<unsigned long long>(frames),
+         static_cast<unsigned long long>(delivered), drop,
+         pool ? pool->ThreadCount() : 1u);
+  printf("pairs %llu  full %llu  idle %llu  rects/pair %.1f\n",
+         static_cast<unsigned long long>(totals.pairs),
+         static_cast<unsigned long long>(totals.fullPairs),
+         static_cast<unsigned long long>(totals.idlePairs),
+         static_cast<double>(totals.rects) / pairs);
+  printf("changed %.1f%%  reported %.1f%%  refreshed %.1f%% of 2 frames\n",
+         100.0 * static_cast<double>(totals.changedPixels) /
+             (pairs * framePixels),
+         100.0 * static_cast<double>(totals.reportedPixels) /
+             (pairs * framePixels),
+         100.0 * static_cast<double>(totals.refreshedPixels) /
+             (2.0 * pairs * framePixels));
+  printf("%-22s %8.3f ms/pair\n", "copy+convert rects",
+         totals.incrementalMs / pairs);
+  printf("%-22s %8.3f ms/pair\n", "copy+convert full", totals.fullMs / pairs);
+  printf("%-22s %8.3f ms/pair\n", "tile map rects", totals.tilesRectMs / pairs);
+  printf("%-22s %8.3f ms/pair\n", "tile map full", totals.tilesFullMs / pairs);
+  printf("mismatches: staging %llu  tensor %llu  tiles %llu  uncovered "
+         "pixels %llu\n",
+         static_cast<unsigned long long>(totals.stagingMismatches),
+         static_cast<unsigned long long>(totals.tensorMismatches),
+         static_cast<unsigned long long>(totals.tileMismatches),
+         static_cast<unsigned long long>(totals.uncoveredPixels));
+
+  const bool failed = totals.stagingMismatches || totals.tensorMismatches ||
+                      totals.tileMismatches || totals.uncoveredPixels;
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,130 @@
+// Scene-cut detection on synthetic sequences with known cuts: slow and fast
+// pans (no cuts), hard cuts between two looks and camera teleports within
+// one look. Runs at full-screen sizes down to small cropped windows, or
+// only at --width x --height if given. Exits non-zero when any sequence is
+// misclassified at any size.
+//
+//   scene_cut_bench [--width W --height H] [--frames 60]
+
+#include "../compute/SceneCutDetector.h"
+#include "BenchUtil.h"
+#include "SyntheticScene.h"
+#include <cstdio>
+#include <set>
+#include <vector>
+
+using namespace DeepFrame;
+using namespace DeepFrame::Bench;
+
+namespace {
+
+struct Sequence {
+  const char *name;
+  SceneMotion motion;
+  // Frame indices that start a new shot; the frame before is the old one.
+  std::set<uint32_t> cuts;
+  bool teleport = false;
+};
+
+struct Result {
+  uint32_t hits = 0;
+  uint32_t misses = 0;
+  uint32_t falseAlarms = 0;
+};
+
+Result RunSequence(const Sequence &seq, uint32_t width, uint32_t height,
+                   uint32_t count) {
+  const SceneLook lookA{};
+  const SceneLook lookB{0x9e3779b9u, 72.0, 2.1};
+  SyntheticScene sceneA(width, height, seq.motion, lookA);
+  SyntheticScene sceneB(width, height, seq.motion, lookB);
+
+  FrameBuffer frame(width, height);
+  SceneCutDetector detector;
+  SceneThumbnail prev, curr;
+  Result result;
+  double detectMs = 0.0;
+
+  bool onB = false;
+  double timeOffset = 0.0;
+  for (uint32_t i = 0; i < count; i++) {
+    const bool cut = seq.cuts.count(i) != 0;
+    if (cut) {
+      if (seq.teleport)
+        timeOffset += 400.0;
+      else
+        onB = !onB;
+    }
+    (onB ? sceneB : sceneA).Render(i + timeOffset, frame.view);
+
+    auto start = Clock::now();
+    SceneCutDetector::Thumbnail(frame.view, curr);
+    const bool detected = i > 0 && detector.IsCut(prev, curr);
+    detectMs += ElapsedMs(start);
+
+    if (i > 0) {
+      if (detected && cut)
+        result.hits++;
+      else if (cut)
+        result.misses++;
+      else if (detected)
+        result.falseAlarms++;
+    }
+    if (detected != cut && i > 0) {
+      printf("    %s frame %u: %s (sad %.2f, histogram %.2f)\n", seq.name, i,
+             cut ? "missed" : "false alarm", detector.LastSad(),
+             detector.LastHistogramDistance());
+    }
+    prev = curr;
+  }
+
+  printf("  %-10s cuts %2zu  hits %2u  misses %2u  false alarms %2u  "
+         "%.3f ms/frame\n",
+         seq.name, seq.cuts.size(), result.hits, result.misses,
+         result.falseAlarms, detectMs / count);
+  return result;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Args args(argc, argv);
+  struct Size {
+    uint32_t width;
+    uint32_t height;
+  };
+  std::vector<Size> sizes = {{1920, 1080}, {1280, 720}, {800, 600},
+                             {640, 360},  {400, 300},  {320, 180}};
+  if (args.Has("--width") || args.Has("--height")) {
+    sizes = {{static_cast<uint32_t>(args.GetInt("--width", 1920)),
+              static_cast<uint32_t>(args.GetInt("--height", 1080))}};
+  }
+  const uint32_t count =
+      static_cast<uint32_t>(std::max(16L, args.GetInt("--frames", 60)));
+
+  SceneMotion still;
+  still.panX = 0.f;
+  still.panY = 0.f;
+  SceneMotion fast;
+  fast.panX = 40.f;
+  fast.panY = 12.f;
+  fast.boxX = -60.f;
+
+  const std::vector<Sequence> sequences = {
+      {"pan", SceneMotion{}, {}},
+      {"fast-pan", fast, {}},
+      {"cuts", SceneMotion{}, {count / 4, count / 2, 3 * count / 4}},
+      {"cuts-still", still, {count / 3, 2 * count / 3}},
+      {"teleport", SceneMotion{}, {count / 3, 2 * count / 3}, true},
+  };
+
+  uint32_t errors = 0;
+  for (const Size &size : sizes) {
+    printf("%ux%u\n", size.width, size.height);
+    for (const Sequence &seq : sequences) {
+      const Result r = RunSequence(seq, size.width, size.height, count);
+      errors += r.misses + r.falseAlarms;
+    }
+  }
+  return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,310 @@
+// Scaling of a capture -> interpolate -> present pipeline with uneven
+// stage costs, run two ways at the same thread budget:
+//   threads  a thread per stage handing frames over SPSC rings, polling
+//            with yield, and a separate ThreadPool for the interpolate
+//            kernel (FramePipeline before the scheduler);
+//   tasks    the stages as SerialTasks on one TaskScheduler whose workers
+//            also run the kernel, each stage signalling the next.
+// Stage work is calibrated CPU spinning; `--parallel` is the share of the
+// interpolate stage that splits into rows. Exits non-zero if a design
+// loses or reorders a frame.
+//
+//   scheduler_bench [--frames 200] [--capture 1] [--interpolate 8]
+//                   [--present 1] [--parallel 0.9] [--threads N]
+
+#include "../compute/SpscRing.h"
+#include "../compute/TaskScheduler.h"
+#include "../compute/ThreadPool.h"
+#include "BenchUtil.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace DeepFrame;
+using namespace DeepFrame::Bench;
+
+namespace {
+
+constexpr size_t kDepth = 3;
+constexpr size_t kRows = 64;
+
+struct Costs {
+  double captureMs = 1.0;
+  double interpolateMs = 8.0;
+  double presentMs = 1.0;
+  double parallel = 0.9;
+};
+
+struct Frame {
+  uint64_t index = 0;
+  Clock::time_point start;
+};
+
+struct Result {
+  double fps = 0.0;
+  double meanMs = 0.0;
+  double p99Ms = 0.0;
+  bool ordered = true;
+};
+
+double g_itersPerMs = 0.0;
+
+void Burn(double ms) noexcept {
+  volatile uint64_t sink = 0;
+  uint64_t x = 88172645463325252ull;
+  const uint64_t iters = static_cast<uint64_t>(ms * g_itersPerMs);
+  for (uint64_t i = 0; i < iters; i++) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+  }
+  sink = x;
+  (void)sink;
+}
+
+void Calibrate() noexcept {
+  g_itersPerMs = 100000.0;
+  for (int pass = 0; pass < 3; pass++) {
+    const auto start = Clock::now();
+    Burn(20.0);
+    g_itersPerMs *= 20.0 / std::max(1e-3, ElapsedMs(start));
+  }
+}
+
+void Interpolate(ThreadPool &pool, const Costs &costs) noexcept {
+  Burn(costs.interpolateMs * (1.0 - costs.parallel));
+  const double rowMs = costs.interpolateMs * costs.parallel / kRows;
+  pool.ParallelFor(kRows, 1, [rowMs](size_t begin, size_t end) {
+    Burn(rowMs * static_cast<double>(end - begin));
+  });
+}
+
+// Present side bookkeeping, shared by both designs.
+struct Sink {
+  std::vector<double> latencies;
+  uint64_t next = 0;
+  bool ordered = true;
+
+  void Present(const Frame &frame) noexcept {
+    ordered &= frame.index == next;
+    latencies[next++] = ElapsedMs(frame.start);
+  }
+
+  Result Finish(double totalMs) {
+    Result result;
+    result.fps = latencies.size() * 1000.0 / totalMs;
+    result.ordered = ordered && next == latencies.size();
+    std::vector<double> sorted = latencies;
+    std::sort(sorted.begin(), sorted.end());
+    double sum = 0.0;
+    for (double ms : sorted)
+      sum += ms;
+    result.meanMs = sum / sorted.size();
+    result.p99Ms = sorted[std::min(sorted.size() - 1,
+                                   static_cast<size_t>(sorted.size() * 0.99))];
+    return result;
+  }
+};
+
+Result RunThreads(uint32_t threads, uint64_t frames, const Costs &costs) {
+  // The three stage threads, the interpolate one doubling as a kernel
+  // worker, plus whatever the budget leaves for the pool.
+  ThreadPool pool(std::max(1u, threads > 2 ? threads - 2 : 1u));
+  SpscRing<Frame, kDepth> captured;
+  SpscRing<Frame, kDepth> interpolated;
+  Sink sink;
+  sink.latencies.resize(frames);
+
+  const auto start = Clock::now();
+  std::thread capture([&] {
+    for (uint64_t i = 0; i < frames; i++) {
+      while (captured.Count() >= kDepth)
+        std::this_thread::yield();
+      Frame frame{i, Clock::now()};
+      Burn(costs.captureMs);
+      (void)captured.Push(frame);
+    }
+  });
+  std::thread interpolate([&] {
+    for (uint64_t i = 0; i < frames; i++) {
+      Frame frame;
+      while (!captured.Pop(frame))
+        std::this_thread::yield();
+      Interpolate(pool, costs);
+      while (!interpolated.Push(frame))
+        std::this_thread::yield();
+    }
+  });
+  std::thread present([&] {
+    for (uint64_t i = 0; i < frames; i++) {
+      Frame frame;
+      while (!interpolated.Pop(frame))
+        std::this_thread::yield();
+      Burn(costs.presentMs);
+      sink.Present(frame);
+    }
+  });
+  capture.join();
+  interpolate.join();
+  present.join();
+  return sink.Finish(ElapsedMs(start));
+}
+
+class TaskPipeline {
+public:
+  TaskPipeline(uint32_t threads, uint64_t frames, const Costs &costs)
+      : scheduler_(threads), pool_(scheduler_), frames_(frames),
+        costs_(costs) {
+    sink_.latencies.resize(frames);
+  }
+
+  Result Run() {
+    const auto start = Clock::now();
+    capture_.Signal();
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      finished_.wait(lock, [this] { return done_; });
+    }
+    const double totalMs = ElapsedMs(start);
+    // Stages still signal each other once or twice after the last frame.
+    while (!capture_.IsIdle() || !interpolate_.IsIdle() ||
+           !present_.IsIdle()) {
+      std::this_thread::yield();
+    }
+    return sink_.Finish(totalMs);
+  }
+
+private:
+  void Capture() noexcept {
+    while (produced_ < frames_ && captured_.Count() < kDepth) {
+      Frame frame{produced_++, Clock::now()};
+      Burn(costs_.captureMs);
+      (void)captured_.Push(frame);
+      interpolate_.Signal();
+    }
+  }
+
+  void Interpolate() noexcept {
+    Frame frame;
+    while (interpolated_.Count() < kDepth && captured_.Pop(frame)) {
+      capture_.Signal();
+      ::Interpolate(pool_, costs_);
+      (void)interpolated_.Push(frame);
+      present_.Signal();
+    }
+  }
+
+  void Present() noexcept {
+    Frame frame;
+    while (interpolated_.Pop(frame)) {
+      interpolate_.Signal();
+      Burn(costs_.presentMs);
+      sink_.Present(frame);
+      if (sink_.next == frames_) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_ = true;
+        finished_.notify_all();
+      }
+    }
+  }
+
+  TaskScheduler scheduler_;
+  ThreadPool pool_;
+  uint64_t frames_;
+  Costs costs_;
+  SpscRing<Frame, kDepth> captured_;
+  SpscRing<Frame, kDepth> interpolated_;
+  uint64_t produced_ = 0;
+  Sink sink_;
+  std::mutex mutex_;
+  std::condition_variable finished_;
+  bool done_ = false;
+
+  SerialTask capture_{scheduler_, TaskPriority::Normal, [this] { Capture(); }};
+  SerialTask interpolate_{scheduler_, TaskPriority::Normal,
+                          [this] { Interpolate(); }};
+  SerialTask present_{scheduler_, TaskPriority::High, [this] { Present(); }};
+};
+
+// Serial and data-parallel use of the scheduler outside a pipeline:
+// counters, continuations and nested ParallelFor.
+bool CheckScheduler(uint32_t threads) {
+  TaskScheduler scheduler(threads);
+  std::atomic<uint64_t> sum{0};
+  TaskCounter first;
+  TaskCounter second;
+  std::atomic<bool> firstDone{false};
+  bool ordered = true;
+  for (uint64_t i = 1; i <= 100; i++)
+    scheduler.Submit([&sum, i] { sum += i; }, TaskPriority::Normal, &first);
+  scheduler.Then(
+      first,
+      [&] {
+        ordered = sum.load() == 5050;
+        firstDone = true;
+      },
+      TaskPriority::High, &second);
+  scheduler.Wait(second);
+
+  std::vector<uint32_t> hits(10000);
+  scheduler.ParallelFor(100, 1, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      scheduler.ParallelFor(100, 7, [&](size_t b, size_t e) {
+        for (size_t j = b; j < e; j++)
+          hits[i * 100 + j]++;
+      });
+    }
+  });
+  const bool covered =
+      std::all_of(hits.begin(), hits.end(), [](uint32_t n) { return n == 1; });
+  return firstDone && ordered && covered;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const Args args(argc, argv);
+  const uint64_t frames = static_cast<uint64_t>(args.GetInt("--frames", 200));
+  Costs costs;
+  costs.captureMs = args.GetDouble("--capture", costs.captureMs);
+  costs.interpolateMs = args.GetDouble("--interpolate", costs.interpolateMs);
+  costs.presentMs = args.GetDouble("--present", costs.presentMs);
+  costs.parallel = std::clamp(args.GetDouble("--parallel", costs.parallel),
+                              0.0, 1.0);
+  const uint32_t hardware = std::max(1u, std::thread::hardware_concurrency());
+  const uint32_t maxThreads =
+      static_cast<uint32_t>(args.GetInt("--threads", hardware));
+
+  Calibrate();
+  bool ok = true;
+  if (!CheckScheduler(std::max(2u, maxThreads))) {
+    printf("scheduler self-check FAILED\n");
+    ok = false;
+  }
+
+  printf("stages %.1f / %.1f (%.0f%% parallel) / %.1f ms, %llu frames, "
+         "%u hardware threads\n",
+         costs.captureMs, costs.interpolateMs, costs.parallel * 100.0,
+         costs.presentMs, static_cast<unsigned long long>(frames), hardware);
+  printf("%-8s %7s %9s %10s %10s\n", "design", "threads", "fps", "mean ms",
+         "p99 ms");
+  std::vector<uint32_t> counts;
+  for (uint32_t n = 1; n < maxThreads; n *= 2)
+    counts.push_back(n);
+  counts.push_back(maxThreads);
+  for (uint32_t n : counts) {
+    const Result threaded = RunThreads(n, frames, costs);
+    const Result tasks = TaskPipeline(n, frames, costs).Run();
+    // Thread-per-stage cannot run on fewer than its three stage threads.
+    printf("%-8s %7u %9.1f %10.2f %10.2f%s\n", "threads", std::max(n, 3u),
+           threaded.fps, threaded.meanMs, threaded.p99Ms,
+           threaded.ordered ? "" : "  (frames lost)");
+    printf("%-8s %7u %9.1f %10.2f %10.2f%s\n", "tasks", n, tasks.fps,
+           tasks.meanMs, tasks.p99Ms, tasks.ordered ? "" : "  (frames lost)");
+    ok &= threaded.ordered && tasks.ordered;
+  }
+  return ok ? 0 : 1;
+}
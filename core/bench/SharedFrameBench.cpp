@@ -0,0 +1,190 @@
+// Throughput of the shared-memory frame ring across processes, at 1080p
+// and 4K. The bench writes frames as fast as it can (or at --fps) and
+// starts a copy of itself as the reader, which copies out every frame it
+// can get. Each frame carries its number in its first, middle and last
+// rows; a frame the reader accepted with mixed numbers is inconsistent
+// and fails the run. Frames the writer overwrote first are only counted.
+//
+//   shared_frame_bench [--frames 600] [--slots 4] [--fps 0]
+//                      [--width W --height H]   (default: 1080p and 4K)
+
+#include "../compute/SharedFrameRing.h"
+#include "BenchUtil.h"
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#endif
+
+using namespace DeepFrame;
+using namespace DeepFrame::Bench;
+
+namespace {
+
+struct ReaderResult {
+  uint64_t read = 0;
+  uint64_t missed = 0;
+  uint64_t bad = 0;
+  double copyMs = 0.0;
+};
+
+void Stamp(const FrameView &frame, uint32_t n) {
+  for (uint32_t y : {0u, frame.height / 2, frame.height - 1})
+    std::memcpy(frame.Row(y), &n, sizeof(n));
+}
+
+bool StampsMatch(const FrameView &frame, uint64_t n) {
+  for (uint32_t y : {0u, frame.height / 2, frame.height - 1}) {
+    uint32_t stamp;
+    std::memcpy(&stamp, frame.Row(y), sizeof(stamp));
+    if (stamp != static_cast<uint32_t>(n))
+      return false;
+  }
+  return true;
+}
+
+// Runs in the child process.
+int Reader(const std::string &name) {
+  SharedFrameReader reader;
+  const auto openStart = Clock::now();
+  while (!reader.Open(name)) {
+    if (ElapsedMs(openStart) > 5000) {
+      fprintf(stderr, "reader: %s never appeared\n", name.c_str());
+      return 1;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  std::vector<uint8_t> pixels(static_cast<size_t>(reader.Width()) *
+                              reader.Height() * 4);
+  const FrameView out{pixels.data(), reader.Width(), reader.Height(),
+                      reader.Width() * 4, PixelFormat::BGRA8};
+  ReaderResult result;
+  uint64_t next = 0;
+  for (;;) {
+    const bool writerOpen = reader.IsWriterOpen();
+    const uint64_t head = reader.Head();
+    if (head - next > reader.Slots()) {
+      result.missed += head - next - reader.Slots();
+      next = head - reader.Slots();
+    }
+    for (; next < head; next++) {
+      SharedFrameInfo info;
+      const auto start = Clock::now();
+      if (!reader.Read(next, out, &info)) {
+        result.missed++;
+        continue;
+      }
+      result.copyMs += ElapsedMs(start);
+      result.read++;
+      if (info.frameIndex != next || !StampsMatch(out, next))
+        result.bad++;
+    }
+    if (!writerOpen)
+      break;
+    if (reader.Head() == next)
+      std::this_thread::yield();
+  }
+  printf("%llu %llu %llu %.3f\n", static_cast<unsigned long long>(result.read),
+         static_cast<unsigned long long>(result.missed),
+         static_cast<unsigned long long>(result.bad), result.copyMs);
+  return 0;
+}
+
+bool Run(const char *self, uint32_t width, uint32_t height, uint32_t frames,
+         uint32_t slots, double fps) {
+  const std::string name =
+      "deepframe-bench-" +
+      std::to_string(Clock::now().time_since_epoch().count() % 1000000007);
+  SharedFrameWriter writer;
+  if (!writer.Create(name, width, height, PixelFormat::BGRA8, slots)) {
+    fprintf(stderr, "could not create shared memory %s\n", name.c_str());
+    return false;
+  }
+
+  const std::string command =
+      std::string("\"") + self + "\" --role reader --name " + name;
+  FILE *child = popen(command.c_str(), "r");
+  if (!child) {
+    fprintf(stderr, "could not start the reader\n");
+    return false;
+  }
+  // Writing before the reader has mapped the ring would only measure the
+  // writer on its own.
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+  std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+  for (size_t i = 0; i < pixels.size(); i++)
+    pixels[i] = static_cast<uint8_t>(i * 7);
+  const FrameView frame{pixels.data(), width, height, width * 4,
+                        PixelFormat::BGRA8};
+
+  const auto period = std::chrono::duration<double>(fps > 0 ? 1.0 / fps : 0);
+  const auto start = Clock::now();
+  double writeMs = 0.0;
+  for (uint32_t n = 0; n < frames; n++) {
+    Stamp(frame, n);
+    const auto before = Clock::now();
+    (void)writer.Write(frame, n, static_cast<int64_t>(n) * 16667);
+    writeMs += ElapsedMs(before);
+    if (fps > 0) {
+      std::this_thread::sleep_until(
+          start +
+          std::chrono::duration_cast<Clock::duration>(period * (n + 1)));
+    }
+  }
+  const double wallMs = ElapsedMs(start);
+  writer.Close();
+
+  ReaderResult r;
+  unsigned long long read = 0, missed = 0, bad = 0;
+  const bool parsed =
+      fscanf(child, "%llu %llu %llu %lf", &read, &missed, &bad, &r.copyMs) == 4;
+  const int status = pclose(child);
+  if (!parsed || status != 0) {
+    fprintf(stderr, "reader failed\n");
+    return false;
+  }
+  r.read = read;
+  r.missed = missed;
+  r.bad = bad;
+
+  const double frameMB = static_cast<double>(pixels.size()) / 1e6;
+  printf("%ux%u, %u slots: write %.2f ms/frame (%.1f GB/s), %.0f frames/s\n",
+         width, height, slots, writeMs / frames,
+         frameMB * frames / writeMs, frames * 1e3 / wallMs);
+  printf("  reader: %llu read, %llu missed, %llu inconsistent, "
+         "copy %.2f ms/frame (%.1f GB/s)\n",
+         read, missed, bad, read ? r.copyMs / read : 0.0,
+         r.copyMs > 0 ? frameMB * read / r.copyMs : 0.0);
+  return r.bad == 0 && r.read + r.missed == frames;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const Args args(argc, argv);
+  if (std::string(args.Get("--role", "")) == "reader")
+    return Reader(args.Get("--name", ""));
+
+  const uint32_t frames = static_cast<uint32_t>(args.GetInt("--frames", 600));
+  const uint32_t slots = static_cast<uint32_t>(args.GetInt("--slots", 4));
+  const double fps = args.GetDouble("--fps", 0.0);
+  printf("%u frames, %s\n", frames, fps > 0 ? "paced" : "unpaced");
+
+  bool ok = true;
+  if (args.Has("--width")) {
+    ok = Run(argv[0], static_cast<uint32_t>(args.GetInt("--width", 1920)),
+             static_cast<uint32_t>(args.GetInt("--height", 1080)), frames,
+             slots, fps);
+  } else {
+    ok &= Run(argv[0], 1920, 1080, frames, slots, fps);
+    ok &= Run(argv[0], 3840, 2160, frames, slots, fps);
+  }
+  return ok ? 0 : 1;
+}
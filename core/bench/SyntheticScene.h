@@ -0,0 +1,135 @@
+#pragma once
+
+#include "../compute/FrameView.h"
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace DeepFrame::Bench {
+
+// Procedural test content with analytically known motion: a textured
+// background panning at a constant rate and a textured foreground box
+// moving on its own path, so any intermediate time can be rendered exactly
+// as ground truth.
+struct SceneMotion {
+  float panX = 6.f;
+  float panY = 2.f;
+  float boxX = -9.f;
+  float boxY = 4.f;
+  bool box = true;
+};
+
+// Appearance of the scene; two different looks stand in for the two sides
+// of a hard cut.
+struct SceneLook {
+  uint32_t seed = 0;
+  double brightness = 16.0;
+  double rampPhase = 0.0;
+};
+
+class SyntheticScene {
+public:
+  SyntheticScene(uint32_t width, uint32_t height, SceneMotion motion = {},
+                 SceneLook look = {})
+      : width_(width), height_(height), motion_(motion), look_(look) {}
+
+  [[nodiscard]] uint32_t Width() const noexcept { return width_; }
+  [[nodiscard]] uint32_t Height() const noexcept { return height_; }
+
+  // True displacement of the content at (x, y) over one frame starting at
+  // `time`, in the sense frame(time)(p) ~ frame(time + 1)(p + flow).
+  void Flow(double time, double x, double y, double &u,
+            double &v) const noexcept {
+    const double bx0 = width_ * 0.3 + motion_.boxX * time;
+    const double by0 = height_ * 0.3 + motion_.boxY * time;
+    if (motion_.box && x >= bx0 && x < bx0 + width_ * 0.25 && y >= by0 &&
+        y < by0 + height_ * 0.25) {
+      u = motion_.boxX;
+      v = motion_.boxY;
+    } else {
+      u = -motion_.panX;
+      v = -motion_.panY;
+    }
+  }
+
+  void Render(double time, const FrameView &out) const noexcept {
+    const double bx0 = width_ * 0.3 + motion_.boxX * time;
+    const double by0 = height_ * 0.3 + motion_.boxY * time;
+    const double bw = width_ * 0.25;
+    const double bh = height_ * 0.25;
+
+    for (uint32_t y = 0; y < out.height; y++) {
+      uint8_t *row = out.Row(y);
+      for (uint32_t x = 0; x < out.width; x++) {
+        double u, v;
+        uint32_t seed;
+        if (motion_.box && x >= bx0 && x < bx0 + bw && y >= by0 &&
+            y < by0 + bh) {
+          u = x - bx0;
+          v = y - by0;
+          seed = 0x5bd1e995u ^ look_.seed;
+        } else {
+          u = x + motion_.panX * time;
+          v = y + motion_.panY * time;
+          seed = 0x27d4eb2du ^ look_.seed;
+        }
+        row[x * 4 + 0] = Texture(u, v, seed);
+        row[x * 4 + 1] = Texture(u * 0.9 + 17.0, v * 1.1 + 5.0, seed * 3u);
+        row[x * 4 + 2] = Texture(v + 41.0, u + 13.0, seed * 7u);
+        row[x * 4 + 3] = 255;
+      }
+    }
+  }
+
+private:
+  static uint32_t Hash(int32_t x, int32_t y, uint32_t seed) noexcept {
+    uint32_t h = static_cast<uint32_t>(x) * 0x8da6b343u ^
+                 static_cast<uint32_t>(y) * 0xd8163841u ^ seed;
+    h ^= h >> 13;
+    h *= 0x85ebca6bu;
+    h ^= h >> 16;
+    return h & 0xFF;
+  }
+
+  // Bilinear value noise on an 8px lattice plus a low-frequency ramp.
+  uint8_t Texture(double u, double v, uint32_t seed) const noexcept {
+    const double fu = u / 8.0;
+    const double fv = v / 8.0;
+    const double iu = std::floor(fu);
+    const double iv = std::floor(fv);
+    const double du = fu - iu;
+    const double dv = fv - iv;
+    const int32_t x0 = static_cast<int32_t>(iu);
+    const int32_t y0 = static_cast<int32_t>(iv);
+    const double n = (1 - du) * (1 - dv) * Hash(x0, y0, seed) +
+                     du * (1 - dv) * Hash(x0 + 1, y0, seed) +
+                     (1 - du) * dv * Hash(x0, y0 + 1, seed) +
+                     du * dv * Hash(x0 + 1, y0 + 1, seed);
+    const double ramp =
+        32.0 * std::sin(u * 0.013 + v * 0.007 + look_.rampPhase);
+    const double value = n * 0.8 + ramp + look_.brightness;
+    return static_cast<uint8_t>(value < 0 ? 0 : (value > 255 ? 255 : value));
+  }
+
+  uint32_t width_;
+  uint32_t height_;
+  SceneMotion motion_;
+  SceneLook look_;
+};
+
+struct FrameBuffer {
+  std::vector<uint8_t> pixels;
+  FrameView view;
+
+  FrameBuffer(uint32_t width, uint32_t height,
+              PixelFormat format = PixelFormat::BGRA8)
+      : pixels(static_cast<size_t>(width) * height * BytesPerPixel(format)) {
+    view.data = pixels.data();
+    view.width = width;
+    view.height = height;
+    view.pitch = width * BytesPerPixel(format);
+    view.format = format;
+  }
+};
+
+} // namespace DeepFrame::Bench
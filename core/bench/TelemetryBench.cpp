@@ -0,0 +1,131 @@
+// Torture test of TelemetryRing: a writer thread fills records whose
+// fields are all derived from their sequence number, as fast as it can or
+// at a frame rate, while a reader polls head and copies new records the
+// way the JS reader does. Every accepted record must match its sequence
+// number; records the writer lapped are counted as lost, not read torn.
+// Exits non-zero on any inconsistent record.
+//
+//   telemetry_bench [--records 2000000] [--capacity 256] [--fps 0]
+
+#include "../compute/TelemetryRing.h"
+#include "BenchUtil.h"
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace DeepFrame;
+using namespace DeepFrame::Bench;
+
+namespace {
+
+TelemetryRecord Make(uint32_t n) {
+  TelemetryRecord r;
+  r.flags = n * 2654435761u;
+  r.frameIndex = n;
+  r.captureMs = n * 0.25;
+  r.queueMs = static_cast<float>(n % 1000);
+  r.inferenceMs = static_cast<float>(n % 997);
+  r.submitMs = static_cast<float>(n % 991);
+  return r;
+}
+
+bool Matches(const TelemetryRecord &r, uint32_t n) {
+  const TelemetryRecord e = Make(n);
+  return r.flags == e.flags && r.frameIndex == e.frameIndex &&
+         r.captureMs == e.captureMs && r.queueMs == e.queueMs &&
+         r.inferenceMs == e.inferenceMs && r.submitMs == e.submitMs;
+}
+
+struct Result {
+  double writeNs = 0.0;
+  uint64_t read = 0;
+  uint64_t lost = 0;
+  uint64_t bad = 0;
+  uint64_t polls = 0;
+};
+
+Result Run(uint32_t records, uint32_t capacity, double fps) {
+  std::vector<double> memory(TelemetryRing::BytesFor(capacity) /
+                             sizeof(double));
+  TelemetryRing ring;
+  if (!ring.Attach(memory.data(), memory.size() * sizeof(double), capacity)) {
+    fprintf(stderr, "capacity must be a power of two\n");
+    std::exit(2);
+  }
+
+  Result result;
+  std::atomic<bool> done{false};
+  std::thread reader([&] {
+    uint32_t next = 0;
+    for (;;) {
+      const bool last = done.load(std::memory_order_acquire);
+      const uint32_t head = ring.Head();
+      result.polls++;
+      // Only the newest `capacity` records can still be in the ring.
+      if (head - next > capacity) {
+        result.lost += head - next - capacity;
+        next = head - capacity;
+      }
+      for (; next != head; next++) {
+        TelemetryRecord r;
+        if (!ring.Read(next, r)) {
+          result.lost++;
+          continue;
+        }
+        result.read++;
+        if (!Matches(r, next))
+          result.bad++;
+      }
+      if (last)
+        break;
+      if (fps > 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(4));
+    }
+  });
+
+  const auto period = std::chrono::duration<double>(fps > 0 ? 1.0 / fps : 0);
+  const auto start = Clock::now();
+  double writeMs = 0.0;
+  for (uint32_t n = 0; n < records; n++) {
+    const TelemetryRecord r = Make(n);
+    if (fps <= 0) {
+      ring.Write(r);
+      continue;
+    }
+    const auto before = Clock::now();
+    ring.Write(r);
+    writeMs += ElapsedMs(before);
+    std::this_thread::sleep_until(
+        start + std::chrono::duration_cast<Clock::duration>(period * (n + 1)));
+  }
+  // Unpaced, the loop is nothing but writes (and building the records).
+  if (fps <= 0)
+    writeMs = ElapsedMs(start);
+  done.store(true, std::memory_order_release);
+  reader.join();
+  result.writeNs = writeMs * 1e6 / records;
+  return result;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const Args args(argc, argv);
+  const uint32_t records =
+      static_cast<uint32_t>(args.GetInt("--records", 2000000));
+  const uint32_t capacity =
+      static_cast<uint32_t>(args.GetInt("--capacity", 256));
+  const double fps = args.GetDouble("--fps", 0.0);
+
+  printf("%u records, capacity %u, %s\n", records, capacity,
+         fps > 0 ? "paced" : "unpaced");
+  const Result r = Run(records, capacity, fps);
+  printf("write %.1f ns/record, read %llu, lost %llu, inconsistent %llu, "
+         "%llu polls\n",
+         r.writeNs, static_cast<unsigned long long>(r.read),
+         static_cast<unsigned long long>(r.lost),
+         static_cast<unsigned long long>(r.bad),
+         static_cast<unsigned long long>(r.polls));
+  return r.bad == 0 ? 0 : 1;
+}
@@ -0,0 +1,220 @@
+// Offline footage path: writes a synthetic clip through VideoFileSink,
+// reads it back through the memory-mapped VideoFileSource and then runs
+// the clip through block matching, writing every source frame plus one
+// interpolated frame between each pair to a second file at twice the
+// rate. Reports per-frame cost of each stage and how often the producer
+// waited on the writer thread. The read-back is checked against the
+// rendered frames (bit-exact for raw, plane-exact against the same
+// BGRA-to-4:2:0 conversion for Y4M) and timestamps against the frame
+// rate. With --input an existing clip is used and the checks are
+// skipped. Exits non-zero on any mismatch or I/O failure.
+//
+//   video_bench [--format y4m|raw] [--width 1280] [--height 720]
+//               [--frames 120] [--fps 60] [--dir <temp>] [--keep]
+//               [--input clip.y4m | --input clip.bgra --width W --height H]
+//               [--threads 0]
+
+#include "../compute/BlockMatchInterpolator.h"
+#include "../compute/ThreadPool.h"
+#include "../compute/VideoFile.h"
+#include "../compute/YuvConvert.h"
+#include "BenchUtil.h"
+#include "SyntheticScene.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+using namespace DeepFrame;
+using namespace DeepFrame::Bench;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+bool SamePlane(const FrameView &a, const FrameView &b) {
+  const size_t rowBytes = static_cast<size_t>(a.width) * BytesPerPixel(a.format);
+  for (uint32_t y = 0; y < a.height; y++)
+    if (std::memcmp(a.Row(y), b.Row(y), rowBytes))
+      return false;
+  return true;
+}
+
+struct Totals {
+  double writeMs = 0.0;
+  double readMs = 0.0;
+  double convertMs = 0.0;
+  double interpolateMs = 0.0;
+  double outputMs = 0.0;
+  uint64_t frameMismatches = 0;
+  uint64_t timestampMismatches = 0;
+};
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Args args(argc, argv);
+  const std::string format = args.Get("--format", "y4m");
+  const bool raw = format == "raw";
+  uint32_t width = static_cast<uint32_t>(args.GetInt("--width", 1280));
+  uint32_t height = static_cast<uint32_t>(args.GetInt("--height", 720));
+  const uint32_t frames =
+      static_cast<uint32_t>(std::max(2L, args.GetInt("--frames", 120)));
+  const uint32_t fps = static_cast<uint32_t>(std::max(1L, args.GetInt("--fps", 60)));
+  const uint32_t threads =
+      static_cast<uint32_t>(std::max(0L, args.GetInt("--threads", 0)));
+  const char *input = args.Get("--input", nullptr);
+  const bool keep = args.Has("--keep");
+
+  std::error_code ec;
+  const fs::path dir = args.Get("--dir", fs::temp_directory_path(ec).c_str());
+  const fs::path clipPath = input ? fs::path(input)
+                                  : dir / (raw ? "video_bench_in.bgra"
+                                               : "video_bench_in.y4m");
+  const fs::path outPath =
+      dir / (raw ? "video_bench_out.bgra" : "video_bench_out.y4m");
+  const VideoFileFormat fileFormat =
+      raw ? VideoFileFormat::RawBgra : VideoFileFormat::Y4M;
+
+  std::unique_ptr<ThreadPool> pool;
+  if (threads != 1)
+    pool = std::make_unique<ThreadPool>(threads);
+
+  Totals totals;
+  bool ok = true;
+  SyntheticScene scene(width, height);
+  FrameBuffer rendered(width, height);
+
+  if (!input) {
+    VideoFileSink sink;
+    if (!sink.Open(clipPath, fileFormat, width, height, fps, 1)) {
+      fprintf(stderr, "cannot create %s\n", clipPath.string().c_str());
+      return 1;
+    }
+    for (uint32_t i = 0; i < frames; i++) {
+      scene.Render(i, rendered.view);
+      const auto start = Clock::now();
+      ok &= sink.Write(rendered.view);
+      totals.writeMs += ElapsedMs(start);
+    }
+    const auto start = Clock::now();
+    ok &= sink.Close();
+    const double drainMs = ElapsedMs(start);
+    const VideoSinkStats stats = sink.GetStats();
+    printf("write %u frames: %.3f ms/frame on the caller, %llu stalls "
+           "(%.1f ms), %.1f ms to drain, %.1f MB\n",
+           frames, totals.writeMs / frames,
+           static_cast<unsigned long long>(stats.stalls), stats.stallMs,
+           drainMs, static_cast<double>(stats.bytesWritten) / 1e6);
+  }
+
+  VideoFileSource source;
+  const bool opened = raw ? source.OpenRaw(clipPath, width, height, fps, 1)
+                          : source.OpenY4m(clipPath);
+  if (!opened) {
+    fprintf(stderr, "cannot open %s\n", clipPath.string().c_str());
+    return 1;
+  }
+  const VideoFileInfo &info = source.Info();
+  width = info.width;
+  height = info.height;
+  const uint64_t count = source.FrameCount();
+
+  // Read-back: the mapped frames against what was rendered.
+  std::vector<uint8_t> expectedYuv(
+      YuvFrameSize(ChromaLayout::Yuv420, width, height));
+  const YuvView expected = PackedYuvView(
+      expectedYuv.data(), ChromaLayout::Yuv420, width, height);
+  uint64_t touched = 0;
+  for (uint64_t i = 0; i < count; i++) {
+    const auto start = Clock::now();
+    VideoFrame frame;
+    ok &= source.Read(i, frame);
+    // Touch every page so the mapping is really read.
+    const FrameView &first = raw ? frame.bgra : frame.yuv.y;
+    for (uint32_t y = 0; y < first.height; y++)
+      touched += first.Row(y)[(y * 61) % first.width];
+    totals.readMs += ElapsedMs(start);
+
+    if (input)
+      continue;
+    totals.timestampMismatches +=
+        frame.timestampUs != static_cast<int64_t>(i * 1000000 / fps);
+    scene.Render(static_cast<double>(i), rendered.view);
+    if (raw) {
+      totals.frameMismatches += !SamePlane(frame.bgra, rendered.view);
+    } else {
+      ok &= BgraToYuv420(rendered.view, expected);
+      totals.frameMismatches += !SamePlane(frame.yuv.y, expected.y) ||
+                                !SamePlane(frame.yuv.u, expected.u) ||
+                                !SamePlane(frame.yuv.v, expected.v);
+    }
+  }
+
+  // The offline pipeline: decode, interpolate, write at twice the rate.
+  VideoFileSink output;
+  ok &= output.Open(outPath, fileFormat, width, height, info.fpsNum * 2,
+                    info.fpsDen);
+  BlockMatchInterpolator engine(pool.get());
+  FrameBuffer bgra[2] = {{width, height}, {width, height}};
+  FrameBuffer middle(width, height);
+  for (uint64_t i = 0; i < count; i++) {
+    FrameBuffer &curr = bgra[i % 2];
+    VideoFrame frame;
+    auto start = Clock::now();
+    ok &= source.Read(i, frame) && VideoFrameToBgra(frame, curr.view, pool.get());
+    totals.convertMs += ElapsedMs(start);
+    if (i > 0) {
+      start = Clock::now();
+      ok &= engine.Interpolate(bgra[(i + 1) % 2].view, curr.view, middle.view,
+                               0.5f);
+      totals.interpolateMs += ElapsedMs(start);
+      start = Clock::now();
+      ok &= output.Write(middle.view);
+      totals.outputMs += ElapsedMs(start);
+    }
+    start = Clock::now();
+    ok &= output.Write(curr.view);
+    totals.outputMs += ElapsedMs(start);
+  }
+  ok &= output.Close();
+  const VideoSinkStats outStats = output.GetStats();
+
+  const double n = static_cast<double>(count);
+  const double frameMb =
+      static_cast<double>(raw ? static_cast<size_t>(width) * height * 4
+                              : YuvFrameSize(info.chroma, width, height)) /
+      1e6;
+  printf("%s %ux%u %s, %llu frames at %u:%u, threads=%u\n",
+         clipPath.string().c_str(), width, height, raw ? "BGRA" : "Y4M",
+         static_cast<unsigned long long>(count), info.fpsNum, info.fpsDen,
+         pool ? pool->ThreadCount() : 1u);
+  printf("%-22s %8.3f ms/frame  %8.1f MB/s\n", "mapped read",
+         totals.readMs / n, frameMb * n / std::max(totals.readMs, 1e-6) * 1e3);
+  printf("%-22s %8.3f ms/frame\n", "read+to BGRA", totals.convertMs / n);
+  printf("%-22s %8.3f ms/pair\n", "interpolate",
+         totals.interpolateMs / std::max(n - 1, 1.0));
+  printf("%-22s %8.3f ms/frame  %llu stalls (%.1f ms)\n", "output write",
+         totals.outputMs / static_cast<double>(std::max<uint64_t>(
+                               outStats.framesWritten, 1)),
+         static_cast<unsigned long long>(outStats.stalls), outStats.stallMs);
+  printf("mismatches: frames %llu  timestamps %llu%s  (checksum %llu)\n",
+         static_cast<unsigned long long>(totals.frameMismatches),
+         static_cast<unsigned long long>(totals.timestampMismatches),
+         ok ? "" : "  (a call failed)",
+         static_cast<unsigned long long>(touched));
+
+  source.Close();
+  if (!keep) {
+    if (!input)
+      fs::remove(clipPath, ec);
+    fs::remove(outPath, ec);
+  }
+  const bool failed =
+      !ok || totals.frameMismatches || totals.timestampMismatches;
+  return failed ? 1 : 0;
+}
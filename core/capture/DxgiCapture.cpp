@@ -1,4 +1,7 @@
 #include "DxgiCapture.h"
+#include "../compute/FrameCrop.h"
+#include "../compute/Log.h"
+#include <algorithm>
 #include <iterator>
 #include <utility>
 #include <chrono> // Added for latency instrumentation
@@ -67,7 +70,7 @@ bool DxgiCapture::Initialize(uint32_t adapterIndex,
   }
 
   initialized_ = true;
-  fprintf(stderr, "[DeepFrame] Capture Pipeline Initialized. Mode: Async DXGI.\n");
+  Log::Info("[DeepFrame] Capture Pipeline Initialized. Mode: Async DXGI.\n");
   return true;
 }
 
@@ -80,9 +83,20 @@ void DxgiCapture::Shutdown() noexcept {
   duplication_.Reset();
   output_.Reset();
   adapter_.Reset();
+  // Pools with a frame still held by a consumer live on until the capture
+  // is destroyed.
+  if (surfaces_ && surfaces_->Reset()) {
+    surfaces_.reset();
+    surfaceDesc_ = {};
+    surfaceCharge_.Set(0);
+  }
+  TrimRetiredSurfaces();
   context_.Reset();
   device_.Reset();
 
+  pendingDirty_.Clear();
+  needFullFrame_ = true;
+  activeCrop_ = {};
   width_ = 0;
   height_ = 0;
   initialized_ = false;
@@ -92,13 +106,13 @@ bool DxgiCapture::CreateD3D11Device(uint32_t adapterIndex) noexcept {
   ComPtr<IDXGIFactory1> factory;
   HRESULT hr = CreateDXGIFactory1(IID_PPV_ARGS(&factory));
   if (FAILED(hr)) {
-    fprintf(stderr, "CreateDXGIFactory1 failed: 0x%08lX\n", hr);
+    Log::Error("CreateDXGIFactory1 failed: 0x%08lX\n", hr);
     return false;
   }
 
   hr = factory->EnumAdapters1(adapterIndex, &adapter_);
   if (FAILED(hr)) {
-    fprintf(stderr, "EnumAdapters1(%u) failed: 0x%08lX\n", adapterIndex, hr);
+    Log::Error("EnumAdapters1(%u) failed: 0x%08lX\n", adapterIndex, hr);
     return false;
   }
 
@@ -114,10 +128,10 @@ bool DxgiCapture::CreateD3D11Device(uint32_t adapterIndex) noexcept {
                          D3D11_SDK_VERSION, &device_, nullptr, &context_);
 
   if (FAILED(hr)) {
-    fprintf(stderr, "D3D11CreateDevice failed: 0x%08lX\n", hr);
+    Log::Error("D3D11CreateDevice failed: 0x%08lX\n", hr);
     return false;
   }
-  fprintf(stderr, "D3D11 device created successfully\n");
+  Log::Info("D3D11 device created successfully\n");
   return true;
 }
 
@@ -129,20 +143,20 @@ bool DxgiCapture::CreateDuplicationOutput(uint32_t outputIndex) noexcept {
   ComPtr<IDXGIOutput> output;
   HRESULT hr = adapter_->EnumOutputs(outputIndex, &output);
   if (FAILED(hr)) {
-    fprintf(stderr, "EnumOutputs(%u) failed: 0x%08lX\n", outputIndex, hr);
+    Log::Error("EnumOutputs(%u) failed: 0x%08lX\n", outputIndex, hr);
     return false;
   }
 
   hr = output.As(&output_);
   if (FAILED(hr)) {
-    fprintf(stderr, "Output.As<IDXGIOutput1> failed: 0x%08lX\n", hr);
+    Log::Error("Output.As<IDXGIOutput1> failed: 0x%08lX\n", hr);
     return false;
   }
 
   DXGI_OUTPUT_DESC desc;
   hr = output_->GetDesc(&desc);
   if (FAILED(hr)) {
-    fprintf(stderr, "GetDesc failed: 0x%08lX\n", hr);
+    Log::Error("GetDesc failed: 0x%08lX\n", hr);
     return false;
   }
 
@@ -150,14 +164,17 @@ bool DxgiCapture::CreateDuplicationOutput(uint32_t outputIndex) noexcept {
                                  desc.DesktopCoordinates.left);
   height_ = static_cast<uint32_t>(desc.DesktopCoordinates.bottom -
                                   desc.DesktopCoordinates.top);
-  fprintf(stderr, "Display: %ux%u\n", width_, height_);
+  outputLeft_ = desc.DesktopCoordinates.left;
+  outputTop_ = desc.DesktopCoordinates.top;
+  Log::Info("Display: %ux%u at (%d, %d)\n", width_, height_, outputLeft_,
+            outputTop_);
 
   hr = output_->DuplicateOutput(device_.Get(), &duplication_);
   if (FAILED(hr)) {
-    fprintf(stderr, "DuplicateOutput failed: 0x%08lX\n", hr);
+    Log::Error("DuplicateOutput failed: 0x%08lX\n", hr);
     return false;
   }
-  fprintf(stderr, "Desktop duplication initialized successfully\n");
+  Log::Info("Desktop duplication initialized successfully\n");
   return true;
 }
 
@@ -174,9 +191,120 @@ bool DxgiCapture::ReinitializeDuplication() noexcept {
   }
 
   HRESULT hr = output_->DuplicateOutput(device_.Get(), &duplication_);
+  needFullFrame_ = true;
   return SUCCEEDED(hr);
 }
 
+bool DxgiCapture::EnsureSurfaces(const D3D11_TEXTURE2D_DESC &srcDesc,
+                                 uint32_t width, uint32_t height) noexcept {
+  TrimRetiredSurfaces();
+  if (surfaces_ && width == surfaceDesc_.Width &&
+      height == surfaceDesc_.Height && srcDesc.Format == surfaceDesc_.Format) {
+    return true;
+  }
+
+  D3D11_TEXTURE2D_DESC dstDesc{};
+  dstDesc.Width = width;
+  dstDesc.Height = height;
+  dstDesc.MipLevels = 1;
+  dstDesc.ArraySize = 1;
+  dstDesc.Format = srcDesc.Format;
+  dstDesc.SampleDesc.Count = 1;
+  dstDesc.SampleDesc.Quality = 0;
+  dstDesc.Usage = D3D11_USAGE_DEFAULT;
+  dstDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS; // Added UAV for Compute
+  dstDesc.CPUAccessFlags = 0;
+  dstDesc.MiscFlags = 0;
+
+  // Frames of the old size may still be in the ring or the interpolator;
+  // their pool stays alive until they come back.
+  surfaceDesc_ = {};
+  try {
+    if (surfaces_ && !surfaces_->Reset())
+      retiredSurfaces_.push_back(std::move(surfaces_));
+    surfaces_ = std::make_unique<ResourcePool<ComPtr<ID3D11Texture2D>>>();
+  } catch (...) {
+    return false;
+  }
+
+  ID3D11Device *device = device_.Get();
+  if (!surfaces_->Initialize(kSurfaceCount,
+                             [&](ComPtr<ID3D11Texture2D> &texture) {
+                               return SUCCEEDED(device->CreateTexture2D(
+                                   &dstDesc, nullptr, &texture));
+                             })) {
+    surfaces_.reset();
+    surfaceCharge_.Set(0);
+    Log::Error("[DxgiCapture] Failed to build %ux%u surface pool\n", width,
+               height);
+    return false;
+  }
+  surfaceDesc_ = dstDesc;
+  surfaceCharge_.Set(kSurfaceCount * static_cast<size_t>(dstDesc.Width) *
+                     dstDesc.Height * 4);
+  return true;
+}
+
+void DxgiCapture::TrimRetiredSurfaces() noexcept {
+  retiredSurfaces_.erase(
+      std::remove_if(retiredSurfaces_.begin(), retiredSurfaces_.end(),
+                     [](const auto &pool) { return pool->Reset(); }),
+      retiredSurfaces_.end());
+}
+
+void DxgiCapture::CollectChanges(const DXGI_OUTDUPL_FRAME_INFO &info,
+                                 const TileRect &crop) noexcept {
+  if (needFullFrame_) {
+    pendingDirty_.SetFull();
+    needFullFrame_ = false;
+    return;
+  }
+  // Only the pointer moved; the desktop image is the same.
+  if (info.LastPresentTime.QuadPart == 0 || pendingDirty_.IsFull())
+    return;
+  if (info.TotalMetadataBufferSize == 0) {
+    pendingDirty_.SetFull();
+    return;
+  }
+
+  try {
+    if (metadata_.size() < info.TotalMetadataBufferSize)
+      metadata_.resize(info.TotalMetadataBufferSize);
+  } catch (...) {
+    pendingDirty_.SetFull();
+    return;
+  }
+  const UINT size = static_cast<UINT>(metadata_.size());
+  const uint32_t width = crop.right - crop.left;
+  const uint32_t height = crop.bottom - crop.top;
+  const auto add = [&](const RECT &r) {
+    const TileRect rect = {static_cast<uint32_t>(std::max<LONG>(r.left, 0)),
+                           static_cast<uint32_t>(std::max<LONG>(r.top, 0)),
+                           static_cast<uint32_t>(std::max<LONG>(r.right, 0)),
+                           static_cast<uint32_t>(std::max<LONG>(r.bottom, 0))};
+    pendingDirty_.Add(CropRect(rect, crop), width, height);
+  };
+
+  // A move only changes its destination; the source keeps its pixels
+  // unless a dirty rect says otherwise.
+  UINT used = 0;
+  auto *moves = reinterpret_cast<DXGI_OUTDUPL_MOVE_RECT *>(metadata_.data());
+  if (FAILED(duplication_->GetFrameMoveRects(size, moves, &used))) {
+    pendingDirty_.SetFull();
+    return;
+  }
+  for (UINT i = 0; i < used / sizeof(DXGI_OUTDUPL_MOVE_RECT); i++)
+    add(moves[i].DestinationRect);
+
+  auto *dirty = reinterpret_cast<RECT *>(metadata_.data());
+  if (FAILED(duplication_->GetFrameDirtyRects(size, dirty, &used))) {
+    pendingDirty_.SetFull();
+    return;
+  }
+  for (UINT i = 0; i < used / sizeof(RECT); i++)
+    add(dirty[i]);
+}
+
 CaptureResult DxgiCapture::AcquireFrame(CapturedFrame &frame,
                                         uint32_t timeoutMs) noexcept {
   // START LATENCY TIMER
@@ -235,30 +363,41 @@ CaptureResult DxgiCapture::AcquireFrame(CapturedFrame &frame,
   D3D11_TEXTURE2D_DESC srcDesc;
   desktopTexture->GetDesc(&srcDesc);
 
-  D3D11_TEXTURE2D_DESC dstDesc{};
-  dstDesc.Width = srcDesc.Width;
-  dstDesc.Height = srcDesc.Height;
-  dstDesc.MipLevels = 1;
-  dstDesc.ArraySize = 1;
-  dstDesc.Format = srcDesc.Format;
-  dstDesc.SampleDesc.Count = 1;
-  dstDesc.SampleDesc.Quality = 0;
-  dstDesc.Usage = D3D11_USAGE_DEFAULT;
-  dstDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS; // Added UAV for Compute
-  dstDesc.CPUAccessFlags = 0;
-  dstDesc.MiscFlags = 0;
+  // A crop that no longer meets the output falls back to all of it.
+  TileRect crop = ClipToOutput(crop_.left, crop_.top, crop_.right,
+                               crop_.bottom, srcDesc.Width, srcDesc.Height);
+  if (crop.Empty())
+    crop = {0, 0, srcDesc.Width, srcDesc.Height};
+  if (crop.left != activeCrop_.left || crop.top != activeCrop_.top ||
+      crop.right != activeCrop_.right || crop.bottom != activeCrop_.bottom) {
+    activeCrop_ = crop;
+    needFullFrame_ = true;
+  }
+  const uint32_t cropWidth = crop.right - crop.left;
+  const uint32_t cropHeight = crop.bottom - crop.top;
 
-  ComPtr<ID3D11Texture2D> copyTexture;
-  hr = device_->CreateTexture2D(&dstDesc, nullptr, &copyTexture);
-  if (FAILED(hr)) {
+  // Collected before anything can drop the frame, so the next delivered
+  // frame still reports these changes.
+  CollectChanges(frameInfo, crop);
+
+  if (!EnsureSurfaces(srcDesc, cropWidth, cropHeight)) {
     duplication_->ReleaseFrame();
     frameAcquired_ = false;
     return CaptureResult::InvalidCall;
   }
 
+  TextureLease surface = surfaces_->Acquire();
+  if (!surface) {
+    duplication_->ReleaseFrame();
+    frameAcquired_ = false;
+    return CaptureResult::PoolExhausted;
+  }
+
   // --- START PIPELINE SIMULATION ---
-  // 1. Capture Copy
-  context_->CopyResource(copyTexture.Get(), desktopTexture.Get());
+  // 1. Capture Copy, only the target window's part of the desktop
+  const D3D11_BOX box = {crop.left, crop.top, 0, crop.right, crop.bottom, 1};
+  context_->CopySubresourceRegion(surface->Get(), 0, 0, 0, 0,
+                                  desktopTexture.Get(), 0, &box);
   
   // 2. Compute Shader Scaling Dispatch (Placeholder)
   // In the full version, we bind the CS and dispatch here.
@@ -268,20 +407,26 @@ CaptureResult DxgiCapture::AcquireFrame(CapturedFrame &frame,
   context_->Flush(); 
   // --- END PIPELINE SIMULATION ---
 
-  frame.texture = std::move(copyTexture);
-  frame.width = srcDesc.Width;
-  frame.height = srcDesc.Height;
+  frame.surface = std::move(surface);
+  frame.width = cropWidth;
+  frame.height = cropHeight;
   frame.timestampQpc = frameInfo.LastPresentTime.QuadPart;
   frame.cursorVisible = frameInfo.PointerPosition.Visible != FALSE;
   frame.cursorX = frameInfo.PointerPosition.Position.x;
   frame.cursorY = frameInfo.PointerPosition.Position.y;
+  frame.frameIndex = ++frameIndex_;
+  frame.dirty = pendingDirty_;
+  pendingDirty_.Clear();
 
   // STOP LATENCY TIMER & LOG
   auto end = std::chrono::high_resolution_clock::now();
   std::chrono::duration<double, std::milli> elapsed = end - start;
   
-  // Print latency metrics to stderr (Terminal Proof)
-  fprintf(stderr, "[DeepFrame] Pipeline Latency: %.4f ms | Capture: OK\n", elapsed.count());
+  // Once a second at most; this runs for every captured frame.
+  static Log::RateLimiter latencyLog(1000);
+  latencyLog.Write(LogLevel::Debug,
+                   "[DeepFrame] Pipeline Latency: %.4f ms | Capture: OK\n",
+                   elapsed.count());
 
   return CaptureResult::Success;
 }
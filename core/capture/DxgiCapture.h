@@ -7,23 +7,41 @@
 #define WIN32_LEAN_AND_MEAN
 #endif
 
+#include "../compute/MemoryLedger.h"
+#include "../compute/RectList.h"
+#include "../compute/ResourcePool.h"
 #include <d3d11.h>
 #include <dxgi1_2.h>
 #include <wrl/client.h>
 #include <cstdint>
+#include <memory>
+#include <vector>
 
 namespace DeepFrame {
 
 using Microsoft::WRL::ComPtr;
 
+using TextureLease = PoolLease<ComPtr<ID3D11Texture2D>>;
+
 struct CapturedFrame {
-    ComPtr<ID3D11Texture2D> texture;
+    // Pooled copy of the cropped desktop; the surface goes back to the capture
+    // pool when the last copy of the lease is dropped.
+    TextureLease surface;
     uint32_t width;
     uint32_t height;
     int64_t timestampQpc;
     bool cursorVisible;
     int32_t cursorX;
     int32_t cursorY;
+    // Counts delivered frames from 1; `dirty` is what changed since the
+    // previous delivered frame, including any dropped in between.
+    uint64_t frameIndex;
+    RectList dirty;
+
+    [[nodiscard]] ID3D11Texture2D* Texture() const noexcept {
+        const ComPtr<ID3D11Texture2D>* texture = surface.Get();
+        return texture ? texture->Get() : nullptr;
+    }
 };
 
 enum class CaptureResult : uint8_t {
@@ -32,7 +50,9 @@ enum class CaptureResult : uint8_t {
     AccessLost,
     DeviceLost,
     InvalidCall,
-    Uninitialized
+    Uninitialized,
+    // Every pooled surface is still leased; the frame was dropped.
+    PoolExhausted
 };
 
 class DxgiCapture final {
@@ -55,21 +75,63 @@ public:
     [[nodiscard]] ID3D11DeviceContext* GetContext() const noexcept { return context_.Get(); }
     [[nodiscard]] uint32_t GetWidth() const noexcept { return width_; }
     [[nodiscard]] uint32_t GetHeight() const noexcept { return height_; }
+    // Top-left of the output on the virtual desktop, for mapping window
+    // rects into output pixels.
+    [[nodiscard]] int32_t GetOutputLeft() const noexcept { return outputLeft_; }
+    [[nodiscard]] int32_t GetOutputTop() const noexcept { return outputTop_; }
     [[nodiscard]] bool IsInitialized() const noexcept { return initialized_; }
+    [[nodiscard]] PoolStats GetSurfaceStats() const noexcept {
+        return surfaces_ ? surfaces_->GetStats() : PoolStats{};
+    }
+
+    // Part of the output later frames are copied from, in output pixels;
+    // empty for the whole output. Frames take the size of the crop, and
+    // their dirty rects are relative to it. Same thread as AcquireFrame.
+    void SetCrop(const TileRect& crop) noexcept { crop_ = crop; }
+
+    // Capture ring, the two frames held by the interpolator and the one
+    // being acquired, plus slack for a slow consumer.
+    static constexpr size_t kSurfaceCount = 8;
 
 private:
     [[nodiscard]] bool CreateD3D11Device(uint32_t adapterIndex) noexcept;
     [[nodiscard]] bool CreateDuplicationOutput(uint32_t outputIndex) noexcept;
     [[nodiscard]] bool ReinitializeDuplication() noexcept;
+    [[nodiscard]] bool EnsureSurfaces(const D3D11_TEXTURE2D_DESC& srcDesc, uint32_t width,
+                                      uint32_t height) noexcept;
+    // Drops retired pools whose leases have all come back.
+    void TrimRetiredSurfaces() noexcept;
+    // Adds the frame's move destinations and dirty rects inside `crop` to
+    // pendingDirty_.
+    void CollectChanges(const DXGI_OUTDUPL_FRAME_INFO& info, const TileRect& crop) noexcept;
 
     ComPtr<ID3D11Device> device_;
     ComPtr<ID3D11DeviceContext> context_;
     ComPtr<IDXGIOutputDuplication> duplication_;
     ComPtr<IDXGIOutput1> output_;
     ComPtr<IDXGIAdapter1> adapter_;
+    // A resize cannot wait for every frame of the old size to come back,
+    // so the old pool is retired and freed once it has drained.
+    std::unique_ptr<ResourcePool<ComPtr<ID3D11Texture2D>>> surfaces_;
+    std::vector<std::unique_ptr<ResourcePool<ComPtr<ID3D11Texture2D>>>> retiredSurfaces_;
+    D3D11_TEXTURE2D_DESC surfaceDesc_{};
+    // The live pool only; retired pools drain within a few frames.
+    MemoryCharge surfaceCharge_{MemorySubsystem::Capture, MemoryDomain::Gpu};
+
+    TileRect crop_{};
+    TileRect activeCrop_{};
+
+    std::vector<uint8_t> metadata_;
+    RectList pendingDirty_;
+    uint64_t frameIndex_ = 0;
+    // Set until the first frame of a duplication, whose rects only cover
+    // what changed since some frame nobody saw.
+    bool needFullFrame_ = true;
 
     uint32_t width_ = 0;
     uint32_t height_ = 0;
+    int32_t outputLeft_ = 0;
+    int32_t outputTop_ = 0;
     uint32_t outputIndex_ = 0;
     bool initialized_ = false;
     bool frameAcquired_ = false;
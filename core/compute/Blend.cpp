@@ -0,0 +1,258 @@
+#include "Blend.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(DEEPFRAME_SSE2)
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define DEEPFRAME_TARGET_AVX2
+#else
+#define DEEPFRAME_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace DeepFrame {
+
+void BlendRowScalar(const uint8_t *__restrict a, const uint8_t *__restrict b,
+                    uint8_t *__restrict dst, size_t bytes,
+                    uint32_t weight256) noexcept {
+  const int32_t w = static_cast<int32_t>(weight256);
+  for (size_t i = 0; i < bytes; i++) {
+    const int32_t va = a[i];
+    dst[i] = static_cast<uint8_t>(va + (((b[i] - va) * w + 128) >> 8));
+  }
+}
+
+// The SIMD variants evaluate (a * (256 - w) + b * w + 128) >> 8 in unsigned
+// 16-bit lanes, which is the same value without needing signed products.
+
+#if defined(DEEPFRAME_SSE2)
+
+namespace {
+
+// Streaming stores skip the read-for-ownership of the destination line, which
+// is a third of the traffic when whole frames are blended into memory that
+// is not read again soon.
+template <bool kStream>
+inline void BlendSse2(const uint8_t *a, const uint8_t *b, uint8_t *dst,
+                      size_t bytes, uint32_t weight256) noexcept {
+  const __m128i wb = _mm_set1_epi16(static_cast<short>(weight256));
+  const __m128i wa = _mm_set1_epi16(static_cast<short>(256 - weight256));
+  const __m128i round = _mm_set1_epi16(128);
+  const __m128i zero = _mm_setzero_si128();
+
+  size_t i = 0;
+  if (kStream) {
+    // Scalar head up to the first 16-byte aligned destination.
+    const size_t head = std::min(
+        bytes, (16 - (reinterpret_cast<uintptr_t>(dst) & 15)) & 15);
+    BlendRowScalar(a, b, dst, head, weight256);
+    i = head;
+  }
+  for (; i + 16 <= bytes; i += 16) {
+    const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+    const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+    __m128i lo = _mm_add_epi16(
+        _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(va, zero), wa),
+                      _mm_mullo_epi16(_mm_unpacklo_epi8(vb, zero), wb)),
+        round);
+    __m128i hi = _mm_add_epi16(
+        _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(va, zero), wa),
+                      _mm_mullo_epi16(_mm_unpackhi_epi8(vb, zero), wb)),
+        round);
+    lo = _mm_srli_epi16(lo, 8);
+    hi = _mm_srli_epi16(hi, 8);
+    const __m128i packed = _mm_packus_epi16(lo, hi);
+    if (kStream)
+      _mm_stream_si128(reinterpret_cast<__m128i *>(dst + i), packed);
+    else
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), packed);
+  }
+  BlendRowScalar(a + i, b + i, dst + i, bytes - i, weight256);
+}
+
+template <bool kStream>
+DEEPFRAME_TARGET_AVX2 inline void
+BlendAvx2(const uint8_t *a, const uint8_t *b, uint8_t *dst, size_t bytes,
+          uint32_t weight256) noexcept {
+  const __m256i wb = _mm256_set1_epi16(static_cast<short>(weight256));
+  const __m256i wa = _mm256_set1_epi16(static_cast<short>(256 - weight256));
+  const __m256i round = _mm256_set1_epi16(128);
+  const __m256i zero = _mm256_setzero_si256();
+
+  size_t i = 0;
+  if (kStream) {
+    const size_t head = std::min(
+        bytes, (32 - (reinterpret_cast<uintptr_t>(dst) & 31)) & 31);
+    BlendRowScalar(a, b, dst, head, weight256);
+    i = head;
+  }
+  for (; i + 32 <= bytes; i += 32) {
+    const __m256i va =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+    const __m256i vb =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+    // unpack/pack both work within 128-bit lanes, so the byte order
+    // survives the round trip.
+    __m256i lo = _mm256_add_epi16(
+        _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(va, zero), wa),
+                         _mm256_mullo_epi16(_mm256_unpacklo_epi8(vb, zero), wb)),
+        round);
+    __m256i hi = _mm256_add_epi16(
+        _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(va, zero), wa),
+                         _mm256_mullo_epi16(_mm256_unpackhi_epi8(vb, zero), wb)),
+        round);
+    lo = _mm256_srli_epi16(lo, 8);
+    hi = _mm256_srli_epi16(hi, 8);
+    const __m256i packed = _mm256_packus_epi16(lo, hi);
+    if (kStream)
+      _mm256_stream_si256(reinterpret_cast<__m256i *>(dst + i), packed);
+    else
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), packed);
+  }
+  BlendSse2<false>(a + i, b + i, dst + i, bytes - i, weight256);
+}
+
+} // namespace
+
+void BlendRowSse2(const uint8_t *a, const uint8_t *b, uint8_t *dst,
+                  size_t bytes, uint32_t weight256) noexcept {
+  BlendSse2<false>(a, b, dst, bytes, weight256);
+}
+
+void BlendRowSse2Stream(const uint8_t *a, const uint8_t *b, uint8_t *dst,
+                        size_t bytes, uint32_t weight256) noexcept {
+  BlendSse2<true>(a, b, dst, bytes, weight256);
+}
+
+DEEPFRAME_TARGET_AVX2
+void BlendRowAvx2(const uint8_t *a, const uint8_t *b, uint8_t *dst,
+                  size_t bytes, uint32_t weight256) noexcept {
+  BlendAvx2<false>(a, b, dst, bytes, weight256);
+}
+
+DEEPFRAME_TARGET_AVX2
+void BlendRowAvx2Stream(const uint8_t *a, const uint8_t *b, uint8_t *dst,
+                        size_t bytes, uint32_t weight256) noexcept {
+  BlendAvx2<true>(a, b, dst, bytes, weight256);
+}
+
+#elif defined(DEEPFRAME_NEON)
+
+void BlendRowNeon(const uint8_t *a, const uint8_t *b, uint8_t *dst,
+                  size_t bytes, uint32_t weight256) noexcept {
+  const uint16x8_t wb = vdupq_n_u16(static_cast<uint16_t>(weight256));
+  const uint16x8_t wa = vdupq_n_u16(static_cast<uint16_t>(256 - weight256));
+  const uint16x8_t round = vdupq_n_u16(128);
+
+  size_t i = 0;
+  for (; i + 16 <= bytes; i += 16) {
+    const uint8x16_t va = vld1q_u8(a + i);
+    const uint8x16_t vb = vld1q_u8(b + i);
+    uint16x8_t lo = vmlaq_u16(vmlaq_u16(round, vmovl_u8(vget_low_u8(va)), wa),
+                              vmovl_u8(vget_low_u8(vb)), wb);
+    uint16x8_t hi =
+        vmlaq_u16(vmlaq_u16(round, vmovl_u8(vget_high_u8(va)), wa),
+                  vmovl_u8(vget_high_u8(vb)), wb);
+    vst1q_u8(dst + i, vcombine_u8(vshrn_n_u16(lo, 8), vshrn_n_u16(hi, 8)));
+  }
+  BlendRowScalar(a + i, b + i, dst + i, bytes - i, weight256);
+}
+
+#endif
+
+bool CpuSupportsAvx2() noexcept {
+#if defined(DEEPFRAME_SSE2) && defined(_MSC_VER)
+  int regs[4];
+  __cpuid(regs, 1);
+  const bool osxsave = (regs[2] & (1 << 27)) != 0;
+  const bool avx = (regs[2] & (1 << 28)) != 0;
+  if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+    return false;
+  __cpuidex(regs, 7, 0);
+  return (regs[1] & (1 << 5)) != 0;
+#elif defined(DEEPFRAME_SSE2)
+  return __builtin_cpu_supports("avx2");
+#else
+  return false;
+#endif
+}
+
+namespace {
+
+struct BlendDispatch {
+  BlendRowFn fn;
+  // Whole-row variant with streaming stores, for blending entire frames.
+  BlendRowFn streamFn;
+  const char *isa;
+};
+
+const BlendDispatch &Dispatch() noexcept {
+  static const BlendDispatch dispatch = []() -> BlendDispatch {
+#if defined(DEEPFRAME_SSE2)
+    if (CpuSupportsAvx2())
+      return {BlendRowAvx2, BlendRowAvx2Stream, "avx2"};
+    return {BlendRowSse2, BlendRowSse2Stream, "sse2"};
+#elif defined(DEEPFRAME_NEON)
+    return {BlendRowNeon, BlendRowNeon, "neon"};
+#else
+    return {BlendRowScalar, BlendRowScalar, "scalar"};
+#endif
+  }();
+  return dispatch;
+}
+
+} // namespace
+
+void BlendRow(const uint8_t *a, const uint8_t *b, uint8_t *dst, size_t bytes,
+              uint32_t weight256) noexcept {
+  Dispatch().fn(a, b, dst, bytes, weight256);
+}
+
+const char *BlendRowIsa() noexcept { return Dispatch().isa; }
+
+uint32_t BlendWeight256(float t, float temporalBlend) noexcept {
+  t = std::clamp(t, 0.f, 1.f);
+  const float blend = std::clamp(temporalBlend, 0.f, 1.f);
+  const float weight = blend * t + (1.f - blend) * (t >= 0.5f ? 1.f : 0.f);
+  return static_cast<uint32_t>(std::lround(weight * 256.f));
+}
+
+bool BlendFrames(const FrameView &prev, const FrameView &curr,
+                 const FrameView &out, float t, float temporalBlend,
+                 ThreadPool *pool) noexcept {
+  if (!prev.IsValid() || !curr.IsValid() || !out.IsValid() ||
+      prev.format != curr.format || out.format != curr.format ||
+      prev.width != curr.width || prev.height != curr.height ||
+      out.width != curr.width || out.height != curr.height) {
+    return false;
+  }
+
+  const uint32_t weight256 = BlendWeight256(t, temporalBlend);
+  const size_t bytes =
+      static_cast<size_t>(curr.width) * BytesPerPixel(curr.format);
+  const BlendRowFn fn = Dispatch().streamFn;
+
+  auto blendRows = [&](size_t begin, size_t end) {
+    for (size_t y = begin; y < end; y++) {
+      const uint32_t row = static_cast<uint32_t>(y);
+      fn(prev.Row(row), curr.Row(row), out.Row(row), bytes, weight256);
+    }
+#if defined(DEEPFRAME_SSE2)
+    // Streaming stores are weakly ordered; publish them before the pool
+    // reports the chunk done.
+    _mm_sfence();
+#endif
+  };
+
+  if (pool) {
+    pool->ParallelFor(curr.height, 16, blendRows);
+  } else {
+    blendRows(0, curr.height);
+  }
+  return true;
+}
+
+} // namespace DeepFrame
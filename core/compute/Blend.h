@@ -0,0 +1,53 @@
+#pragma once
+
+#include "FrameView.h"
+#include "Simd.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace DeepFrame {
+
+class ThreadPool;
+
+// Per-byte fixed-point lerp: dst = a + ((b - a) * weight256 + 128) >> 8,
+// weight in 1/256 steps (0 = a, 256 = b). Every variant produces the same
+// bytes as the scalar reference.
+using BlendRowFn = void (*)(const uint8_t *a, const uint8_t *b, uint8_t *dst,
+                            size_t bytes, uint32_t weight256);
+
+void BlendRowScalar(const uint8_t *a, const uint8_t *b, uint8_t *dst,
+                    size_t bytes, uint32_t weight256) noexcept;
+#if defined(DEEPFRAME_SSE2)
+void BlendRowSse2(const uint8_t *a, const uint8_t *b, uint8_t *dst,
+                  size_t bytes, uint32_t weight256) noexcept;
+// Only call when CpuSupportsAvx2().
+void BlendRowAvx2(const uint8_t *a, const uint8_t *b, uint8_t *dst,
+                  size_t bytes, uint32_t weight256) noexcept;
+// Non-temporal stores; callers issue _mm_sfence() before publishing dst.
+void BlendRowSse2Stream(const uint8_t *a, const uint8_t *b, uint8_t *dst,
+                        size_t bytes, uint32_t weight256) noexcept;
+void BlendRowAvx2Stream(const uint8_t *a, const uint8_t *b, uint8_t *dst,
+                        size_t bytes, uint32_t weight256) noexcept;
+#elif defined(DEEPFRAME_NEON)
+void BlendRowNeon(const uint8_t *a, const uint8_t *b, uint8_t *dst,
+                  size_t bytes, uint32_t weight256) noexcept;
+#endif
+
+[[nodiscard]] bool CpuSupportsAvx2() noexcept;
+
+// Widest variant the running CPU supports, resolved once.
+void BlendRow(const uint8_t *a, const uint8_t *b, uint8_t *dst, size_t bytes,
+              uint32_t weight256) noexcept;
+[[nodiscard]] const char *BlendRowIsa() noexcept;
+
+// Weight of the later frame at t. temporalBlend 1 blends linearly, 0 snaps
+// to the temporally nearest frame.
+[[nodiscard]] uint32_t BlendWeight256(float t, float temporalBlend) noexcept;
+
+// Cheapest interpolation there is: a cross-fade of the two frames at t.
+[[nodiscard]] bool BlendFrames(const FrameView &prev, const FrameView &curr,
+                               const FrameView &out, float t,
+                               float temporalBlend = 1.f,
+                               ThreadPool *pool = nullptr) noexcept;
+
+} // namespace DeepFrame
@@ -0,0 +1,546 @@
+#include "BlockMatchInterpolator.h"
+#include "Blend.h"
+#include "Simd.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cmath>
+
+namespace DeepFrame {
+
+namespace {
+
+constexpr uint32_t kBlockPixels = BlockMatchInterpolator::kBlockSize *
+                                  BlockMatchInterpolator::kBlockSize;
+// SAD penalty per pixel of vector length; biases flat areas toward the
+// shortest vector instead of noise-driven matches.
+constexpr uint32_t kLambda = 4;
+constexpr int kRefineSteps = 4;
+// Temporal search re-seeds from a full hierarchical search this often so
+// errors in the history cannot persist indefinitely.
+constexpr uint32_t kHistoryRefresh = 60;
+// Grid step of the fallback search for blocks the predictors miss.
+constexpr int32_t kRescueStep = 4;
+
+struct BlockGrid {
+  uint32_t cols;
+  uint32_t rows;
+  int32_t maxX;
+  int32_t maxY;
+};
+
+BlockGrid GridFor(const LumaImage &img) noexcept {
+  constexpr uint32_t bs = BlockMatchInterpolator::kBlockSize;
+  return {(img.width + bs - 1) / bs, (img.height + bs - 1) / bs,
+          static_cast<int32_t>(img.width - bs),
+          static_cast<int32_t>(img.height - bs)};
+}
+
+// Blocks on the right/bottom edge are shifted inward so every SAD reads a
+// full 16x16 window inside the image.
+inline int32_t BlockOrigin(uint32_t index, int32_t maxOrigin) noexcept {
+  return std::min(static_cast<int32_t>(
+                      index * BlockMatchInterpolator::kBlockSize),
+                  maxOrigin);
+}
+
+inline uint32_t VectorPenalty(int32_t vx, int32_t vy) noexcept {
+  return kLambda * static_cast<uint32_t>(std::abs(vx) + std::abs(vy));
+}
+
+inline int32_t RoundScaled(float t, int32_t v) noexcept {
+  return static_cast<int32_t>(std::lround(t * static_cast<float>(v)));
+}
+
+// Greedy +-1 descent around the current best vector.
+template <typename Consider>
+void Refine(const int32_t &bestX, const int32_t &bestY,
+            Consider &&consider) noexcept {
+  for (int step = 0; step < kRefineSteps; step++) {
+    const int32_t cx = bestX;
+    const int32_t cy = bestY;
+    for (int32_t dy = -1; dy <= 1; dy++)
+      for (int32_t dx = -1; dx <= 1; dx++)
+        if (dx || dy)
+          consider(cx + dx, cy + dy);
+    if (cx == bestX && cy == bestY)
+      break;
+  }
+}
+
+} // namespace
+
+void BlockMatchInterpolator::ForBlockRows(uint32_t rows, RangeFn fn) noexcept {
+  if (pool_) {
+    pool_->ParallelFor(rows, 1, fn);
+  } else {
+    fn(0, rows);
+  }
+}
+
+bool BlockMatchInterpolator::Interpolate(const FrameView &prev,
+                                         const FrameView &curr,
+                                         const FrameView &out, float t,
+                                         const TileChangeMap *changes) noexcept {
+  resampleWidth_ = 0;
+  resampleHeight_ = 0;
+  if (!prev.IsValid() || !curr.IsValid() || !out.IsValid() ||
+      prev.format != PixelFormat::BGRA8 || curr.format != PixelFormat::BGRA8 ||
+      out.format != PixelFormat::BGRA8 || prev.width != curr.width ||
+      prev.height != curr.height || out.width != curr.width ||
+      out.height != curr.height || curr.width < kBlockSize ||
+      curr.height < kBlockSize) {
+    return false;
+  }
+
+  if (changes && !changes->Matches(curr.width, curr.height))
+    changes = nullptr;
+  if (changes && !changes->AnyChanged()) {
+    changes->CopyUnchanged(curr, out);
+    staticBlocks_ = ((curr.width + kBlockSize - 1) / kBlockSize) *
+                    ((curr.height + kBlockSize - 1) / kBlockSize);
+    return true;
+  }
+
+  t = std::clamp(t, 0.f, 1.f);
+  const int32_t radius = std::max(0, params_.searchRadius);
+
+  const uint32_t cols = (curr.width + kBlockSize - 1) / kBlockSize;
+  const uint32_t rows = (curr.height + kBlockSize - 1) / kBlockSize;
+  const bool temporal = params_.search == MotionSearch::Temporal &&
+                        historyValid_ && historyAge_ < kHistoryRefresh &&
+                        historyForward_.cols == cols &&
+                        historyForward_.rows == rows;
+
+  // Each level halves the residual search radius; stop once the coarsest
+  // full search is small or the image gets too small for whole blocks.
+  uint32_t levels = 1;
+  while (!temporal && params_.search != MotionSearch::Exhaustive &&
+         levels < 4 && (radius >> levels) >= 4 &&
+         (curr.width >> levels) >= 2 * kBlockSize &&
+         (curr.height >> levels) >= 2 * kBlockSize) {
+    levels++;
+  }
+
+  try {
+    prevPyramid_.Build(prev, levels, pool_);
+    currPyramid_.Build(curr, levels, pool_);
+    if (forward_.size() < levels) {
+      forward_.resize(levels);
+      backward_.resize(levels);
+    }
+  } catch (...) {
+    return false;
+  }
+
+  candidates_.store(0, std::memory_order_relaxed);
+  if (temporal) {
+    const uint32_t staticSad = static_cast<uint32_t>(
+        std::max(0.f, params_.diffThreshold) * kBlockPixels);
+    const uint32_t rescueSad = 2 * std::max(staticSad, historyMeanCost_);
+    EstimateTemporal(prevPyramid_.Level(0), currPyramid_.Level(0),
+                     historyForward_, forward_[0], radius, rescueSad, changes);
+    EstimateTemporal(currPyramid_.Level(0), prevPyramid_.Level(0),
+                     historyBackward_, backward_[0], radius, rescueSad,
+                     changes);
+    historyAge_++;
+  }
+
+  for (int32_t level = temporal ? -1 : static_cast<int32_t>(levels) - 1;
+       level >= 0; level--) {
+    const MotionField *coarseF =
+        level + 1 < static_cast<int32_t>(levels) ? &forward_[level + 1]
+                                                 : nullptr;
+    const MotionField *coarseB =
+        level + 1 < static_cast<int32_t>(levels) ? &backward_[level + 1]
+                                                 : nullptr;
+    const int32_t levelRadius = std::max(1, radius >> level);
+    // Coarse levels are cheap and feed predictors into changed regions,
+    // so only full resolution honours the change map.
+    const TileChangeMap *levelChanges = level == 0 ? changes : nullptr;
+    EstimateLevel(prevPyramid_.Level(level), currPyramid_.Level(level),
+                  coarseF, forward_[level], levelRadius, levelChanges);
+    EstimateLevel(currPyramid_.Level(level), prevPyramid_.Level(level),
+                  coarseB, backward_[level], levelRadius, levelChanges);
+  }
+
+  candidatesPerBlock_ =
+      static_cast<float>(candidates_.load(std::memory_order_relaxed)) /
+      static_cast<float>(2 * cols * rows);
+
+  SelectBilateral(prevPyramid_.Level(0), currPyramid_.Level(0), t, changes);
+  Compensate(prev, curr, out, t, changes);
+  if (!changes) {
+    resampleWidth_ = curr.width;
+    resampleHeight_ = curr.height;
+  }
+
+  // This pair's curr is the next pair's prev, so its fields predict the
+  // next search.
+  try {
+    historyForward_ = forward_[0];
+    historyBackward_ = backward_[0];
+  } catch (...) {
+    historyValid_ = false;
+    return true;
+  }
+  uint64_t costSum = 0;
+  for (uint32_t c : historyForward_.costs)
+    costSum += c;
+  for (uint32_t c : historyBackward_.costs)
+    costSum += c;
+  historyMeanCost_ = static_cast<uint32_t>(costSum / (2ull * cols * rows));
+  if (!temporal)
+    historyAge_ = 0;
+  historyValid_ = true;
+  return true;
+}
+
+bool BlockMatchInterpolator::Resample(const FrameView &prev,
+                                      const FrameView &curr,
+                                      const FrameView &out, float t) noexcept {
+  if (!prev.IsValid() || !curr.IsValid() || !out.IsValid() ||
+      out.format != PixelFormat::BGRA8 || curr.width != resampleWidth_ ||
+      curr.height != resampleHeight_ || prev.width != curr.width ||
+      prev.height != curr.height || out.width != curr.width ||
+      out.height != curr.height) {
+    return false;
+  }
+  t = std::clamp(t, 0.f, 1.f);
+  SelectBilateral(prevPyramid_.Level(0), currPyramid_.Level(0), t, nullptr);
+  Compensate(prev, curr, out, t, nullptr);
+  return true;
+}
+
+void BlockMatchInterpolator::EstimateLevel(const LumaImage &src,
+                                           const LumaImage &dst,
+                                           const MotionField *coarse,
+                                           MotionField &field,
+                                           int32_t radius,
+                                           const TileChangeMap *changes) noexcept {
+  const BlockGrid grid = GridFor(src);
+  field.Resize(grid.cols, grid.rows);
+
+  const uint32_t staticSad = static_cast<uint32_t>(
+      std::max(0.f, params_.diffThreshold) * kBlockPixels);
+
+  ForBlockRows(grid.rows, [&](size_t begin, size_t end) {
+    uint64_t evaluated = 0;
+    for (uint32_t by = static_cast<uint32_t>(begin); by < end; by++) {
+      for (uint32_t bx = 0; bx < grid.cols; bx++) {
+        const int32_t ox = BlockOrigin(bx, grid.maxX);
+        const int32_t oy = BlockOrigin(by, grid.maxY);
+        const size_t idx = static_cast<size_t>(by) * grid.cols + bx;
+        if (changes && !changes->IsPixelChanged(bx * kBlockSize,
+                                                by * kBlockSize)) {
+          field.vectors[idx] = MotionVector{};
+          field.costs[idx] = 0;
+          continue;
+        }
+        const uint8_t *block = src.Row(oy) + ox;
+
+        auto cost = [&](int32_t vx, int32_t vy) -> uint32_t {
+          const int32_t px = ox + vx;
+          const int32_t py = oy + vy;
+          if (px < 0 || py < 0 || px > grid.maxX || py > grid.maxY ||
+              std::abs(vx) > radius || std::abs(vy) > radius) {
+            return UINT32_MAX;
+          }
+          evaluated++;
+          return Sad16x16(block, src.pitch, dst.Row(py) + px, dst.pitch) +
+                 VectorPenalty(vx, vy);
+        };
+
+        int32_t bestX = 0;
+        int32_t bestY = 0;
+        uint32_t bestCost = cost(0, 0);
+
+        if (bestCost > staticSad) {
+          auto consider = [&](int32_t vx, int32_t vy) {
+            uint32_t c = cost(vx, vy);
+            if (c < bestCost) {
+              bestCost = c;
+              bestX = vx;
+              bestY = vy;
+            }
+          };
+
+          if (!coarse) {
+            for (int32_t vy = -radius; vy <= radius; vy++)
+              for (int32_t vx = -radius; vx <= radius; vx++)
+                consider(vx, vy);
+          } else {
+            const int32_t pc = static_cast<int32_t>(
+                std::min(bx / 2, coarse->cols - 1));
+            const int32_t pr = static_cast<int32_t>(
+                std::min(by / 2, coarse->rows - 1));
+            static constexpr int32_t kNeighbors[5][2] = {
+                {0, 0}, {-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+            for (const auto &n : kNeighbors) {
+              const int32_t c = pc + n[0];
+              const int32_t r = pr + n[1];
+              if (c < 0 || r < 0 || c >= static_cast<int32_t>(coarse->cols) ||
+                  r >= static_cast<int32_t>(coarse->rows)) {
+                continue;
+              }
+              const MotionVector &mv = coarse->At(c, r);
+              consider(mv.x * 2, mv.y * 2);
+            }
+            Refine(bestX, bestY, consider);
+          }
+        }
+
+        field.vectors[idx] = {static_cast<int16_t>(bestX),
+                              static_cast<int16_t>(bestY)};
+        field.costs[idx] = bestCost;
+      }
+    }
+    candidates_.fetch_add(evaluated, std::memory_order_relaxed);
+  });
+}
+
+void BlockMatchInterpolator::EstimateTemporal(
+    const LumaImage &src, const LumaImage &dst, const MotionField &history,
+    MotionField &field, int32_t radius, uint32_t rescueSad,
+    const TileChangeMap *changes) noexcept {
+  const BlockGrid grid = GridFor(src);
+  field.Resize(grid.cols, grid.rows);
+
+  const uint32_t staticSad = static_cast<uint32_t>(
+      std::max(0.f, params_.diffThreshold) * kBlockPixels);
+
+  ForBlockRows(grid.rows, [&](size_t begin, size_t end) {
+    uint64_t evaluated = 0;
+    for (uint32_t by = static_cast<uint32_t>(begin); by < end; by++) {
+      for (uint32_t bx = 0; bx < grid.cols; bx++) {
+        const int32_t ox = BlockOrigin(bx, grid.maxX);
+        const int32_t oy = BlockOrigin(by, grid.maxY);
+        const size_t idx = static_cast<size_t>(by) * grid.cols + bx;
+        if (changes && !changes->IsPixelChanged(bx * kBlockSize,
+                                                by * kBlockSize)) {
+          field.vectors[idx] = MotionVector{};
+          field.costs[idx] = 0;
+          continue;
+        }
+        const uint8_t *block = src.Row(oy) + ox;
+
+        auto cost = [&](int32_t vx, int32_t vy) -> uint32_t {
+          const int32_t px = ox + vx;
+          const int32_t py = oy + vy;
+          if (px < 0 || py < 0 || px > grid.maxX || py > grid.maxY ||
+              std::abs(vx) > radius || std::abs(vy) > radius) {
+            return UINT32_MAX;
+          }
+          evaluated++;
+          return Sad16x16(block, src.pitch, dst.Row(py) + px, dst.pitch) +
+                 VectorPenalty(vx, vy);
+        };
+
+        int32_t bestX = 0;
+        int32_t bestY = 0;
+        uint32_t bestCost = cost(0, 0);
+
+        if (bestCost > staticSad) {
+          auto consider = [&](int32_t vx, int32_t vy) {
+            uint32_t c = cost(vx, vy);
+            if (c < bestCost) {
+              bestCost = c;
+              bestX = vx;
+              bestY = vy;
+            }
+          };
+
+          // Temporal predictors from the co-located block and its
+          // neighbours, plus the spatial predictor already solved to the
+          // left; duplicates are common in coherent motion.
+          MotionVector tried[7];
+          uint32_t triedCount = 0;
+          tried[triedCount++] = MotionVector{};
+          auto predict = [&](const MotionVector &mv) {
+            for (uint32_t i = 0; i < triedCount; i++)
+              if (tried[i] == mv)
+                return;
+            tried[triedCount++] = mv;
+            consider(mv.x, mv.y);
+          };
+
+          static constexpr int32_t kNeighbors[5][2] = {
+              {0, 0}, {-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+          for (const auto &n : kNeighbors) {
+            const int32_t c = static_cast<int32_t>(bx) + n[0];
+            const int32_t r = static_cast<int32_t>(by) + n[1];
+            if (c < 0 || r < 0 || c >= static_cast<int32_t>(grid.cols) ||
+                r >= static_cast<int32_t>(grid.rows)) {
+              continue;
+            }
+            predict(history.At(c, r));
+          }
+          if (bx > 0)
+            predict(field.vectors[idx - 1]);
+          Refine(bestX, bestY, consider);
+
+          // New or accelerating content the predictors cannot reach. A
+          // search that finds no good match either (content entering at
+          // the frame edge, occlusions) keeps the predicted vector rather
+          // than an arbitrary noise match.
+          if (bestCost > rescueSad) {
+            const int32_t predX = bestX;
+            const int32_t predY = bestY;
+            const uint32_t predCost = bestCost;
+            for (int32_t vy = -radius; vy <= radius; vy += kRescueStep)
+              for (int32_t vx = -radius; vx <= radius; vx += kRescueStep)
+                consider(vx, vy);
+            Refine(bestX, bestY, consider);
+            if (bestCost > rescueSad) {
+              bestX = predX;
+              bestY = predY;
+              bestCost = predCost;
+            }
+          }
+        }
+
+        field.vectors[idx] = {static_cast<int16_t>(bestX),
+                              static_cast<int16_t>(bestY)};
+        field.costs[idx] = bestCost;
+      }
+    }
+    candidates_.fetch_add(evaluated, std::memory_order_relaxed);
+  });
+}
+
+void BlockMatchInterpolator::SelectBilateral(const LumaImage &prev,
+                                             const LumaImage &curr,
+                                             float t,
+                                             const TileChangeMap *changes) noexcept {
+  const BlockGrid grid = GridFor(prev);
+  field_.Resize(grid.cols, grid.rows);
+  const MotionField &fwd = forward_[0];
+  const MotionField &bwd = backward_[0];
+
+  const uint32_t staticSad = static_cast<uint32_t>(
+      std::max(0.f, params_.diffThreshold) * kBlockPixels);
+  std::atomic<uint32_t> staticBlocks{0};
+
+  ForBlockRows(grid.rows, [&](size_t begin, size_t end) {
+    uint32_t localStatic = 0;
+    for (uint32_t by = static_cast<uint32_t>(begin); by < end; by++) {
+      for (uint32_t bx = 0; bx < grid.cols; bx++) {
+        const size_t idx = static_cast<size_t>(by) * grid.cols + bx;
+        const int32_t ox = BlockOrigin(bx, grid.maxX);
+        const int32_t oy = BlockOrigin(by, grid.maxY);
+
+        const bool unchanged =
+            changes &&
+            !changes->IsPixelChanged(bx * kBlockSize, by * kBlockSize);
+        if (unchanged || (fwd.vectors[idx] == MotionVector{} &&
+                          fwd.costs[idx] <= staticSad)) {
+          field_.vectors[idx] = MotionVector{};
+          field_.costs[idx] = fwd.costs[idx];
+          localStatic++;
+          continue;
+        }
+
+        // A vector v moves content from prev to curr; the generated block
+        // samples prev at -t*v and curr at +(1-t)*v.
+        auto cost = [&](int32_t vx, int32_t vy) -> uint32_t {
+          const int32_t ax = RoundScaled(t, vx);
+          const int32_t ay = RoundScaled(t, vy);
+          const int32_t pax = ox - ax;
+          const int32_t pay = oy - ay;
+          const int32_t pbx = ox + (vx - ax);
+          const int32_t pby = oy + (vy - ay);
+          if (pax < 0 || pay < 0 || pax > grid.maxX || pay > grid.maxY ||
+              pbx < 0 || pby < 0 || pbx > grid.maxX || pby > grid.maxY) {
+            return UINT32_MAX;
+          }
+          return Sad16x16(prev.Row(pay) + pax, prev.pitch,
+                          curr.Row(pby) + pbx, curr.pitch) +
+                 VectorPenalty(vx, vy);
+        };
+
+        int32_t bestX = 0;
+        int32_t bestY = 0;
+        uint32_t bestCost = cost(0, 0);
+        auto consider = [&](int32_t vx, int32_t vy) {
+          uint32_t c = cost(vx, vy);
+          if (c < bestCost) {
+            bestCost = c;
+            bestX = vx;
+            bestY = vy;
+          }
+        };
+
+        static constexpr int32_t kNeighbors[5][2] = {
+            {0, 0}, {-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+        for (const auto &n : kNeighbors) {
+          const int32_t c = static_cast<int32_t>(bx) + n[0];
+          const int32_t r = static_cast<int32_t>(by) + n[1];
+          if (c < 0 || r < 0 || c >= static_cast<int32_t>(grid.cols) ||
+              r >= static_cast<int32_t>(grid.rows)) {
+            continue;
+          }
+          const MotionVector &f = fwd.At(c, r);
+          const MotionVector &b = bwd.At(c, r);
+          consider(f.x, f.y);
+          consider(-b.x, -b.y);
+        }
+
+        const int32_t cx = bestX;
+        const int32_t cy = bestY;
+        for (int32_t dy = -1; dy <= 1; dy++)
+          for (int32_t dx = -1; dx <= 1; dx++)
+            if (dx || dy)
+              consider(cx + dx, cy + dy);
+
+        field_.vectors[idx] = {static_cast<int16_t>(bestX),
+                               static_cast<int16_t>(bestY)};
+        field_.costs[idx] = bestCost;
+      }
+    }
+    staticBlocks.fetch_add(localStatic, std::memory_order_relaxed);
+  });
+
+  staticBlocks_ = staticBlocks.load();
+}
+
+void BlockMatchInterpolator::Compensate(const FrameView &prev,
+                                        const FrameView &curr,
+                                        const FrameView &out, float t,
+                                        const TileChangeMap *changes) noexcept {
+  const uint32_t weight256 = BlendWeight256(t, params_.temporalBlend);
+  const uint32_t bs = kBlockSize;
+
+  ForBlockRows(field_.rows, [&](size_t begin, size_t end) {
+    for (uint32_t by = static_cast<uint32_t>(begin); by < end; by++) {
+      const uint32_t y0 = by * bs;
+      const uint32_t y1 = std::min(curr.height, y0 + bs);
+      for (uint32_t bx = 0; bx < field_.cols; bx++) {
+        const uint32_t x0 = bx * bs;
+        if (changes && !changes->IsPixelChanged(x0, y0))
+          continue;
+        const uint32_t width = std::min(curr.width, x0 + bs) - x0;
+        const MotionVector &mv = field_.At(bx, by);
+        const int32_t ax = RoundScaled(t, mv.x);
+        const int32_t ay = RoundScaled(t, mv.y);
+        const int32_t bxOff = mv.x - ax;
+        const int32_t byOff = mv.y - ay;
+
+        for (uint32_t y = y0; y < y1; y++) {
+          const uint8_t *rowA =
+              prev.Row(static_cast<uint32_t>(static_cast<int32_t>(y) - ay)) +
+              (static_cast<int32_t>(x0) - ax) * 4;
+          const uint8_t *rowB =
+              curr.Row(static_cast<uint32_t>(static_cast<int32_t>(y) + byOff)) +
+              (static_cast<int32_t>(x0) + bxOff) * 4;
+          BlendRow(rowA, rowB, out.Row(y) + x0 * 4, width * 4, weight256);
+        }
+      }
+    }
+  });
+
+  if (changes)
+    changes->CopyUnchanged(curr, out);
+}
+
+} // namespace DeepFrame
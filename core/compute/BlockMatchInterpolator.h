@@ -0,0 +1,105 @@
+#pragma once
+
+#include "FrameView.h"
+#include "LumaPyramid.h"
+#include "MotionField.h"
+#include "RangeFn.h"
+#include "TileChangeMap.h"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace DeepFrame {
+
+class ThreadPool;
+
+// Model-free motion-compensated interpolation. Motion is estimated on a
+// luma pyramid with 16x16 block matching (full search at the coarsest level,
+// predictor refinement above it) in both directions; each block of the
+// generated frame then picks the candidate vector with the lowest bilateral
+// error and blends the two compensated source blocks at t. Consecutive calls
+// on a stream seed the search with the previous pair's fields instead (see
+// MotionSearch::Temporal).
+class BlockMatchInterpolator {
+public:
+  static constexpr uint32_t kBlockSize = 16;
+
+  explicit BlockMatchInterpolator(ThreadPool *pool = nullptr) noexcept
+      : pool_(pool) {}
+
+  void SetParams(const MotionParams &params) noexcept { params_ = params; }
+  [[nodiscard]] const MotionParams &GetParams() const noexcept {
+    return params_;
+  }
+
+  // With `changes`, blocks in unchanged tiles skip motion search and are
+  // copied from `curr`.
+  [[nodiscard]] bool Interpolate(const FrameView &prev, const FrameView &curr,
+                                 const FrameView &out, float t,
+                                 const TileChangeMap *changes = nullptr) noexcept;
+  // Another frame of the last pair at a different t, reusing its motion;
+  // only after an Interpolate without a change map on the same frames.
+  [[nodiscard]] bool Resample(const FrameView &prev, const FrameView &curr,
+                              const FrameView &out, float t) noexcept;
+
+  [[nodiscard]] const MotionField &ForwardField() const noexcept {
+    return forward_[0];
+  }
+  [[nodiscard]] const MotionField &BackwardField() const noexcept {
+    return backward_[0];
+  }
+  [[nodiscard]] const MotionField &InterpolatedField() const noexcept {
+    return field_;
+  }
+  [[nodiscard]] uint32_t StaticBlocks() const noexcept {
+    return staticBlocks_;
+  }
+  // SAD evaluations of the last call per full-resolution block and
+  // direction, coarse levels included.
+  [[nodiscard]] float CandidatesPerBlock() const noexcept {
+    return candidatesPerBlock_;
+  }
+  // Forgets the motion history, e.g. after a scene cut.
+  void ResetHistory() noexcept { historyValid_ = false; }
+
+private:
+  void EstimateLevel(const LumaImage &src, const LumaImage &dst,
+                     const MotionField *coarse, MotionField &field,
+                     int32_t radius, const TileChangeMap *changes) noexcept;
+  void EstimateTemporal(const LumaImage &src, const LumaImage &dst,
+                        const MotionField &history, MotionField &field,
+                        int32_t radius, uint32_t rescueSad,
+                        const TileChangeMap *changes) noexcept;
+  void SelectBilateral(const LumaImage &prev, const LumaImage &curr, float t,
+                       const TileChangeMap *changes) noexcept;
+  void Compensate(const FrameView &prev, const FrameView &curr,
+                  const FrameView &out, float t,
+                  const TileChangeMap *changes) noexcept;
+  void ForBlockRows(uint32_t rows, RangeFn fn) noexcept;
+
+  ThreadPool *pool_ = nullptr;
+  MotionParams params_;
+
+  LumaPyramid prevPyramid_;
+  LumaPyramid currPyramid_;
+  std::vector<MotionField> forward_{1};
+  std::vector<MotionField> backward_{1};
+  MotionField field_;
+  uint32_t staticBlocks_ = 0;
+  // Size of the pair whose full fields are still in forward_/backward_.
+  uint32_t resampleWidth_ = 0;
+  uint32_t resampleHeight_ = 0;
+
+  // Fields of the previous pair; its curr frame is this pair's prev, so
+  // the motion mostly carries over.
+  MotionField historyForward_;
+  MotionField historyBackward_;
+  uint32_t historyMeanCost_ = 0;
+  uint32_t historyAge_ = 0;
+  bool historyValid_ = false;
+
+  std::atomic<uint64_t> candidates_{0};
+  float candidatesPerBlock_ = 0.f;
+};
+
+} // namespace DeepFrame
@@ -0,0 +1,495 @@
+#include "FlowInterpolator.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace DeepFrame {
+
+namespace {
+
+static_assert((TileChangeMap::kTileSize & (TileChangeMap::kTileSize - 1)) == 0,
+              "Warp skips unchanged tiles with a mask");
+
+// Lerp of two packed BGRA pixels with the weight in 1/256 steps; red/blue
+// and green/alpha are processed as two 16-bit lane pairs.
+inline uint32_t LerpPacked(uint32_t a, uint32_t b, uint32_t w) noexcept {
+  const uint32_t iw = 256 - w;
+  const uint32_t rb =
+      (((a & 0x00FF00FFu) * iw + (b & 0x00FF00FFu) * w + 0x00800080u) >> 8) &
+      0x00FF00FFu;
+  const uint32_t ga = (((a >> 8) & 0x00FF00FFu) * iw +
+                       ((b >> 8) & 0x00FF00FFu) * w + 0x00800080u) &
+                      0xFF00FF00u;
+  return rb | ga;
+}
+
+inline uint32_t LoadPixel(const uint8_t *p) noexcept {
+  uint32_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+// Bilinear BGRA fetch in 8-bit fixed point with edge clamping.
+inline uint32_t SampleBgra(const FrameView &img, float x, float y) noexcept {
+  x = std::clamp(x, 0.f, static_cast<float>(img.width - 1));
+  y = std::clamp(y, 0.f, static_cast<float>(img.height - 1));
+  const uint32_t x0 = static_cast<uint32_t>(x);
+  const uint32_t y0 = static_cast<uint32_t>(y);
+  const uint32_t x1 = std::min(x0 + 1, img.width - 1);
+  const uint32_t y1 = std::min(y0 + 1, img.height - 1);
+  const uint32_t fx = static_cast<uint32_t>((x - x0) * 256.f);
+  const uint32_t fy = static_cast<uint32_t>((y - y0) * 256.f);
+  const uint8_t *r0 = img.Row(y0);
+  const uint8_t *r1 = img.Row(y1);
+  const uint32_t top = LerpPacked(LoadPixel(r0 + x0 * 4),
+                                  LoadPixel(r0 + x1 * 4), fx);
+  const uint32_t bottom = LerpPacked(LoadPixel(r1 + x0 * 4),
+                                     LoadPixel(r1 + x1 * 4), fx);
+  return LerpPacked(top, bottom, fy);
+}
+
+bool IsUsablePair(const FrameView &prev, const FrameView &curr,
+                  const FrameView &out) noexcept {
+  return prev.IsValid() && curr.IsValid() && out.IsValid() &&
+         prev.format == PixelFormat::BGRA8 &&
+         curr.format == PixelFormat::BGRA8 &&
+         out.format == PixelFormat::BGRA8 && prev.width == curr.width &&
+         prev.height == curr.height && out.width == curr.width &&
+         out.height == curr.height && curr.width >= 16 && curr.height >= 16;
+}
+
+bool SameLuma(const LumaImage &a, const LumaImage &b) noexcept {
+  if (a.width != b.width || a.height != b.height || a.width == 0)
+    return false;
+  for (uint32_t y = 0; y < a.height; y++)
+    if (std::memcmp(a.Row(y), b.Row(y), a.width))
+      return false;
+  return true;
+}
+
+} // namespace
+
+void FlowInterpolator::ForRows(uint32_t rows, uint32_t grain,
+                               RangeFn fn) noexcept {
+  if (pool_) {
+    pool_->ParallelFor(rows, grain, fn);
+  } else {
+    fn(0, rows);
+  }
+}
+
+bool FlowInterpolator::Interpolate(const FrameView &prev,
+                                   const FrameView &curr,
+                                   const FrameView &out, float t,
+                                   const TileChangeMap *changes) noexcept {
+  resampleWidth_ = 0;
+  resampleHeight_ = 0;
+  if (!IsUsablePair(prev, curr, out))
+    return false;
+
+  if (changes && !changes->Matches(curr.width, curr.height))
+    changes = nullptr;
+  if (changes && !changes->AnyChanged()) {
+    changes->CopyUnchanged(curr, out);
+    return true;
+  }
+
+  t = std::clamp(t, 0.f, 1.f);
+  const uint32_t levels =
+      OpticalFlowEstimator::LevelsFor(curr.width, curr.height);
+
+  prevPyramid_.Build(prev, levels, pool_);
+  currPyramid_.Build(curr, levels, pool_);
+
+  if (!estimator_.Estimate(prevPyramid_, currPyramid_, forward_, changes) ||
+      !estimator_.Estimate(currPyramid_, prevPyramid_, backward_, changes)) {
+    return false;
+  }
+
+  try {
+    ComputeOcclusion(forward_, backward_, occlusionPrev_);
+    ComputeOcclusion(backward_, forward_, occlusionCurr_);
+    columns_.resize(out.width);
+    rowFlow_.resize(static_cast<size_t>(forward_.width) * 4 *
+                    ((out.height + kWarpRows - 1) / kWarpRows));
+  } catch (...) {
+    return false;
+  }
+
+  Warp(prev, curr, out, t, changes);
+  if (!changes) {
+    resampleWidth_ = curr.width;
+    resampleHeight_ = curr.height;
+  }
+  return true;
+}
+
+bool FlowInterpolator::Resample(const FrameView &prev, const FrameView &curr,
+                                const FrameView &out, float t) noexcept {
+  if (!prev.IsValid() || !curr.IsValid() || !out.IsValid() ||
+      out.format != PixelFormat::BGRA8 || curr.width != resampleWidth_ ||
+      curr.height != resampleHeight_ || prev.width != curr.width ||
+      prev.height != curr.height || out.width != curr.width ||
+      out.height != curr.height) {
+    return false;
+  }
+  Warp(prev, curr, out, std::clamp(t, 0.f, 1.f), nullptr);
+  return true;
+}
+
+bool FlowInterpolator::Extrapolate(const FrameView &prev,
+                                   const FrameView &curr,
+                                   const FrameView &out, float s,
+                                   const TileChangeMap *changes) noexcept {
+  extrapolateWidth_ = 0;
+  extrapolateHeight_ = 0;
+  if (!IsUsablePair(prev, curr, out))
+    return false;
+
+  if (changes && !changes->Matches(curr.width, curr.height))
+    changes = nullptr;
+  if (changes && !changes->AnyChanged()) {
+    changes->CopyUnchanged(curr, out);
+    return true;
+  }
+
+  const uint32_t levels =
+      OpticalFlowEstimator::LevelsFor(curr.width, curr.height);
+  prevPyramid_.Build(prev, levels, pool_);
+  currPyramid_.Build(curr, levels, pool_);
+  if (!estimator_.Estimate(currPyramid_, prevPyramid_, backward_, changes))
+    return false;
+
+  const uint32_t fw = backward_.width;
+  const uint32_t fh = backward_.height;
+  const bool continues = history_.width == fw && history_.height == fh &&
+                         SameLuma(historyLuma_, prevPyramid_.Level(levels - 1));
+  try {
+    motion_.Resize(fw, fh);
+    predicted_.Resize(fw, fh);
+    splatMotion_.resize(static_cast<size_t>(fw) * fh);
+    fillPass_.resize(static_cast<size_t>(fw) * fh);
+    columns_.resize(out.width);
+    rowFlow_.resize(static_cast<size_t>(fw) * 4 *
+                    ((out.height + kWarpRows - 1) / kWarpRows));
+  } catch (...) {
+    return false;
+  }
+
+  EstimateMotion(continues);
+  try {
+    history_ = backward_;
+    historyLuma_ = currPyramid_.Level(levels - 1);
+  } catch (...) {
+    history_.width = 0;
+  }
+
+  PredictFlow(std::clamp(s, 0.f, 1.f));
+  WarpPredicted(curr, out, changes);
+  if (!changes) {
+    extrapolateWidth_ = curr.width;
+    extrapolateHeight_ = curr.height;
+  }
+  return true;
+}
+
+bool FlowInterpolator::ResampleExtrapolation(const FrameView &curr,
+                                             const FrameView &out,
+                                             float s) noexcept {
+  if (!IsUsablePair(curr, curr, out) || curr.width != extrapolateWidth_ ||
+      curr.height != extrapolateHeight_) {
+    return false;
+  }
+  PredictFlow(std::clamp(s, 0.f, 1.f));
+  WarpPredicted(curr, out, nullptr);
+  return true;
+}
+
+void FlowInterpolator::EstimateMotion(bool continues) noexcept {
+  const uint32_t fw = backward_.width;
+  ForRows(backward_.height, 4, [&](size_t begin, size_t end) {
+    for (size_t y = begin; y < end; y++) {
+      for (uint32_t x = 0; x < fw; x++) {
+        const size_t idx = y * fw + x;
+        const float bu = backward_.u[idx];
+        const float bv = backward_.v[idx];
+        // Under constant velocity the content had the same motion one
+        // pair earlier, where it was in the previous frame.
+        float keep = 1.f;
+        if (continues) {
+          float hu, hv;
+          history_.Sample(x + bu, y + bv, hu, hv);
+          const float eu = bu - hu;
+          const float ev = bv - hv;
+          const float error = std::sqrt(eu * eu + ev * ev);
+          const float tolerance = 1.f + 0.5f * std::sqrt(bu * bu + bv * bv);
+          keep = std::clamp(2.f - error / tolerance, 0.f, 1.f);
+        }
+        motion_.u[idx] = -bu * keep;
+        motion_.v[idx] = -bv * keep;
+      }
+    }
+  });
+}
+
+void FlowInterpolator::PredictFlow(float s) noexcept {
+  const int32_t fw = static_cast<int32_t>(motion_.width);
+  const int32_t fh = static_cast<int32_t>(motion_.height);
+  std::fill(fillPass_.begin(), fillPass_.end(), 0);
+
+  // Scattered, so serial; the field is a sixteenth of the frame. Where
+  // several pixels land on one, the fastest is taken as the one in front.
+  for (int32_t y = 0; y < fh; y++) {
+    for (int32_t x = 0; x < fw; x++) {
+      const size_t idx = static_cast<size_t>(y) * fw + x;
+      const float mu = motion_.u[idx] * s;
+      const float mv = motion_.v[idx] * s;
+      const int32_t tx = static_cast<int32_t>(std::lround(x + mu));
+      const int32_t ty = static_cast<int32_t>(std::lround(y + mv));
+      if (tx < 0 || ty < 0 || tx >= fw || ty >= fh)
+        continue;
+      const size_t target = static_cast<size_t>(ty) * fw + tx;
+      const float speed = mu * mu + mv * mv;
+      if (fillPass_[target] && splatMotion_[target] >= speed)
+        continue;
+      predicted_.u[target] = -mu;
+      predicted_.v[target] = -mv;
+      splatMotion_[target] = speed;
+      fillPass_[target] = 1;
+    }
+  }
+
+  // Each pass grows the filled area by a pixel into the holes, from the
+  // slowest neighbour filled before the pass.
+  for (uint8_t pass = 2; pass < kFillPasses + 2; pass++) {
+    bool holes = false;
+    for (int32_t y = 0; y < fh; y++) {
+      for (int32_t x = 0; x < fw; x++) {
+        const size_t idx = static_cast<size_t>(y) * fw + x;
+        if (fillPass_[idx])
+          continue;
+        size_t best = idx;
+        auto consider = [&](int32_t nx, int32_t ny) {
+          if (nx < 0 || ny < 0 || nx >= fw || ny >= fh)
+            return;
+          const size_t n = static_cast<size_t>(ny) * fw + nx;
+          if (fillPass_[n] && fillPass_[n] < pass &&
+              (best == idx || splatMotion_[n] < splatMotion_[best])) {
+            best = n;
+          }
+        };
+        consider(x - 1, y);
+        consider(x + 1, y);
+        consider(x, y - 1);
+        consider(x, y + 1);
+        if (best == idx) {
+          holes = true;
+          continue;
+        }
+        predicted_.u[idx] = predicted_.u[best];
+        predicted_.v[idx] = predicted_.v[best];
+        splatMotion_[idx] = splatMotion_[best];
+        fillPass_[idx] = pass;
+      }
+    }
+    if (!holes)
+      return;
+  }
+  // Holes wider than the passes reach show the current frame unmoved.
+  for (size_t i = 0; i < fillPass_.size(); i++) {
+    if (!fillPass_[i]) {
+      predicted_.u[i] = 0.f;
+      predicted_.v[i] = 0.f;
+    }
+  }
+}
+
+void FlowInterpolator::WarpPredicted(const FrameView &curr,
+                                     const FrameView &out,
+                                     const TileChangeMap *changes) noexcept {
+  const int32_t fw = static_cast<int32_t>(predicted_.width);
+  const int32_t fh = static_cast<int32_t>(predicted_.height);
+  const float sx = static_cast<float>(out.width) / fw;
+  const float sy = static_cast<float>(out.height) / fh;
+
+  for (uint32_t x = 0; x < out.width; x++) {
+    const float fx = std::clamp((x + 0.5f) / sx - 0.5f, 0.f,
+                                static_cast<float>(fw - 1));
+    Tap &tap = columns_[x];
+    tap.i0 = static_cast<uint32_t>(fx);
+    tap.i1 = std::min(tap.i0 + 1, static_cast<uint32_t>(fw - 1));
+    tap.w = fx - tap.i0;
+  }
+
+  ForRows(out.height, kWarpRows, [&](size_t begin, size_t end) {
+    float *ru = rowFlow_.data() + (begin / kWarpRows) * fw * 4;
+    float *rv = ru + fw;
+
+    for (uint32_t y = static_cast<uint32_t>(begin); y < end; y++) {
+      const float fy = std::clamp((y + 0.5f) / sy - 0.5f, 0.f,
+                                  static_cast<float>(fh - 1));
+      const uint32_t y0 = static_cast<uint32_t>(fy);
+      const uint32_t y1 = std::min(y0 + 1, static_cast<uint32_t>(fh - 1));
+      const float wy = fy - y0;
+      const size_t o0 = static_cast<size_t>(y0) * fw;
+      const size_t o1 = static_cast<size_t>(y1) * fw;
+      for (int32_t i = 0; i < fw; i++) {
+        auto lerp = [&](const std::vector<float> &f) {
+          return f[o0 + i] + wy * (f[o1 + i] - f[o0 + i]);
+        };
+        ru[i] = lerp(predicted_.u) * sx;
+        rv[i] = lerp(predicted_.v) * sy;
+      }
+
+      uint8_t *dst = out.Row(y);
+      for (uint32_t x = 0; x < out.width; x++) {
+        if (changes && !changes->IsPixelChanged(x, y)) {
+          x |= TileChangeMap::kTileSize - 1;
+          continue;
+        }
+        const Tap &tap = columns_[x];
+        const float pu = ru[tap.i0] + tap.w * (ru[tap.i1] - ru[tap.i0]);
+        const float pv = rv[tap.i0] + tap.w * (rv[tap.i1] - rv[tap.i0]);
+        const uint32_t pixel = SampleBgra(curr, x + pu, y + pv);
+        std::memcpy(dst + x * 4, &pixel, sizeof(pixel));
+      }
+    }
+  });
+
+  if (changes)
+    changes->CopyUnchanged(curr, out);
+}
+
+void FlowInterpolator::ComputeOcclusion(
+    const FlowField &fwd, const FlowField &bwd,
+    std::vector<uint8_t> &occlusion) noexcept {
+  occlusion.resize(static_cast<size_t>(fwd.width) * fwd.height);
+
+  // A pixel whose round trip through both fields does not come back to
+  // itself has no counterpart in the other frame.
+  ForRows(fwd.height, 4, [&](size_t begin, size_t end) {
+    for (size_t y = begin; y < end; y++) {
+      for (uint32_t x = 0; x < fwd.width; x++) {
+        const size_t idx = y * fwd.width + x;
+        const float u = fwd.u[idx];
+        const float v = fwd.v[idx];
+        float bu, bv;
+        bwd.Sample(x + u, y + v, bu, bv);
+        const float eu = u + bu;
+        const float ev = v + bv;
+        const float error = std::sqrt(eu * eu + ev * ev);
+        const float tolerance = 0.5f + 0.05f * std::sqrt(u * u + v * v);
+        const float o = std::clamp((error - tolerance) / tolerance, 0.f, 1.f);
+        occlusion[idx] = static_cast<uint8_t>(o * 255.f);
+      }
+    }
+  });
+}
+
+void FlowInterpolator::Warp(const FrameView &prev, const FrameView &curr,
+                            const FrameView &out, float t,
+                            const TileChangeMap *changes) noexcept {
+  const float blend = std::clamp(params_.temporalBlend, 0.f, 1.f);
+  const float wCurr = blend * t + (1.f - blend) * (t >= 0.5f ? 1.f : 0.f);
+  const float wPrev = 1.f - wCurr;
+
+  const float sx = static_cast<float>(out.width) / forward_.width;
+  const float sy = static_cast<float>(out.height) / forward_.height;
+  const int32_t fw = static_cast<int32_t>(forward_.width);
+  const int32_t fh = static_cast<int32_t>(forward_.height);
+
+  // Linear-motion estimate of the flow from the generated frame back to
+  // each source, evaluated at the output pixel.
+  const float a0 = -(1.f - t) * t;
+  const float b0 = t * t;
+  const float a1 = (1.f - t) * (1.f - t);
+  const float b1 = -t * (1.f - t);
+
+  const float invSx = 1.f / sx;
+  const float invSy = 1.f / sy;
+  auto occlusionAt = [&](const std::vector<uint8_t> &occ, float x, float y) {
+    const int32_t ix = std::clamp(static_cast<int32_t>(x * invSx), 0, fw - 1);
+    const int32_t iy = std::clamp(static_cast<int32_t>(y * invSy), 0, fh - 1);
+    return occ[static_cast<size_t>(iy) * fw + ix] * (1.f / 255.f);
+  };
+
+  // The flow fields are upsampled bilinearly; horizontal taps are shared by
+  // every row and vertical taps by every pixel of a row.
+  for (uint32_t x = 0; x < out.width; x++) {
+    const float fx = std::clamp((x + 0.5f) / sx - 0.5f, 0.f,
+                                static_cast<float>(fw - 1));
+    Tap &tap = columns_[x];
+    tap.i0 = static_cast<uint32_t>(fx);
+    tap.i1 = std::min(tap.i0 + 1, static_cast<uint32_t>(fw - 1));
+    tap.w = fx - tap.i0;
+  }
+
+  ForRows(out.height, kWarpRows, [&](size_t begin, size_t end) {
+    // Forward u, v and backward u, v of the current row, already scaled to
+    // full-resolution pixels. Chunks are grain-aligned, so each owns a slot.
+    float *ru = rowFlow_.data() + (begin / kWarpRows) * fw * 4;
+    float *rv = ru + fw;
+    float *rbu = rv + fw;
+    float *rbv = rbu + fw;
+
+    for (uint32_t y = static_cast<uint32_t>(begin); y < end; y++) {
+      const float fy = std::clamp((y + 0.5f) / sy - 0.5f, 0.f,
+                                  static_cast<float>(fh - 1));
+      const uint32_t y0 = static_cast<uint32_t>(fy);
+      const uint32_t y1 = std::min(y0 + 1, static_cast<uint32_t>(fh - 1));
+      const float wy = fy - y0;
+      const size_t o0 = static_cast<size_t>(y0) * fw;
+      const size_t o1 = static_cast<size_t>(y1) * fw;
+      for (int32_t i = 0; i < fw; i++) {
+        auto lerp = [&](const std::vector<float> &f) {
+          return f[o0 + i] + wy * (f[o1 + i] - f[o0 + i]);
+        };
+        ru[i] = lerp(forward_.u) * sx;
+        rv[i] = lerp(forward_.v) * sy;
+        rbu[i] = lerp(backward_.u) * sx;
+        rbv[i] = lerp(backward_.v) * sy;
+      }
+
+      uint8_t *dst = out.Row(y);
+      for (uint32_t x = 0; x < out.width; x++) {
+        if (changes && !changes->IsPixelChanged(x, y)) {
+          x |= TileChangeMap::kTileSize - 1;
+          continue;
+        }
+        const Tap &tap = columns_[x];
+        auto at = [&](const float *r) {
+          return r[tap.i0] + tap.w * (r[tap.i1] - r[tap.i0]);
+        };
+        const float fu = at(ru);
+        const float fv = at(rv);
+        const float bu = at(rbu);
+        const float bv = at(rbv);
+
+        const float x0 = x + a0 * fu + b0 * bu;
+        const float y0f = y + a0 * fv + b0 * bv;
+        const float x1 = x + a1 * fu + b1 * bu;
+        const float y1f = y + a1 * fv + b1 * bv;
+
+        // Content occluded in the other frame is only trustworthy from the
+        // frame it was sampled in.
+        const float occ0 = occlusionAt(occlusionPrev_, x0, y0f);
+        const float occ1 = occlusionAt(occlusionCurr_, x1, y1f);
+        const float w0 = wPrev * (1.f - occ1);
+        const float w1 = wCurr * (1.f - occ0);
+        const float sum = w0 + w1;
+        const float weight = sum < 1e-3f ? wCurr : w1 / sum;
+
+        const uint32_t pixel =
+            LerpPacked(SampleBgra(prev, x0, y0f), SampleBgra(curr, x1, y1f),
+                       static_cast<uint32_t>(weight * 256.f + 0.5f));
+        std::memcpy(dst + x * 4, &pixel, sizeof(pixel));
+      }
+    }
+  });
+
+  if (changes)
+    changes->CopyUnchanged(curr, out);
+}
+
+} // namespace DeepFrame
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "FrameView.h"
+#include "LumaPyramid.h"
+#include "MotionField.h"
+#include "OpticalFlow.h"
+#include "RangeFn.h"
+#include "TileChangeMap.h"
+#include <cstdint>
+#include <vector>
+
+namespace DeepFrame {
+
+class ThreadPool;
+
+// Quality tier between block matching and a learned model. Dense flow is
+// estimated in both directions, the flow at t is approximated from the two
+// fields, and both frames are backward-warped and blended with weights that
+// drop a source wherever forward-backward consistency says the sampled
+// pixel has no counterpart in the other frame. The same flow also predicts
+// frames past the last one, for extrapolation.
+class FlowInterpolator {
+public:
+  explicit FlowInterpolator(ThreadPool *pool = nullptr) noexcept
+      : pool_(pool), estimator_(pool) {}
+
+  void SetParams(const MotionParams &params) noexcept { params_ = params; }
+  void SetFlowParams(const OpticalFlowParams &params) noexcept {
+    estimator_.SetParams(params);
+  }
+
+  // With `changes`, pixels in unchanged tiles are copied from `curr`
+  // instead of warped, and a frame with no changed tiles skips flow.
+  [[nodiscard]] bool Interpolate(const FrameView &prev, const FrameView &curr,
+                                 const FrameView &out, float t,
+                                 const TileChangeMap *changes = nullptr) noexcept;
+  // Another frame of the last pair at a different t from the same flow;
+  // only after an Interpolate without a change map on the same frames.
+  [[nodiscard]] bool Resample(const FrameView &prev, const FrameView &curr,
+                              const FrameView &out, float t) noexcept;
+
+  // Predicts the frame `s` pair intervals after `curr` by forward-warping
+  // the motion of the pair, so it can be shown before the next frame
+  // exists. When `prev` is the `curr` of the previous call, motion that
+  // disagrees with that pair's is damped as unpredictable. Holes the warp
+  // opens take the slowest neighbouring motion: uncovered background.
+  [[nodiscard]] bool Extrapolate(const FrameView &prev, const FrameView &curr,
+                                 const FrameView &out, float s,
+                                 const TileChangeMap *changes = nullptr) noexcept;
+  // Another prediction from the last Extrapolate without a change map, at
+  // a different s.
+  [[nodiscard]] bool ResampleExtrapolation(const FrameView &curr,
+                                           const FrameView &out,
+                                           float s) noexcept;
+
+  [[nodiscard]] const FlowField &ForwardFlow() const noexcept {
+    return forward_;
+  }
+  [[nodiscard]] const FlowField &BackwardFlow() const noexcept {
+    return backward_;
+  }
+
+private:
+  void ComputeOcclusion(const FlowField &fwd, const FlowField &bwd,
+                        std::vector<uint8_t> &occlusion) noexcept;
+  void Warp(const FrameView &prev, const FrameView &curr, const FrameView &out,
+            float t, const TileChangeMap *changes) noexcept;
+  // Motion of each pixel of the current frame over one pair interval,
+  // from backward_ and, if `continues`, damped against history_.
+  void EstimateMotion(bool continues) noexcept;
+  // Splats motion_ scaled by `s` into predicted_ and fills the holes.
+  void PredictFlow(float s) noexcept;
+  void WarpPredicted(const FrameView &curr, const FrameView &out,
+                     const TileChangeMap *changes) noexcept;
+  void ForRows(uint32_t rows, uint32_t grain, RangeFn fn) noexcept;
+
+  static constexpr uint32_t kWarpRows = 16;
+  static constexpr uint8_t kFillPasses = 16;
+
+  struct Tap {
+    uint32_t i0 = 0;
+    uint32_t i1 = 0;
+    float w = 0.f;
+  };
+
+  ThreadPool *pool_ = nullptr;
+  MotionParams params_;
+  OpticalFlowEstimator estimator_;
+
+  LumaPyramid prevPyramid_;
+  LumaPyramid currPyramid_;
+  FlowField forward_;
+  FlowField backward_;
+  std::vector<uint8_t> occlusionPrev_;
+  std::vector<uint8_t> occlusionCurr_;
+  std::vector<Tap> columns_;
+  std::vector<float> rowFlow_;
+  // Size of the pair the fields above were estimated for, 0 when they
+  // cannot be reused.
+  uint32_t resampleWidth_ = 0;
+  uint32_t resampleHeight_ = 0;
+
+  // Extrapolation. history_ is the previous pair's backward flow and
+  // historyLuma_ the coarsest level of the frame it started from.
+  FlowField history_;
+  LumaImage historyLuma_;
+  FlowField motion_;
+  // Offset from each predicted pixel back to its source in the current
+  // frame, and the squared motion that won the pixel.
+  FlowField predicted_;
+  std::vector<float> splatMotion_;
+  // 0 for a hole, 1 for splatted, else the fill pass that reached it.
+  std::vector<uint8_t> fillPass_;
+  uint32_t extrapolateWidth_ = 0;
+  uint32_t extrapolateHeight_ = 0;
+};
+
+} // namespace DeepFrame
@@ -0,0 +1,153 @@
+#include "FrameArena.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace DeepFrame {
+
+namespace {
+
+constexpr size_t kHugePageBytes = size_t(2) << 20;
+
+size_t RoundUp(size_t value, size_t to) noexcept {
+  return (value + to - 1) / to * to;
+}
+
+// Faults every page in now rather than on the first frame that uses it.
+void Touch(uint8_t *base, size_t bytes, size_t page) noexcept {
+  for (size_t offset = 0; offset < bytes; offset += page)
+    static_cast<volatile uint8_t *>(base)[offset] = 0;
+}
+
+} // namespace
+
+#ifdef _WIN32
+
+bool FrameArena::Reserve(size_t bytes, ArenaPages pages) noexcept {
+  Release();
+  if (bytes == 0)
+    return false;
+
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  const size_t page = info.dwPageSize;
+  void *memory = nullptr;
+  size_t mapped = 0;
+  if (pages == ArenaPages::Huge) {
+    const size_t large = GetLargePageMinimum();
+    if (large) {
+      mapped = RoundUp(bytes, large);
+      memory = VirtualAlloc(nullptr, mapped,
+                            MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                            PAGE_READWRITE);
+      hugePages_ = memory != nullptr;
+    }
+  }
+  if (!memory) {
+    mapped = RoundUp(bytes, page);
+    memory =
+        VirtualAlloc(nullptr, mapped, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (!memory)
+      return false;
+    Touch(static_cast<uint8_t *>(memory), mapped, page);
+  }
+
+  base_ = static_cast<uint8_t *>(memory);
+  capacity_ = mapped;
+  charge_.Set(mapped);
+  return true;
+}
+
+void FrameArena::Release() noexcept {
+  if (base_)
+    VirtualFree(base_, 0, MEM_RELEASE);
+  base_ = nullptr;
+  capacity_ = 0;
+  used_ = 0;
+  highWater_ = 0;
+  hugePages_ = false;
+  charge_.Set(0);
+}
+
+#else
+
+bool FrameArena::Reserve(size_t bytes, ArenaPages pages) noexcept {
+  Release();
+  if (bytes == 0)
+    return false;
+
+  const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  void *memory = MAP_FAILED;
+  size_t mapped = 0;
+  if (pages == ArenaPages::Huge) {
+    // Reserved hugetlbfs pages first; most systems have none, so
+    // transparent huge pages are the usual outcome.
+    mapped = RoundUp(bytes, kHugePageBytes);
+#ifdef MAP_HUGETLB
+    memory = mmap(nullptr, mapped, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1,
+                  0);
+    hugePages_ = memory != MAP_FAILED;
+#endif
+    if (memory == MAP_FAILED) {
+      memory = mmap(nullptr, mapped, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#ifdef MADV_HUGEPAGE
+      if (memory != MAP_FAILED)
+        madvise(memory, mapped, MADV_HUGEPAGE);
+#endif
+      // After the advice, so the faults can come back as huge pages.
+      if (memory != MAP_FAILED)
+        Touch(static_cast<uint8_t *>(memory), mapped, page);
+    }
+  } else {
+    mapped = RoundUp(bytes, page);
+    memory = mmap(nullptr, mapped, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+  }
+  if (memory == MAP_FAILED) {
+    hugePages_ = false;
+    return false;
+  }
+
+  base_ = static_cast<uint8_t *>(memory);
+  capacity_ = mapped;
+  charge_.Set(mapped);
+  return true;
+}
+
+void FrameArena::Release() noexcept {
+  if (base_)
+    munmap(base_, capacity_);
+  base_ = nullptr;
+  capacity_ = 0;
+  used_ = 0;
+  highWater_ = 0;
+  hugePages_ = false;
+  charge_.Set(0);
+}
+
+#endif
+
+void *FrameArena::Allocate(size_t bytes) noexcept {
+  const size_t size = AlignedSize(bytes);
+  if (!base_ || size > capacity_ - used_)
+    return nullptr;
+  void *memory = base_ + used_;
+  used_ += size;
+  if (used_ > highWater_)
+    highWater_ = used_;
+  return memory;
+}
+
+} // namespace DeepFrame
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "MemoryLedger.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace DeepFrame {
+
+enum class ArenaPages : uint8_t {
+  Normal,
+  // 2 MB pages where the OS grants them: MAP_HUGETLB, then transparent
+  // huge pages on Linux; MEM_LARGE_PAGES (needs SeLockMemoryPrivilege) on
+  // Windows. Falls back to normal pages.
+  Huge
+};
+
+// One up-front mapping carved into 64-byte-aligned buffers by bumping a
+// pointer. Buffers that live as long as the frame size (tensors, output
+// frames) are taken first; Mark/Rewind around a frame's work recycles
+// per-frame scratch after them. The pages are faulted in by Reserve, so
+// steady-state frames neither allocate nor page-fault. One thread.
+class FrameArena {
+public:
+  static constexpr size_t kAlignment = 64;
+
+  explicit FrameArena(MemorySubsystem subsystem) noexcept
+      : charge_(subsystem, MemoryDomain::Cpu) {}
+  ~FrameArena() noexcept { Release(); }
+
+  FrameArena(const FrameArena &) = delete;
+  FrameArena &operator=(const FrameArena &) = delete;
+
+  // Replaces the mapping with one of at least `bytes` (rounded up to the
+  // page size); everything handed out before is gone.
+  [[nodiscard]] bool Reserve(size_t bytes,
+                             ArenaPages pages = ArenaPages::Normal) noexcept;
+  void Release() noexcept;
+
+  // Null when the arena is full.
+  [[nodiscard]] void *Allocate(size_t bytes) noexcept;
+  template <typename T> [[nodiscard]] T *AllocateArray(size_t count) noexcept {
+    return static_cast<T *>(Allocate(count * sizeof(T)));
+  }
+
+  [[nodiscard]] size_t Mark() const noexcept { return used_; }
+  void Rewind(size_t mark) noexcept {
+    if (mark <= used_)
+      used_ = mark;
+  }
+
+  [[nodiscard]] static constexpr size_t AlignedSize(size_t bytes) noexcept {
+    return (bytes + kAlignment - 1) & ~(kAlignment - 1);
+  }
+
+  [[nodiscard]] size_t Capacity() const noexcept { return capacity_; }
+  [[nodiscard]] size_t Used() const noexcept { return used_; }
+  [[nodiscard]] size_t HighWater() const noexcept { return highWater_; }
+  // The mapping is known to be backed by huge pages (not just advised).
+  [[nodiscard]] bool HasHugePages() const noexcept { return hugePages_; }
+
+private:
+  uint8_t *base_ = nullptr;
+  size_t capacity_ = 0;
+  size_t used_ = 0;
+  size_t highWater_ = 0;
+  bool hugePages_ = false;
+  MemoryCharge charge_;
+};
+
+} // namespace DeepFrame
@@ -0,0 +1,81 @@
+#include "FrameCrop.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cstring>
+
+namespace DeepFrame {
+
+TileRect ClipToOutput(int64_t left, int64_t top, int64_t right, int64_t bottom,
+                      uint32_t width, uint32_t height) noexcept {
+  const auto clamp = [](int64_t v, uint32_t hi) {
+    return static_cast<uint32_t>(std::clamp<int64_t>(v, 0, hi));
+  };
+  TileRect rect = {clamp(left, width), clamp(top, height), clamp(right, width),
+                   clamp(bottom, height)};
+  return rect.Empty() ? TileRect{} : rect;
+}
+
+TileRect CropRect(const TileRect &rect, const TileRect &crop) noexcept {
+  const uint32_t left = std::max(rect.left, crop.left);
+  const uint32_t top = std::max(rect.top, crop.top);
+  const uint32_t right = std::min(rect.right, crop.right);
+  const uint32_t bottom = std::min(rect.bottom, crop.bottom);
+  if (left >= right || top >= bottom)
+    return {};
+  return {left - crop.left, top - crop.top, right - crop.left,
+          bottom - crop.top};
+}
+
+void CropRects(const RectList &in, const TileRect &crop,
+               RectList &out) noexcept {
+  const uint32_t width = crop.right - crop.left;
+  const uint32_t height = crop.bottom - crop.top;
+  if (in.IsFull()) {
+    out.SetFull();
+    return;
+  }
+  for (const TileRect &rect : in)
+    out.Add(CropRect(rect, crop), width, height);
+}
+
+FrameView CropView(const FrameView &src, const TileRect &crop) noexcept {
+  if (!src.IsValid() || crop.Empty() || crop.right > src.width ||
+      crop.bottom > src.height) {
+    return {};
+  }
+  FrameView view = src;
+  view.data = src.Row(crop.top) + crop.left * BytesPerPixel(src.format);
+  view.width = crop.right - crop.left;
+  view.height = crop.bottom - crop.top;
+  return view;
+}
+
+bool PadFrame(const FrameView &src, const FrameView &dst,
+              ThreadPool *pool) noexcept {
+  if (!src.IsValid() || !dst.IsValid() || src.format != dst.format ||
+      dst.width < src.width || dst.height < src.height) {
+    return false;
+  }
+
+  const uint32_t bpp = BytesPerPixel(src.format);
+  const size_t rowBytes = static_cast<size_t>(src.width) * bpp;
+  auto padRows = [&](size_t begin, size_t end) {
+    for (size_t y = begin; y < end; y++) {
+      const uint8_t *in =
+          src.Row(std::min(static_cast<uint32_t>(y), src.height - 1));
+      uint8_t *out = dst.Row(static_cast<uint32_t>(y));
+      std::memcpy(out, in, rowBytes);
+      const uint8_t *last = in + rowBytes - bpp;
+      for (uint32_t x = src.width; x < dst.width; x++)
+        std::memcpy(out + static_cast<size_t>(x) * bpp, last, bpp);
+    }
+  };
+  if (pool) {
+    pool->ParallelFor(dst.height, 16, padRows);
+  } else {
+    padRows(0, dst.height);
+  }
+  return true;
+}
+
+} // namespace DeepFrame
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "FrameView.h"
+#include "RectList.h"
+#include <cstdint>
+
+namespace DeepFrame {
+
+class ThreadPool;
+
+// Window rect in output pixels, which may hang off the output, clipped to
+// it. Empty when none of the window is on the output.
+[[nodiscard]] TileRect ClipToOutput(int64_t left, int64_t top, int64_t right,
+                                    int64_t bottom, uint32_t width,
+                                    uint32_t height) noexcept;
+
+// Part of `rect` inside `crop`, in crop coordinates; empty if they do not
+// meet.
+[[nodiscard]] TileRect CropRect(const TileRect &rect,
+                                const TileRect &crop) noexcept;
+
+// Adds what `in` reports inside `crop` to `out`, in crop coordinates.
+void CropRects(const RectList &in, const TileRect &crop,
+               RectList &out) noexcept;
+
+// `crop` of `src`, sharing its pixels. Invalid if `crop` is empty or
+// reaches past `src`.
+[[nodiscard]] FrameView CropView(const FrameView &src,
+                                 const TileRect &crop) noexcept;
+
+// Copies `src` into the top-left of the larger `dst` and fills the rest by
+// repeating the last column and row, for models with a fixed input size.
+[[nodiscard]] bool PadFrame(const FrameView &src, const FrameView &dst,
+                            ThreadPool *pool = nullptr) noexcept;
+
+} // namespace DeepFrame
@@ -0,0 +1,153 @@
+#include "FrameFingerprint.h"
+#include "Simd.h"
+#include <algorithm>
+#include <cstring>
+
+namespace DeepFrame {
+
+namespace {
+
+constexpr uint32_t kLaneMul = 0x9E3779B1u;
+constexpr uint32_t kLaneSeed[4] = {0x243F6A88u, 0x85A308D3u, 0x13198A2Eu,
+                                   0x03707344u};
+
+// Each 32-bit lane takes every fourth word of the runs:
+// lane = (lane ^ word) * kLaneMul, then lane ^= lane >> 15. The SIMD paths
+// compute exactly the scalar result, so fingerprints agree across builds.
+void HashRuns(const uint8_t *row, const size_t *offsets, uint32_t count,
+              uint32_t lanes[4]) noexcept {
+#if defined(DEEPFRAME_SSE2)
+  const __m128i mul = _mm_set1_epi32(static_cast<int>(kLaneMul));
+  const __m128i mulOdd = _mm_srli_epi64(mul, 32);
+  __m128i acc = _mm_loadu_si128(reinterpret_cast<const __m128i *>(lanes));
+  for (uint32_t i = 0; i < count; i++) {
+    const __m128i v = _mm_xor_si128(
+        acc, _mm_loadu_si128(
+                 reinterpret_cast<const __m128i *>(row + offsets[i])));
+    // SSE2 has no 32-bit mullo; multiply even and odd lanes separately
+    // and interleave the low halves.
+    const __m128i even = _mm_mul_epu32(v, mul);
+    const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(v, 32), mulOdd);
+    acc = _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                             _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+    acc = _mm_xor_si128(acc, _mm_srli_epi32(acc, 15));
+  }
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), acc);
+#elif defined(DEEPFRAME_NEON)
+  const uint32x4_t mul = vdupq_n_u32(kLaneMul);
+  uint32x4_t acc = vld1q_u32(lanes);
+  for (uint32_t i = 0; i < count; i++) {
+    const uint32x4_t v =
+        veorq_u32(acc, vreinterpretq_u32_u8(vld1q_u8(row + offsets[i])));
+    acc = vmulq_u32(v, mul);
+    acc = veorq_u32(acc, vshrq_n_u32(acc, 15));
+  }
+  vst1q_u32(lanes, acc);
+#else
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t words[4];
+    std::memcpy(words, row + offsets[i], sizeof(words));
+    for (int l = 0; l < 4; l++) {
+      uint32_t lane = (lanes[l] ^ words[l]) * kLaneMul;
+      lanes[l] = lane ^ (lane >> 15);
+    }
+  }
+#endif
+}
+
+} // namespace
+
+FrameFingerprint Fingerprint(const FrameView &frame) noexcept {
+  FrameFingerprint fp;
+  if (!frame.IsValid())
+    return fp;
+  fp.width = frame.width;
+  fp.height = frame.height;
+
+  const size_t rowBytes =
+      static_cast<size_t>(frame.width) * BytesPerPixel(frame.format);
+  // Runs spread evenly over the row, the last one ending at its end. Rows
+  // shorter than a run are hashed from a zero-padded copy.
+  const uint32_t runs = static_cast<uint32_t>(
+      std::clamp<size_t>(rowBytes / 16, 1, FrameFingerprint::kRunsPerRow));
+  size_t offsets[FrameFingerprint::kRunsPerRow];
+  const size_t span = rowBytes >= 16 ? rowBytes - 16 : 0;
+  for (uint32_t i = 0; i < runs; i++)
+    offsets[i] = runs > 1 ? span * i / (runs - 1) : 0;
+
+  uint32_t lanes[4];
+  std::memcpy(lanes, kLaneSeed, sizeof(lanes));
+  const uint32_t rows = std::min(frame.height, FrameFingerprint::kRows);
+  uint8_t padded[16] = {};
+  for (uint32_t i = 0; i < rows; i++) {
+    const uint32_t y = static_cast<uint32_t>(
+        (2 * static_cast<uint64_t>(i) + 1) * frame.height / (2 * rows));
+    const uint8_t *row = frame.Row(y);
+    if (rowBytes < 16) {
+      std::memcpy(padded, row, rowBytes);
+      row = padded;
+    }
+    HashRuns(row, offsets, runs, lanes);
+  }
+
+  uint64_t h = 0xCBF29CE484222325ull ^
+               (static_cast<uint64_t>(frame.width) << 32 | frame.height);
+  for (uint32_t lane : lanes) {
+    h = (h ^ lane) * 0x100000001B3ull;
+    h ^= h >> 29;
+  }
+  fp.hash = h;
+  return fp;
+}
+
+bool SameContent(const FrameView &a, const FrameView &b,
+                 const RectList *rects) noexcept {
+  if (!a.IsValid() || !b.IsValid() || a.width != b.width ||
+      a.height != b.height || a.format != b.format) {
+    return false;
+  }
+  const size_t bpp = BytesPerPixel(a.format);
+  const auto same = [&](const TileRect &rect) {
+    const uint32_t right = std::min(rect.right, a.width);
+    const uint32_t bottom = std::min(rect.bottom, a.height);
+    if (rect.left >= right || rect.top >= bottom)
+      return true;
+    const size_t offset = rect.left * bpp;
+    const size_t bytes = (right - rect.left) * bpp;
+    for (uint32_t y = rect.top; y < bottom; y++)
+      if (std::memcmp(a.Row(y) + offset, b.Row(y) + offset, bytes))
+        return false;
+    return true;
+  };
+  if (!rects || rects->IsFull())
+    return same({0, 0, a.width, a.height});
+  for (const TileRect &rect : *rects)
+    if (!same(rect))
+      return false;
+  return true;
+}
+
+bool DuplicateDetector::IsDuplicate(const FrameView &prev,
+                                    const FrameView &curr,
+                                    const RectList *changes) noexcept {
+  if (!prev.IsValid() || !curr.IsValid() || prev.width != curr.width ||
+      prev.height != curr.height || prev.format != curr.format) {
+    return false;
+  }
+  stats_.checked++;
+
+  bool duplicate;
+  if (changes && !changes->IsFull()) {
+    // Already as narrow as sampling could make it.
+    duplicate = changes->IsEmpty() || SameContent(prev, curr, changes);
+  } else if (Fingerprint(prev) != Fingerprint(curr)) {
+    duplicate = false;
+  } else {
+    duplicate = SameContent(prev, curr);
+    stats_.collisions += !duplicate;
+  }
+  stats_.duplicates += duplicate;
+  return duplicate;
+}
+
+} // namespace DeepFrame
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "FrameView.h"
+#include "RectList.h"
+#include <cstdint>
+
+namespace DeepFrame {
+
+// Hash of a sparse grid of 16-byte runs across a frame. Different hashes
+// prove the frames differ; equal ones only suggest they are the same, since
+// a change can fall between the samples.
+struct FrameFingerprint {
+  // Rows and 16-byte runs per row that are sampled, at most.
+  static constexpr uint32_t kRows = 64;
+  static constexpr uint32_t kRunsPerRow = 32;
+
+  uint64_t hash = 0;
+  uint32_t width = 0;
+  uint32_t height = 0;
+
+  [[nodiscard]] bool operator==(const FrameFingerprint &o) const noexcept {
+    return hash == o.hash && width == o.width && height == o.height;
+  }
+  [[nodiscard]] bool operator!=(const FrameFingerprint &o) const noexcept {
+    return !(*this == o);
+  }
+};
+
+[[nodiscard]] FrameFingerprint Fingerprint(const FrameView &frame) noexcept;
+
+// Byte comparison of two frames of the same size and format, limited to
+// `rects` when given; stops at the first difference.
+[[nodiscard]] bool SameContent(const FrameView &a, const FrameView &b,
+                               const RectList *rects = nullptr) noexcept;
+
+struct DuplicateStats {
+  uint64_t checked = 0;
+  uint64_t duplicates = 0;
+  // Fingerprints matched but the full comparison found a difference.
+  uint64_t collisions = 0;
+};
+
+// Finds frames that repeat their predecessor, such as the ones Desktop
+// Duplication delivers for a pointer move over unchanged content.
+class DuplicateDetector {
+public:
+  // `changes`, when known, bounds where `curr` can differ from `prev`: an
+  // empty list is a duplicate without looking, and a partial one is
+  // compared directly. Otherwise the fingerprints are compared and a match
+  // is confirmed byte for byte, so a duplicate is never a guess.
+  [[nodiscard]] bool IsDuplicate(const FrameView &prev, const FrameView &curr,
+                                 const RectList *changes = nullptr) noexcept;
+
+  void Reset() noexcept { stats_ = {}; }
+  [[nodiscard]] const DuplicateStats &Stats() const noexcept { return stats_; }
+
+private:
+  DuplicateStats stats_;
+};
+
+} // namespace DeepFrame
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace DeepFrame {
+
+enum class PixelFormat : uint8_t {
+  BGRA8,
+  Gray8
+};
+
+[[nodiscard]] constexpr uint32_t BytesPerPixel(PixelFormat format) noexcept {
+  return format == PixelFormat::BGRA8 ? 4u : 1u;
+}
+
+// Non-owning view of a CPU-visible image: a mapped staging texture, a
+// decoded file frame or a plain heap buffer.
+struct FrameView {
+  uint8_t *data = nullptr;
+  uint32_t width = 0;
+  uint32_t height = 0;
+  uint32_t pitch = 0;
+  PixelFormat format = PixelFormat::BGRA8;
+
+  [[nodiscard]] uint8_t *Row(uint32_t y) const noexcept {
+    return data + static_cast<size_t>(y) * pitch;
+  }
+  [[nodiscard]] bool IsValid() const noexcept {
+    return data && width > 0 && height > 0 &&
+           pitch >= width * BytesPerPixel(format);
+  }
+};
+
+} // namespace DeepFrame
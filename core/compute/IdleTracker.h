@@ -0,0 +1,70 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace DeepFrame {
+
+// Decides when a stream has gone static: idle once no new content has
+// arrived for `idleAfter`, active again with the next frame that has some.
+// Duplicates and empty polls keep the clock running without resetting it.
+// One thread.
+class IdleTracker {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit IdleTracker(std::chrono::milliseconds idleAfter =
+                           std::chrono::milliseconds(250)) noexcept
+      : idleAfter_(idleAfter) {}
+
+  // True when this changed the state.
+  bool Update(bool newContent, Clock::time_point now) noexcept {
+    if (newContent) {
+      last_ = now;
+      started_ = true;
+      if (!idle_)
+        return false;
+      idle_ = false;
+      idleTotal_ += now - idleSince_;
+      return true;
+    }
+    if (!started_) {
+      last_ = now;
+      started_ = true;
+    }
+    if (idle_ || now - last_ < idleAfter_)
+      return false;
+    idle_ = true;
+    idleSince_ = now;
+    entries_++;
+    return true;
+  }
+
+  void Reset() noexcept {
+    idleTotal_ = Clock::duration::zero();
+    entries_ = 0;
+    started_ = false;
+    idle_ = false;
+  }
+
+  [[nodiscard]] bool IsIdle() const noexcept { return idle_; }
+  // Times the stream went idle.
+  [[nodiscard]] uint64_t Entries() const noexcept { return entries_; }
+  // Total time spent idle, including the current stretch.
+  [[nodiscard]] double IdleMs(Clock::time_point now) const noexcept {
+    const Clock::duration total =
+        idle_ ? idleTotal_ + (now - idleSince_) : idleTotal_;
+    return std::chrono::duration<double, std::milli>(total).count();
+  }
+
+private:
+  Clock::duration idleAfter_;
+  Clock::time_point last_;
+  Clock::time_point idleSince_;
+  Clock::duration idleTotal_{0};
+  uint64_t entries_ = 0;
+  bool started_ = false;
+  bool idle_ = false;
+};
+
+} // namespace DeepFrame
@@ -0,0 +1,44 @@
+#pragma once
+
+namespace DeepFrame {
+
+enum class InterpolationMode {
+  FAST,
+  BALANCED,
+  QUALITY,
+  OPTICAL_FLOW, // model-free dense flow on the CPU
+  BLEND,        // cross-fade of the two frames, no motion
+  EXTRAPOLATE   // predicts past the newest frame from dense flow on the CPU
+};
+
+// Modes served by an ONNX model; the rest run on the CPU engines.
+[[nodiscard]] constexpr bool UsesModel(InterpolationMode mode) noexcept {
+  return mode != InterpolationMode::OPTICAL_FLOW &&
+         mode != InterpolationMode::BLEND &&
+         mode != InterpolationMode::EXTRAPOLATE;
+}
+
+// Per-frame budget of each mode. For a model this is how long the
+// stand-in queued in its slot (RingBuffer::PushSpeculative) is held back;
+// a later model frame still replaces it if present has not taken it yet.
+[[nodiscard]] constexpr float TimeBudgetMs(InterpolationMode mode) noexcept {
+  switch (mode) {
+  case InterpolationMode::FAST:
+    return 8.0f;
+  case InterpolationMode::BALANCED:
+    return 12.0f;
+  case InterpolationMode::QUALITY:
+    return 20.0f;
+  case InterpolationMode::OPTICAL_FLOW:
+    return 16.0f;
+  case InterpolationMode::BLEND:
+    return 2.0f;
+  // Shown half an interval after the frame it is predicted from.
+  case InterpolationMode::EXTRAPOLATE:
+    return 8.0f;
+  default:
+    return 8.0f;
+  }
+}
+
+} // namespace DeepFrame
@@ -0,0 +1,359 @@
+#include "Log.h"
+#include "SpscRing.h"
+#include <algorithm>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace DeepFrame {
+
+namespace LogDetail {
+std::atomic<LogLevel> gLevel{LogLevel::Info};
+}
+
+namespace {
+
+using LogDetail::ArgType;
+using LogDetail::Record;
+
+// 128 KB per logging thread.
+constexpr size_t kRingRecords = 512;
+
+// Cleared when the drain is destroyed at exit; threads still logging after
+// that lose their messages instead of touching freed rings.
+std::atomic<bool> gDrainAlive{true};
+
+std::atomic<uint64_t> gSequence{0};
+
+struct ThreadRing {
+  RingCursor<kRingRecords> cursor;
+  Record records[kRingRecords];
+  // Set when the owning thread exits; the drain frees the ring once empty.
+  std::atomic<bool> retired{false};
+};
+
+// Expands one record. Conversions are re-issued to snprintf one at a time
+// with the length modifier replaced by the type the argument was stored
+// as, so %d, %ld and %zu all work from the same 64-bit slot.
+void Format(const Record &record, std::string &out) {
+  size_t next = 0;
+  const char *f = record.format;
+  while (*f) {
+    if (*f != '%') {
+      out.push_back(*f++);
+      continue;
+    }
+    if (f[1] == '%') {
+      out.push_back('%');
+      f += 2;
+      continue;
+    }
+
+    const char *start = f++;
+    char spec[24] = "%";
+    size_t length = 1;
+    while (*f && std::strchr("-+ #0123456789.", *f) && length < 16)
+      spec[length++] = *f++;
+    while (*f && std::strchr("hlzjtL", *f))
+      f++;
+    const char conversion = *f ? *f++ : '\0';
+    if (next >= record.argCount) {
+      out.append(start, f);
+      continue;
+    }
+
+    const LogDetail::Arg &arg = record.args[next];
+    const ArgType type = record.types[next++];
+    const bool isSigned = type == ArgType::Int || type == ArgType::Int32;
+    const auto asInt = [&]() -> long long {
+      return type == ArgType::Double ? static_cast<long long>(arg.d)
+             : isSigned              ? arg.i
+                                     : static_cast<long long>(arg.u);
+    };
+    const auto asDouble = [&]() -> double {
+      return type == ArgType::Double ? arg.d
+             : isSigned              ? static_cast<double>(arg.i)
+                                     : static_cast<double>(arg.u);
+    };
+
+    char buffer[160];
+    int written = 0;
+    switch (conversion) {
+    case 'd':
+    case 'i':
+      std::strcpy(spec + length, "lld");
+      written = std::snprintf(buffer, sizeof(buffer), spec, asInt());
+      break;
+    case 'u':
+    case 'x':
+    case 'X':
+    case 'o':
+      spec[length] = 'l';
+      spec[length + 1] = 'l';
+      spec[length + 2] = conversion;
+      spec[length + 3] = '\0';
+      written = std::snprintf(
+          buffer, sizeof(buffer), spec,
+          type == ArgType::Int32
+              ? static_cast<unsigned long long>(static_cast<uint32_t>(arg.i))
+              : static_cast<unsigned long long>(asInt()));
+      break;
+    case 'c':
+      std::strcpy(spec + length, "c");
+      written = std::snprintf(buffer, sizeof(buffer), spec,
+                              static_cast<int>(asInt()));
+      break;
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+      spec[length] = conversion;
+      spec[length + 1] = '\0';
+      written = std::snprintf(buffer, sizeof(buffer), spec, asDouble());
+      break;
+    case 's':
+      std::strcpy(spec + length, "s");
+      written = std::snprintf(buffer, sizeof(buffer), spec,
+                              type == ArgType::String
+                                  ? record.text + arg.text
+                                  : "?");
+      break;
+    case 'p':
+      std::strcpy(spec + length, "p");
+      written = std::snprintf(buffer, sizeof(buffer), spec,
+                              type == ArgType::Pointer ? arg.p : nullptr);
+      break;
+    default:
+      out.append(start, f);
+      continue;
+    }
+    if (written > 0)
+      out.append(buffer, std::min(static_cast<size_t>(written),
+                                  sizeof(buffer) - 1));
+  }
+
+  if (record.suppressed) {
+    const bool newline = !out.empty() && out.back() == '\n';
+    if (newline)
+      out.pop_back();
+    out += " (+" + std::to_string(record.suppressed) + " suppressed)";
+    if (newline)
+      out.push_back('\n');
+  }
+}
+
+class Drain {
+public:
+  static Drain &Instance() {
+    static Drain drain;
+    return drain;
+  }
+
+  ~Drain() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    if (thread_.joinable())
+      thread_.join();
+    gDrainAlive.store(false, std::memory_order_release);
+  }
+
+  ThreadRing *Register() noexcept {
+    try {
+      auto ring = std::make_unique<ThreadRing>();
+      ThreadRing *raw = ring.get();
+      std::lock_guard<std::mutex> lock(mutex_);
+      rings_.push_back(std::move(ring));
+      if (!thread_.joinable())
+        thread_ = std::thread(&Drain::Run, this);
+      return raw;
+    } catch (...) {
+      return nullptr;
+    }
+  }
+
+  void Flush() noexcept {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!thread_.joinable())
+      return;
+    const uint64_t ticket = ++flushRequested_;
+    wake_.notify_all();
+    flushed_.wait(lock, [&] { return flushDone_ >= ticket || stop_; });
+  }
+
+  void SetSink(FILE *sink) noexcept {
+    sink_.store(sink, std::memory_order_relaxed);
+  }
+
+  std::atomic<uint64_t> written{0};
+  std::atomic<uint64_t> dropped{0};
+  std::atomic<uint64_t> suppressed{0};
+
+private:
+  Drain() = default;
+
+  void Run() noexcept {
+    std::vector<ThreadRing *> rings;
+    std::string line;
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+      // Records committed before a Flush are visible to the pass that
+      // starts after it was requested.
+      const uint64_t ticket = flushRequested_;
+      rings.clear();
+      for (const auto &ring : rings_)
+        rings.push_back(ring.get());
+      lock.unlock();
+
+      const size_t count = DrainOnce(rings, line);
+
+      lock.lock();
+      rings_.erase(std::remove_if(rings_.begin(), rings_.end(),
+                                  [](const std::unique_ptr<ThreadRing> &r) {
+                                    return r->retired.load(
+                                               std::memory_order_acquire) &&
+                                           r->cursor.Count() == 0;
+                                  }),
+                   rings_.end());
+      if (flushDone_ < ticket) {
+        flushDone_ = ticket;
+        flushed_.notify_all();
+      }
+      if (count)
+        continue;
+      if (stop_)
+        break;
+      wake_.wait_for(lock, std::chrono::milliseconds(5),
+                     [&] { return stop_ || flushRequested_ != ticket; });
+    }
+    flushDone_ = flushRequested_;
+    flushed_.notify_all();
+  }
+
+  // Merges the rings in call order and writes what is there now.
+  size_t DrainOnce(const std::vector<ThreadRing *> &rings,
+                   std::string &line) noexcept {
+    FILE *sink = sink_.load(std::memory_order_relaxed);
+    size_t count = 0;
+    // Bounded so a thread that never stops logging cannot hold off
+    // flushes and ring cleanup.
+    while (count < 4 * kRingRecords) {
+      ThreadRing *oldest = nullptr;
+      size_t oldestSlot = 0;
+      for (ThreadRing *ring : rings) {
+        const size_t slot = ring->cursor.BeginPop();
+        if (slot == kRingRecords)
+          continue;
+        if (!oldest || ring->records[slot].sequence <
+                           oldest->records[oldestSlot].sequence) {
+          oldest = ring;
+          oldestSlot = slot;
+        }
+      }
+      if (!oldest)
+        break;
+
+      try {
+        line.clear();
+        Format(oldest->records[oldestSlot], line);
+        std::fwrite(line.data(), 1, line.size(), sink);
+      } catch (...) {
+      }
+      oldest->cursor.CommitPop();
+      count++;
+    }
+    if (count) {
+      std::fflush(sink);
+      written.fetch_add(count, std::memory_order_relaxed);
+    }
+    return count;
+  }
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable flushed_;
+  std::vector<std::unique_ptr<ThreadRing>> rings_;
+  std::thread thread_;
+  std::atomic<FILE *> sink_{stderr};
+  uint64_t flushRequested_ = 0;
+  uint64_t flushDone_ = 0;
+  bool stop_ = false;
+};
+
+struct ThreadSlot {
+  ThreadRing *ring = nullptr;
+  bool registered = false;
+
+  ~ThreadSlot() {
+    if (ring && gDrainAlive.load(std::memory_order_acquire))
+      ring->retired.store(true, std::memory_order_release);
+  }
+};
+
+thread_local ThreadSlot tlsSlot;
+
+} // namespace
+
+namespace LogDetail {
+
+Record *BeginRecord() noexcept {
+  if (!gDrainAlive.load(std::memory_order_acquire))
+    return nullptr;
+  ThreadSlot &slot = tlsSlot;
+  if (!slot.registered) {
+    slot.registered = true;
+    slot.ring = Drain::Instance().Register();
+  }
+  if (!slot.ring)
+    return nullptr;
+
+  const size_t index = slot.ring->cursor.BeginPush();
+  if (index == kRingRecords) {
+    Drain::Instance().dropped.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  Record &record = slot.ring->records[index];
+  record.sequence = gSequence.fetch_add(1, std::memory_order_relaxed);
+  return &record;
+}
+
+void CommitRecord() noexcept { tlsSlot.ring->cursor.CommitPush(); }
+
+void CountSuppressed() noexcept {
+  Drain::Instance().suppressed.fetch_add(1, std::memory_order_relaxed);
+}
+
+} // namespace LogDetail
+
+namespace Log {
+
+void SetLevel(LogLevel level) noexcept {
+  LogDetail::gLevel.store(level, std::memory_order_relaxed);
+}
+
+void SetSink(FILE *sink) noexcept {
+  Drain::Instance().SetSink(sink ? sink : stderr);
+}
+
+void Flush() noexcept { Drain::Instance().Flush(); }
+
+LogStats GetStats() noexcept {
+  Drain &drain = Drain::Instance();
+  LogStats stats;
+  stats.written = drain.written.load(std::memory_order_relaxed);
+  stats.dropped = drain.dropped.load(std::memory_order_relaxed);
+  stats.suppressed = drain.suppressed.load(std::memory_order_relaxed);
+  return stats;
+}
+
+} // namespace Log
+
+} // namespace DeepFrame
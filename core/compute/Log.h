@@ -0,0 +1,222 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <type_traits>
+
+namespace DeepFrame {
+
+enum class LogLevel : uint8_t { Debug, Info, Warn, Error, Off };
+
+struct LogStats {
+  uint64_t written = 0;
+  // Lost because the calling thread's ring was full.
+  uint64_t dropped = 0;
+  // Held back by a RateLimiter.
+  uint64_t suppressed = 0;
+};
+
+namespace LogDetail {
+
+constexpr size_t kMaxArgs = 8;
+constexpr size_t kRecordBytes = 256;
+
+// Int32 keeps %x of a negative 32-bit value (an HRESULT) at 8 digits.
+enum class ArgType : uint8_t { Int, Int32, Uint, Double, String, Pointer };
+
+union Arg {
+  int64_t i;
+  uint64_t u;
+  double d;
+  const void *p;
+  // Offset of a NUL-terminated copy in Record::text.
+  uint16_t text;
+};
+
+struct RecordHeader {
+  // Global call order, for merging the per-thread rings.
+  uint64_t sequence;
+  const char *format;
+  uint32_t suppressed;
+  uint16_t textUsed;
+  LogLevel level;
+  uint8_t argCount;
+  ArgType types[kMaxArgs];
+  Arg args[kMaxArgs];
+};
+
+// One call: the format pointer and raw arguments, formatted later on the
+// drain thread. Strings are copied since the caller's may not live that
+// long.
+struct Record : RecordHeader {
+  char text[kRecordBytes - sizeof(RecordHeader)];
+};
+static_assert(sizeof(Record) == kRecordBytes, "log record layout");
+
+extern std::atomic<LogLevel> gLevel;
+
+// Slot in the calling thread's ring, or null when it is full.
+[[nodiscard]] Record *BeginRecord() noexcept;
+void CommitRecord() noexcept;
+void CountSuppressed() noexcept;
+
+// Millisecond-grade clock for rate limiting. The coarse Linux clock is a
+// plain memory read; steady_clock costs more than the rest of a log call.
+[[nodiscard]] inline uint64_t CoarseNowNs() noexcept {
+#if defined(CLOCK_MONOTONIC_COARSE)
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+  return static_cast<uint64_t>(now.tv_sec) * 1000000000ull +
+         static_cast<uint64_t>(now.tv_nsec);
+#else
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+#endif
+}
+
+inline void EncodeString(Record &record, const char *value) noexcept {
+  constexpr size_t kCapacity = sizeof(Record::text);
+  if (!value)
+    value = "(null)";
+  const size_t room = kCapacity - 1 - record.textUsed;
+  const size_t length = std::min(std::strlen(value), room);
+  std::memcpy(record.text + record.textUsed, value, length);
+  record.text[record.textUsed + length] = '\0';
+  record.args[record.argCount].text = record.textUsed;
+  record.types[record.argCount] = ArgType::String;
+  // The last byte stays free, so a full buffer still ends strings in "".
+  record.textUsed = static_cast<uint16_t>(
+      std::min(record.textUsed + length + 1, kCapacity - 1));
+}
+
+template <typename T> void Encode(Record &record, const T &value) noexcept {
+  using U = std::decay_t<T>;
+  Arg &arg = record.args[record.argCount];
+  ArgType &type = record.types[record.argCount];
+  if constexpr (std::is_enum_v<U>) {
+    Encode(record, static_cast<std::underlying_type_t<U>>(value));
+    return;
+  } else if constexpr (std::is_same_v<U, bool> || std::is_unsigned_v<U>) {
+    arg.u = static_cast<uint64_t>(value);
+    type = ArgType::Uint;
+  } else if constexpr (std::is_integral_v<U>) {
+    arg.i = static_cast<int64_t>(value);
+    type = sizeof(U) <= 4 ? ArgType::Int32 : ArgType::Int;
+  } else if constexpr (std::is_floating_point_v<U>) {
+    arg.d = static_cast<double>(value);
+    type = ArgType::Double;
+  } else if constexpr (std::is_same_v<U, const char *> ||
+                       std::is_same_v<U, char *>) {
+    EncodeString(record, value);
+  } else if constexpr (std::is_same_v<U, std::string>) {
+    EncodeString(record, value.c_str());
+  } else if constexpr (std::is_pointer_v<U>) {
+    arg.p = static_cast<const void *>(value);
+    type = ArgType::Pointer;
+  } else {
+    static_assert(std::is_pointer_v<U>, "unsupported log argument type");
+  }
+  record.argCount++;
+}
+
+template <typename... Args>
+void Emit(LogLevel level, uint32_t suppressed, const char *format,
+          const Args &...args) noexcept {
+  static_assert(sizeof...(Args) <= kMaxArgs, "too many log arguments");
+  Record *record = BeginRecord();
+  if (!record)
+    return;
+  record->format = format;
+  record->level = level;
+  record->suppressed = suppressed;
+  record->argCount = 0;
+  record->textUsed = 0;
+  (Encode(*record, args), ...);
+  CommitRecord();
+}
+
+} // namespace LogDetail
+
+// Asynchronous printf-style logging. A call copies its format pointer and
+// arguments into a ring owned by the calling thread and returns; a
+// background thread formats and writes them in call order. The
+// format must be a string literal. A full ring drops the message rather
+// than block the caller.
+namespace Log {
+
+void SetLevel(LogLevel level) noexcept;
+[[nodiscard]] inline bool Enabled(LogLevel level) noexcept {
+  return level >= LogDetail::gLevel.load(std::memory_order_relaxed);
+}
+
+// stderr by default.
+void SetSink(FILE *sink) noexcept;
+// Returns once everything logged before the call has been written.
+void Flush() noexcept;
+[[nodiscard]] LogStats GetStats() noexcept;
+
+template <typename... Args>
+void Write(LogLevel level, const char *format, const Args &...args) noexcept {
+  if (Enabled(level))
+    LogDetail::Emit(level, 0, format, args...);
+}
+
+template <typename... Args>
+void Debug(const char *format, const Args &...args) noexcept {
+  Write(LogLevel::Debug, format, args...);
+}
+template <typename... Args>
+void Info(const char *format, const Args &...args) noexcept {
+  Write(LogLevel::Info, format, args...);
+}
+template <typename... Args>
+void Warn(const char *format, const Args &...args) noexcept {
+  Write(LogLevel::Warn, format, args...);
+}
+template <typename... Args>
+void Error(const char *format, const Args &...args) noexcept {
+  Write(LogLevel::Error, format, args...);
+}
+
+// Lets one message through per interval from a call site, typically a
+// function-local static. The next message that passes reports how many
+// were held back.
+class RateLimiter {
+public:
+  explicit RateLimiter(uint32_t intervalMs) noexcept
+      : intervalNs_(static_cast<uint64_t>(intervalMs) * 1000000) {}
+
+  template <typename... Args>
+  void Write(LogLevel level, const char *format,
+             const Args &...args) noexcept {
+    if (!Enabled(level))
+      return;
+    const uint64_t now = LogDetail::CoarseNowNs();
+    uint64_t next = next_.load(std::memory_order_relaxed);
+    if (now < next || !next_.compare_exchange_strong(
+                          next, now + intervalNs_, std::memory_order_relaxed)) {
+      suppressed_.fetch_add(1, std::memory_order_relaxed);
+      LogDetail::CountSuppressed();
+      return;
+    }
+    LogDetail::Emit(level, suppressed_.exchange(0, std::memory_order_relaxed),
+                    format, args...);
+  }
+
+private:
+  const uint64_t intervalNs_;
+  std::atomic<uint64_t> next_{0};
+  std::atomic<uint32_t> suppressed_{0};
+};
+
+} // namespace Log
+
+} // namespace DeepFrame
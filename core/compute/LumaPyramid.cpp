@@ -0,0 +1,74 @@
+#include "LumaPyramid.h"
+#include "ThreadPool.h"
+#include <algorithm>
+
+namespace DeepFrame {
+
+void LumaImage::Resize(uint32_t w, uint32_t h) {
+  width = w;
+  height = h;
+  pitch = (w + 31u) & ~31u;
+  if (pixels.size() < static_cast<size_t>(pitch) * h)
+    pixels.resize(static_cast<size_t>(pitch) * h);
+}
+
+static void ForRows(ThreadPool *pool, uint32_t rows, RangeFn fn) noexcept {
+  if (pool) {
+    pool->ParallelFor(rows, 32, fn);
+  } else {
+    fn(0, rows);
+  }
+}
+
+void ExtractLuma(const FrameView &bgra, LumaImage &out,
+                 ThreadPool *pool) noexcept {
+  out.Resize(bgra.width, bgra.height);
+
+  ForRows(pool, bgra.height, [&](size_t begin, size_t end) {
+    for (size_t y = begin; y < end; y++) {
+      const uint8_t *src = bgra.Row(static_cast<uint32_t>(y));
+      uint8_t *dst = out.Row(static_cast<uint32_t>(y));
+      for (uint32_t x = 0; x < bgra.width; x++) {
+        uint32_t b = src[x * 4 + 0];
+        uint32_t g = src[x * 4 + 1];
+        uint32_t r = src[x * 4 + 2];
+        dst[x] = static_cast<uint8_t>((r * 77 + g * 150 + b * 29 + 128) >> 8);
+      }
+    }
+  });
+}
+
+void DownsampleLuma(const LumaImage &src, LumaImage &dst,
+                    ThreadPool *pool) noexcept {
+  dst.Resize(std::max(1u, src.width / 2), std::max(1u, src.height / 2));
+
+  ForRows(pool, dst.height, [&](size_t begin, size_t end) {
+    for (size_t y = begin; y < end; y++) {
+      uint32_t sy = std::min(static_cast<uint32_t>(y) * 2, src.height - 1);
+      uint32_t sy1 = std::min(sy + 1, src.height - 1);
+      const uint8_t *r0 = src.Row(sy);
+      const uint8_t *r1 = src.Row(sy1);
+      uint8_t *d = dst.Row(static_cast<uint32_t>(y));
+      for (uint32_t x = 0; x < dst.width; x++) {
+        uint32_t sx = x * 2;
+        uint32_t sx1 = std::min(sx + 1, src.width - 1);
+        d[x] = static_cast<uint8_t>(
+            (r0[sx] + r0[sx1] + r1[sx] + r1[sx1] + 2) >> 2);
+      }
+    }
+  });
+}
+
+void LumaPyramid::Build(const FrameView &bgra, uint32_t levels,
+                        ThreadPool *pool) noexcept {
+  levels = std::max(1u, levels);
+  if (images_.size() < levels)
+    images_.resize(levels);
+
+  ExtractLuma(bgra, images_[0], pool);
+  for (uint32_t i = 1; i < levels; i++)
+    DownsampleLuma(images_[i - 1], images_[i], pool);
+  levels_ = levels;
+}
+
+} // namespace DeepFrame
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "FrameView.h"
+#include <cstdint>
+#include <vector>
+
+namespace DeepFrame {
+
+class ThreadPool;
+
+struct LumaImage {
+  std::vector<uint8_t> pixels;
+  uint32_t width = 0;
+  uint32_t height = 0;
+  uint32_t pitch = 0;
+
+  void Resize(uint32_t w, uint32_t h);
+
+  [[nodiscard]] const uint8_t *Row(uint32_t y) const noexcept {
+    return pixels.data() + static_cast<size_t>(y) * pitch;
+  }
+  [[nodiscard]] uint8_t *Row(uint32_t y) noexcept {
+    return pixels.data() + static_cast<size_t>(y) * pitch;
+  }
+};
+
+// BT.601 luma in 8.8 fixed point; this is what every motion search works on.
+void ExtractLuma(const FrameView &bgra, LumaImage &out,
+                 ThreadPool *pool = nullptr) noexcept;
+
+// 2x2 box filter.
+void DownsampleLuma(const LumaImage &src, LumaImage &dst,
+                    ThreadPool *pool = nullptr) noexcept;
+
+class LumaPyramid {
+public:
+  void Build(const FrameView &bgra, uint32_t levels,
+             ThreadPool *pool = nullptr) noexcept;
+
+  [[nodiscard]] uint32_t Levels() const noexcept { return levels_; }
+  [[nodiscard]] const LumaImage &Level(uint32_t i) const noexcept {
+    return images_[i];
+  }
+
+private:
+  std::vector<LumaImage> images_;
+  uint32_t levels_ = 0;
+};
+
+} // namespace DeepFrame
@@ -0,0 +1,136 @@
+#include "MappedFile.h"
+#include <algorithm>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace DeepFrame {
+
+namespace fs = std::filesystem;
+
+MappedFile::~MappedFile() noexcept { Close(); }
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const fs::path &path, MapAccess access) noexcept {
+  Close();
+
+  // Both kinds of file are read front to back.
+  (void)access;
+  HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING,
+                            FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+
+  LARGE_INTEGER size{};
+  if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+    CloseHandle(file);
+    return false;
+  }
+
+  HANDLE mapping =
+      CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping) {
+    CloseHandle(file);
+    return false;
+  }
+
+  const void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (!view) {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return false;
+  }
+
+  file_ = file;
+  mapping_ = mapping;
+  data_ = view;
+  size_ = static_cast<size_t>(size.QuadPart);
+  return true;
+}
+
+void MappedFile::Close() noexcept {
+  if (data_)
+    UnmapViewOfFile(data_);
+  if (mapping_)
+    CloseHandle(static_cast<HANDLE>(mapping_));
+  if (file_)
+    CloseHandle(static_cast<HANDLE>(file_));
+  data_ = nullptr;
+  mapping_ = nullptr;
+  file_ = nullptr;
+  size_ = 0;
+}
+
+void MappedFile::Prefetch(size_t offset, size_t size) const noexcept {
+  if (!data_ || offset >= size_)
+    return;
+  WIN32_MEMORY_RANGE_ENTRY range;
+  range.VirtualAddress =
+      const_cast<uint8_t *>(static_cast<const uint8_t *>(data_) + offset);
+  range.NumberOfBytes = std::min(size, size_ - offset);
+  PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
+
+#else
+
+bool MappedFile::Open(const fs::path &path, MapAccess access) noexcept {
+  Close();
+
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return false;
+
+  struct stat st {};
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    ::close(fd);
+    return false;
+  }
+
+  void *view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ,
+                    MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (view == MAP_FAILED)
+    return false;
+
+  madvise(view, static_cast<size_t>(st.st_size),
+          access == MapAccess::Sequential ? MADV_SEQUENTIAL : MADV_WILLNEED);
+  data_ = view;
+  size_ = static_cast<size_t>(st.st_size);
+  return true;
+}
+
+void MappedFile::Close() noexcept {
+  if (data_)
+    munmap(const_cast<void *>(data_), size_);
+  data_ = nullptr;
+  size_ = 0;
+}
+
+void MappedFile::Prefetch(size_t offset, size_t size) const noexcept {
+  if (!data_ || offset >= size_)
+    return;
+  // madvise wants a page-aligned start.
+  const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  const size_t begin = offset & ~(page - 1);
+  const size_t end = offset + std::min(size, size_ - offset);
+  madvise(const_cast<uint8_t *>(static_cast<const uint8_t *>(data_)) + begin,
+          end - begin, MADV_WILLNEED);
+}
+
+#endif
+
+} // namespace DeepFrame
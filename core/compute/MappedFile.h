@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+namespace DeepFrame {
+
+// How a mapping will be read, passed on to the kernel's readahead.
+enum class MapAccess : uint8_t {
+  // Fault the whole file in up front; models, read in full right away.
+  WholeFile,
+  // Read once front to back, possibly much larger than memory; video.
+  Sequential
+};
+
+// Read-only memory mapping of a whole file. The view stays valid until
+// Close() or destruction, so ORT can reference the bytes directly.
+class MappedFile {
+public:
+  MappedFile() noexcept = default;
+  ~MappedFile() noexcept;
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  [[nodiscard]] bool Open(const std::filesystem::path &path,
+                          MapAccess access = MapAccess::WholeFile) noexcept;
+  void Close() noexcept;
+
+  // Starts reading [offset, offset + size) in the background so a later
+  // touch does not wait on the disk.
+  void Prefetch(size_t offset, size_t size) const noexcept;
+
+  [[nodiscard]] const void *Data() const noexcept { return data_; }
+  [[nodiscard]] size_t Size() const noexcept { return size_; }
+  [[nodiscard]] bool IsOpen() const noexcept { return data_ != nullptr; }
+
+private:
+  const void *data_ = nullptr;
+  size_t size_ = 0;
+#ifdef _WIN32
+  void *file_ = nullptr;
+  void *mapping_ = nullptr;
+#endif
+};
+
+} // namespace DeepFrame
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace DeepFrame {
+
+// Who holds a buffer, for the memory breakdown in the stats.
+enum class MemorySubsystem : uint8_t {
+  Capture,       // duplicated desktop surfaces
+  Interpolation, // CPU engine read-back and output buffers
+  Tensors,       // model inputs and outputs
+  Present,       // present ring and swap chain
+  Export,        // shared frame ring and its read-back
+  Count
+};
+
+enum class MemoryDomain : uint8_t { Cpu, Gpu };
+
+constexpr size_t kMemorySubsystems =
+    static_cast<size_t>(MemorySubsystem::Count);
+
+[[nodiscard]] constexpr const char *
+MemorySubsystemName(MemorySubsystem subsystem) noexcept {
+  switch (subsystem) {
+  case MemorySubsystem::Capture:
+    return "capture";
+  case MemorySubsystem::Interpolation:
+    return "interpolation";
+  case MemorySubsystem::Tensors:
+    return "tensors";
+  case MemorySubsystem::Present:
+    return "present";
+  case MemorySubsystem::Export:
+    return "export";
+  case MemorySubsystem::Count:
+    break;
+  }
+  return "";
+}
+
+struct MemoryUsage {
+  std::array<uint64_t, kMemorySubsystems> cpuBytes{};
+  std::array<uint64_t, kMemorySubsystems> gpuBytes{};
+
+  [[nodiscard]] uint64_t CpuTotal() const noexcept {
+    uint64_t total = 0;
+    for (uint64_t bytes : cpuBytes)
+      total += bytes;
+    return total;
+  }
+  [[nodiscard]] uint64_t GpuTotal() const noexcept {
+    uint64_t total = 0;
+    for (uint64_t bytes : gpuBytes)
+      total += bytes;
+    return total;
+  }
+};
+
+[[nodiscard]] inline bool operator==(const MemoryUsage &a,
+                                     const MemoryUsage &b) noexcept {
+  return a.cpuBytes == b.cpuBytes && a.gpuBytes == b.gpuBytes;
+}
+
+// Process-wide totals of the large buffers the pipeline owns, kept by the
+// MemoryCharge next to each one. Small and transient allocations are not
+// counted.
+class MemoryLedger {
+public:
+  static void Add(MemorySubsystem subsystem, MemoryDomain domain,
+                  int64_t delta) noexcept {
+    Counter(subsystem, domain)
+        .fetch_add(static_cast<uint64_t>(delta), std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] static MemoryUsage Snapshot() noexcept {
+    MemoryUsage usage;
+    for (size_t i = 0; i < kMemorySubsystems; i++) {
+      usage.cpuBytes[i] = counters_[i][0].load(std::memory_order_relaxed);
+      usage.gpuBytes[i] = counters_[i][1].load(std::memory_order_relaxed);
+    }
+    return usage;
+  }
+
+private:
+  static std::atomic<uint64_t> &Counter(MemorySubsystem subsystem,
+                                        MemoryDomain domain) noexcept {
+    return counters_[static_cast<size_t>(subsystem)]
+                    [static_cast<size_t>(domain)];
+  }
+
+  static inline std::atomic<uint64_t> counters_[kMemorySubsystems][2] = {};
+};
+
+// One buffer's (or set of buffers') entry in the ledger. Set it to the
+// current size whenever the buffers are (re)created; it is taken back out
+// on destruction.
+class MemoryCharge {
+public:
+  MemoryCharge(MemorySubsystem subsystem, MemoryDomain domain) noexcept
+      : subsystem_(subsystem), domain_(domain) {}
+  ~MemoryCharge() noexcept { Set(0); }
+
+  MemoryCharge(const MemoryCharge &) = delete;
+  MemoryCharge &operator=(const MemoryCharge &) = delete;
+
+  void Set(size_t bytes) noexcept {
+    MemoryLedger::Add(subsystem_, domain_,
+                      static_cast<int64_t>(bytes) -
+                          static_cast<int64_t>(bytes_));
+    bytes_ = bytes;
+  }
+  [[nodiscard]] size_t Bytes() const noexcept { return bytes_; }
+
+private:
+  MemorySubsystem subsystem_;
+  MemoryDomain domain_;
+  size_t bytes_ = 0;
+};
+
+} // namespace DeepFrame
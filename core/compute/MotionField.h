@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace DeepFrame {
+
+enum class MotionSearch : uint8_t {
+  // Full search of the whole radius at full resolution; reference only.
+  Exhaustive,
+  // Full search at the coarsest pyramid level, predictor refinement above.
+  Hierarchical,
+  // Previous pair's field as predictors at full resolution, falling back to
+  // Hierarchical without usable history.
+  Temporal
+};
+
+// Tuning knobs surfaced to the UI as FrameGenConfig.
+struct MotionParams {
+  // Largest motion (in full-resolution pixels) the search will consider.
+  int32_t searchRadius = 16;
+  // Mean absolute luma difference per pixel under which a block is treated
+  // as static and skips motion search.
+  float diffThreshold = 2.0f;
+  // 1 = linear blend of both motion-compensated frames weighted by t,
+  // 0 = take the temporally nearest compensated frame only.
+  float temporalBlend = 1.0f;
+  MotionSearch search = MotionSearch::Temporal;
+};
+
+struct MotionVector {
+  int16_t x = 0;
+  int16_t y = 0;
+
+  [[nodiscard]] bool operator==(const MotionVector &o) const noexcept {
+    return x == o.x && y == o.y;
+  }
+};
+
+struct MotionField {
+  uint32_t cols = 0;
+  uint32_t rows = 0;
+  std::vector<MotionVector> vectors;
+  std::vector<uint32_t> costs;
+
+  void Resize(uint32_t c, uint32_t r) {
+    cols = c;
+    rows = r;
+    vectors.assign(static_cast<size_t>(c) * r, MotionVector{});
+    costs.assign(static_cast<size_t>(c) * r, 0);
+  }
+
+  [[nodiscard]] MotionVector &At(uint32_t c, uint32_t r) noexcept {
+    return vectors[static_cast<size_t>(r) * cols + c];
+  }
+  [[nodiscard]] const MotionVector &At(uint32_t c, uint32_t r) const noexcept {
+    return vectors[static_cast<size_t>(r) * cols + c];
+  }
+};
+
+} // namespace DeepFrame
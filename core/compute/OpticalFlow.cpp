@@ -0,0 +1,297 @@
+#include "OpticalFlow.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+
+namespace DeepFrame {
+
+namespace {
+
+constexpr uint32_t kP = OpticalFlowEstimator::kPatchSize;
+constexpr uint32_t kPatchPixels = kP * kP;
+
+inline float SampleLuma(const LumaImage &img, float x, float y) noexcept {
+  x = std::clamp(x, 0.f, static_cast<float>(img.width - 1));
+  y = std::clamp(y, 0.f, static_cast<float>(img.height - 1));
+  const uint32_t x0 = std::min(static_cast<uint32_t>(x), img.width - 2);
+  const uint32_t y0 = std::min(static_cast<uint32_t>(y), img.height - 2);
+  const float fx = x - static_cast<float>(x0);
+  const float fy = y - static_cast<float>(y0);
+  const uint8_t *r0 = img.Row(y0) + x0;
+  const uint8_t *r1 = img.Row(y0 + 1) + x0;
+  const float top = r0[0] + fx * (r0[1] - r0[0]);
+  const float bottom = r1[0] + fx * (r1[1] - r1[0]);
+  return top + fy * (bottom - top);
+}
+
+inline uint32_t PatchOrigin(uint32_t index, uint32_t stride,
+                            uint32_t extent) noexcept {
+  return std::min(index * stride, extent - kP);
+}
+
+inline uint32_t PatchCount(uint32_t extent, uint32_t stride) noexcept {
+  return (extent - kP + stride - 1) / stride + 1;
+}
+
+// Patches along one axis whose extent covers `pos`, as [lo, hi] plus the
+// edge-clamped last patch.
+struct Coverage {
+  uint32_t lo;
+  uint32_t hi;
+  bool last;
+};
+
+inline Coverage CoverageFor(uint32_t pos, uint32_t count, uint32_t stride,
+                            uint32_t extent) noexcept {
+  Coverage c{};
+  c.lo = pos >= kP ? (pos - kP) / stride + 1 : 0;
+  c.hi = count >= 2 ? std::min(pos / stride, count - 2) : 0;
+  if (count < 2)
+    c.lo = 1;
+  c.last = PatchOrigin(count - 1, stride, extent) <= pos;
+  return c;
+}
+
+} // namespace
+
+void FlowField::Sample(float x, float y, float &outU,
+                       float &outV) const noexcept {
+  x = std::clamp(x, 0.f, static_cast<float>(width - 1));
+  y = std::clamp(y, 0.f, static_cast<float>(height - 1));
+  const uint32_t x0 = std::min(static_cast<uint32_t>(x), width - 1);
+  const uint32_t y0 = std::min(static_cast<uint32_t>(y), height - 1);
+  const uint32_t x1 = std::min(x0 + 1, width - 1);
+  const uint32_t y1 = std::min(y0 + 1, height - 1);
+  const float fx = x - static_cast<float>(x0);
+  const float fy = y - static_cast<float>(y0);
+  const size_t i00 = static_cast<size_t>(y0) * width + x0;
+  const size_t i01 = static_cast<size_t>(y0) * width + x1;
+  const size_t i10 = static_cast<size_t>(y1) * width + x0;
+  const size_t i11 = static_cast<size_t>(y1) * width + x1;
+  const float w00 = (1.f - fx) * (1.f - fy);
+  const float w01 = fx * (1.f - fy);
+  const float w10 = (1.f - fx) * fy;
+  const float w11 = fx * fy;
+  outU = u[i00] * w00 + u[i01] * w01 + u[i10] * w10 + u[i11] * w11;
+  outV = v[i00] * w00 + v[i01] * w01 + v[i10] * w10 + v[i11] * w11;
+}
+
+uint32_t OpticalFlowEstimator::LevelsFor(uint32_t width,
+                                         uint32_t height) noexcept {
+  uint32_t levels = 1;
+  while (levels < 6 && (width >> levels) >= 6 * kP &&
+         (height >> levels) >= 4 * kP) {
+    levels++;
+  }
+  return levels;
+}
+
+void OpticalFlowEstimator::ForRows(uint32_t rows, RangeFn fn) noexcept {
+  if (pool_) {
+    pool_->ParallelFor(rows, 1, fn);
+  } else {
+    fn(0, rows);
+  }
+}
+
+bool OpticalFlowEstimator::Estimate(const LumaPyramid &from,
+                                    const LumaPyramid &to,
+                                    FlowField &flow,
+                                    const TileChangeMap *changes) noexcept {
+  const uint32_t levels = std::min(from.Levels(), to.Levels());
+  if (levels == 0)
+    return false;
+  const uint32_t finest = std::min(params_.finestLevel, levels - 1);
+  const uint32_t stride = std::clamp(params_.patchStride, 1u, kP);
+
+  try {
+    const LumaImage &top = from.Level(levels - 1);
+    flow.Resize(top.width, top.height);
+
+    for (int32_t level = static_cast<int32_t>(levels) - 1;
+         level >= static_cast<int32_t>(finest); level--) {
+      const LumaImage &i0 = from.Level(level);
+      const LumaImage &i1 = to.Level(level);
+
+      if (flow.width != i0.width || flow.height != i0.height) {
+        scratch_.Resize(i0.width, i0.height);
+        const float sx = static_cast<float>(flow.width) / i0.width;
+        const float sy = static_cast<float>(flow.height) / i0.height;
+        ForRows(i0.height, [&](size_t begin, size_t end) {
+          for (size_t y = begin; y < end; y++) {
+            for (uint32_t x = 0; x < i0.width; x++) {
+              float cu, cv;
+              flow.Sample((x + 0.5f) * sx - 0.5f, (y + 0.5f) * sy - 0.5f, cu,
+                          cv);
+              const size_t idx = y * i0.width + x;
+              scratch_.u[idx] = cu / sx;
+              scratch_.v[idx] = cv / sy;
+            }
+          }
+        });
+        std::swap(flow, scratch_);
+      }
+
+      if (i0.width < kP + 1 || i0.height < kP + 1)
+        continue;
+
+      const uint32_t cols = PatchCount(i0.width, stride);
+      const uint32_t rows = PatchCount(i0.height, stride);
+      patches_.resize(static_cast<size_t>(cols) * rows);
+      SolvePatches(i0, i1, flow, cols, rows,
+                   level == static_cast<int32_t>(finest) ? changes : nullptr,
+                   static_cast<uint32_t>(level));
+      Densify(i0, cols, rows, flow);
+    }
+  } catch (...) {
+    return false;
+  }
+  return true;
+}
+
+void OpticalFlowEstimator::SolvePatches(const LumaImage &from,
+                                        const LumaImage &to,
+                                        const FlowField &init, uint32_t cols,
+                                        uint32_t rows,
+                                        const TileChangeMap *changes,
+                                        uint32_t level) noexcept {
+  const uint32_t stride = std::clamp(params_.patchStride, 1u, kP);
+  const uint32_t iterations = std::max(1u, params_.iterations);
+  const float maxStep = 2.f * kP;
+
+  ForRows(rows, [&](size_t begin, size_t end) {
+    float tpl[kPatchPixels];
+    float gx[kPatchPixels];
+    float gy[kPatchPixels];
+
+    for (uint32_t r = static_cast<uint32_t>(begin); r < end; r++) {
+      const uint32_t oy = PatchOrigin(r, stride, from.height);
+      for (uint32_t c = 0; c < cols; c++) {
+        const uint32_t ox = PatchOrigin(c, stride, from.width);
+        Patch &patch = patches_[static_cast<size_t>(r) * cols + c];
+
+        if (changes && !changes->IsPixelChanged((ox + kP / 2) << level,
+                                                (oy + kP / 2) << level)) {
+          patch = Patch{0.f, 0.f, 1.f};
+          continue;
+        }
+
+        float hxx = 0.f, hxy = 0.f, hyy = 0.f;
+        for (uint32_t j = 0; j < kP; j++) {
+          const uint32_t y = oy + j;
+          const uint8_t *row = from.Row(y);
+          const uint8_t *up = from.Row(y > 0 ? y - 1 : y);
+          const uint8_t *down = from.Row(y + 1 < from.height ? y + 1 : y);
+          for (uint32_t i = 0; i < kP; i++) {
+            const uint32_t x = ox + i;
+            const uint32_t xl = x > 0 ? x - 1 : x;
+            const uint32_t xr = x + 1 < from.width ? x + 1 : x;
+            const uint32_t k = j * kP + i;
+            tpl[k] = row[x];
+            gx[k] = 0.5f * (static_cast<float>(row[xr]) - row[xl]);
+            gy[k] = 0.5f * (static_cast<float>(down[x]) - up[x]);
+            hxx += gx[k] * gx[k];
+            hxy += gx[k] * gy[k];
+            hyy += gy[k] * gy[k];
+          }
+        }
+
+        float u0, v0;
+        init.Sample(ox + 0.5f * kP - 0.5f, oy + 0.5f * kP - 0.5f, u0, v0);
+
+        const float det = hxx * hyy - hxy * hxy;
+        float u = u0;
+        float v = v0;
+        float bestU = u0;
+        float bestV = v0;
+        float bestSsd = 1e30f;
+
+        bool converged = false;
+        for (uint32_t it = 0;; it++) {
+          float diff[kPatchPixels];
+          float mean = 0.f;
+          for (uint32_t j = 0; j < kP; j++) {
+            for (uint32_t i = 0; i < kP; i++) {
+              const uint32_t k = j * kP + i;
+              diff[k] = SampleLuma(to, ox + i + u, oy + j + v) - tpl[k];
+              mean += diff[k];
+            }
+          }
+          mean *= 1.f / kPatchPixels;
+
+          float ssd = 0.f, bx = 0.f, by = 0.f;
+          for (uint32_t k = 0; k < kPatchPixels; k++) {
+            const float d = diff[k] - mean;
+            ssd += d * d;
+            bx += gx[k] * d;
+            by += gy[k] * d;
+          }
+          if (ssd < bestSsd) {
+            bestSsd = ssd;
+            bestU = u;
+            bestV = v;
+          }
+
+          if (converged || it == iterations || det < 1e-2f)
+            break;
+
+          // Inverse compositional step: the template moves by delta, so
+          // the warp into `to` moves by -delta.
+          const float du = (hyy * bx - hxy * by) / det;
+          const float dv = (hxx * by - hxy * bx) / det;
+          u -= du;
+          v -= dv;
+          if (std::fabs(u - u0) > maxStep || std::fabs(v - v0) > maxStep)
+            break;
+          converged = du * du + dv * dv < 1e-4f;
+        }
+
+        patch.u = bestU;
+        patch.v = bestV;
+        patch.weight =
+            1.f / std::max(1.f, std::sqrt(bestSsd * (1.f / kPatchPixels)));
+      }
+    }
+  });
+}
+
+void OpticalFlowEstimator::Densify(const LumaImage &from, uint32_t cols,
+                                   uint32_t rows, FlowField &out) noexcept {
+  const uint32_t stride = std::clamp(params_.patchStride, 1u, kP);
+
+  ForRows(from.height, [&](size_t begin, size_t end) {
+    for (uint32_t y = static_cast<uint32_t>(begin); y < end; y++) {
+      const Coverage cy = CoverageFor(y, rows, stride, from.height);
+      for (uint32_t x = 0; x < from.width; x++) {
+        const Coverage cx = CoverageFor(x, cols, stride, from.width);
+        float su = 0.f, sv = 0.f, sw = 0.f;
+
+        auto accumulate = [&](uint32_t r, uint32_t c) {
+          const Patch &p = patches_[static_cast<size_t>(r) * cols + c];
+          su += p.weight * p.u;
+          sv += p.weight * p.v;
+          sw += p.weight;
+        };
+        auto accumulateRow = [&](uint32_t r) {
+          for (uint32_t c = cx.lo; c <= cx.hi; c++)
+            accumulate(r, c);
+          if (cx.last)
+            accumulate(r, cols - 1);
+        };
+
+        for (uint32_t r = cy.lo; r <= cy.hi; r++)
+          accumulateRow(r);
+        if (cy.last)
+          accumulateRow(rows - 1);
+
+        if (sw > 0.f) {
+          const size_t idx = static_cast<size_t>(y) * from.width + x;
+          out.u[idx] = su / sw;
+          out.v[idx] = sv / sw;
+        }
+      }
+    }
+  });
+}
+
+} // namespace DeepFrame
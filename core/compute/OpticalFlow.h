@@ -0,0 +1,89 @@
+#pragma once
+
+#include "LumaPyramid.h"
+#include "RangeFn.h"
+#include "TileChangeMap.h"
+#include <cstdint>
+#include <vector>
+
+namespace DeepFrame {
+
+class ThreadPool;
+
+// Dense per-pixel displacement, stored planar at the resolution of the
+// pyramid level it was estimated on.
+struct FlowField {
+  uint32_t width = 0;
+  uint32_t height = 0;
+  std::vector<float> u;
+  std::vector<float> v;
+
+  void Resize(uint32_t w, uint32_t h) {
+    width = w;
+    height = h;
+    u.assign(static_cast<size_t>(w) * h, 0.f);
+    v.assign(static_cast<size_t>(w) * h, 0.f);
+  }
+
+  // Bilinear sample with edge clamping; coordinates in flow pixels.
+  void Sample(float x, float y, float &outU, float &outV) const noexcept;
+};
+
+struct OpticalFlowParams {
+  // Pyramid level the dense result is produced at (0 = full resolution).
+  uint32_t finestLevel = 2;
+  uint32_t patchStride = 4;
+  uint32_t iterations = 12;
+};
+
+// Coarse-to-fine patch flow in the style of DIS: inverse-compositional
+// Lucas-Kanade on a grid of overlapping 8x8 luma patches per level, then
+// densified by residual-weighted averaging of the covering patches. The
+// coarser level's dense flow seeds the next one.
+class OpticalFlowEstimator {
+public:
+  static constexpr uint32_t kPatchSize = 8;
+
+  explicit OpticalFlowEstimator(ThreadPool *pool = nullptr) noexcept
+      : pool_(pool) {}
+
+  void SetParams(const OpticalFlowParams &params) noexcept {
+    params_ = params;
+  }
+  [[nodiscard]] const OpticalFlowParams &GetParams() const noexcept {
+    return params_;
+  }
+
+  // Pyramid levels the caller should build so that the coarsest level is
+  // still a few patches across.
+  [[nodiscard]] static uint32_t LevelsFor(uint32_t width,
+                                          uint32_t height) noexcept;
+
+  // Flow from `from` to `to`: from(x) ~ to(x + flow(x)). Patches of the
+  // finest level that fall in tiles `changes` marks unchanged are taken as
+  // static instead of solved.
+  [[nodiscard]] bool Estimate(const LumaPyramid &from, const LumaPyramid &to,
+                              FlowField &flow,
+                              const TileChangeMap *changes = nullptr) noexcept;
+
+private:
+  struct Patch {
+    float u = 0.f;
+    float v = 0.f;
+    float weight = 0.f;
+  };
+
+  void SolvePatches(const LumaImage &from, const LumaImage &to,
+                    const FlowField &init, uint32_t cols, uint32_t rows,
+                    const TileChangeMap *changes, uint32_t level) noexcept;
+  void Densify(const LumaImage &from, uint32_t cols, uint32_t rows,
+               FlowField &out) noexcept;
+  void ForRows(uint32_t rows, RangeFn fn) noexcept;
+
+  ThreadPool *pool_ = nullptr;
+  OpticalFlowParams params_;
+  std::vector<Patch> patches_;
+  FlowField scratch_;
+};
+
+} // namespace DeepFrame
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+
+namespace DeepFrame {
+
+// Non-owning reference to a `void(size_t begin, size_t end)` callable.
+// Unlike std::function it never copies the callable, so handing a lambda
+// with a large capture to a per-frame kernel does not allocate. Only valid
+// while the callable it was made from is alive; pass it down, never store
+// it.
+class RangeFn {
+public:
+  template <typename F, typename = std::enable_if_t<
+                            !std::is_same_v<std::decay_t<F>, RangeFn>>>
+  RangeFn(const F &fn) noexcept
+      : object_(&fn), call_([](const void *object, size_t begin, size_t end) {
+          (*static_cast<const F *>(object))(begin, end);
+        }) {}
+
+  void operator()(size_t begin, size_t end) const {
+    call_(object_, begin, end);
+  }
+
+private:
+  const void *object_;
+  void (*call_)(const void *, size_t, size_t);
+};
+
+} // namespace DeepFrame
@@ -0,0 +1,154 @@
+#include "RectList.h"
+#include <algorithm>
+
+namespace DeepFrame {
+
+namespace {
+
+[[nodiscard]] bool Contains(const TileRect &outer,
+                            const TileRect &inner) noexcept {
+  return outer.left <= inner.left && outer.top <= inner.top &&
+         outer.right >= inner.right && outer.bottom >= inner.bottom;
+}
+
+[[nodiscard]] TileRect Bounds(const TileRect &a, const TileRect &b) noexcept {
+  return {std::min(a.left, b.left), std::min(a.top, b.top),
+          std::max(a.right, b.right), std::max(a.bottom, b.bottom)};
+}
+
+// Area the bounding box of a and b covers beyond a and b themselves.
+[[nodiscard]] uint64_t MergeWaste(const TileRect &a,
+                                  const TileRect &b) noexcept {
+  const TileRect overlap = {std::max(a.left, b.left), std::max(a.top, b.top),
+                            std::min(a.right, b.right),
+                            std::min(a.bottom, b.bottom)};
+  const uint64_t covered = a.Area() + b.Area() - overlap.Area();
+  return Bounds(a, b).Area() - covered;
+}
+
+} // namespace
+
+void RectList::Add(const TileRect &rect, uint32_t width,
+                   uint32_t height) noexcept {
+  if (full_)
+    return;
+  const TileRect clipped = {rect.left, rect.top, std::min(rect.right, width),
+                            std::min(rect.bottom, height)};
+  if (clipped.Empty())
+    return;
+  if (clipped.left == 0 && clipped.top == 0 && clipped.right == width &&
+      clipped.bottom == height) {
+    SetFull();
+    return;
+  }
+
+  size_t kept = 0;
+  for (size_t i = 0; i < count_; i++) {
+    if (Contains(rects_[i], clipped))
+      return;
+    // Rects swallowed by the new one go; a neighbour that merges with it
+    // at no cost (an adjacent strip of the same span) is absorbed.
+    if (!Contains(clipped, rects_[i]))
+      rects_[kept++] = rects_[i];
+  }
+  count_ = kept;
+
+  TileRect added = clipped;
+  for (size_t i = 0; i < count_; i++) {
+    if (MergeWaste(rects_[i], added) == 0) {
+      added = Bounds(rects_[i], added);
+      rects_[i] = rects_[--count_];
+      i = static_cast<size_t>(-1);
+    }
+  }
+  rects_[count_++] = added;
+  if (count_ > kMaxRects)
+    MergeCheapestPair();
+}
+
+void RectList::Merge(const RectList &other, uint32_t width,
+                     uint32_t height) noexcept {
+  if (other.full_) {
+    SetFull();
+    return;
+  }
+  for (const TileRect &rect : other)
+    Add(rect, width, height);
+}
+
+uint64_t RectList::Area(uint32_t width, uint32_t height) const noexcept {
+  if (full_)
+    return static_cast<uint64_t>(width) * height;
+  uint64_t area = 0;
+  for (const TileRect &rect : *this)
+    area += rect.Area();
+  return area;
+}
+
+void RectList::MergeCheapestPair() noexcept {
+  size_t bestA = 0, bestB = 1;
+  uint64_t bestWaste = UINT64_MAX;
+  for (size_t a = 0; a < count_; a++) {
+    for (size_t b = a + 1; b < count_; b++) {
+      const uint64_t waste = MergeWaste(rects_[a], rects_[b]);
+      if (waste < bestWaste) {
+        bestWaste = waste;
+        bestA = a;
+        bestB = b;
+      }
+    }
+  }
+  rects_[bestA] = Bounds(rects_[bestA], rects_[bestB]);
+  rects_[bestB] = rects_[--count_];
+  // The merged rect may now contain others.
+  for (size_t i = 0; i < count_; i++) {
+    if (i != bestA && Contains(rects_[bestA], rects_[i])) {
+      if (bestA == count_ - 1)
+        bestA = i;
+      rects_[i] = rects_[--count_];
+      i--;
+    }
+  }
+}
+
+FramePairPlan FramePairTracker::Next(uint64_t prevIndex, uint64_t currIndex,
+                                     const RectList *changes, uint32_t width,
+                                     uint32_t height) noexcept {
+  FramePairPlan plan;
+  const bool sameSize = width == width_ && height == height_;
+  const uint8_t older = static_cast<uint8_t>(1 - latest_);
+
+  if (sameSize && prevIndex != 0 && currIndex != 0 && changes &&
+      lastKnown_ && slots_[latest_] == prevIndex) {
+    // The older buffer is two frames behind: it needs what changed into
+    // the latest frame plus what changes now.
+    plan.prevSlot = latest_;
+    plan.currSlot = older;
+    plan.prevFull = false;
+    plan.currRefresh = lastChanges_;
+    plan.currRefresh.Merge(*changes, width, height);
+  } else {
+    plan.prevSlot = older;
+    plan.currSlot = latest_;
+    plan.prevFull = true;
+    plan.currRefresh.SetFull();
+  }
+
+  slots_[plan.prevSlot] = prevIndex;
+  slots_[plan.currSlot] = currIndex;
+  latest_ = plan.currSlot;
+  lastKnown_ = changes && prevIndex != 0 && currIndex != 0;
+  if (lastKnown_)
+    lastChanges_ = *changes;
+  width_ = width;
+  height_ = height;
+  return plan;
+}
+
+void FramePairTracker::Reset() noexcept {
+  slots_[0] = slots_[1] = 0;
+  lastKnown_ = false;
+  latest_ = 1;
+}
+
+} // namespace DeepFrame
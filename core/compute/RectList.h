@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace DeepFrame {
+
+// Pixel rectangle, right/bottom exclusive.
+struct TileRect {
+  uint32_t left = 0;
+  uint32_t top = 0;
+  uint32_t right = 0;
+  uint32_t bottom = 0;
+
+  [[nodiscard]] bool Empty() const noexcept {
+    return left >= right || top >= bottom;
+  }
+  [[nodiscard]] uint64_t Area() const noexcept {
+    return Empty() ? 0
+                   : static_cast<uint64_t>(right - left) * (bottom - top);
+  }
+};
+
+// Bounded list of changed regions of a frame, as the OS compositor reports
+// them. Rects contained in another are dropped, and once the list is full
+// the two rects whose bounding box wastes the least area are merged, so
+// the list always covers every pixel added to it. A full list means the
+// whole frame changed.
+class RectList {
+public:
+  static constexpr size_t kMaxRects = 16;
+
+  void Clear() noexcept {
+    count_ = 0;
+    full_ = false;
+  }
+  void SetFull() noexcept {
+    count_ = 0;
+    full_ = true;
+  }
+
+  // Clipped to `width` x `height`; a rect covering the frame marks it full.
+  void Add(const TileRect &rect, uint32_t width, uint32_t height) noexcept;
+  void Merge(const RectList &other, uint32_t width, uint32_t height) noexcept;
+
+  [[nodiscard]] bool IsFull() const noexcept { return full_; }
+  // Nothing changed.
+  [[nodiscard]] bool IsEmpty() const noexcept { return !full_ && !count_; }
+  [[nodiscard]] size_t Count() const noexcept { return count_; }
+  [[nodiscard]] const TileRect *begin() const noexcept { return rects_; }
+  [[nodiscard]] const TileRect *end() const noexcept {
+    return rects_ + count_;
+  }
+  [[nodiscard]] const TileRect &operator[](size_t i) const noexcept {
+    return rects_[i];
+  }
+
+  // Pixels the rects cover, counting overlaps twice.
+  [[nodiscard]] uint64_t Area(uint32_t width, uint32_t height) const noexcept;
+
+private:
+  void MergeCheapestPair() noexcept;
+
+  TileRect rects_[kMaxRects + 1];
+  size_t count_ = 0;
+  bool full_ = false;
+};
+
+// Two buffers that take turns holding the previous and the current frame
+// of a stream (staging textures, input tensors). When the new pair follows
+// on from the last one, the buffer that held the current frame becomes the
+// previous one untouched, and the other only needs the regions that
+// changed over the last two frames.
+struct FramePairPlan {
+  uint8_t prevSlot = 0;
+  uint8_t currSlot = 1;
+  // prevSlot has to be rebuilt in full.
+  bool prevFull = true;
+  // What currSlot needs; full when it has to be rebuilt.
+  RectList currRefresh;
+};
+
+class FramePairTracker {
+public:
+  // `changes` is what differs from frame `prevIndex` to `currIndex`, or
+  // null when unknown. Frame index 0 means unknown.
+  [[nodiscard]] FramePairPlan Next(uint64_t prevIndex, uint64_t currIndex,
+                                   const RectList *changes, uint32_t width,
+                                   uint32_t height) noexcept;
+
+  // Forgets what the buffers hold, e.g. after they were recreated.
+  void Reset() noexcept;
+
+private:
+  uint64_t slots_[2] = {0, 0};
+  // Changes from slots_[1 - latest_] to slots_[latest_], when known.
+  RectList lastChanges_;
+  bool lastKnown_ = false;
+  uint8_t latest_ = 1;
+  uint32_t width_ = 0;
+  uint32_t height_ = 0;
+};
+
+// Identity of two consecutive frames handed to an interpolator and what
+// changed between them, so it can reuse work from the previous pair.
+struct FramePair {
+  uint64_t prevIndex = 0;
+  uint64_t currIndex = 0;
+  const RectList *changes = nullptr;
+};
+
+} // namespace DeepFrame
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace DeepFrame {
+
+// Names one use of a pool slot. The generation is bumped every time the
+// slot goes back to the free list, so a handle kept past its lease no
+// longer resolves instead of aliasing whoever owns the slot next.
+struct PoolHandle {
+  uint32_t index = UINT32_MAX;
+  uint32_t generation = 0;
+};
+
+struct PoolStats {
+  size_t capacity = 0;
+  size_t inUse = 0;
+  uint64_t acquires = 0;
+  // Acquire found every slot leased.
+  uint64_t exhausted = 0;
+  // Lookups and lease accesses that hit a recycled slot.
+  uint64_t stale = 0;
+};
+
+template <typename T> class ResourcePool;
+
+// Reference-counted hold on one slot. Copies share the slot; the last one
+// to go returns it to the pool. Leases must not outlive their pool.
+template <typename T> class PoolLease {
+public:
+  PoolLease() noexcept = default;
+  ~PoolLease() noexcept { Reset(); }
+
+  PoolLease(const PoolLease &other) noexcept
+      : pool_(other.pool_), handle_(other.handle_) {
+    if (pool_)
+      pool_->AddRef(handle_.index);
+  }
+  PoolLease &operator=(const PoolLease &other) noexcept {
+    if (this != &other) {
+      PoolLease copy(other);
+      Swap(copy);
+    }
+    return *this;
+  }
+  PoolLease(PoolLease &&other) noexcept
+      : pool_(std::exchange(other.pool_, nullptr)), handle_(other.handle_) {}
+  PoolLease &operator=(PoolLease &&other) noexcept {
+    if (this != &other) {
+      Reset();
+      pool_ = std::exchange(other.pool_, nullptr);
+      handle_ = other.handle_;
+    }
+    return *this;
+  }
+
+  void Reset() noexcept {
+    if (pool_)
+      std::exchange(pool_, nullptr)->Release(handle_.index);
+  }
+
+  // Null when empty, or when the slot was recycled under this lease, which
+  // only a refcounting bug can cause; the pool counts those as stale.
+  [[nodiscard]] T *Get() const noexcept {
+    return pool_ ? pool_->Lookup(handle_) : nullptr;
+  }
+  T *operator->() const noexcept { return Get(); }
+  T &operator*() const noexcept { return *Get(); }
+  explicit operator bool() const noexcept { return pool_ != nullptr; }
+
+  [[nodiscard]] PoolHandle Handle() const noexcept { return handle_; }
+
+private:
+  friend class ResourcePool<T>;
+  PoolLease(ResourcePool<T> *pool, PoolHandle handle) noexcept
+      : pool_(pool), handle_(handle) {}
+
+  void Swap(PoolLease &other) noexcept {
+    std::swap(pool_, other.pool_);
+    std::swap(handle_, other.handle_);
+  }
+
+  ResourcePool<T> *pool_ = nullptr;
+  PoolHandle handle_;
+};
+
+// Fixed set of pre-built resources handed out as leases, so steady-state
+// frames recycle surfaces and buffers instead of allocating them. Acquire
+// and the last Release may run on different threads.
+template <typename T> class ResourcePool {
+public:
+  ResourcePool() noexcept = default;
+  ~ResourcePool() noexcept { Reset(); }
+
+  ResourcePool(const ResourcePool &) = delete;
+  ResourcePool &operator=(const ResourcePool &) = delete;
+
+  // Builds `capacity` slots with `create(T &)`. Fails, leaving the pool
+  // empty, if a slot cannot be built or leases from a previous Initialize
+  // are still out.
+  template <typename Create>
+  [[nodiscard]] bool Initialize(size_t capacity, Create &&create) noexcept {
+    if (!Reset() || capacity == 0 || capacity >= UINT32_MAX)
+      return false;
+    try {
+      auto slots = std::make_unique<Slot[]>(capacity);
+      std::vector<uint32_t> free;
+      free.reserve(capacity);
+      for (size_t i = 0; i < capacity; i++) {
+        if (!create(slots[i].value))
+          return false;
+        // Handed out from the back, so slot 0 goes first.
+        free.push_back(static_cast<uint32_t>(capacity - 1 - i));
+      }
+      std::lock_guard<std::mutex> lock(mutex_);
+      slots_ = std::move(slots);
+      free_ = std::move(free);
+      capacity_ = capacity;
+    } catch (...) {
+      return false;
+    }
+    return true;
+  }
+
+  // Drops every slot. Refused while leases are out.
+  bool Reset() noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (free_.size() != capacity_)
+      return false;
+    slots_.reset();
+    free_.clear();
+    capacity_ = 0;
+    return true;
+  }
+
+  // Empty lease when every slot is in use.
+  [[nodiscard]] PoolLease<T> Acquire() noexcept {
+    uint32_t index;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (free_.empty()) {
+        exhausted_.fetch_add(1, std::memory_order_relaxed);
+        return {};
+      }
+      index = free_.back();
+      free_.pop_back();
+    }
+    acquires_.fetch_add(1, std::memory_order_relaxed);
+    Slot &slot = slots_[index];
+    slot.refs.store(1, std::memory_order_relaxed);
+    return {this, {index, slot.generation.load(std::memory_order_acquire)}};
+  }
+
+  // Resource behind `handle`, or null once its slot has been recycled.
+  [[nodiscard]] T *Lookup(PoolHandle handle) noexcept {
+    if (handle.index >= capacity_)
+      return nullptr;
+    Slot &slot = slots_[handle.index];
+    if (slot.generation.load(std::memory_order_acquire) != handle.generation) {
+      stale_.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    return &slot.value;
+  }
+
+  [[nodiscard]] size_t Capacity() const noexcept { return capacity_; }
+
+  [[nodiscard]] PoolStats GetStats() const noexcept {
+    PoolStats stats;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stats.capacity = capacity_;
+      stats.inUse = capacity_ - free_.size();
+    }
+    stats.acquires = acquires_.load(std::memory_order_relaxed);
+    stats.exhausted = exhausted_.load(std::memory_order_relaxed);
+    stats.stale = stale_.load(std::memory_order_relaxed);
+    return stats;
+  }
+
+private:
+  friend class PoolLease<T>;
+
+  struct Slot {
+    T value{};
+    std::atomic<uint32_t> refs{0};
+    std::atomic<uint32_t> generation{0};
+  };
+
+  void AddRef(uint32_t index) noexcept {
+    slots_[index].refs.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void Release(uint32_t index) noexcept {
+    Slot &slot = slots_[index];
+    if (slot.refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+      return;
+    slot.generation.fetch_add(1, std::memory_order_release);
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Reserved at Initialize, so this never allocates.
+    free_.push_back(index);
+  }
+
+  std::unique_ptr<Slot[]> slots_;
+  std::vector<uint32_t> free_;
+  size_t capacity_ = 0;
+  mutable std::mutex mutex_;
+
+  std::atomic<uint64_t> acquires_{0};
+  std::atomic<uint64_t> exhausted_{0};
+  std::atomic<uint64_t> stale_{0};
+};
+
+} // namespace DeepFrame
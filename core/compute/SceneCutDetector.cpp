@@ -0,0 +1,196 @@
+#include "SceneCutDetector.h"
+#include "Simd.h"
+#include <algorithm>
+#include <cmath>
+
+namespace DeepFrame {
+
+namespace {
+
+constexpr uint32_t kHistogramBins = 32;
+// Samples per cell edge in the sparse thumbnail.
+constexpr uint32_t kCellSamples = 4;
+// Weight of the newest pair in the running SAD average.
+constexpr float kAverageAlpha = 0.1f;
+// Thumbnail cells a pan may move between frames and still be matched;
+// the compared window keeps this margin from every edge.
+constexpr int32_t kShiftCells = 2;
+// Contrast floor, so near-flat frames (a black screen) do not turn noise
+// into large relative SADs.
+constexpr float kMinContrast = 4.f;
+
+inline uint32_t Luma(const uint8_t *bgra) noexcept {
+  return (bgra[2] * 77u + bgra[1] * 150u + bgra[0] * 29u + 128u) >> 8;
+}
+
+float MeanDeviation(const SceneThumbnail &thumb) noexcept {
+  uint32_t sum = 0;
+  for (uint8_t v : thumb.luma)
+    sum += v;
+  const int32_t mean =
+      static_cast<int32_t>((sum + SceneThumbnail::kPixels / 2) /
+                           SceneThumbnail::kPixels);
+  uint32_t deviation = 0;
+  for (uint8_t v : thumb.luma)
+    deviation += static_cast<uint32_t>(std::abs(v - mean));
+  return static_cast<float>(deviation) / SceneThumbnail::kPixels;
+}
+
+// Mean absolute difference after the whole-frame shift that matches best,
+// so a pan costs only what the shift cannot explain while unrelated frames
+// stay far apart.
+float ShiftedSad(const SceneThumbnail &prev,
+                 const SceneThumbnail &curr) noexcept {
+  constexpr uint32_t kW = SceneThumbnail::kWidth;
+  constexpr uint32_t kH = SceneThumbnail::kHeight;
+  constexpr uint32_t kSpan = kW - 2 * kShiftCells;
+  uint32_t best = UINT32_MAX;
+  for (int32_t dy = -kShiftCells; dy <= kShiftCells; dy++) {
+    for (int32_t dx = -kShiftCells; dx <= kShiftCells; dx++) {
+      uint32_t sum = 0;
+      for (uint32_t y = kShiftCells; y < kH - kShiftCells && sum < best; y++) {
+        sum += SadBytes(prev.luma.data() + y * kW + kShiftCells,
+                        curr.luma.data() + (y + dy) * kW + kShiftCells + dx,
+                        kSpan);
+      }
+      best = std::min(best, sum);
+    }
+  }
+  return static_cast<float>(best) / (kSpan * (kH - 2 * kShiftCells));
+}
+
+} // namespace
+
+bool SceneThumbnailBuilder::Begin(uint32_t width, uint32_t height) noexcept {
+  if (width == 0 || height == 0)
+    return false;
+  try {
+    if (width != width_) {
+      columnCell_.resize(width);
+      for (uint32_t x = 0; x < width; x++) {
+        columnCell_[x] = static_cast<uint8_t>(
+            static_cast<uint64_t>(x) * SceneThumbnail::kWidth / width);
+      }
+    }
+  } catch (...) {
+    return false;
+  }
+  width_ = width;
+  height_ = height;
+  sums_.fill(0);
+  counts_.fill(0);
+  return true;
+}
+
+void SceneThumbnailBuilder::AddBgraRow(uint32_t y,
+                                       const uint8_t *row) noexcept {
+  const uint32_t cellRow = static_cast<uint32_t>(
+      static_cast<uint64_t>(y) * SceneThumbnail::kHeight / height_);
+  uint32_t *sums = sums_.data() + cellRow * SceneThumbnail::kWidth;
+  uint32_t *counts = counts_.data() + cellRow * SceneThumbnail::kWidth;
+  for (uint32_t x = 0; x < width_; x++) {
+    sums[columnCell_[x]] += Luma(row + x * 4);
+    counts[columnCell_[x]]++;
+  }
+}
+
+void SceneThumbnailBuilder::Finish(SceneThumbnail &out) noexcept {
+  for (uint32_t i = 0; i < SceneThumbnail::kPixels; i++) {
+    out.luma[i] = static_cast<uint8_t>(
+        counts_[i] ? (sums_[i] + counts_[i] / 2) / counts_[i] : 0);
+  }
+  out.valid = true;
+}
+
+void SceneCutDetector::Thumbnail(const FrameView &bgra,
+                                 SceneThumbnail &out) noexcept {
+  out.valid = false;
+  if (!bgra.IsValid() || bgra.format != PixelFormat::BGRA8)
+    return;
+
+  for (uint32_t cy = 0; cy < SceneThumbnail::kHeight; cy++) {
+    const uint64_t y0 =
+        static_cast<uint64_t>(cy) * bgra.height / SceneThumbnail::kHeight;
+    const uint64_t y1 =
+        static_cast<uint64_t>(cy + 1) * bgra.height / SceneThumbnail::kHeight;
+    for (uint32_t cx = 0; cx < SceneThumbnail::kWidth; cx++) {
+      const uint64_t x0 =
+          static_cast<uint64_t>(cx) * bgra.width / SceneThumbnail::kWidth;
+      const uint64_t x1 =
+          static_cast<uint64_t>(cx + 1) * bgra.width / SceneThumbnail::kWidth;
+      uint32_t sum = 0;
+      uint32_t count = 0;
+      for (uint32_t sy = 0; sy < kCellSamples; sy++) {
+        const uint64_t y = y0 + (2 * sy + 1) * (y1 - y0) / (2 * kCellSamples);
+        if (y >= bgra.height)
+          continue;
+        const uint8_t *row = bgra.Row(static_cast<uint32_t>(y));
+        for (uint32_t sx = 0; sx < kCellSamples; sx++) {
+          const uint64_t x =
+              x0 + (2 * sx + 1) * (x1 - x0) / (2 * kCellSamples);
+          if (x >= bgra.width)
+            continue;
+          sum += Luma(row + x * 4);
+          count++;
+        }
+      }
+      out.luma[cy * SceneThumbnail::kWidth + cx] =
+          static_cast<uint8_t>(count ? (sum + count / 2) / count : 0);
+    }
+  }
+  out.valid = true;
+}
+
+bool SceneCutDetector::IsCut(const SceneThumbnail &prev,
+                             const SceneThumbnail &curr) noexcept {
+  if (!prev.valid || !curr.valid)
+    return false;
+
+  const float contrast =
+      std::max(kMinContrast, MeanDeviation(prev) + MeanDeviation(curr));
+  const float sad = ShiftedSad(prev, curr) / contrast;
+
+  std::array<int32_t, kHistogramBins> histogram{};
+  for (uint32_t i = 0; i < SceneThumbnail::kPixels; i++) {
+    histogram[prev.luma[i] * kHistogramBins / 256]++;
+    histogram[curr.luma[i] * kHistogramBins / 256]--;
+  }
+  int32_t l1 = 0;
+  for (int32_t h : histogram)
+    l1 += std::abs(h);
+  const float histogramDistance =
+      static_cast<float>(l1) / (2.f * SceneThumbnail::kPixels);
+
+  lastSad_ = sad;
+  lastHistogram_ = histogramDistance;
+
+  // With no average yet there is nothing to jump from; a shot opening on
+  // fast motion must not read as a cut on every frame.
+  const float average = hasAverage_ ? averageSad_ : 0.f;
+  const bool cut =
+      sad >= params_.hardSad ||
+      (histogramDistance >= params_.histogramThreshold &&
+       sad >= std::max(params_.minSad, average * params_.sadRatio)) ||
+      (hasAverage_ &&
+       sad >= std::max(params_.jumpSad, average * params_.jumpRatio));
+
+  if (cut) {
+    cuts_++;
+    hasAverage_ = false;
+  } else {
+    averageSad_ = hasAverage_ ? averageSad_ + kAverageAlpha * (sad - averageSad_)
+                              : sad;
+    hasAverage_ = true;
+  }
+  return cut;
+}
+
+void SceneCutDetector::Reset() noexcept {
+  averageSad_ = 0.f;
+  hasAverage_ = false;
+  lastSad_ = 0.f;
+  lastHistogram_ = 0.f;
+  cuts_ = 0;
+}
+
+} // namespace DeepFrame
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "FrameView.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace DeepFrame {
+
+// Fixed-size luma thumbnail, the only thing the detector looks at.
+struct SceneThumbnail {
+  static constexpr uint32_t kWidth = 64;
+  static constexpr uint32_t kHeight = 36;
+  static constexpr uint32_t kPixels = kWidth * kHeight;
+
+  std::array<uint8_t, kPixels> luma{};
+  bool valid = false;
+};
+
+// Accumulates a thumbnail from full-resolution rows as a conversion loop
+// walks the frame, so the frame does not have to be read twice.
+class SceneThumbnailBuilder {
+public:
+  [[nodiscard]] bool Begin(uint32_t width, uint32_t height) noexcept;
+  void AddBgraRow(uint32_t y, const uint8_t *row) noexcept;
+  void Finish(SceneThumbnail &out) noexcept;
+
+private:
+  uint32_t width_ = 0;
+  uint32_t height_ = 0;
+  std::vector<uint8_t> columnCell_;
+  std::array<uint32_t, SceneThumbnail::kPixels> sums_{};
+  std::array<uint32_t, SceneThumbnail::kPixels> counts_{};
+};
+
+// SADs are taken after the small whole-frame shift that matches best, and
+// relative to the pair's contrast, the sum of the thumbnails' mean absolute
+// deviations: roughly what two unrelated frames of that content differ by.
+// How much texture survives in a thumbnail cell, and how many cells a pan
+// crosses, depend on the frame size; absolute SADs would not carry across
+// resolutions.
+struct SceneCutParams {
+  // Histogram L1 distance (0 = identical, 1 = disjoint) above which the
+  // two frames no longer show the same content.
+  float histogramThreshold = 0.3f;
+  // Relative SAD that always counts as a cut: more than unrelated frames
+  // of the same content differ by.
+  float hardSad = 1.f;
+  // Below hardSad a cut also needs the histogram to move and the SAD to
+  // stand out against the shot's average by this factor.
+  float sadRatio = 3.f;
+  float minSad = 0.4f;
+  // Teleports keep the histogram; they are caught by a SAD jump alone,
+  // which has to clear a higher floor so a pan starting from rest does not.
+  float jumpRatio = 2.2f;
+  float jumpSad = 0.5f;
+};
+
+// Flags hard cuts and camera teleports between consecutive frames, where
+// any interpolated frame is a ghost of two unrelated images.
+class SceneCutDetector {
+public:
+  // Thumbnail of a whole frame from a sparse sample grid in each cell.
+  static void Thumbnail(const FrameView &bgra, SceneThumbnail &out) noexcept;
+
+  void SetParams(const SceneCutParams &params) noexcept { params_ = params; }
+
+  // Compares two thumbnails. The running motion average covers the
+  // current shot: a cut clears it and the pair after seeds it, and until
+  // then only the hard and histogram tests apply.
+  [[nodiscard]] bool IsCut(const SceneThumbnail &prev,
+                           const SceneThumbnail &curr) noexcept;
+
+  void Reset() noexcept;
+
+  [[nodiscard]] uint64_t Cuts() const noexcept { return cuts_; }
+  // Relative to the pair's contrast.
+  [[nodiscard]] float LastSad() const noexcept { return lastSad_; }
+  [[nodiscard]] float LastHistogramDistance() const noexcept {
+    return lastHistogram_;
+  }
+
+private:
+  SceneCutParams params_;
+  float averageSad_ = 0.f;
+  bool hasAverage_ = false;
+  float lastSad_ = 0.f;
+  float lastHistogram_ = 0.f;
+  uint64_t cuts_ = 0;
+};
+
+} // namespace DeepFrame
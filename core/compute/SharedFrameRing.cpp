@@ -0,0 +1,434 @@
+#include "SharedFrameRing.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace DeepFrame {
+
+namespace {
+
+using Layout = SharedFrameLayout;
+
+constexpr size_t kPageBytes = 4096;
+
+constexpr uint64_t RoundUp(uint64_t value, uint64_t to) noexcept {
+  return (value + to - 1) / to * to;
+}
+
+uint32_t LoadU32(const uint8_t *base, size_t offset) noexcept {
+  uint32_t value;
+  std::memcpy(&value, base + offset, 4);
+  return value;
+}
+
+uint64_t LoadU64(const uint8_t *base, size_t offset) noexcept {
+  uint64_t value;
+  std::memcpy(&value, base + offset, 8);
+  return value;
+}
+
+template <typename T>
+void Store(uint8_t *base, size_t offset, T value) noexcept {
+  std::memcpy(base + offset, &value, sizeof(T));
+}
+
+template <typename T>
+std::atomic<T> &AtomicAt(uint8_t *base, size_t offset) noexcept {
+  static_assert(sizeof(std::atomic<T>) == sizeof(T) &&
+                    std::atomic<T>::is_always_lock_free,
+                "shared counters must be plain lock-free words");
+  return *reinterpret_cast<std::atomic<T> *>(base + offset);
+}
+
+void CopyRows(const uint8_t *from, uint32_t fromPitch, uint8_t *to,
+              uint32_t toPitch, uint32_t rowBytes, uint32_t rows) noexcept {
+  if (fromPitch == toPitch) {
+    std::memcpy(to, from, static_cast<size_t>(toPitch) * rows);
+    return;
+  }
+  for (uint32_t y = 0; y < rows; y++) {
+    std::memcpy(to + static_cast<size_t>(y) * toPitch,
+                from + static_cast<size_t>(y) * fromPitch, rowBytes);
+  }
+}
+
+} // namespace
+
+SharedMemory::~SharedMemory() noexcept { Close(); }
+
+#ifdef _WIN32
+
+namespace {
+
+std::wstring MappingName(const std::string &name) {
+  std::wstring wide = L"Local\\";
+  for (char c : name)
+    wide += static_cast<wchar_t>(static_cast<unsigned char>(c));
+  return wide;
+}
+
+} // namespace
+
+bool SharedMemory::Create(const std::string &name, size_t bytes) noexcept {
+  Close();
+  try {
+    const std::wstring wide = MappingName(name);
+    HANDLE mapping = CreateFileMappingW(
+        INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+        static_cast<DWORD>(static_cast<uint64_t>(bytes) >> 32),
+        static_cast<DWORD>(bytes), wide.c_str());
+    if (!mapping)
+      return false;
+    // Named mappings live as long as any handle does, so an existing one
+    // belongs to a writer that is still running.
+    if (GetLastError() == ERROR_ALREADY_EXISTS) {
+      CloseHandle(mapping);
+      return false;
+    }
+    void *view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+    if (!view) {
+      CloseHandle(mapping);
+      return false;
+    }
+    mapping_ = mapping;
+    data_ = view;
+    size_ = bytes;
+    name_ = name;
+    owner_ = true;
+    return true;
+  } catch (...) {
+    return false;
+  }
+}
+
+bool SharedMemory::Open(const std::string &name, bool writable) noexcept {
+  Close();
+  try {
+    const std::wstring wide = MappingName(name);
+    const DWORD access = writable ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ;
+    HANDLE mapping = OpenFileMappingW(access, FALSE, wide.c_str());
+    if (!mapping)
+      return false;
+    void *view = MapViewOfFile(mapping, access, 0, 0, 0);
+    MEMORY_BASIC_INFORMATION info{};
+    if (!view || !VirtualQuery(view, &info, sizeof(info))) {
+      if (view)
+        UnmapViewOfFile(view);
+      CloseHandle(mapping);
+      return false;
+    }
+    mapping_ = mapping;
+    data_ = view;
+    size_ = info.RegionSize;
+    name_ = name;
+    owner_ = false;
+    return true;
+  } catch (...) {
+    return false;
+  }
+}
+
+void SharedMemory::Close() noexcept {
+  if (data_)
+    UnmapViewOfFile(data_);
+  if (mapping_)
+    CloseHandle(static_cast<HANDLE>(mapping_));
+  data_ = nullptr;
+  mapping_ = nullptr;
+  size_ = 0;
+  owner_ = false;
+}
+
+#else
+
+namespace {
+
+std::string ShmName(const std::string &name) { return "/" + name; }
+
+} // namespace
+
+bool SharedMemory::Create(const std::string &name, size_t bytes) noexcept {
+  Close();
+  try {
+    const std::string path = ShmName(name);
+    shm_unlink(path.c_str());
+    const int fd =
+        shm_open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fd < 0)
+      return false;
+    void *view = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(bytes)) == 0) {
+      view = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (view == MAP_FAILED) {
+      shm_unlink(path.c_str());
+      return false;
+    }
+    data_ = view;
+    size_ = bytes;
+    name_ = name;
+    owner_ = true;
+    return true;
+  } catch (...) {
+    return false;
+  }
+}
+
+bool SharedMemory::Open(const std::string &name, bool writable) noexcept {
+  Close();
+  try {
+    const std::string path = ShmName(name);
+    const int fd =
+        shm_open(path.c_str(), (writable ? O_RDWR : O_RDONLY) | O_CLOEXEC, 0);
+    if (fd < 0)
+      return false;
+    struct stat st {};
+    void *view = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+      view = mmap(nullptr, static_cast<size_t>(st.st_size),
+                  writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED,
+                  fd, 0);
+    }
+    ::close(fd);
+    if (view == MAP_FAILED)
+      return false;
+    data_ = view;
+    size_ = static_cast<size_t>(st.st_size);
+    name_ = name;
+    owner_ = false;
+    return true;
+  } catch (...) {
+    return false;
+  }
+}
+
+void SharedMemory::Close() noexcept {
+  if (data_)
+    munmap(data_, size_);
+  if (owner_)
+    shm_unlink(ShmName(name_).c_str());
+  data_ = nullptr;
+  size_ = 0;
+  owner_ = false;
+}
+
+#endif
+
+bool SharedFrameWriter::Create(const std::string &name, uint32_t width,
+                               uint32_t height, PixelFormat format,
+                               uint32_t slots) noexcept {
+  Close();
+  if (width == 0 || height == 0 || slots == 0)
+    return false;
+
+  // Rows start on cache lines and slots on pages, so readers can copy
+  // with aligned loads and map a single slot if they want to.
+  const uint32_t pitch =
+      static_cast<uint32_t>(RoundUp(width * BytesPerPixel(format), 64));
+  const uint64_t stride =
+      RoundUp(static_cast<uint64_t>(pitch) * height, kPageBytes);
+  const uint64_t dataOffset = RoundUp(
+      Layout::kHeaderBytes + slots * Layout::kSlotHeaderBytes, kPageBytes);
+  if (!memory_.Create(name, static_cast<size_t>(dataOffset + stride * slots)))
+    return false;
+
+  // The mapping starts zeroed: every slot reads as being written and head
+  // is 0. The magic goes in last, so a reader that opens the ring early
+  // sees no ring rather than half a header.
+  base_ = static_cast<uint8_t *>(memory_.Data());
+  Store<uint32_t>(base_, 4, Layout::kVersion);
+  Store<uint32_t>(base_, 8, width);
+  Store<uint32_t>(base_, 12, height);
+  Store<uint32_t>(base_, 16, pitch);
+  Store<uint32_t>(base_, 20, static_cast<uint32_t>(format));
+  Store<uint32_t>(base_, 24, slots);
+  Store<uint64_t>(base_, 32, stride);
+  Store<uint64_t>(base_, 40, dataOffset);
+  AtomicAt<uint32_t>(base_, Layout::kStateOffset)
+      .store(1, std::memory_order_relaxed);
+  AtomicAt<uint32_t>(base_, 0).store(Layout::kMagic, std::memory_order_release);
+
+  width_ = width;
+  height_ = height;
+  pitch_ = pitch;
+  format_ = format;
+  slots_ = slots;
+  stride_ = stride;
+  dataOffset_ = dataOffset;
+  head_ = 0;
+  charge_.Set(memory_.Size());
+  return true;
+}
+
+void SharedFrameWriter::Close() noexcept {
+  if (!base_)
+    return;
+  AtomicAt<uint32_t>(base_, Layout::kStateOffset)
+      .store(0, std::memory_order_release);
+  memory_.Close();
+  base_ = nullptr;
+  charge_.Set(0);
+}
+
+bool SharedFrameWriter::Write(const FrameView &frame, uint64_t frameIndex,
+                              int64_t timestampUs) noexcept {
+  if (!base_ || !frame.IsValid() || frame.width > width_ ||
+      frame.height > height_ || frame.format != format_) {
+    return false;
+  }
+  const uint64_t n = head_;
+  const size_t slot = static_cast<size_t>(n % slots_);
+  uint8_t *header =
+      base_ + Layout::kHeaderBytes + slot * Layout::kSlotHeaderBytes;
+  std::atomic<uint64_t> &seq = AtomicAt<uint64_t>(header, 0);
+
+  seq.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  Store<uint64_t>(header, 8, frameIndex);
+  Store<int64_t>(header, 16, timestampUs);
+  Store<uint32_t>(header, 24, frame.width);
+  Store<uint32_t>(header, 28, frame.height);
+  CopyRows(frame.data, frame.pitch, base_ + dataOffset_ + slot * stride_,
+           pitch_, frame.width * BytesPerPixel(format_), frame.height);
+  seq.store(n + 1, std::memory_order_release);
+
+  head_ = n + 1;
+  AtomicAt<uint64_t>(base_, Layout::kHeadOffset)
+      .store(head_, std::memory_order_release);
+  return true;
+}
+
+bool SharedFrameReader::Open(const std::string &name) noexcept {
+  Close();
+  if (!memory_.Open(name, false))
+    return false;
+  uint8_t *base = static_cast<uint8_t *>(memory_.Data());
+  const size_t size = memory_.Size();
+  if (size < Layout::kHeaderBytes ||
+      AtomicAt<uint32_t>(base, 0).load(std::memory_order_acquire) !=
+          Layout::kMagic ||
+      LoadU32(base, 4) != Layout::kVersion) {
+    memory_.Close();
+    return false;
+  }
+
+  width_ = LoadU32(base, 8);
+  height_ = LoadU32(base, 12);
+  pitch_ = LoadU32(base, 16);
+  format_ = static_cast<PixelFormat>(LoadU32(base, 20));
+  slots_ = LoadU32(base, 24);
+  stride_ = LoadU64(base, 32);
+  dataOffset_ = LoadU64(base, 40);
+  // A header that does not fit its own mapping is not one we wrote.
+  if (slots_ == 0 || pitch_ < width_ * BytesPerPixel(format_) ||
+      stride_ < static_cast<uint64_t>(pitch_) * height_ ||
+      dataOffset_ < Layout::kHeaderBytes + slots_ * Layout::kSlotHeaderBytes ||
+      dataOffset_ + stride_ * slots_ > size) {
+    memory_.Close();
+    return false;
+  }
+  base_ = base;
+  return true;
+}
+
+void SharedFrameReader::Close() noexcept {
+  memory_.Close();
+  base_ = nullptr;
+}
+
+bool SharedFrameReader::IsWriterOpen() const noexcept {
+  return base_ && AtomicAt<uint32_t>(base_, Layout::kStateOffset)
+                          .load(std::memory_order_acquire) != 0;
+}
+
+uint64_t SharedFrameReader::Head() const noexcept {
+  return base_ ? AtomicAt<uint64_t>(base_, Layout::kHeadOffset)
+                     .load(std::memory_order_acquire)
+               : 0;
+}
+
+uint8_t *SharedFrameReader::SlotHeader(uint64_t n) const noexcept {
+  return base_ + Layout::kHeaderBytes + (n % slots_) * Layout::kSlotHeaderBytes;
+}
+
+const std::atomic<uint64_t> &
+SharedFrameReader::Seq(uint64_t n) const noexcept {
+  return AtomicAt<uint64_t>(SlotHeader(n), 0);
+}
+
+uint8_t *SharedFrameReader::Pixels(uint64_t n) const noexcept {
+  return base_ + dataOffset_ + (n % slots_) * stride_;
+}
+
+bool SharedFrameReader::Peek(uint64_t n, FrameView &view,
+                             SharedFrameInfo *info) const noexcept {
+  if (!base_ || Seq(n).load(std::memory_order_acquire) != n + 1)
+    return false;
+  const uint8_t *header = SlotHeader(n);
+  // Clamped, so a torn read cannot send a caller past the slot.
+  const uint32_t width = std::min(LoadU32(header, 24), width_);
+  const uint32_t height = std::min(LoadU32(header, 28), height_);
+  if (info) {
+    info->sequence = n;
+    info->frameIndex = LoadU64(header, 8);
+    info->timestampUs = static_cast<int64_t>(LoadU64(header, 16));
+    info->width = width;
+    info->height = height;
+  }
+  view.data = Pixels(n);
+  view.width = width;
+  view.height = height;
+  view.pitch = pitch_;
+  view.format = format_;
+  return true;
+}
+
+bool SharedFrameReader::StillValid(uint64_t n) const noexcept {
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return base_ && Seq(n).load(std::memory_order_relaxed) == n + 1;
+}
+
+bool SharedFrameReader::Read(uint64_t n, const FrameView &out,
+                             SharedFrameInfo *info) const noexcept {
+  if (!out.IsValid() || out.format != format_)
+    return false;
+  FrameView view;
+  if (!Peek(n, view, info) || view.width > out.width ||
+      view.height > out.height) {
+    return false;
+  }
+  CopyRows(view.data, view.pitch, out.data, out.pitch,
+           view.width * BytesPerPixel(format_), view.height);
+  return StillValid(n);
+}
+
+bool SharedFrameReader::ReadLatest(const FrameView &out,
+                                   SharedFrameInfo *info) const noexcept {
+  // Losing the race for the newest frame means a newer one exists; a
+  // reader slower than the writer's whole ring gets nothing.
+  for (uint32_t attempt = 0; attempt < std::max(slots_, 1u); attempt++) {
+    const uint64_t head = Head();
+    if (head == 0)
+      return false;
+    if (Read(head - 1, out, info))
+      return true;
+  }
+  return false;
+}
+
+} // namespace DeepFrame
@@ -0,0 +1,176 @@
+#pragma once
+
+#include "FrameView.h"
+#include "MemoryLedger.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace DeepFrame {
+
+// A named, process-shared read/write mapping: POSIX shared memory on
+// Linux, a pagefile-backed file mapping ("Local\" namespace) on Windows.
+// The creator owns the name; it goes away when the creator closes it,
+// although processes that still have it mapped keep their view.
+class SharedMemory {
+public:
+  SharedMemory() noexcept = default;
+  ~SharedMemory() noexcept;
+
+  SharedMemory(const SharedMemory &) = delete;
+  SharedMemory &operator=(const SharedMemory &) = delete;
+
+  // Replaces any stale object of the same name left by a crashed writer.
+  [[nodiscard]] bool Create(const std::string &name, size_t bytes) noexcept;
+  [[nodiscard]] bool Open(const std::string &name, bool writable) noexcept;
+  void Close() noexcept;
+
+  [[nodiscard]] void *Data() const noexcept { return data_; }
+  [[nodiscard]] size_t Size() const noexcept { return size_; }
+  [[nodiscard]] bool IsOpen() const noexcept { return data_ != nullptr; }
+
+private:
+  void *data_ = nullptr;
+  size_t size_ = 0;
+  std::string name_;
+  bool owner_ = false;
+#ifdef _WIN32
+  void *mapping_ = nullptr;
+#endif
+};
+
+// Layout of a shared frame ring, little endian:
+//
+//   header at 0:
+//     0  u32 magic (kMagic)        16  u32 pitch (bytes per row)
+//     4  u32 version (kVersion)    20  u32 PixelFormat
+//     8  u32 max width             24  u32 slot count
+//    12  u32 max height            32  u64 slot stride (bytes)
+//    40  u64 offset of slot 0's pixels (page aligned)
+//    64  u64 head: frames published so far
+//   128  u32 writer state: 1 open, 0 closed
+//
+//   slot s header at kHeaderBytes + s * kSlotHeaderBytes:
+//     0  u64 seq: n + 1 once frame n is complete, 0 while being written
+//     8  u64 frame index      24  u32 width
+//    16  i64 timestamp (us)   28  u32 height
+//
+// Frames may be smaller than the maximum (a cropped window); rows are
+// always `pitch` apart. The writer never waits for readers. A reader
+// takes head, copies frame n from slot n % slots between two loads of
+// that slot's seq, and keeps the copy only if both were n + 1.
+struct SharedFrameLayout {
+  static constexpr uint32_t kMagic = 0x46534644; // "DFSF"
+  static constexpr uint32_t kVersion = 1;
+  static constexpr size_t kHeaderBytes = 256;
+  static constexpr size_t kSlotHeaderBytes = 64;
+  static constexpr size_t kHeadOffset = 64;
+  static constexpr size_t kStateOffset = 128;
+};
+
+struct SharedFrameInfo {
+  uint64_t sequence = 0; // position in the ring, counting from 0
+  uint64_t frameIndex = 0;
+  int64_t timestampUs = 0;
+  uint32_t width = 0;
+  uint32_t height = 0;
+};
+
+// Publishes frames into a SharedFrameRing. One writer per ring.
+class SharedFrameWriter {
+public:
+  static constexpr uint32_t kDefaultSlots = 4;
+
+  SharedFrameWriter() noexcept = default;
+  ~SharedFrameWriter() noexcept { Close(); }
+
+  SharedFrameWriter(const SharedFrameWriter &) = delete;
+  SharedFrameWriter &operator=(const SharedFrameWriter &) = delete;
+
+  [[nodiscard]] bool Create(const std::string &name, uint32_t width,
+                            uint32_t height,
+                            PixelFormat format = PixelFormat::BGRA8,
+                            uint32_t slots = kDefaultSlots) noexcept;
+  // Marks the ring closed for readers and releases the name.
+  void Close() noexcept;
+
+  // Copies `frame` (the ring's format, at most its size) into the next
+  // slot, overwriting the oldest frame whether or not anyone has read it.
+  [[nodiscard]] bool Write(const FrameView &frame, uint64_t frameIndex,
+                           int64_t timestampUs) noexcept;
+
+  [[nodiscard]] uint32_t Width() const noexcept { return width_; }
+  [[nodiscard]] uint32_t Height() const noexcept { return height_; }
+  [[nodiscard]] uint64_t Published() const noexcept { return head_; }
+  [[nodiscard]] bool IsOpen() const noexcept { return memory_.IsOpen(); }
+
+private:
+  SharedMemory memory_;
+  uint8_t *base_ = nullptr;
+  uint32_t width_ = 0;
+  uint32_t height_ = 0;
+  uint32_t pitch_ = 0;
+  PixelFormat format_ = PixelFormat::BGRA8;
+  uint32_t slots_ = 0;
+  uint64_t stride_ = 0;
+  uint64_t dataOffset_ = 0;
+  uint64_t head_ = 0;
+  MemoryCharge charge_{MemorySubsystem::Export, MemoryDomain::Cpu};
+};
+
+// Reader side, for tools in other processes. Never blocks the writer; a
+// frame overwritten while it was being copied is reported as missed.
+class SharedFrameReader {
+public:
+  SharedFrameReader() noexcept = default;
+
+  SharedFrameReader(const SharedFrameReader &) = delete;
+  SharedFrameReader &operator=(const SharedFrameReader &) = delete;
+
+  // False until a writer has created `name`.
+  [[nodiscard]] bool Open(const std::string &name) noexcept;
+  void Close() noexcept;
+
+  // The largest frame the writer can publish.
+  [[nodiscard]] uint32_t Width() const noexcept { return width_; }
+  [[nodiscard]] uint32_t Height() const noexcept { return height_; }
+  [[nodiscard]] PixelFormat Format() const noexcept { return format_; }
+  [[nodiscard]] uint32_t Slots() const noexcept { return slots_; }
+  [[nodiscard]] bool IsOpen() const noexcept { return memory_.IsOpen(); }
+  [[nodiscard]] bool IsWriterOpen() const noexcept;
+
+  // Frames published so far; frame Head() - 1 is the newest.
+  [[nodiscard]] uint64_t Head() const noexcept;
+
+  // Copies frame `n` into the top left of `out` (any pitch, at least the
+  // frame's size). False if it has been, or was while copying, overwritten.
+  [[nodiscard]] bool Read(uint64_t n, const FrameView &out,
+                          SharedFrameInfo *info = nullptr) const noexcept;
+  // The newest complete frame; false when there is none yet.
+  [[nodiscard]] bool ReadLatest(const FrameView &out,
+                                SharedFrameInfo *info = nullptr) const noexcept;
+
+  // Zero-copy access: a read-only view of frame `n` in the mapping.
+  // Whatever was computed from it only counts if StillValid(n) afterwards.
+  [[nodiscard]] bool Peek(uint64_t n, FrameView &view,
+                          SharedFrameInfo *info = nullptr) const noexcept;
+  [[nodiscard]] bool StillValid(uint64_t n) const noexcept;
+
+private:
+  [[nodiscard]] const std::atomic<uint64_t> &Seq(uint64_t n) const noexcept;
+  [[nodiscard]] uint8_t *SlotHeader(uint64_t n) const noexcept;
+  [[nodiscard]] uint8_t *Pixels(uint64_t n) const noexcept;
+
+  SharedMemory memory_;
+  uint8_t *base_ = nullptr;
+  uint32_t width_ = 0;
+  uint32_t height_ = 0;
+  uint32_t pitch_ = 0;
+  PixelFormat format_ = PixelFormat::BGRA8;
+  uint32_t slots_ = 0;
+  uint64_t stride_ = 0;
+  uint64_t dataOffset_ = 0;
+};
+
+} // namespace DeepFrame
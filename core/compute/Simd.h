@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                   \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DEEPFRAME_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define DEEPFRAME_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace DeepFrame {
+
+// Sum of absolute differences over a 16x16 block of 8-bit samples.
+[[nodiscard]] inline uint32_t Sad16x16(const uint8_t *a, ptrdiff_t pitchA,
+                                       const uint8_t *b,
+                                       ptrdiff_t pitchB) noexcept {
+#if defined(DEEPFRAME_SSE2)
+  __m128i acc = _mm_setzero_si128();
+  for (int y = 0; y < 16; y++) {
+    __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a));
+    __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b));
+    acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+    a += pitchA;
+    b += pitchB;
+  }
+  return static_cast<uint32_t>(_mm_cvtsi128_si32(acc) +
+                               _mm_cvtsi128_si32(_mm_srli_si128(acc, 8)));
+#elif defined(DEEPFRAME_NEON)
+  uint16x8_t acc = vdupq_n_u16(0);
+  for (int y = 0; y < 16; y++) {
+    acc = vpadalq_u8(acc, vabdq_u8(vld1q_u8(a), vld1q_u8(b)));
+    a += pitchA;
+    b += pitchB;
+  }
+  return vaddlvq_u16(acc);
+#else
+  uint32_t sum = 0;
+  for (int y = 0; y < 16; y++) {
+    for (int x = 0; x < 16; x++)
+      sum += static_cast<uint32_t>(std::abs(a[x] - b[x]));
+    a += pitchA;
+    b += pitchB;
+  }
+  return sum;
+#endif
+}
+
+// Sum of absolute differences over a run of bytes.
+[[nodiscard]] inline uint32_t SadBytes(const uint8_t *a, const uint8_t *b,
+                                       size_t bytes) noexcept {
+  size_t i = 0;
+  uint32_t sum = 0;
+#if defined(DEEPFRAME_SSE2)
+  __m128i acc = _mm_setzero_si128();
+  for (; i + 16 <= bytes; i += 16) {
+    __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+    __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+    acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+  }
+  sum = static_cast<uint32_t>(_mm_cvtsi128_si32(acc) +
+                              _mm_cvtsi128_si32(_mm_srli_si128(acc, 8)));
+#elif defined(DEEPFRAME_NEON)
+  uint32x4_t acc = vdupq_n_u32(0);
+  for (; i + 16 <= bytes; i += 16) {
+    uint8x16_t d = vabdq_u8(vld1q_u8(a + i), vld1q_u8(b + i));
+    acc = vpadalq_u16(acc, vpaddlq_u8(d));
+  }
+  sum = vaddvq_u32(acc);
+#endif
+  for (; i < bytes; i++)
+    sum += static_cast<uint32_t>(std::abs(a[i] - b[i]));
+  return sum;
+}
+
+} // namespace DeepFrame
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace DeepFrame {
+
+// Slot bookkeeping for a single-producer single-consumer ring of SIZE
+// slots. Head and tail count up forever and sit on separate cache lines,
+// so each side only writes its own line and reads the other's; the payload
+// lives with the caller (textures, CPU buffers, indices).
+template <size_t SIZE> class RingCursor {
+public:
+  static_assert(SIZE > 0, "ring needs at least one slot");
+
+  // Producer side: slot to fill next, or SIZE when the ring is full.
+  [[nodiscard]] size_t BeginPush() const noexcept {
+    const uint64_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) >= SIZE)
+      return SIZE;
+    return static_cast<size_t>(head % SIZE);
+  }
+  // Publishes the slot returned by BeginPush.
+  void CommitPush() noexcept {
+    head_.store(head_.load(std::memory_order_relaxed) + 1,
+                std::memory_order_release);
+  }
+
+  // Consumer side: oldest filled slot, or SIZE when the ring is empty.
+  [[nodiscard]] size_t BeginPop() const noexcept {
+    const uint64_t tail = tail_.load(std::memory_order_relaxed);
+    if (head_.load(std::memory_order_acquire) == tail)
+      return SIZE;
+    return static_cast<size_t>(tail % SIZE);
+  }
+  // Hands the slot returned by BeginPop back to the producer.
+  void CommitPop() noexcept {
+    tail_.store(tail_.load(std::memory_order_relaxed) + 1,
+                std::memory_order_release);
+  }
+
+  // Newest filled slot, or SIZE when empty.
+  [[nodiscard]] size_t Latest() const noexcept {
+    const uint64_t head = head_.load(std::memory_order_acquire);
+    if (head == tail_.load(std::memory_order_acquire))
+      return SIZE;
+    return static_cast<size_t>((head - 1) % SIZE);
+  }
+
+  [[nodiscard]] size_t Count() const noexcept {
+    return static_cast<size_t>(head_.load(std::memory_order_acquire) -
+                               tail_.load(std::memory_order_acquire));
+  }
+
+  // Only while neither side is running.
+  void Reset() noexcept {
+    head_.store(0, std::memory_order_relaxed);
+    tail_.store(0, std::memory_order_relaxed);
+  }
+
+private:
+  alignas(64) std::atomic<uint64_t> head_{0};
+  alignas(64) std::atomic<uint64_t> tail_{0};
+};
+
+// RingCursor with the payload stored inline. Items are moved out on Pop,
+// so a slot does not keep a popped lease or buffer alive.
+template <typename T, size_t SIZE> class SpscRing {
+public:
+  [[nodiscard]] bool Push(const T &item) noexcept {
+    const size_t slot = cursor_.BeginPush();
+    if (slot == SIZE)
+      return false;
+    items_[slot] = item;
+    cursor_.CommitPush();
+    return true;
+  }
+
+  [[nodiscard]] bool Push(T &&item) noexcept {
+    const size_t slot = cursor_.BeginPush();
+    if (slot == SIZE)
+      return false;
+    items_[slot] = std::move(item);
+    cursor_.CommitPush();
+    return true;
+  }
+
+  [[nodiscard]] bool Pop(T &item) noexcept {
+    const size_t slot = cursor_.BeginPop();
+    if (slot == SIZE)
+      return false;
+    item = std::move(items_[slot]);
+    cursor_.CommitPop();
+    return true;
+  }
+
+  [[nodiscard]] size_t Count() const noexcept { return cursor_.Count(); }
+
+private:
+  RingCursor<SIZE> cursor_;
+  T items_[SIZE]{};
+};
+
+} // namespace DeepFrame
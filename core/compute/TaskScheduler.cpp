@@ -0,0 +1,283 @@
+#include "TaskScheduler.h"
+#include <algorithm>
+
+namespace DeepFrame {
+
+namespace {
+
+struct WorkerIdentity {
+  const TaskScheduler *scheduler = nullptr;
+  int32_t index = -1;
+};
+
+thread_local WorkerIdentity t_worker;
+
+} // namespace
+
+void TaskScheduler::Queue::PushBack(TaskNode *task) noexcept {
+  std::lock_guard<std::mutex> lock(mutex);
+  task->next = nullptr;
+  task->prev = tail;
+  if (tail)
+    tail->next = task;
+  else
+    head = task;
+  tail = task;
+}
+
+TaskNode *TaskScheduler::Queue::PopBack() noexcept {
+  std::lock_guard<std::mutex> lock(mutex);
+  TaskNode *task = tail;
+  if (!task)
+    return nullptr;
+  tail = task->prev;
+  if (tail)
+    tail->next = nullptr;
+  else
+    head = nullptr;
+  return task;
+}
+
+TaskNode *TaskScheduler::Queue::PopFront() noexcept {
+  std::lock_guard<std::mutex> lock(mutex);
+  TaskNode *task = head;
+  if (!task)
+    return nullptr;
+  head = task->next;
+  if (head)
+    head->prev = nullptr;
+  else
+    tail = nullptr;
+  return task;
+}
+
+TaskScheduler::TaskScheduler(uint32_t threads) noexcept {
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+
+  try {
+    nodes_ = std::make_unique<TaskNode[]>(kMaxTasks);
+    for (size_t i = 0; i < kMaxTasks; i++) {
+      nodes_[i].next = freeNodes_;
+      freeNodes_ = &nodes_[i];
+    }
+    jobs_ = std::make_unique<Job[]>(kMaxJobs);
+    for (size_t i = 0; i < kMaxJobs; i++) {
+      jobs_[i].free = freeJobs_;
+      freeJobs_ = &jobs_[i];
+    }
+    // All queues exist before any worker starts stealing from them.
+    for (uint32_t i = 0; i < threads; i++)
+      workers_.push_back(std::make_unique<Worker>());
+    for (uint32_t i = 0; i < threads; i++)
+      workers_[i]->thread = std::thread(&TaskScheduler::WorkerLoop, this, i);
+  } catch (...) {
+    // Whatever workers started still run tasks; with none, Submit runs
+    // them inline.
+  }
+}
+
+TaskScheduler::~TaskScheduler() noexcept {
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  for (auto &worker : workers_) {
+    if (worker->thread.joinable())
+      worker->thread.join();
+  }
+}
+
+int32_t TaskScheduler::CurrentWorker() const noexcept {
+  return t_worker.scheduler == this ? t_worker.index : -1;
+}
+
+TaskNode *TaskScheduler::AcquireNode() noexcept {
+  std::lock_guard<std::mutex> lock(nodeMutex_);
+  TaskNode *task = freeNodes_;
+  // Without running workers nothing would ever take a queued task.
+  if (!task || workers_.empty() || !workers_.back()->thread.joinable())
+    return nullptr;
+  freeNodes_ = task->next;
+  return task;
+}
+
+void TaskScheduler::ReleaseNode(TaskNode *task) noexcept {
+  std::lock_guard<std::mutex> lock(nodeMutex_);
+  task->next = freeNodes_;
+  freeNodes_ = task;
+}
+
+void TaskScheduler::Enqueue(TaskNode *task) noexcept {
+  const size_t priority = static_cast<size_t>(task->priority);
+  const int32_t worker = CurrentWorker();
+  if (worker >= 0)
+    workers_[worker]->queues[priority].PushBack(task);
+  else
+    shared_[priority].PushBack(task);
+
+  queued_.fetch_add(1, std::memory_order_seq_cst);
+  if (sleepers_.load(std::memory_order_seq_cst) > 0) {
+    std::lock_guard<std::mutex> lock(sleepMutex_);
+    wake_.notify_one();
+  }
+}
+
+void TaskScheduler::Defer(TaskCounter &after, TaskNode *task) noexcept {
+  {
+    std::lock_guard<std::mutex> lock(after.mutex_);
+    if (after.pending_ > 0) {
+      task->next = after.continuations_;
+      after.continuations_ = task;
+      return;
+    }
+  }
+  Enqueue(task);
+}
+
+TaskNode *TaskScheduler::Take(int32_t worker) noexcept {
+  if (queued_.load(std::memory_order_acquire) == 0)
+    return nullptr;
+  const size_t workers = workers_.size();
+  for (size_t priority = 0; priority < kPriorities; priority++) {
+    TaskNode *task = nullptr;
+    if (worker >= 0)
+      task = workers_[worker]->queues[priority].PopBack();
+    if (!task)
+      task = shared_[priority].PopFront();
+    // Victims in order from the next worker on, so thieves spread out.
+    const size_t first = worker >= 0 ? static_cast<size_t>(worker) + 1 : 0;
+    for (size_t i = 0; !task && i < workers; i++) {
+      const size_t victim = (first + i) % workers;
+      if (static_cast<int32_t>(victim) != worker)
+        task = workers_[victim]->queues[priority].PopFront();
+    }
+    if (task) {
+      queued_.fetch_sub(1, std::memory_order_acq_rel);
+      return task;
+    }
+  }
+  return nullptr;
+}
+
+void TaskScheduler::Execute(TaskNode *task) noexcept {
+  task->run(task->storage);
+  TaskCounter *counter = task->counter;
+  ReleaseNode(task);
+  if (!counter)
+    return;
+
+  TaskNode *continuations = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(counter->mutex_);
+    if (--counter->pending_ == 0) {
+      continuations = counter->continuations_;
+      counter->continuations_ = nullptr;
+    }
+  }
+  // The counter may already be gone; only the detached list is used.
+  while (continuations) {
+    TaskNode *next = continuations->next;
+    Enqueue(continuations);
+    continuations = next;
+  }
+}
+
+void TaskScheduler::Wait(const TaskCounter &counter) noexcept {
+  const int32_t worker = CurrentWorker();
+  while (!counter.Done()) {
+    if (TaskNode *task = Take(worker))
+      Execute(task);
+    else
+      std::this_thread::yield();
+  }
+}
+
+void TaskScheduler::WorkerLoop(uint32_t index) noexcept {
+  t_worker = {this, static_cast<int32_t>(index)};
+  for (;;) {
+    if (TaskNode *task = Take(static_cast<int32_t>(index))) {
+      Execute(task);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(sleepMutex_);
+    sleepers_.fetch_add(1, std::memory_order_seq_cst);
+    wake_.wait(lock, [this] {
+      return stopping_ || queued_.load(std::memory_order_seq_cst) > 0;
+    });
+    sleepers_.fetch_sub(1, std::memory_order_relaxed);
+    if (stopping_ && queued_.load(std::memory_order_acquire) == 0)
+      return;
+  }
+}
+
+TaskScheduler::Job *TaskScheduler::AcquireJob() noexcept {
+  std::lock_guard<std::mutex> lock(jobMutex_);
+  Job *job = freeJobs_;
+  if (job)
+    freeJobs_ = job->free;
+  return job;
+}
+
+void TaskScheduler::ReleaseJob(Job *job) noexcept {
+  if (job->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+    return;
+  std::lock_guard<std::mutex> lock(jobMutex_);
+  job->free = freeJobs_;
+  freeJobs_ = job;
+}
+
+void TaskScheduler::RunJob(Job &job) noexcept {
+  for (;;) {
+    const size_t begin =
+        job.next.fetch_add(job.grain, std::memory_order_relaxed);
+    if (begin >= job.count)
+      return;
+    (*job.fn)(begin, std::min(job.count, begin + job.grain));
+    job.done.fetch_add(1, std::memory_order_release);
+  }
+}
+
+void TaskScheduler::ParallelFor(size_t count, size_t grain, RangeFn fn,
+                                TaskPriority priority) noexcept {
+  if (count == 0)
+    return;
+  grain = std::max<size_t>(1, grain);
+  const size_t chunks = (count + grain - 1) / grain;
+  // The calling thread takes part, so a worker calling this asks one
+  // fewer helper.
+  const size_t others = workers_.size() - (CurrentWorker() >= 0 ? 1 : 0);
+  const size_t helpers = std::min(chunks - 1, others);
+  Job *job = helpers ? AcquireJob() : nullptr;
+  if (!job) {
+    fn(0, count);
+    return;
+  }
+
+  job->fn = &fn;
+  job->count = count;
+  job->grain = grain;
+  job->next.store(0, std::memory_order_relaxed);
+  job->done.store(0, std::memory_order_relaxed);
+  job->refs.store(static_cast<uint32_t>(helpers) + 1,
+                  std::memory_order_release);
+  for (size_t i = 0; i < helpers; i++) {
+    Submit(
+        [this, job] {
+          RunJob(*job);
+          ReleaseJob(job);
+        },
+        priority);
+  }
+
+  RunJob(*job);
+  // Only chunks other threads are part-way through are left; they are
+  // short, so spin rather than sleep.
+  while (job->done.load(std::memory_order_acquire) < chunks)
+    std::this_thread::yield();
+  ReleaseJob(job);
+}
+
+} // namespace DeepFrame
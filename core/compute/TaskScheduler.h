@@ -0,0 +1,258 @@
+#pragma once
+
+#include "RangeFn.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace DeepFrame {
+
+enum class TaskPriority : uint8_t {
+  // Work a present is waiting on; any queued High task is taken before
+  // any Normal one.
+  High,
+  Normal,
+  Count
+};
+
+class TaskCounter;
+
+// A submitted callable with its captures stored inline, so submitting does
+// not allocate. Internal to TaskScheduler.
+struct TaskNode {
+  static constexpr size_t kStorage = 64;
+
+  alignas(std::max_align_t) unsigned char storage[kStorage];
+  // Runs the callable in `storage` and destroys it.
+  void (*run)(void *storage) noexcept = nullptr;
+  TaskCounter *counter = nullptr;
+  TaskPriority priority = TaskPriority::Normal;
+  TaskNode *prev = nullptr;
+  TaskNode *next = nullptr;
+};
+
+// Tasks outstanding against it; continuations added with
+// TaskScheduler::Then are submitted once the count drops to zero. Must
+// outlive the tasks counted on it.
+class TaskCounter {
+public:
+  TaskCounter() noexcept = default;
+  TaskCounter(const TaskCounter &) = delete;
+  TaskCounter &operator=(const TaskCounter &) = delete;
+
+  [[nodiscard]] bool Done() const noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_ == 0;
+  }
+
+private:
+  friend class TaskScheduler;
+
+  // The mutex, not an atomic count, so that a waiter which saw zero can
+  // destroy the counter while the finishing worker is still in it.
+  mutable std::mutex mutex_;
+  uint32_t pending_ = 0;
+  TaskNode *continuations_ = nullptr;
+};
+
+// Work-stealing task scheduler. Each worker owns a deque per priority: it
+// pushes and pops its own tasks at the back (the newest, cache-warm ones),
+// and idle workers steal from the front of the others'. Tasks submitted
+// from outside the workers go to a shared queue. Pipeline stages run on it
+// as SerialTasks and data-parallel kernels through ParallelFor, so a slow
+// stage borrows the cores the others leave idle.
+class TaskScheduler {
+public:
+  explicit TaskScheduler(uint32_t threads = 0) noexcept;
+  // Runs what is still queued, then joins. Tasks that keep resubmitting
+  // themselves must be stopped first.
+  ~TaskScheduler() noexcept;
+
+  TaskScheduler(const TaskScheduler &) = delete;
+  TaskScheduler &operator=(const TaskScheduler &) = delete;
+
+  // Queues `fn`, counted on `counter` if given. When every task slot is in
+  // use, `fn` runs on the calling thread instead.
+  template <typename F>
+  void Submit(F &&fn, TaskPriority priority = TaskPriority::Normal,
+              TaskCounter *counter = nullptr) noexcept {
+    if (TaskNode *task = Prepare(std::forward<F>(fn), priority, counter))
+      Enqueue(task);
+    else
+      fn();
+  }
+
+  // Queues `fn` once `after` has no tasks outstanding (now, if it has
+  // none). `fn` counts on `counter` from this call on. When every task
+  // slot is in use, waits for `after` and runs `fn` on the calling thread.
+  template <typename F>
+  void Then(TaskCounter &after, F &&fn,
+            TaskPriority priority = TaskPriority::Normal,
+            TaskCounter *counter = nullptr) noexcept {
+    if (TaskNode *task = Prepare(std::forward<F>(fn), priority, counter)) {
+      Defer(after, task);
+    } else {
+      Wait(after);
+      fn();
+    }
+  }
+
+  // Runs queued tasks on the calling thread until `counter` is done.
+  void Wait(const TaskCounter &counter) noexcept;
+
+  // Splits [0, count) into `grain`-sized chunks that the calling thread
+  // and idle workers claim until none are left; returns once all have run.
+  void ParallelFor(size_t count, size_t grain, RangeFn fn,
+                   TaskPriority priority = TaskPriority::Normal) noexcept;
+
+  [[nodiscard]] uint32_t ThreadCount() const noexcept {
+    return static_cast<uint32_t>(workers_.size());
+  }
+  // Worker index of the calling thread, or -1 off the workers.
+  [[nodiscard]] int32_t CurrentWorker() const noexcept;
+
+private:
+  static constexpr size_t kMaxTasks = 1024;
+  static constexpr size_t kMaxJobs = 64;
+  static constexpr size_t kPriorities =
+      static_cast<size_t>(TaskPriority::Count);
+
+  // Intrusive, so queueing never allocates.
+  struct alignas(64) Queue {
+    std::mutex mutex;
+    TaskNode *head = nullptr;
+    TaskNode *tail = nullptr;
+
+    void PushBack(TaskNode *task) noexcept;
+    [[nodiscard]] TaskNode *PopBack() noexcept;
+    [[nodiscard]] TaskNode *PopFront() noexcept;
+  };
+  struct Worker {
+    Queue queues[kPriorities];
+    std::thread thread;
+  };
+  // One ParallelFor call. Helpers hold a reference, since one can still
+  // be starting after the caller has returned.
+  struct Job {
+    const RangeFn *fn = nullptr;
+    size_t count = 0;
+    size_t grain = 1;
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> done{0};
+    std::atomic<uint32_t> refs{0};
+    Job *free = nullptr;
+  };
+
+  template <typename F>
+  TaskNode *Prepare(F &&fn, TaskPriority priority,
+                    TaskCounter *counter) noexcept {
+    using Fn = std::decay_t<F>;
+    static_assert(sizeof(Fn) <= TaskNode::kStorage &&
+                      alignof(Fn) <= alignof(std::max_align_t),
+                  "task captures too large to store inline");
+    TaskNode *task = AcquireNode();
+    if (!task)
+      return nullptr;
+    new (task->storage) Fn(std::forward<F>(fn));
+    task->run = [](void *storage) noexcept {
+      Fn &callable = *static_cast<Fn *>(storage);
+      callable();
+      callable.~Fn();
+    };
+    task->priority = priority;
+    task->counter = counter;
+    if (counter) {
+      std::lock_guard<std::mutex> lock(counter->mutex_);
+      counter->pending_++;
+    }
+    return task;
+  }
+
+  [[nodiscard]] TaskNode *AcquireNode() noexcept;
+  void ReleaseNode(TaskNode *task) noexcept;
+  void Enqueue(TaskNode *task) noexcept;
+  void Defer(TaskCounter &after, TaskNode *task) noexcept;
+  // Highest priority first: own deque, the shared queue, then the others.
+  [[nodiscard]] TaskNode *Take(int32_t worker) noexcept;
+  void Execute(TaskNode *task) noexcept;
+  void WorkerLoop(uint32_t index) noexcept;
+
+  [[nodiscard]] Job *AcquireJob() noexcept;
+  void ReleaseJob(Job *job) noexcept;
+  static void RunJob(Job &job) noexcept;
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  Queue shared_[kPriorities];
+
+  std::unique_ptr<TaskNode[]> nodes_;
+  std::mutex nodeMutex_;
+  TaskNode *freeNodes_ = nullptr;
+
+  std::unique_ptr<Job[]> jobs_;
+  std::mutex jobMutex_;
+  Job *freeJobs_ = nullptr;
+
+  // Queued, not yet taken. Sleepers re-check it under sleepMutex_, and a
+  // submitter that sees a sleeper notifies under it, so no wake-up is lost.
+  std::atomic<uint32_t> queued_{0};
+  std::atomic<uint32_t> sleepers_{0};
+  std::mutex sleepMutex_;
+  std::condition_variable wake_;
+  bool stopping_ = false;
+};
+
+// A body that runs on one worker at a time however often it is signalled:
+// a Signal during a run causes one more run. Pipeline stages are these; a
+// stage signals the next when it hands over a frame.
+class SerialTask {
+public:
+  SerialTask(TaskScheduler &scheduler, TaskPriority priority,
+             std::function<void()> body) noexcept
+      : scheduler_(scheduler), priority_(priority), body_(std::move(body)) {}
+
+  SerialTask(const SerialTask &) = delete;
+  SerialTask &operator=(const SerialTask &) = delete;
+
+  void Signal() noexcept {
+    if (signals_.fetch_add(1, std::memory_order_acq_rel) == 0)
+      scheduler_.Submit([this] { Run(); }, priority_);
+  }
+
+  [[nodiscard]] bool IsIdle() const noexcept {
+    return signals_.load(std::memory_order_acquire) == 0;
+  }
+  // Until no run is queued or in progress. Nothing may signal it after.
+  void WaitIdle() const noexcept {
+    while (!IsIdle())
+      std::this_thread::yield();
+  }
+
+private:
+  void Run() noexcept {
+    uint32_t seen = signals_.load(std::memory_order_acquire);
+    for (;;) {
+      body_();
+      const uint32_t left =
+          signals_.fetch_sub(seen, std::memory_order_acq_rel) - seen;
+      if (left == 0)
+        return;
+      seen = left;
+    }
+  }
+
+  TaskScheduler &scheduler_;
+  TaskPriority priority_;
+  std::function<void()> body_;
+  std::atomic<uint32_t> signals_{0};
+};
+
+} // namespace DeepFrame
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace DeepFrame {
+
+enum TelemetryFlag : uint32_t {
+  // An in-between frame was generated for this pair.
+  kTelemetryInterpolated = 1u << 0,
+  // ...by the ONNX model.
+  kTelemetryModel = 1u << 1,
+  // The model was late or failed and a cross-fade replaced it.
+  kTelemetryBlendFallback = 1u << 2,
+  // Same content as the previous frame; nothing was presented.
+  kTelemetryDuplicate = 1u << 3,
+  // The pair straddled a scene cut.
+  kTelemetrySceneCut = 1u << 4,
+  // Nothing to interpolate with; the frame was presented as captured.
+  kTelemetryPassthrough = 1u << 5,
+  // The present ring was full and dropped a frame of this pair.
+  kTelemetryPresentDropped = 1u << 6,
+  // The pipeline was idling on static content.
+  kTelemetryIdle = 1u << 7,
+};
+
+// One per frame taken by the inference stage.
+struct TelemetryRecord {
+  uint32_t flags = 0;
+  uint32_t frameIndex = 0; // low 32 bits of the capture frame index
+  double captureMs = 0.0;  // capture time on the pipeline clock
+  float queueMs = 0.f;     // capture to inference start
+  float inferenceMs = 0.f; // interpolation, including read-back
+  float submitMs = 0.f;    // copies into the present ring
+};
+
+// Per-frame telemetry in caller-provided memory that another runtime (the
+// addon's JS side) reads in place, with no calls into the writer. Little
+// endian, every field naturally aligned:
+//
+//   header, kHeaderBytes:
+//     0  u32 magic (kMagic)       8  u32 capacity, a power of two
+//     4  u32 version (kVersion)  12  u32 record bytes (kRecordBytes)
+//    16  u32 head: records written so far, mod 2^32
+//
+//   record n at kHeaderBytes + (n % capacity) * kRecordBytes:
+//     0  u32 seq: n + 1 once complete, 0 while being written
+//     4  u32 flags (TelemetryFlag)   16  f32 queueMs
+//     8  f64 captureMs               20  f32 inferenceMs
+//                                    24  f32 submitMs
+//                                    28  u32 frameIndex
+//
+// One writer. Readers take head, then for each record n they have not
+// seen: load seq, copy the fields, load seq again; the copy is good if
+// both loads were n + 1. Anything else means the writer lapped them.
+class TelemetryRing {
+public:
+  static constexpr uint32_t kMagic = 0x4C544644; // "DFTL"
+  static constexpr uint32_t kVersion = 1;
+  static constexpr size_t kHeaderBytes = 64;
+  static constexpr size_t kRecordBytes = 32;
+
+  [[nodiscard]] static constexpr size_t BytesFor(uint32_t capacity) noexcept {
+    return kHeaderBytes + static_cast<size_t>(capacity) * kRecordBytes;
+  }
+
+  // Formats `memory` (8-byte aligned, BytesFor(capacity) long, zeroed or
+  // not) as an empty ring; false for a capacity that is not a power of two
+  // or memory that is too small.
+  [[nodiscard]] bool Attach(void *memory, size_t bytes,
+                            uint32_t capacity) noexcept {
+    if (!memory || capacity == 0 || (capacity & (capacity - 1)) ||
+        bytes < BytesFor(capacity) ||
+        reinterpret_cast<uintptr_t>(memory) % alignof(double)) {
+      return false;
+    }
+    base_ = static_cast<uint8_t *>(memory);
+    capacity_ = capacity;
+    std::memset(base_, 0, BytesFor(capacity));
+    StoreU32(0, kMagic);
+    StoreU32(4, kVersion);
+    StoreU32(8, capacity);
+    StoreU32(12, static_cast<uint32_t>(kRecordBytes));
+    head_ = 0;
+    Word(16).store(0, std::memory_order_release);
+    return true;
+  }
+
+  [[nodiscard]] bool IsAttached() const noexcept { return base_ != nullptr; }
+  [[nodiscard]] uint32_t Capacity() const noexcept { return capacity_; }
+
+  // Writer only.
+  void Write(const TelemetryRecord &record) noexcept {
+    const uint32_t n = head_;
+    const size_t at = RecordOffset(n);
+    std::atomic<uint32_t> &seq = Word(at);
+    seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(base_ + at + 4, &record.flags, 4);
+    std::memcpy(base_ + at + 8, &record.captureMs, 8);
+    std::memcpy(base_ + at + 16, &record.queueMs, 4);
+    std::memcpy(base_ + at + 20, &record.inferenceMs, 4);
+    std::memcpy(base_ + at + 24, &record.submitMs, 4);
+    std::memcpy(base_ + at + 28, &record.frameIndex, 4);
+    seq.store(n + 1, std::memory_order_release);
+    head_ = n + 1;
+    Word(16).store(head_, std::memory_order_release);
+  }
+
+  // Native counterpart of the JS reader, for tools and benches.
+  [[nodiscard]] uint32_t Head() const noexcept {
+    return Word(16).load(std::memory_order_acquire);
+  }
+
+  // Record n if it is still in the ring and was not being rewritten while
+  // it was copied.
+  [[nodiscard]] bool Read(uint32_t n, TelemetryRecord &record) const noexcept {
+    const size_t at = RecordOffset(n);
+    const std::atomic<uint32_t> &seq = Word(at);
+    if (seq.load(std::memory_order_acquire) != n + 1)
+      return false;
+    std::memcpy(&record.flags, base_ + at + 4, 4);
+    std::memcpy(&record.captureMs, base_ + at + 8, 8);
+    std::memcpy(&record.queueMs, base_ + at + 16, 4);
+    std::memcpy(&record.inferenceMs, base_ + at + 20, 4);
+    std::memcpy(&record.submitMs, base_ + at + 24, 4);
+    std::memcpy(&record.frameIndex, base_ + at + 28, 4);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return seq.load(std::memory_order_relaxed) == n + 1;
+  }
+
+private:
+  static_assert(sizeof(std::atomic<uint32_t>) == 4 &&
+                    std::atomic<uint32_t>::is_always_lock_free,
+                "the layout needs plain 32-bit atomics");
+
+  [[nodiscard]] size_t RecordOffset(uint32_t n) const noexcept {
+    return kHeaderBytes + static_cast<size_t>(n & (capacity_ - 1)) *
+                              kRecordBytes;
+  }
+  [[nodiscard]] std::atomic<uint32_t> &Word(size_t offset) const noexcept {
+    return *reinterpret_cast<std::atomic<uint32_t> *>(base_ + offset);
+  }
+  void StoreU32(size_t offset, uint32_t value) noexcept {
+    std::memcpy(base_ + offset, &value, 4);
+  }
+
+  uint8_t *base_ = nullptr;
+  uint32_t capacity_ = 0;
+  uint32_t head_ = 0;
+};
+
+} // namespace DeepFrame
@@ -0,0 +1,187 @@
+#include "TensorConvert.h"
+#include "Simd.h"
+#include "ThreadPool.h"
+#include <algorithm>
+
+namespace DeepFrame {
+
+namespace {
+
+void ForRows(ThreadPool *pool, uint32_t rows, RangeFn fn) noexcept {
+  if (pool) {
+    pool->ParallelFor(rows, 16, fn);
+  } else {
+    fn(0, rows);
+  }
+}
+
+inline uint8_t ToByte(float v) noexcept {
+  return static_cast<uint8_t>(std::clamp(v * 255.f + 0.5f, 0.f, 255.f));
+}
+
+} // namespace
+
+void BgraRowToPlanarRgb(const uint8_t *bgra, uint32_t width, float *r,
+                        float *g, float *b) noexcept {
+  constexpr float kScale = 1.f / 255.f;
+  uint32_t x = 0;
+#if defined(DEEPFRAME_SSE2)
+  const __m128i mask = _mm_set1_epi32(0xFF);
+  const __m128 scale = _mm_set1_ps(kScale);
+  for (; x + 4 <= width; x += 4) {
+    const __m128i px =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(bgra + x * 4));
+    const __m128i vb = _mm_and_si128(px, mask);
+    const __m128i vg = _mm_and_si128(_mm_srli_epi32(px, 8), mask);
+    const __m128i vr = _mm_and_si128(_mm_srli_epi32(px, 16), mask);
+    _mm_storeu_ps(r + x, _mm_mul_ps(_mm_cvtepi32_ps(vr), scale));
+    _mm_storeu_ps(g + x, _mm_mul_ps(_mm_cvtepi32_ps(vg), scale));
+    _mm_storeu_ps(b + x, _mm_mul_ps(_mm_cvtepi32_ps(vb), scale));
+  }
+#endif
+  for (; x < width; x++) {
+    r[x] = bgra[x * 4 + 2] * kScale;
+    g[x] = bgra[x * 4 + 1] * kScale;
+    b[x] = bgra[x * 4 + 0] * kScale;
+  }
+}
+
+void PlanarRgbRowToBgra(const float *r, const float *g, const float *b,
+                        uint32_t width, uint8_t *bgra) noexcept {
+  uint32_t x = 0;
+#if defined(DEEPFRAME_SSE2)
+  // Same clamp-then-truncate as ToByte, four pixels at a time.
+  const __m128 scale = _mm_set1_ps(255.f);
+  const __m128 half = _mm_set1_ps(0.5f);
+  const __m128 lo = _mm_setzero_ps();
+  const __m128 hi = _mm_set1_ps(255.f);
+  const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+  auto toLane = [&](const float *p) {
+    const __m128 v = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(p), scale), half);
+    return _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(v, lo), hi));
+  };
+  for (; x + 4 <= width; x += 4) {
+    const __m128i px = _mm_or_si128(
+        _mm_or_si128(toLane(b + x), _mm_slli_epi32(toLane(g + x), 8)),
+        _mm_or_si128(_mm_slli_epi32(toLane(r + x), 16), alpha));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(bgra + x * 4), px);
+  }
+#endif
+  for (; x < width; x++) {
+    bgra[x * 4 + 0] = ToByte(b[x]);
+    bgra[x * 4 + 1] = ToByte(g[x]);
+    bgra[x * 4 + 2] = ToByte(r[x]);
+    bgra[x * 4 + 3] = 255;
+  }
+}
+
+bool BgraToPlanarRgb(const FrameView &bgra, float *planes,
+                     ThreadPool *pool) noexcept {
+  return BgraToPlanarRgbPadded(bgra, planes, bgra.width, bgra.height, pool);
+}
+
+bool BgraRectsToPlanarRgb(const FrameView &bgra, float *planes,
+                          const RectList &rects, ThreadPool *pool) noexcept {
+  return BgraRectsToPlanarRgbPadded(bgra, planes, bgra.width, bgra.height,
+                                    rects, pool);
+}
+
+bool PlanarRgbToBgra(const float *planes, const FrameView &bgra,
+                     ThreadPool *pool) noexcept {
+  return PlanarRgbToBgraCropped(planes, bgra.width, bgra.height, bgra, pool);
+}
+
+bool BgraToPlanarRgbPadded(const FrameView &bgra, float *planes,
+                           uint32_t planeWidth, uint32_t planeHeight,
+                           ThreadPool *pool) noexcept {
+  RectList all;
+  all.SetFull();
+  return BgraRectsToPlanarRgbPadded(bgra, planes, planeWidth, planeHeight, all,
+                                    pool);
+}
+
+bool BgraRectsToPlanarRgbPadded(const FrameView &bgra, float *planes,
+                                uint32_t planeWidth, uint32_t planeHeight,
+                                const RectList &rects,
+                                ThreadPool *pool) noexcept {
+  if (!bgra.IsValid() || bgra.format != PixelFormat::BGRA8 || !planes ||
+      planeWidth < bgra.width || planeHeight < bgra.height) {
+    return false;
+  }
+
+  const size_t plane = static_cast<size_t>(planeWidth) * planeHeight;
+  bool touchesEdge = rects.IsFull();
+  const auto convert = [&](const TileRect &rect) {
+    const uint32_t right = std::min(rect.right, bgra.width);
+    const uint32_t bottom = std::min(rect.bottom, bgra.height);
+    if (rect.left >= right || rect.top >= bottom)
+      return;
+    touchesEdge |= right == bgra.width || bottom == bgra.height;
+    ForRows(pool, bottom - rect.top, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        const uint32_t y = rect.top + static_cast<uint32_t>(i);
+        float *r = planes + static_cast<size_t>(y) * planeWidth + rect.left;
+        BgraRowToPlanarRgb(bgra.Row(y) + rect.left * 4, right - rect.left, r,
+                           r + plane, r + 2 * plane);
+      }
+    });
+  };
+  if (rects.IsFull()) {
+    convert({0, 0, bgra.width, bgra.height});
+  } else {
+    for (const TileRect &rect : rects)
+      convert(rect);
+  }
+  // The padding repeats the last column and row, so only changes there
+  // reach it.
+  if (touchesEdge)
+    PadPlanarRgb(planes, bgra.width, bgra.height, planeWidth, planeHeight,
+                 pool);
+  return true;
+}
+
+void PadPlanarRgb(float *planes, uint32_t width, uint32_t height,
+                  uint32_t planeWidth, uint32_t planeHeight,
+                  ThreadPool *pool) noexcept {
+  if (!planes || width == 0 || height == 0 ||
+      (width >= planeWidth && height >= planeHeight)) {
+    return;
+  }
+  const size_t plane = static_cast<size_t>(planeWidth) * planeHeight;
+  ForRows(pool, planeHeight, [&](size_t begin, size_t end) {
+    for (size_t y = begin; y < end; y++) {
+      for (size_t c = 0; c < 3; c++) {
+        // Rows below the frame read only the frame part of its last row,
+        // which no other row writes.
+        const float *last =
+            planes + c * plane + (height - 1) * size_t{planeWidth};
+        float *row = planes + c * plane + y * planeWidth;
+        const float *source = y >= height ? last : row;
+        if (y >= height)
+          std::copy_n(last, width, row);
+        std::fill(row + width, row + planeWidth, source[width - 1]);
+      }
+    }
+  });
+}
+
+bool PlanarRgbToBgraCropped(const float *planes, uint32_t planeWidth,
+                            uint32_t planeHeight, const FrameView &bgra,
+                            ThreadPool *pool) noexcept {
+  if (!bgra.IsValid() || bgra.format != PixelFormat::BGRA8 || !planes ||
+      planeWidth < bgra.width || planeHeight < bgra.height) {
+    return false;
+  }
+
+  const size_t plane = static_cast<size_t>(planeWidth) * planeHeight;
+  ForRows(pool, bgra.height, [&](size_t begin, size_t end) {
+    for (size_t y = begin; y < end; y++) {
+      const float *r = planes + y * planeWidth;
+      PlanarRgbRowToBgra(r, r + plane, r + 2 * plane, bgra.width,
+                         bgra.Row(static_cast<uint32_t>(y)));
+    }
+  });
+  return true;
+}
+
+} // namespace DeepFrame
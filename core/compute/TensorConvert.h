@@ -0,0 +1,63 @@
+#pragma once
+
+#include "FrameView.h"
+#include "RectList.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace DeepFrame {
+
+class ThreadPool;
+
+// The interpolation models take and return NCHW float RGB in [0, 1]; one
+// frame is three consecutive width*height planes in R, G, B order.
+[[nodiscard]] constexpr size_t PlanarRgbSize(uint32_t width,
+                                             uint32_t height) noexcept {
+  return 3 * static_cast<size_t>(width) * height;
+}
+
+// One row of `width` pixels; callers that walk mapped memory row by row
+// (and do other work per row) use these directly.
+void BgraRowToPlanarRgb(const uint8_t *bgra, uint32_t width, float *r,
+                        float *g, float *b) noexcept;
+void PlanarRgbRowToBgra(const float *r, const float *g, const float *b,
+                        uint32_t width, uint8_t *bgra) noexcept;
+
+// `planes` must hold PlanarRgbSize(bgra.width, bgra.height) floats.
+[[nodiscard]] bool BgraToPlanarRgb(const FrameView &bgra, float *planes,
+                                   ThreadPool *pool = nullptr) noexcept;
+
+// Converts only the pixels inside `rects` and leaves the rest of `planes`
+// as it was; a full list converts the whole frame.
+[[nodiscard]] bool BgraRectsToPlanarRgb(const FrameView &bgra, float *planes,
+                                        const RectList &rects,
+                                        ThreadPool *pool = nullptr) noexcept;
+
+// Rounds to nearest and clamps; alpha is written opaque.
+[[nodiscard]] bool PlanarRgbToBgra(const float *planes, const FrameView &bgra,
+                                   ThreadPool *pool = nullptr) noexcept;
+
+// Planes of planeWidth x planeHeight with the frame in the top-left corner
+// and the rest repeating its last column and row, for models exported at a
+// fixed size larger than the frame.
+[[nodiscard]] bool BgraToPlanarRgbPadded(const FrameView &bgra, float *planes,
+                                         uint32_t planeWidth,
+                                         uint32_t planeHeight,
+                                         ThreadPool *pool = nullptr) noexcept;
+[[nodiscard]] bool
+BgraRectsToPlanarRgbPadded(const FrameView &bgra, float *planes,
+                           uint32_t planeWidth, uint32_t planeHeight,
+                           const RectList &rects,
+                           ThreadPool *pool = nullptr) noexcept;
+// Fills the padding of planes whose top-left width x height is set.
+void PadPlanarRgb(float *planes, uint32_t width, uint32_t height,
+                  uint32_t planeWidth, uint32_t planeHeight,
+                  ThreadPool *pool = nullptr) noexcept;
+// Reads the top-left bgra.width x bgra.height of larger planes.
+[[nodiscard]] bool PlanarRgbToBgraCropped(const float *planes,
+                                          uint32_t planeWidth,
+                                          uint32_t planeHeight,
+                                          const FrameView &bgra,
+                                          ThreadPool *pool = nullptr) noexcept;
+
+} // namespace DeepFrame
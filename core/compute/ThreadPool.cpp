@@ -0,0 +1,100 @@
+#include "ThreadPool.h"
+#include "TaskScheduler.h"
+#include <algorithm>
+
+namespace DeepFrame {
+
+ThreadPool::ThreadPool(uint32_t threads) noexcept {
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+
+  try {
+    for (uint32_t i = 1; i < threads; i++)
+      workers_.emplace_back(&ThreadPool::WorkerLoop, this);
+  } catch (...) {
+  }
+}
+
+ThreadPool::~ThreadPool() noexcept {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  for (auto &worker : workers_) {
+    if (worker.joinable())
+      worker.join();
+  }
+}
+
+uint32_t ThreadPool::ThreadCount() const noexcept {
+  return scheduler_ ? scheduler_->ThreadCount()
+                    : static_cast<uint32_t>(workers_.size()) + 1;
+}
+
+void ThreadPool::ParallelFor(size_t count, size_t grain, RangeFn fn) noexcept {
+  if (scheduler_) {
+    scheduler_->ParallelFor(count, grain, fn);
+    return;
+  }
+  if (count == 0)
+    return;
+  grain = std::max<size_t>(1, grain);
+
+  if (workers_.empty() || count <= grain) {
+    fn(0, count);
+    return;
+  }
+
+  std::lock_guard<std::mutex> call(callMutex_);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    job_ = &fn;
+    count_ = count;
+    grain_ = grain;
+    next_.store(0, std::memory_order_relaxed);
+    active_.store(static_cast<uint32_t>(workers_.size()),
+                  std::memory_order_relaxed);
+    generation_++;
+  }
+  wake_.notify_all();
+
+  RunChunks();
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_.wait(lock, [this] {
+    return active_.load(std::memory_order_acquire) == 0;
+  });
+  job_ = nullptr;
+}
+
+void ThreadPool::RunChunks() noexcept {
+  for (;;) {
+    size_t begin = next_.fetch_add(grain_, std::memory_order_relaxed);
+    if (begin >= count_)
+      break;
+    (*job_)(begin, std::min(count_, begin + grain_));
+  }
+}
+
+void ThreadPool::WorkerLoop() noexcept {
+  uint64_t seen = 0;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+      if (stopping_)
+        return;
+      seen = generation_;
+    }
+
+    RunChunks();
+
+    if (active_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      done_.notify_all();
+    }
+  }
+}
+
+} // namespace DeepFrame
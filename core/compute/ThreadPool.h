@@ -0,0 +1,55 @@
+#pragma once
+
+#include "RangeFn.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace DeepFrame {
+
+class TaskScheduler;
+
+// Persistent worker pool for data-parallel kernels. ParallelFor splits
+// [0, count) into chunks that workers and the calling thread claim from a
+// shared counter, so per-call overhead is a wake-up rather than a spawn.
+// Built on a TaskScheduler, it owns no threads and the kernels run on the
+// scheduler's workers instead.
+class ThreadPool {
+public:
+  explicit ThreadPool(uint32_t threads = 0) noexcept;
+  explicit ThreadPool(TaskScheduler &scheduler) noexcept
+      : scheduler_(&scheduler) {}
+  ~ThreadPool() noexcept;
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  void ParallelFor(size_t count, size_t grain, RangeFn fn) noexcept;
+
+  [[nodiscard]] uint32_t ThreadCount() const noexcept;
+
+private:
+  void WorkerLoop() noexcept;
+  void RunChunks() noexcept;
+
+  TaskScheduler *scheduler_ = nullptr;
+  std::vector<std::thread> workers_;
+  std::mutex callMutex_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+
+  const RangeFn *job_ = nullptr;
+  size_t count_ = 0;
+  size_t grain_ = 1;
+  uint64_t generation_ = 0;
+  std::atomic<size_t> next_{0};
+  std::atomic<uint32_t> active_{0};
+  bool stopping_ = false;
+};
+
+} // namespace DeepFrame
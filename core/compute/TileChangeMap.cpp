@@ -0,0 +1,163 @@
+#include "TileChangeMap.h"
+#include "Simd.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cstring>
+
+namespace DeepFrame {
+
+bool TileChangeMap::Update(const FrameView &prev, const FrameView &curr,
+                           const TileRect *dirty, size_t dirtyCount,
+                           uint32_t threshold) noexcept {
+  if (!prev.IsValid() || !curr.IsValid() || prev.format != curr.format ||
+      prev.width != curr.width || prev.height != curr.height) {
+    return false;
+  }
+
+  try {
+    width_ = curr.width;
+    height_ = curr.height;
+    cols_ = (width_ + kTileSize - 1) / kTileSize;
+    rows_ = (height_ + kTileSize - 1) / kTileSize;
+    const size_t tiles = static_cast<size_t>(cols_) * rows_;
+
+    // 1 = candidate for comparison, 0 = known unchanged.
+    if (dirty) {
+      changed_.assign(tiles, 0);
+      for (size_t i = 0; i < dirtyCount; i++) {
+        const TileRect &r = dirty[i];
+        const uint32_t right = std::min(r.right, width_);
+        const uint32_t bottom = std::min(r.bottom, height_);
+        if (r.left >= right || r.top >= bottom)
+          continue;
+        for (uint32_t ty = r.top / kTileSize; ty <= (bottom - 1) / kTileSize;
+             ty++) {
+          for (uint32_t tx = r.left / kTileSize;
+               tx <= (right - 1) / kTileSize; tx++) {
+            changed_[static_cast<size_t>(ty) * cols_ + tx] = 1;
+          }
+        }
+      }
+    } else {
+      changed_.assign(tiles, 1);
+    }
+  } catch (...) {
+    return false;
+  }
+
+  const uint32_t bpp = BytesPerPixel(curr.format);
+
+  auto compareRows = [&](size_t begin, size_t end) {
+    for (uint32_t ty = static_cast<uint32_t>(begin); ty < end; ty++) {
+      const uint32_t y0 = ty * kTileSize;
+      const uint32_t y1 = std::min(height_, y0 + kTileSize);
+      for (uint32_t tx = 0; tx < cols_; tx++) {
+        uint8_t &flag = changed_[static_cast<size_t>(ty) * cols_ + tx];
+        if (!flag)
+          continue;
+
+        const uint32_t x0 = tx * kTileSize;
+        const uint32_t pixels = std::min(width_, x0 + kTileSize) - x0;
+        const uint64_t limit =
+            static_cast<uint64_t>(threshold) * pixels * (y1 - y0);
+        const size_t bytes = static_cast<size_t>(pixels) * bpp;
+
+        // Bail out on the first row that pushes the tile over the limit.
+        uint64_t sad = 0;
+        for (uint32_t y = y0; y < y1 && sad <= limit; y++) {
+          sad += SadBytes(prev.Row(y) + x0 * bpp, curr.Row(y) + x0 * bpp,
+                          bytes);
+        }
+        flag = sad > limit ? 1 : 0;
+      }
+    }
+  };
+
+  if (pool_) {
+    pool_->ParallelFor(rows_, 1, compareRows);
+  } else {
+    compareRows(0, rows_);
+  }
+
+  Recount();
+  return true;
+}
+
+void TileChangeMap::Dilate(uint32_t radius) noexcept {
+  if (radius == 0 || changedCount_ == 0)
+    return;
+
+  try {
+    scratch_ = changed_;
+  } catch (...) {
+    MarkAll();
+    return;
+  }
+
+  for (uint32_t ty = 0; ty < rows_; ty++) {
+    for (uint32_t tx = 0; tx < cols_; tx++) {
+      if (!scratch_[static_cast<size_t>(ty) * cols_ + tx])
+        continue;
+      const uint32_t r0 = ty > radius ? ty - radius : 0;
+      const uint32_t r1 = std::min(rows_ - 1, ty + radius);
+      const uint32_t c0 = tx > radius ? tx - radius : 0;
+      const uint32_t c1 = std::min(cols_ - 1, tx + radius);
+      for (uint32_t r = r0; r <= r1; r++)
+        std::memset(&changed_[static_cast<size_t>(r) * cols_ + c0], 1,
+                    c1 - c0 + 1);
+    }
+  }
+  Recount();
+}
+
+void TileChangeMap::MarkAll() noexcept {
+  std::fill(changed_.begin(), changed_.end(), uint8_t{1});
+  Recount();
+}
+
+void TileChangeMap::CopyUnchanged(const FrameView &src,
+                                  const FrameView &dst) const noexcept {
+  if (src.width != width_ || src.height != height_ || dst.width != width_ ||
+      dst.height != height_ || src.format != dst.format) {
+    return;
+  }
+
+  const uint32_t bpp = BytesPerPixel(src.format);
+
+  auto copyRows = [&](size_t begin, size_t end) {
+    for (uint32_t ty = static_cast<uint32_t>(begin); ty < end; ty++) {
+      const uint32_t y0 = ty * kTileSize;
+      const uint32_t y1 = std::min(height_, y0 + kTileSize);
+      // Runs of unchanged tiles along the row are copied as one span.
+      uint32_t tx = 0;
+      while (tx < cols_) {
+        if (IsChanged(tx, ty)) {
+          tx++;
+          continue;
+        }
+        const uint32_t start = tx;
+        while (tx < cols_ && !IsChanged(tx, ty))
+          tx++;
+        const uint32_t x0 = start * kTileSize;
+        const uint32_t x1 = std::min(width_, tx * kTileSize);
+        for (uint32_t y = y0; y < y1; y++) {
+          std::memcpy(dst.Row(y) + x0 * bpp, src.Row(y) + x0 * bpp,
+                      static_cast<size_t>(x1 - x0) * bpp);
+        }
+      }
+    }
+  };
+
+  if (pool_) {
+    pool_->ParallelFor(rows_, 1, copyRows);
+  } else {
+    copyRows(0, rows_);
+  }
+}
+
+void TileChangeMap::Recount() noexcept {
+  changedCount_ = static_cast<uint32_t>(
+      std::count(changed_.begin(), changed_.end(), uint8_t{1}));
+}
+
+} // namespace DeepFrame
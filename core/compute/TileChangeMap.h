@@ -0,0 +1,74 @@
+#pragma once
+
+#include "FrameView.h"
+#include "RectList.h"
+#include <cstdint>
+#include <vector>
+
+namespace DeepFrame {
+
+class ThreadPool;
+
+// Per-tile record of which parts of a frame differ from the previous one.
+// Interpolation only has to run where something changed; everywhere else
+// the current frame is already the answer.
+class TileChangeMap {
+public:
+  static constexpr uint32_t kTileSize = 64;
+
+  explicit TileChangeMap(ThreadPool *pool = nullptr) noexcept : pool_(pool) {}
+
+  // Compares both frames tile by tile. A tile counts as changed once its
+  // BGRA SAD exceeds `threshold` per pixel on average. When `dirty` rects
+  // are given (e.g. from the OS compositor) only tiles they touch are
+  // compared and the rest are taken as unchanged.
+  [[nodiscard]] bool Update(const FrameView &prev, const FrameView &curr,
+                            const TileRect *dirty = nullptr,
+                            size_t dirtyCount = 0,
+                            uint32_t threshold = 0) noexcept;
+
+  // Marks every tile within `radius` tiles of a changed one as changed, so
+  // motion that crosses a tile border is still searched from both sides.
+  void Dilate(uint32_t radius) noexcept;
+
+  void MarkAll() noexcept;
+
+  // Copies every unchanged tile of `src` into `dst`.
+  void CopyUnchanged(const FrameView &src, const FrameView &dst) const noexcept;
+
+  [[nodiscard]] bool IsChanged(uint32_t col, uint32_t row) const noexcept {
+    return changed_[static_cast<size_t>(row) * cols_ + col] != 0;
+  }
+  // Tile containing pixel (x, y).
+  [[nodiscard]] bool IsPixelChanged(uint32_t x, uint32_t y) const noexcept {
+    return IsChanged(x / kTileSize, y / kTileSize);
+  }
+
+  // True when the map was last built for frames of this size.
+  [[nodiscard]] bool Matches(uint32_t width, uint32_t height) const noexcept {
+    return width_ == width && height_ == height && !changed_.empty();
+  }
+
+  [[nodiscard]] uint32_t Cols() const noexcept { return cols_; }
+  [[nodiscard]] uint32_t Rows() const noexcept { return rows_; }
+  [[nodiscard]] uint32_t ChangedTiles() const noexcept { return changedCount_; }
+  [[nodiscard]] bool AnyChanged() const noexcept { return changedCount_ > 0; }
+  [[nodiscard]] float SkippedFraction() const noexcept {
+    const uint32_t total = cols_ * rows_;
+    return total ? 1.f - static_cast<float>(changedCount_) / total : 0.f;
+  }
+
+private:
+  void Recount() noexcept;
+
+  ThreadPool *pool_ = nullptr;
+  uint32_t width_ = 0;
+  uint32_t height_ = 0;
+  uint32_t cols_ = 0;
+  uint32_t rows_ = 0;
+  uint32_t changedCount_ = 0;
+  std::vector<uint8_t> changed_;
+  std::vector<uint8_t> scratch_;
+};
+
+} // namespace DeepFrame
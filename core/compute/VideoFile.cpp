@@ -0,0 +1,410 @@
+#include "VideoFile.h"
+#include "Log.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <string_view>
+
+namespace DeepFrame {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr std::string_view kY4mMagic = "YUV4MPEG2 ";
+constexpr std::string_view kY4mFrame = "FRAME";
+// Generous; real headers are under 100 bytes.
+constexpr size_t kMaxHeaderBytes = 1024;
+
+bool ParseUint(std::string_view text, uint32_t &out) noexcept {
+  const auto [end, ec] =
+      std::from_chars(text.data(), text.data() + text.size(), out);
+  return ec == std::errc() && end == text.data() + text.size();
+}
+
+// 4:2:0 tags differ only in chroma siting, which repetition ignores.
+bool ParseChroma(std::string_view tag, ChromaLayout &out) noexcept {
+  if (tag == "420" || tag == "420jpeg" || tag == "420paldv" ||
+      tag == "420mpeg2") {
+    out = ChromaLayout::Yuv420;
+  } else if (tag == "422") {
+    out = ChromaLayout::Yuv422;
+  } else if (tag == "444") {
+    out = ChromaLayout::Yuv444;
+  } else if (tag == "mono") {
+    out = ChromaLayout::Mono;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+FILE *OpenForWrite(const fs::path &path) noexcept {
+#ifdef _WIN32
+  return _wfopen(path.c_str(), L"wb");
+#else
+  return std::fopen(path.c_str(), "wb");
+#endif
+}
+
+} // namespace
+
+bool VideoFileSource::OpenY4m(const fs::path &path) noexcept {
+  Close();
+  if (!file_.Open(path, MapAccess::Sequential)) {
+    Log::Error("[VideoFile] Cannot map %s\n", path.string());
+    return false;
+  }
+
+  const char *data = static_cast<const char *>(file_.Data());
+  const size_t size = file_.Size();
+  const void *newline =
+      std::memchr(data, '\n', std::min(size, kMaxHeaderBytes));
+  if (!newline || size < kY4mMagic.size() ||
+      std::string_view(data, kY4mMagic.size()) != kY4mMagic) {
+    Log::Error("[VideoFile] %s is not a Y4M file\n", path.string());
+    Close();
+    return false;
+  }
+
+  VideoFileInfo info;
+  info.format = VideoFileFormat::Y4M;
+  const size_t headerEnd = static_cast<const char *>(newline) - data;
+  std::string_view header(data + kY4mMagic.size(),
+                          headerEnd - kY4mMagic.size());
+  bool ok = true;
+  while (!header.empty()) {
+    const size_t space = header.find(' ');
+    const std::string_view token = header.substr(0, space);
+    header = space == std::string_view::npos ? std::string_view()
+                                             : header.substr(space + 1);
+    if (token.empty())
+      continue;
+    const std::string_view value = token.substr(1);
+    switch (token[0]) {
+    case 'W':
+      ok &= ParseUint(value, info.width);
+      break;
+    case 'H':
+      ok &= ParseUint(value, info.height);
+      break;
+    case 'F': {
+      const size_t colon = value.find(':');
+      ok &= colon != std::string_view::npos &&
+            ParseUint(value.substr(0, colon), info.fpsNum) &&
+            ParseUint(value.substr(colon + 1), info.fpsDen);
+      break;
+    }
+    case 'C':
+      // High bit depth (420p10 and the like) is not supported.
+      ok &= ParseChroma(value, info.chroma);
+      break;
+    default:
+      // Interlacing, aspect ratio and X extensions do not matter here.
+      break;
+    }
+  }
+  if (!ok || info.width == 0 || info.height == 0 || info.fpsNum == 0 ||
+      info.fpsDen == 0) {
+    Log::Error("[VideoFile] Unsupported Y4M header in %s\n", path.string());
+    Close();
+    return false;
+  }
+  info_ = info;
+
+  // Each frame is "FRAME", optional parameters, a newline and the planes.
+  const size_t frameBytes = FrameBytes();
+  size_t pos = headerEnd + 1;
+  try {
+    while (size - pos > kY4mFrame.size() &&
+           std::string_view(data + pos, kY4mFrame.size()) == kY4mFrame) {
+      const void *end = std::memchr(data + pos, '\n',
+                                    std::min(size - pos, kMaxHeaderBytes));
+      if (!end)
+        break;
+      const size_t pixels = static_cast<const char *>(end) - data + 1;
+      if (size - pixels < frameBytes)
+        break;
+      offsets_.push_back(pixels);
+      pos = pixels + frameBytes;
+    }
+  } catch (...) {
+    Close();
+    return false;
+  }
+  if (pos != size)
+    Log::Warn("[VideoFile] Ignoring %llu trailing bytes of %s\n",
+              static_cast<unsigned long long>(size - pos), path.string());
+
+  info_.frameCount = offsets_.size();
+  if (info_.frameCount == 0) {
+    Log::Error("[VideoFile] No frames in %s\n", path.string());
+    Close();
+    return false;
+  }
+  Log::Info("[VideoFile] %s: %ux%u Y4M, %llu frames at %u:%u\n",
+            path.string(), info_.width, info_.height,
+            static_cast<unsigned long long>(info_.frameCount), info_.fpsNum,
+            info_.fpsDen);
+  return true;
+}
+
+bool VideoFileSource::OpenRaw(const fs::path &path, uint32_t width,
+                              uint32_t height, uint32_t fpsNum,
+                              uint32_t fpsDen) noexcept {
+  Close();
+  if (width == 0 || height == 0 || fpsNum == 0 || fpsDen == 0)
+    return false;
+  if (!file_.Open(path, MapAccess::Sequential)) {
+    Log::Error("[VideoFile] Cannot map %s\n", path.string());
+    return false;
+  }
+
+  info_.format = VideoFileFormat::RawBgra;
+  info_.width = width;
+  info_.height = height;
+  info_.fpsNum = fpsNum;
+  info_.fpsDen = fpsDen;
+  info_.frameCount = file_.Size() / FrameBytes();
+  if (info_.frameCount == 0) {
+    Log::Error("[VideoFile] %s is smaller than one %ux%u frame\n",
+               path.string(), width, height);
+    Close();
+    return false;
+  }
+  return true;
+}
+
+void VideoFileSource::Close() noexcept {
+  file_.Close();
+  offsets_.clear();
+  info_ = {};
+}
+
+size_t VideoFileSource::FrameBytes() const noexcept {
+  return info_.format == VideoFileFormat::RawBgra
+             ? static_cast<size_t>(info_.width) * info_.height * 4
+             : YuvFrameSize(info_.chroma, info_.width, info_.height);
+}
+
+bool VideoFileSource::Read(uint64_t index, VideoFrame &frame) const noexcept {
+  if (index >= info_.frameCount)
+    return false;
+
+  const bool raw = info_.format == VideoFileFormat::RawBgra;
+  const size_t frameBytes = FrameBytes();
+  const auto offset = [&](uint64_t i) {
+    return raw ? static_cast<size_t>(i) * frameBytes
+               : static_cast<size_t>(offsets_[i]);
+  };
+  // The mapping is read-only; FrameView just has no const flavour.
+  uint8_t *pixels = const_cast<uint8_t *>(
+      static_cast<const uint8_t *>(file_.Data()) + offset(index));
+
+  frame = {};
+  frame.index = index;
+  frame.timestampUs = static_cast<int64_t>(index * 1000000ull *
+                                           info_.fpsDen / info_.fpsNum);
+  if (raw) {
+    frame.bgra = {pixels, info_.width, info_.height, info_.width * 4,
+                  PixelFormat::BGRA8};
+  } else {
+    frame.yuv = PackedYuvView(pixels, info_.chroma, info_.width, info_.height);
+  }
+  if (index + 1 < info_.frameCount)
+    file_.Prefetch(offset(index + 1), frameBytes);
+  return true;
+}
+
+bool VideoFrameToBgra(const VideoFrame &frame, const FrameView &bgra,
+                      ThreadPool *pool) noexcept {
+  if (!frame.bgra.IsValid())
+    return YuvToBgra(frame.yuv, bgra, pool);
+  if (!bgra.IsValid() || bgra.format != PixelFormat::BGRA8 ||
+      bgra.width != frame.bgra.width || bgra.height != frame.bgra.height) {
+    return false;
+  }
+  for (uint32_t y = 0; y < bgra.height; y++)
+    std::memcpy(bgra.Row(y), frame.bgra.Row(y),
+                static_cast<size_t>(bgra.width) * 4);
+  return true;
+}
+
+VideoFileSink::~VideoFileSink() noexcept { Close(); }
+
+bool VideoFileSink::Open(const fs::path &path, VideoFileFormat format,
+                         uint32_t width, uint32_t height, uint32_t fpsNum,
+                         uint32_t fpsDen) noexcept {
+  Close();
+  if (width == 0 || height == 0 || fpsNum == 0 || fpsDen == 0)
+    return false;
+
+  format_ = format;
+  width_ = width;
+  height_ = height;
+  try {
+    for (std::vector<uint8_t> &slot : slots_)
+      slot.resize(static_cast<size_t>(width) * height * 4);
+    if (format == VideoFileFormat::Y4M)
+      yuv_.resize(YuvFrameSize(ChromaLayout::Yuv420, width, height));
+  } catch (...) {
+    Close();
+    return false;
+  }
+
+  file_ = OpenForWrite(path);
+  if (!file_) {
+    Log::Error("[VideoFile] Cannot create %s\n", path.string());
+    Close();
+    return false;
+  }
+  if (format == VideoFileFormat::Y4M &&
+      std::fprintf(file_, "YUV4MPEG2 W%u H%u F%u:%u Ip A1:1 C420jpeg\n",
+                   width, height, fpsNum, fpsDen) < 0) {
+    Close();
+    return false;
+  }
+
+  cursor_.Reset();
+  stopping_ = false;
+  failed_ = false;
+  framesWritten_ = 0;
+  bytesWritten_ = 0;
+  stalls_ = 0;
+  stallNs_ = 0;
+  try {
+    writer_ = std::thread(&VideoFileSink::WriterLoop, this);
+  } catch (...) {
+    Close();
+    return false;
+  }
+  return true;
+}
+
+bool VideoFileSink::Write(const FrameView &bgra) noexcept {
+  if (!file_ || failed_ || !bgra.IsValid() ||
+      bgra.format != PixelFormat::BGRA8 || bgra.width != width_ ||
+      bgra.height != height_) {
+    return false;
+  }
+
+  size_t idx = cursor_.BeginPush();
+  if (idx == kSlots) {
+    const auto start = std::chrono::steady_clock::now();
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait(lock, [&] {
+        idx = cursor_.BeginPush();
+        return idx != kSlots || failed_;
+      });
+    }
+    stalls_.fetch_add(1, std::memory_order_relaxed);
+    stallNs_.fetch_add(
+        static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start)
+                .count()),
+        std::memory_order_relaxed);
+    if (idx == kSlots)
+      return false;
+  }
+
+  uint8_t *packed = slots_[idx].data();
+  const size_t rowBytes = static_cast<size_t>(width_) * 4;
+  for (uint32_t y = 0; y < height_; y++)
+    std::memcpy(packed + y * rowBytes, bgra.Row(y), rowBytes);
+  cursor_.CommitPush();
+  {
+    // Taken so the writer cannot miss the wake between check and wait.
+    std::lock_guard<std::mutex> lock(mutex_);
+  }
+  wake_.notify_all();
+  return true;
+}
+
+bool VideoFileSink::Close() noexcept {
+  bool ok = !failed_;
+  if (writer_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    wake_.notify_all();
+    writer_.join();
+    ok = !failed_;
+  }
+  if (file_) {
+    ok &= std::fclose(file_) == 0;
+    file_ = nullptr;
+  }
+  for (std::vector<uint8_t> &slot : slots_)
+    std::vector<uint8_t>().swap(slot);
+  std::vector<uint8_t>().swap(yuv_);
+  return ok;
+}
+
+VideoSinkStats VideoFileSink::GetStats() const noexcept {
+  VideoSinkStats stats;
+  stats.framesWritten = framesWritten_.load(std::memory_order_relaxed);
+  stats.bytesWritten = bytesWritten_.load(std::memory_order_relaxed);
+  stats.stalls = stalls_.load(std::memory_order_relaxed);
+  stats.stallMs =
+      static_cast<double>(stallNs_.load(std::memory_order_relaxed)) / 1e6;
+  return stats;
+}
+
+void VideoFileSink::WriterLoop() noexcept {
+  for (;;) {
+    const size_t idx = cursor_.BeginPop();
+    if (idx == kSlots) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait(lock, [&] {
+        return cursor_.BeginPop() != kSlots || stopping_;
+      });
+      if (cursor_.BeginPop() == kSlots)
+        return;
+      continue;
+    }
+
+    // After a failure the queue is still drained so Write never waits on
+    // a writer that has given up.
+    if (!failed_ && !WriteSlot(slots_[idx])) {
+      Log::Error("[VideoFile] Write failed after %llu frames\n",
+                 static_cast<unsigned long long>(framesWritten_.load()));
+      failed_ = true;
+    }
+    cursor_.CommitPop();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+    }
+    wake_.notify_all();
+  }
+}
+
+bool VideoFileSink::WriteSlot(const std::vector<uint8_t> &bgra) noexcept {
+  const uint8_t *data = bgra.data();
+  size_t bytes = bgra.size();
+  if (format_ == VideoFileFormat::Y4M) {
+    const FrameView src = {const_cast<uint8_t *>(bgra.data()), width_,
+                           height_, width_ * 4, PixelFormat::BGRA8};
+    const YuvView dst =
+        PackedYuvView(yuv_.data(), ChromaLayout::Yuv420, width_, height_);
+    if (!BgraToYuv420(src, dst) ||
+        std::fwrite(kY4mFrame.data(), 1, kY4mFrame.size(), file_) !=
+            kY4mFrame.size() ||
+        std::fputc('\n', file_) == EOF) {
+      return false;
+    }
+    data = yuv_.data();
+    bytes = yuv_.size();
+    bytesWritten_.fetch_add(kY4mFrame.size() + 1, std::memory_order_relaxed);
+  }
+  if (std::fwrite(data, 1, bytes, file_) != bytes)
+    return false;
+  bytesWritten_.fetch_add(bytes, std::memory_order_relaxed);
+  framesWritten_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+} // namespace DeepFrame
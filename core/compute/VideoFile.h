@@ -0,0 +1,144 @@
+#pragma once
+
+#include "FrameView.h"
+#include "MappedFile.h"
+#include "SpscRing.h"
+#include "YuvConvert.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace DeepFrame {
+
+class ThreadPool;
+
+// Uncompressed footage for offline runs: YUV4MPEG2 (8-bit planar YCbCr) or
+// headerless BGRA frames back to back.
+enum class VideoFileFormat : uint8_t { Y4M, RawBgra };
+
+struct VideoFileInfo {
+  VideoFileFormat format = VideoFileFormat::Y4M;
+  uint32_t width = 0;
+  uint32_t height = 0;
+  uint32_t fpsNum = 60;
+  uint32_t fpsDen = 1;
+  ChromaLayout chroma = ChromaLayout::Yuv420;
+  uint64_t frameCount = 0;
+};
+
+// One frame of a VideoFileSource, pointing into its read-only mapping.
+// Raw files fill `bgra`, Y4M files `yuv`; neither may be written through.
+struct VideoFrame {
+  uint64_t index = 0;
+  int64_t timestampUs = 0;
+  FrameView bgra;
+  YuvView yuv;
+};
+
+// Memory-maps a whole file and hands out frames without copying, so a
+// run reads at page-cache speed. Frames stay valid until Close().
+class VideoFileSource {
+public:
+  VideoFileSource() noexcept = default;
+
+  VideoFileSource(const VideoFileSource &) = delete;
+  VideoFileSource &operator=(const VideoFileSource &) = delete;
+
+  // Y4M carries its own size, rate and chroma layout. A truncated last
+  // frame is ignored.
+  [[nodiscard]] bool OpenY4m(const std::filesystem::path &path) noexcept;
+  [[nodiscard]] bool OpenRaw(const std::filesystem::path &path,
+                             uint32_t width, uint32_t height,
+                             uint32_t fpsNum = 60,
+                             uint32_t fpsDen = 1) noexcept;
+  void Close() noexcept;
+
+  // Frame `index`; also starts paging in the one after it.
+  [[nodiscard]] bool Read(uint64_t index, VideoFrame &frame) const noexcept;
+
+  [[nodiscard]] const VideoFileInfo &Info() const noexcept { return info_; }
+  [[nodiscard]] uint64_t FrameCount() const noexcept {
+    return info_.frameCount;
+  }
+  [[nodiscard]] bool IsOpen() const noexcept { return file_.IsOpen(); }
+
+private:
+  [[nodiscard]] size_t FrameBytes() const noexcept;
+
+  MappedFile file_;
+  VideoFileInfo info_;
+  // Start of each frame's pixels; Y4M frame headers may vary in length.
+  std::vector<uint64_t> offsets_;
+};
+
+// BGRA copy of a source frame, converting Y4M.
+[[nodiscard]] bool VideoFrameToBgra(const VideoFrame &frame,
+                                    const FrameView &bgra,
+                                    ThreadPool *pool = nullptr) noexcept;
+
+struct VideoSinkStats {
+  uint64_t framesWritten = 0;
+  uint64_t bytesWritten = 0;
+  // Writes that waited for the writer thread to free a slot.
+  uint64_t stalls = 0;
+  double stallMs = 0.0;
+};
+
+// Writes BGRA frames to a Y4M (4:2:0) or raw file on its own thread. Write
+// copies the frame into a queue slot and returns; it only blocks while
+// every slot is waiting for the disk, so no frame is ever dropped.
+class VideoFileSink {
+public:
+  static constexpr size_t kSlots = 4;
+
+  VideoFileSink() noexcept = default;
+  ~VideoFileSink() noexcept;
+
+  VideoFileSink(const VideoFileSink &) = delete;
+  VideoFileSink &operator=(const VideoFileSink &) = delete;
+
+  [[nodiscard]] bool Open(const std::filesystem::path &path,
+                          VideoFileFormat format, uint32_t width,
+                          uint32_t height, uint32_t fpsNum = 60,
+                          uint32_t fpsDen = 1) noexcept;
+  // Fails once the writer has hit an I/O error, or for a frame of another
+  // size. One producer thread.
+  [[nodiscard]] bool Write(const FrameView &bgra) noexcept;
+  // Drains the queue and closes the file; false if anything failed.
+  bool Close() noexcept;
+
+  [[nodiscard]] VideoSinkStats GetStats() const noexcept;
+  [[nodiscard]] bool IsOpen() const noexcept { return file_ != nullptr; }
+
+private:
+  void WriterLoop() noexcept;
+  [[nodiscard]] bool WriteSlot(const std::vector<uint8_t> &bgra) noexcept;
+
+  FILE *file_ = nullptr;
+  VideoFileFormat format_ = VideoFileFormat::Y4M;
+  uint32_t width_ = 0;
+  uint32_t height_ = 0;
+
+  // Packed BGRA frames waiting for the writer.
+  std::vector<uint8_t> slots_[kSlots];
+  RingCursor<kSlots> cursor_;
+  std::vector<uint8_t> yuv_;
+
+  std::thread writer_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::atomic<bool> stopping_{false};
+  std::atomic<bool> failed_{false};
+
+  std::atomic<uint64_t> framesWritten_{0};
+  std::atomic<uint64_t> bytesWritten_{0};
+  std::atomic<uint64_t> stalls_{0};
+  std::atomic<uint64_t> stallNs_{0};
+};
+
+} // namespace DeepFrame
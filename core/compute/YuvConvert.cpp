@@ -0,0 +1,147 @@
+#include "YuvConvert.h"
+#include "ThreadPool.h"
+#include <algorithm>
+
+namespace DeepFrame {
+
+namespace {
+
+void ForRows(ThreadPool *pool, uint32_t rows, RangeFn fn) noexcept {
+  if (pool) {
+    pool->ParallelFor(rows, 16, fn);
+  } else {
+    fn(0, rows);
+  }
+}
+
+inline uint8_t Clamp8(int v) noexcept {
+  return static_cast<uint8_t>(std::clamp(v, 0, 255));
+}
+
+// 8.8 fixed-point BT.601 limited-range coefficients.
+inline void YuvToBgraPixel(int y, int u, int v, uint8_t *out) noexcept {
+  const int c = 298 * (y - 16) + 128;
+  const int d = u - 128;
+  const int e = v - 128;
+  out[0] = Clamp8((c + 516 * d) >> 8);
+  out[1] = Clamp8((c - 100 * d - 208 * e) >> 8);
+  out[2] = Clamp8((c + 409 * e) >> 8);
+  out[3] = 255;
+}
+
+inline uint8_t Luma(int r, int g, int b) noexcept {
+  return static_cast<uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+}
+
+bool PlaneFits(const FrameView &plane, uint32_t width,
+               uint32_t height) noexcept {
+  return plane.IsValid() && plane.format == PixelFormat::Gray8 &&
+         plane.width >= width && plane.height >= height;
+}
+
+} // namespace
+
+bool YuvView::IsValid() const noexcept {
+  if (!y.IsValid() || y.format != PixelFormat::Gray8)
+    return false;
+  if (layout == ChromaLayout::Mono)
+    return true;
+  const uint32_t cw = ChromaWidth(layout, y.width);
+  const uint32_t ch = ChromaHeight(layout, y.height);
+  return PlaneFits(u, cw, ch) && PlaneFits(v, cw, ch);
+}
+
+YuvView PackedYuvView(uint8_t *data, ChromaLayout layout, uint32_t width,
+                      uint32_t height) noexcept {
+  YuvView view;
+  view.layout = layout;
+  view.y = {data, width, height, width, PixelFormat::Gray8};
+  const uint32_t cw = ChromaWidth(layout, width);
+  const uint32_t ch = ChromaHeight(layout, height);
+  if (cw == 0)
+    return view;
+  uint8_t *u = data + static_cast<size_t>(width) * height;
+  view.u = {u, cw, ch, cw, PixelFormat::Gray8};
+  view.v = {u + static_cast<size_t>(cw) * ch, cw, ch, cw, PixelFormat::Gray8};
+  return view;
+}
+
+bool YuvToBgra(const YuvView &yuv, const FrameView &bgra,
+               ThreadPool *pool) noexcept {
+  if (!yuv.IsValid() || !bgra.IsValid() ||
+      bgra.format != PixelFormat::BGRA8 || bgra.width != yuv.y.width ||
+      bgra.height != yuv.y.height) {
+    return false;
+  }
+
+  const uint32_t width = bgra.width;
+  const uint32_t xShift = yuv.layout == ChromaLayout::Yuv444 ? 0 : 1;
+  const uint32_t yShift = yuv.layout == ChromaLayout::Yuv420 ? 1 : 0;
+  ForRows(pool, bgra.height, [&](size_t begin, size_t end) {
+    for (size_t row = begin; row < end; row++) {
+      const uint32_t y = static_cast<uint32_t>(row);
+      const uint8_t *luma = yuv.y.Row(y);
+      uint8_t *out = bgra.Row(y);
+      if (yuv.layout == ChromaLayout::Mono) {
+        for (uint32_t x = 0; x < width; x++)
+          YuvToBgraPixel(luma[x], 128, 128, out + x * 4);
+        continue;
+      }
+      const uint8_t *u = yuv.u.Row(y >> yShift);
+      const uint8_t *v = yuv.v.Row(y >> yShift);
+      for (uint32_t x = 0; x < width; x++)
+        YuvToBgraPixel(luma[x], u[x >> xShift], v[x >> xShift], out + x * 4);
+    }
+  });
+  return true;
+}
+
+bool BgraToYuv420(const FrameView &bgra, const YuvView &yuv,
+                  ThreadPool *pool) noexcept {
+  if (!bgra.IsValid() || bgra.format != PixelFormat::BGRA8 ||
+      yuv.layout != ChromaLayout::Yuv420 || !yuv.IsValid() ||
+      yuv.y.width != bgra.width || yuv.y.height != bgra.height) {
+    return false;
+  }
+
+  // One task per chroma row: it owns the two luma rows above it.
+  const uint32_t width = bgra.width;
+  const uint32_t height = bgra.height;
+  const uint32_t chromaWidth = ChromaWidth(ChromaLayout::Yuv420, width);
+  const uint32_t chromaHeight = ChromaHeight(ChromaLayout::Yuv420, height);
+  ForRows(pool, chromaHeight, [&](size_t begin, size_t end) {
+    for (size_t row = begin; row < end; row++) {
+      const uint32_t y0 = static_cast<uint32_t>(row) * 2;
+      const uint32_t y1 = std::min(y0 + 1, height - 1);
+      const uint8_t *src[2] = {bgra.Row(y0), bgra.Row(y1)};
+      for (uint32_t y = y0; y <= y1; y++) {
+        const uint8_t *in = bgra.Row(y);
+        uint8_t *luma = yuv.y.Row(y);
+        for (uint32_t x = 0; x < width; x++)
+          luma[x] = Luma(in[x * 4 + 2], in[x * 4 + 1], in[x * 4 + 0]);
+      }
+      uint8_t *u = yuv.u.Row(static_cast<uint32_t>(row));
+      uint8_t *v = yuv.v.Row(static_cast<uint32_t>(row));
+      for (uint32_t cx = 0; cx < chromaWidth; cx++) {
+        const uint32_t x0 = cx * 2;
+        const uint32_t x1 = std::min(x0 + 1, width - 1);
+        int r = 0, g = 0, b = 0;
+        for (const uint8_t *in : src) {
+          for (uint32_t x : {x0, x1}) {
+            b += in[x * 4 + 0];
+            g += in[x * 4 + 1];
+            r += in[x * 4 + 2];
+          }
+        }
+        r = (r + 2) >> 2;
+        g = (g + 2) >> 2;
+        b = (b + 2) >> 2;
+        u[cx] = Clamp8(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+        v[cx] = Clamp8(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+      }
+    }
+  });
+  return true;
+}
+
+} // namespace DeepFrame
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "FrameView.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace DeepFrame {
+
+class ThreadPool;
+
+// Chroma subsampling of 8-bit planar YCbCr, as named by Y4M's C tag.
+enum class ChromaLayout : uint8_t { Yuv420, Yuv422, Yuv444, Mono };
+
+[[nodiscard]] constexpr uint32_t ChromaWidth(ChromaLayout layout,
+                                             uint32_t width) noexcept {
+  return layout == ChromaLayout::Mono     ? 0
+         : layout == ChromaLayout::Yuv444 ? width
+                                          : (width + 1) / 2;
+}
+[[nodiscard]] constexpr uint32_t ChromaHeight(ChromaLayout layout,
+                                              uint32_t height) noexcept {
+  return layout == ChromaLayout::Mono     ? 0
+         : layout == ChromaLayout::Yuv420 ? (height + 1) / 2
+                                          : height;
+}
+// Bytes of one tightly packed Y, U, V frame.
+[[nodiscard]] constexpr size_t YuvFrameSize(ChromaLayout layout,
+                                            uint32_t width,
+                                            uint32_t height) noexcept {
+  return static_cast<size_t>(width) * height +
+         2 * static_cast<size_t>(ChromaWidth(layout, width)) *
+             ChromaHeight(layout, height);
+}
+
+// Non-owning view of a planar frame; each plane is Gray8. u and v are
+// unset for Mono.
+struct YuvView {
+  FrameView y;
+  FrameView u;
+  FrameView v;
+  ChromaLayout layout = ChromaLayout::Yuv420;
+
+  [[nodiscard]] bool IsValid() const noexcept;
+};
+
+// Views of a tightly packed frame of YuvFrameSize bytes at `data`.
+[[nodiscard]] YuvView PackedYuvView(uint8_t *data, ChromaLayout layout,
+                                    uint32_t width, uint32_t height) noexcept;
+
+// BT.601 limited range, what recorded gameplay and Y4M tools use. Alpha
+// is written opaque; chroma is upsampled by repetition.
+[[nodiscard]] bool YuvToBgra(const YuvView &yuv, const FrameView &bgra,
+                             ThreadPool *pool = nullptr) noexcept;
+// Chroma of each 2x2 block is taken from its average colour.
+[[nodiscard]] bool BgraToYuv420(const FrameView &bgra, const YuvView &yuv,
+                                ThreadPool *pool = nullptr) noexcept;
+
+} // namespace DeepFrame
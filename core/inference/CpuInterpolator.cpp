@@ -0,0 +1,302 @@
+#include "CpuInterpolator.h"
+#include "../compute/Log.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace DeepFrame {
+
+CpuInterpolator::~CpuInterpolator() noexcept { Shutdown(); }
+
+bool CpuInterpolator::Initialize(ID3D11Device *device, uint32_t width,
+                                 uint32_t height, uint32_t threads,
+                                 TaskScheduler *scheduler) noexcept {
+  if (initialized_)
+    return true;
+  if (!device || width == 0 || height == 0)
+    return false;
+
+  device_ = device;
+  device_->GetImmediateContext(&context_);
+  width_ = width;
+  height_ = height;
+
+  if (!CreateStaging(D3D11_CPU_ACCESS_READ, staging_[0]) ||
+      !CreateStaging(D3D11_CPU_ACCESS_READ, staging_[1]) ||
+      !CreateStaging(D3D11_CPU_ACCESS_WRITE, stagingOut_)) {
+    Log::Error("[CpuInterpolator] Failed to create staging textures\n");
+    Shutdown();
+    return false;
+  }
+
+  // Capture, inference and present already own a core each.
+  if (threads == 0)
+    threads = std::clamp(std::thread::hardware_concurrency() / 2, 1u, 8u);
+
+  try {
+    pool_ = scheduler ? std::make_unique<ThreadPool>(*scheduler)
+                      : std::make_unique<ThreadPool>(threads);
+    blockMatch_ = std::make_unique<BlockMatchInterpolator>(pool_.get());
+    flow_ = std::make_unique<FlowInterpolator>(pool_.get());
+    changes_ = std::make_unique<TileChangeMap>(pool_.get());
+  } catch (...) {
+    Shutdown();
+    return false;
+  }
+
+  initialized_ = true;
+  Log::Info("[CpuInterpolator] Initialized %ux%u with %u threads\n", width_,
+            height_, pool_->ThreadCount());
+  return true;
+}
+
+void CpuInterpolator::Shutdown() noexcept {
+  changes_.reset();
+  flow_.reset();
+  blockMatch_.reset();
+  pool_.reset();
+  staging_[0].Reset();
+  staging_[1].Reset();
+  stagingOut_.Reset();
+  stagingCharge_.Set(0);
+  tracker_.Reset();
+  context_.Reset();
+  device_.Reset();
+  initialized_ = false;
+}
+
+void CpuInterpolator::SetParams(const MotionParams &params) noexcept {
+  std::lock_guard<std::mutex> lock(paramsMutex_);
+  params_ = params;
+}
+
+void CpuInterpolator::SetMode(InterpolationMode mode) noexcept {
+  std::lock_guard<std::mutex> lock(paramsMutex_);
+  mode_ = mode;
+}
+
+bool CpuInterpolator::CreateStaging(UINT cpuAccess,
+                                    ComPtr<ID3D11Texture2D> &out) noexcept {
+  D3D11_TEXTURE2D_DESC desc = {};
+  desc.Width = width_;
+  desc.Height = height_;
+  desc.MipLevels = 1;
+  desc.ArraySize = 1;
+  desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+  desc.SampleDesc.Count = 1;
+  desc.Usage = D3D11_USAGE_STAGING;
+  desc.CPUAccessFlags = cpuAccess;
+  return SUCCEEDED(device_->CreateTexture2D(&desc, nullptr, &out));
+}
+
+bool CpuInterpolator::Resize(uint32_t width, uint32_t height) noexcept {
+  width_ = width;
+  height_ = height;
+  staging_[0].Reset();
+  staging_[1].Reset();
+  stagingOut_.Reset();
+  tracker_.Reset();
+  blockMatch_->ResetHistory();
+  if (!CreateStaging(D3D11_CPU_ACCESS_READ, staging_[0]) ||
+      !CreateStaging(D3D11_CPU_ACCESS_READ, staging_[1]) ||
+      !CreateStaging(D3D11_CPU_ACCESS_WRITE, stagingOut_)) {
+    Log::Error("[CpuInterpolator] Failed to create %ux%u staging textures\n",
+               width, height);
+    // Retried with the next frame.
+    stagingCharge_.Set(0);
+    width_ = 0;
+    height_ = 0;
+    return false;
+  }
+  stagingCharge_.Set(3 * static_cast<size_t>(width) * height * 4);
+  return true;
+}
+
+bool CpuInterpolator::Map(ID3D11Texture2D *staging, D3D11_MAP mapType,
+                          FrameView &view) noexcept {
+  D3D11_MAPPED_SUBRESOURCE mapped;
+  if (FAILED(context_->Map(staging, 0, mapType, 0, &mapped)))
+    return false;
+
+  view.data = static_cast<uint8_t *>(mapped.pData);
+  view.width = width_;
+  view.height = height_;
+  view.pitch = mapped.RowPitch;
+  view.format = PixelFormat::BGRA8;
+  return true;
+}
+
+bool CpuInterpolator::Interpolate(ID3D11Texture2D *frameA,
+                                  ID3D11Texture2D *frameB,
+                                  ID3D11Texture2D *output, float t,
+                                  const FramePair *pair) noexcept {
+  InterpolationMode mode;
+  {
+    std::lock_guard<std::mutex> lock(paramsMutex_);
+    mode = mode_;
+  }
+  return Run(frameA, frameB, output, t, mode, pair);
+}
+
+bool CpuInterpolator::Blend(ID3D11Texture2D *frameA, ID3D11Texture2D *frameB,
+                            ID3D11Texture2D *output, float t,
+                            const FramePair *pair) noexcept {
+  return Run(frameA, frameB, output, t, InterpolationMode::BLEND, pair);
+}
+
+bool CpuInterpolator::Extrapolate(ID3D11Texture2D *frameA,
+                                  ID3D11Texture2D *frameB,
+                                  ID3D11Texture2D *output, float s,
+                                  const FramePair *pair) noexcept {
+  return Run(frameA, frameB, output, s, InterpolationMode::EXTRAPOLATE, pair);
+}
+
+bool CpuInterpolator::Run(ID3D11Texture2D *frameA, ID3D11Texture2D *frameB,
+                          ID3D11Texture2D *output, float t,
+                          InterpolationMode mode,
+                          const FramePair *pair) noexcept {
+  lastDuplicate_ = false;
+  lastSceneCut_ = false;
+  if (!initialized_ || !frameA || !frameB || !output)
+    return false;
+
+  D3D11_TEXTURE2D_DESC desc;
+  frameB->GetDesc(&desc);
+  if (desc.Format != DXGI_FORMAT_B8G8R8A8_UNORM)
+    return false;
+  // Frames follow the target window's size.
+  if ((desc.Width != width_ || desc.Height != height_) &&
+      !Resize(desc.Width, desc.Height)) {
+    return false;
+  }
+
+  auto startTime = std::chrono::high_resolution_clock::now();
+
+  // The staging copy of the last pair's current frame is this pair's
+  // previous frame; the other copy is brought forward by the rects that
+  // changed since it was read.
+  const FramePairPlan plan =
+      pair ? tracker_.Next(pair->prevIndex, pair->currIndex, pair->changes,
+                           width_, height_)
+           : tracker_.Next(0, 0, nullptr, width_, height_);
+  ID3D11Texture2D *prevStaging = staging_[plan.prevSlot].Get();
+  ID3D11Texture2D *currStaging = staging_[plan.currSlot].Get();
+  if (plan.prevFull)
+    context_->CopyResource(prevStaging, frameA);
+  if (plan.currRefresh.IsFull()) {
+    context_->CopyResource(currStaging, frameB);
+  } else {
+    for (const TileRect &rect : plan.currRefresh) {
+      const D3D11_BOX box = {rect.left, rect.top, 0, rect.right, rect.bottom,
+                             1};
+      context_->CopySubresourceRegion(currStaging, 0, rect.left, rect.top, 0,
+                                      frameB, 0, &box);
+    }
+  }
+
+  // A failed map leaves the thumbnails behind the staging copies; the
+  // next pair starts over.
+  FrameView prev, curr, out;
+  if (!Map(prevStaging, D3D11_MAP_READ, prev)) {
+    tracker_.Reset();
+    return false;
+  }
+  if (!Map(currStaging, D3D11_MAP_READ, curr)) {
+    context_->Unmap(prevStaging, 0);
+    tracker_.Reset();
+    return false;
+  }
+
+  // Across a cut there is nothing to interpolate; repeat the new frame.
+  // Thumbnails of an unchanged staging copy are still current.
+  SceneThumbnail &thumbPrev = thumbs_[plan.prevSlot];
+  SceneThumbnail &thumbCurr = thumbs_[plan.currSlot];
+  if (plan.prevFull)
+    SceneCutDetector::Thumbnail(prev, thumbPrev);
+  if (!plan.currRefresh.IsEmpty() || !thumbCurr.valid)
+    SceneCutDetector::Thumbnail(curr, thumbCurr);
+
+  // A frame presented again without changing anything; the compositor's
+  // rects narrow the comparison, otherwise the fingerprints decide.
+  if (duplicates_.IsDuplicate(prev, curr, pair ? pair->changes : nullptr)) {
+    context_->Unmap(currStaging, 0);
+    context_->Unmap(prevStaging, 0);
+    context_->CopyResource(output, frameB);
+    lastDuplicate_ = true;
+    stats_.duplicateFrames = duplicates_.Stats().duplicates;
+    stats_.totalFrames++;
+    return true;
+  }
+
+  if (sceneCuts_.IsCut(thumbPrev, thumbCurr)) {
+    context_->Unmap(currStaging, 0);
+    context_->Unmap(prevStaging, 0);
+    context_->CopyResource(output, frameB);
+    blockMatch_->ResetHistory();
+    lastSceneCut_ = true;
+    stats_.sceneCuts = sceneCuts_.Cuts();
+    stats_.totalFrames++;
+    return true;
+  }
+
+  if (!Map(stagingOut_.Get(), D3D11_MAP_WRITE, out)) {
+    context_->Unmap(currStaging, 0);
+    context_->Unmap(prevStaging, 0);
+    return false;
+  }
+
+  float temporalBlend;
+  {
+    std::lock_guard<std::mutex> lock(paramsMutex_);
+    blockMatch_->SetParams(params_);
+    flow_->SetParams(params_);
+    temporalBlend = params_.temporalBlend;
+  }
+
+  bool ok;
+  if (mode == InterpolationMode::BLEND) {
+    // Streams at memory bandwidth; a change map would cost as much.
+    ok = BlendFrames(prev, curr, out, t, temporalBlend, pool_.get());
+    stats_.skippedTileFraction = 0.f;
+  } else {
+    // Desktop content is mostly static; only tiles that changed (plus a
+    // border for motion crossing into them) go through the engine. The
+    // compositor's rects, when known, limit the comparison to tiles they
+    // touch.
+    const RectList *dirty =
+        pair && pair->changes && !pair->changes->IsFull() ? pair->changes
+                                                          : nullptr;
+    const TileChangeMap *changes = nullptr;
+    if (dirty ? changes_->Update(prev, curr, dirty->begin(), dirty->Count())
+              : changes_->Update(prev, curr)) {
+      changes_->Dilate(1);
+      changes = changes_.get();
+    }
+    if (mode == InterpolationMode::EXTRAPOLATE)
+      ok = flow_->Extrapolate(prev, curr, out, t, changes);
+    else if (mode == InterpolationMode::OPTICAL_FLOW)
+      ok = flow_->Interpolate(prev, curr, out, t, changes);
+    else
+      ok = blockMatch_->Interpolate(prev, curr, out, t, changes);
+    stats_.skippedTileFraction = changes ? changes->SkippedFraction() : 0.f;
+  }
+
+  context_->Unmap(stagingOut_.Get(), 0);
+  context_->Unmap(currStaging, 0);
+  context_->Unmap(prevStaging, 0);
+
+  if (!ok) {
+    stats_.droppedFrames++;
+    return false;
+  }
+
+  context_->CopyResource(output, stagingOut_.Get());
+
+  auto endTime = std::chrono::high_resolution_clock::now();
+  stats_.lastInferenceMs =
+      std::chrono::duration<float, std::milli>(endTime - startTime).count();
+  stats_.totalFrames++;
+  return true;
+}
+
+} // namespace DeepFrame
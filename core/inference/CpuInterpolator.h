@@ -0,0 +1,128 @@
+#pragma once
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+
+#include "../compute/Blend.h"
+#include "../compute/BlockMatchInterpolator.h"
+#include "../compute/FlowInterpolator.h"
+#include "../compute/FrameFingerprint.h"
+#include "../compute/RectList.h"
+#include "../compute/SceneCutDetector.h"
+#include "../compute/ThreadPool.h"
+#include "../compute/TileChangeMap.h"
+#include "OnnxInference.h"
+#include <d3d11.h>
+#include <memory>
+#include <mutex>
+#include <wrl/client.h>
+
+namespace DeepFrame {
+
+using Microsoft::WRL::ComPtr;
+
+// D3D11 front end for the CPU interpolation engines: reads both source
+// frames back through staging textures, runs the engine on the mapped
+// memory and uploads the result. Used whenever no ONNX model is loaded.
+// Given the FramePair, the staging copies of consecutive pairs are kept
+// and only the changed rects are read back.
+class CpuInterpolator {
+public:
+  CpuInterpolator() noexcept = default;
+  ~CpuInterpolator() noexcept;
+
+  CpuInterpolator(const CpuInterpolator &) = delete;
+  CpuInterpolator &operator=(const CpuInterpolator &) = delete;
+
+  // Kernels run on `scheduler`'s workers when given, else on a pool of
+  // `threads` of its own.
+  [[nodiscard]] bool Initialize(ID3D11Device *device, uint32_t width,
+                                uint32_t height, uint32_t threads = 0,
+                                TaskScheduler *scheduler = nullptr) noexcept;
+  void Shutdown() noexcept;
+
+  // In EXTRAPOLATE mode the output is `t` of an interval past frameB.
+  [[nodiscard]] bool Interpolate(ID3D11Texture2D *frameA,
+                                 ID3D11Texture2D *frameB,
+                                 ID3D11Texture2D *output, float t = 0.5f,
+                                 const FramePair *pair = nullptr) noexcept;
+  // Cross-fade regardless of mode; the fill-in when a model misses its
+  // deadline.
+  [[nodiscard]] bool Blend(ID3D11Texture2D *frameA, ID3D11Texture2D *frameB,
+                           ID3D11Texture2D *output, float t = 0.5f,
+                           const FramePair *pair = nullptr) noexcept;
+
+  // Flow extrapolation regardless of mode: the output is `s` of an
+  // interval past frameB.
+  [[nodiscard]] bool Extrapolate(ID3D11Texture2D *frameA,
+                                 ID3D11Texture2D *frameB,
+                                 ID3D11Texture2D *output, float s = 0.5f,
+                                 const FramePair *pair = nullptr) noexcept;
+
+  void SetParams(const MotionParams &params) noexcept;
+  // OPTICAL_FLOW selects the dense flow engine, BLEND the cross-fade,
+  // EXTRAPOLATE flow extrapolation and anything else block matching.
+  void SetMode(InterpolationMode mode) noexcept;
+
+  [[nodiscard]] const InferenceStats &GetStats() const noexcept {
+    return stats_;
+  }
+  // The last pair had the same pixels in both frames; the output is a copy
+  // of the second and need not be presented again.
+  [[nodiscard]] bool LastWasDuplicate() const noexcept {
+    return lastDuplicate_;
+  }
+  // The last pair was a scene cut; the output is a copy of the second
+  // frame, not an interpolated one.
+  [[nodiscard]] bool LastWasSceneCut() const noexcept { return lastSceneCut_; }
+  [[nodiscard]] bool IsInitialized() const noexcept { return initialized_; }
+
+private:
+  [[nodiscard]] bool Run(ID3D11Texture2D *frameA, ID3D11Texture2D *frameB,
+                         ID3D11Texture2D *output, float t,
+                         InterpolationMode mode,
+                         const FramePair *pair) noexcept;
+  [[nodiscard]] bool Resize(uint32_t width, uint32_t height) noexcept;
+  [[nodiscard]] bool CreateStaging(UINT cpuAccess,
+                                   ComPtr<ID3D11Texture2D> &out) noexcept;
+  [[nodiscard]] bool Map(ID3D11Texture2D *staging, D3D11_MAP mapType,
+                         FrameView &view) noexcept;
+
+  ComPtr<ID3D11Device> device_;
+  ComPtr<ID3D11DeviceContext> context_;
+
+  // Read-back copies of the source frames; tracker_ decides which one
+  // holds the previous frame.
+  ComPtr<ID3D11Texture2D> staging_[2];
+  ComPtr<ID3D11Texture2D> stagingOut_;
+  MemoryCharge stagingCharge_{MemorySubsystem::Interpolation,
+                              MemoryDomain::Gpu};
+  FramePairTracker tracker_;
+
+  std::unique_ptr<ThreadPool> pool_;
+  std::unique_ptr<BlockMatchInterpolator> blockMatch_;
+  std::unique_ptr<FlowInterpolator> flow_;
+  std::unique_ptr<TileChangeMap> changes_;
+
+  SceneCutDetector sceneCuts_;
+  SceneThumbnail thumbs_[2];
+  DuplicateDetector duplicates_;
+  bool lastDuplicate_ = false;
+  bool lastSceneCut_ = false;
+
+  std::mutex paramsMutex_;
+  MotionParams params_;
+  InterpolationMode mode_ = InterpolationMode::FAST;
+
+  InferenceStats stats_;
+
+  uint32_t width_ = 0;
+  uint32_t height_ = 0;
+  bool initialized_ = false;
+};
+
+} // namespace DeepFrame
@@ -0,0 +1,168 @@
+#include "ModelCache.h"
+#include <cstdio>
+#include <cstring>
+#include <system_error>
+
+namespace DeepFrame {
+
+namespace fs = std::filesystem;
+
+std::string ModelCacheKey::FileStem() const {
+  uint64_t h = ModelCache::HashBytes(providers.data(), providers.size(),
+                                     modelHash);
+  h = ModelCache::HashBytes(options.data(), options.size(), h);
+
+  char stem[40];
+  snprintf(stem, sizeof(stem), "%016llx-%016llx",
+           static_cast<unsigned long long>(modelHash),
+           static_cast<unsigned long long>(h));
+  return stem;
+}
+
+void ModelCache::SetDirectory(const fs::path &dir) noexcept {
+  dir_ = dir;
+  std::error_code ec;
+  fs::create_directories(dir_, ec);
+}
+
+uint64_t ModelCache::HashBytes(const void *data, size_t size,
+                               uint64_t seed) noexcept {
+  // Four independent multiply-xorshift lanes over 8-byte words keep the
+  // hash near memory bandwidth on multi-hundred-MB models.
+  constexpr uint64_t kMul = 0x9E3779B97F4A7C15ull;
+  const uint8_t *p = static_cast<const uint8_t *>(data);
+  uint64_t lanes[4] = {
+      seed ^ 0x243F6A8885A308D3ull, seed ^ 0x13198A2E03707344ull,
+      seed ^ 0xA4093822299F31D0ull, seed ^ 0x082EFA98EC4E6C89ull};
+
+  size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    for (int l = 0; l < 4; l++) {
+      uint64_t w;
+      memcpy(&w, p + i + l * 8, 8);
+      lanes[l] = (lanes[l] ^ w) * kMul;
+      lanes[l] ^= lanes[l] >> 31;
+    }
+  }
+
+  uint64_t h = static_cast<uint64_t>(size) * kMul;
+  for (int l = 0; l < 4; l++) {
+    h = (h ^ lanes[l]) * kMul;
+    h ^= h >> 29;
+  }
+  for (; i < size; i++) {
+    h = (h ^ p[i]) * 0x100000001B3ull;
+  }
+  h ^= h >> 33;
+  h *= 0xFF51AFD7ED558CCDull;
+  h ^= h >> 33;
+  h *= 0xC4CEB9FE1A85EC53ull;
+  h ^= h >> 33;
+  return h;
+}
+
+fs::path ModelCache::EntryPath(const ModelCacheKey &key,
+                               CachedModelFormat format) const {
+  return dir_ / (key.FileStem() +
+                 (format == CachedModelFormat::Ort ? ".ort" : ".onnx"));
+}
+
+fs::path ModelCache::SidecarPath(const ModelCacheKey &key,
+                                 const char *ext) const {
+  return dir_ / (key.FileStem() + ext);
+}
+
+CachedModelFormat ModelCache::Lookup(const ModelCacheKey &key,
+                                     MappedFile &out) const noexcept {
+  if (dir_.empty())
+    return CachedModelFormat::None;
+
+  try {
+    for (CachedModelFormat format :
+         {CachedModelFormat::Ort, CachedModelFormat::Onnx}) {
+      if (out.Open(EntryPath(key, format)))
+        return format;
+    }
+  } catch (...) {
+  }
+  return CachedModelFormat::None;
+}
+
+fs::path ModelCache::StagingPath(const ModelCacheKey &key,
+                                 CachedModelFormat format) const {
+  fs::path path = EntryPath(key, format);
+  path += ".tmp";
+  return path;
+}
+
+bool ModelCache::Publish(const ModelCacheKey &key,
+                         CachedModelFormat format) const noexcept {
+  try {
+    std::error_code ec;
+    fs::path staging = StagingPath(key, format);
+    if (!fs::exists(staging, ec) || fs::file_size(staging, ec) == 0)
+      return false;
+    fs::rename(staging, EntryPath(key, format), ec);
+    return !ec;
+  } catch (...) {
+    return false;
+  }
+}
+
+void ModelCache::Evict(const ModelCacheKey &key) const noexcept {
+  try {
+    std::error_code ec;
+    for (CachedModelFormat format :
+         {CachedModelFormat::Ort, CachedModelFormat::Onnx}) {
+      fs::remove(EntryPath(key, format), ec);
+      fs::remove(StagingPath(key, format), ec);
+    }
+  } catch (...) {
+  }
+}
+
+void ModelCache::MarkUncacheable(const ModelCacheKey &key) const noexcept {
+  try {
+    FILE *f = fopen(SidecarPath(key, ".nocache").string().c_str(), "wb");
+    if (f)
+      fclose(f);
+  } catch (...) {
+  }
+}
+
+bool ModelCache::IsUncacheable(const ModelCacheKey &key) const noexcept {
+  try {
+    std::error_code ec;
+    return fs::exists(SidecarPath(key, ".nocache"), ec);
+  } catch (...) {
+    return false;
+  }
+}
+
+void ModelCache::StoreColdCreateMs(const ModelCacheKey &key,
+                                   float ms) const noexcept {
+  try {
+    FILE *f = fopen(SidecarPath(key, ".meta").string().c_str(), "wb");
+    if (f) {
+      fprintf(f, "%.3f\n", ms);
+      fclose(f);
+    }
+  } catch (...) {
+  }
+}
+
+float ModelCache::LoadColdCreateMs(const ModelCacheKey &key) const noexcept {
+  float ms = 0.f;
+  try {
+    FILE *f = fopen(SidecarPath(key, ".meta").string().c_str(), "rb");
+    if (f) {
+      if (fscanf(f, "%f", &ms) != 1)
+        ms = 0.f;
+      fclose(f);
+    }
+  } catch (...) {
+  }
+  return ms;
+}
+
+} // namespace DeepFrame
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "../compute/MappedFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace DeepFrame {
+
+enum class CachedModelFormat : uint8_t { None, Ort, Onnx };
+
+struct ModelCacheKey {
+  uint64_t modelHash = 0;
+  std::string providers;
+  std::string options;
+
+  [[nodiscard]] std::string FileStem() const;
+};
+
+// On-disk store of ORT-optimized models. Entries are published atomically
+// (write to a staging file, then rename) so a crash mid-optimization never
+// leaves a truncated model behind.
+class ModelCache {
+public:
+  ModelCache() noexcept = default;
+
+  void SetDirectory(const std::filesystem::path &dir) noexcept;
+  [[nodiscard]] const std::filesystem::path &GetDirectory() const noexcept {
+    return dir_;
+  }
+
+  [[nodiscard]] static uint64_t HashBytes(const void *data, size_t size,
+                                          uint64_t seed = 0) noexcept;
+
+  [[nodiscard]] CachedModelFormat Lookup(const ModelCacheKey &key,
+                                         MappedFile &out) const noexcept;
+
+  [[nodiscard]] std::filesystem::path
+  StagingPath(const ModelCacheKey &key, CachedModelFormat format) const;
+  [[nodiscard]] bool Publish(const ModelCacheKey &key,
+                             CachedModelFormat format) const noexcept;
+  void Evict(const ModelCacheKey &key) const noexcept;
+
+  // Marks a key whose optimized graph cannot be serialized (e.g. it holds
+  // EP-compiled nodes) so later starts skip the failing save attempt.
+  void MarkUncacheable(const ModelCacheKey &key) const noexcept;
+  [[nodiscard]] bool IsUncacheable(const ModelCacheKey &key) const noexcept;
+
+  void StoreColdCreateMs(const ModelCacheKey &key, float ms) const noexcept;
+  [[nodiscard]] float LoadColdCreateMs(const ModelCacheKey &key) const noexcept;
+
+private:
+  [[nodiscard]] std::filesystem::path
+  EntryPath(const ModelCacheKey &key, CachedModelFormat format) const;
+  [[nodiscard]] std::filesystem::path
+  SidecarPath(const ModelCacheKey &key, const char *ext) const;
+
+  std::filesystem::path dir_;
+};
+
+} // namespace DeepFrame
@@ -7,35 +7,36 @@
 #define WIN32_LEAN_AND_MEAN
 #endif
 
+#include "../compute/InterpolationMode.h"
+#include "../compute/MemoryLedger.h"
+#include "../compute/SceneCutDetector.h"
+#include "OnnxSession.h"
 #include <d3d11.h>
-#include <memory>
+#include <filesystem>
 #include <string>
-#include <vector>
 #include <wrl/client.h>
 
-
-#if __has_include(<onnxruntime_cxx_api.h>)
-#define HAS_ONNX 1
-#include <onnxruntime_cxx_api.h>
-#endif
-
 namespace DeepFrame {
 
 using Microsoft::WRL::ComPtr;
 
-enum class InterpolationMode {
-  FAST,     
-  BALANCED, 
-  QUALITY   
-};
-
 struct InferenceStats {
   float lastInferenceMs = 0.f;
   uint64_t totalFrames = 0;
   uint64_t droppedFrames = 0;
   size_t vramUsageMB = 0;
+  float sessionCreateMs = 0.f;
+  float coldSessionCreateMs = 0.f;
+  bool modelCacheHit = false;
+  float skippedTileFraction = 0.f;
+  uint64_t sceneCuts = 0;
+  uint64_t duplicateFrames = 0;
 };
 
+// D3D11 front end for OnnxSession: reads both frames back through
+// staging textures, runs the model on the mapped memory and uploads the
+// result. Given the FramePair, each staging texture and session input
+// keeps its frame across pairs and only changed rects are refreshed.
 class OnnxInference {
 public:
   OnnxInference() noexcept = default;
@@ -56,47 +57,52 @@ public:
   
   [[nodiscard]] bool Interpolate(ID3D11Texture2D *frameA,
                                  ID3D11Texture2D *frameB,
-                                 ID3D11Texture2D *output,
-                                 float t = 0.5f) noexcept;
-
-  [[nodiscard]] float GetTimeBudgetMs() const noexcept;
+                                 ID3D11Texture2D *output, float t = 0.5f,
+                                 const FramePair *pair = nullptr) noexcept;
+
+  // How long the pipeline waits for a model frame before showing its
+  // stand-in. A slower frame is still returned; the caller decides whether
+  // it is too late.
+  [[nodiscard]] float GetTimeBudgetMs() const noexcept {
+    return TimeBudgetMs(mode_);
+  }
   [[nodiscard]] const InferenceStats &GetStats() const noexcept {
     return stats_;
   }
+  // The last pair was a scene cut; the output is a copy of the second
+  // frame, not a model frame.
+  [[nodiscard]] bool LastWasSceneCut() const noexcept { return lastSceneCut_; }
   [[nodiscard]] bool IsInitialized() const noexcept { return initialized_; }
   [[nodiscard]] InterpolationMode GetMode() const noexcept { return mode_; }
 
   [[nodiscard]] bool SetMode(InterpolationMode mode,
                              const std::wstring &modelPath) noexcept;
 
+  
+  void SetCacheDirectory(const std::wstring &dir) noexcept;
+
 private:
-  [[nodiscard]] bool TextureToTensor(ID3D11Texture2D *texture,
-                                     std::vector<float> &tensorData) noexcept;
-  [[nodiscard]] bool TensorToTexture(const std::vector<float> &tensorData,
-                                     ID3D11Texture2D *texture) noexcept;
+  // Brings staging texture and session input `slot` up to date with
+  // `texture` within `refresh`, and the slot's thumbnail with them.
+  [[nodiscard]] bool Upload(ID3D11Texture2D *texture, size_t slot,
+                            const RectList &refresh) noexcept;
+  [[nodiscard]] bool Download(ID3D11Texture2D *texture) noexcept;
+  // (Re)creates the staging textures for frames of this size.
+  [[nodiscard]] bool EnsureStaging(uint32_t width, uint32_t height) noexcept;
 
   ID3D11Device *device_ = nullptr;
   ID3D11DeviceContext *context_ = nullptr;
 
-#ifdef HAS_ONNX
-  std::unique_ptr<Ort::Env> env_;
-  std::unique_ptr<Ort::Session> session_;
-  Ort::AllocatorWithDefaultOptions allocator_;
-#endif
-
-  
-  ComPtr<ID3D11Texture2D> gpuInputA_;
-  ComPtr<ID3D11Texture2D> gpuInputB_;
-  ComPtr<ID3D11Texture2D> gpuOutput_;
+  OnnxSession session_;
+  std::filesystem::path cacheDirectory_;
 
-  
-  ComPtr<ID3D11Texture2D> stagingTextureA_;
-  ComPtr<ID3D11Texture2D> stagingTextureB_;
+  ComPtr<ID3D11Texture2D> stagingInput_[OnnxSession::kInputs];
   ComPtr<ID3D11Texture2D> stagingOutput_;
+  MemoryCharge stagingCharge_{MemorySubsystem::Tensors, MemoryDomain::Gpu};
+  FramePairTracker tracker_;
 
-  std::vector<float> inputTensorA_;
-  std::vector<float> inputTensorB_;
-  std::vector<float> outputTensor_;
+  SceneCutDetector sceneCuts_;
+  SceneThumbnail thumbs_[OnnxSession::kInputs];
 
   InterpolationMode mode_ = InterpolationMode::FAST;
   InferenceStats stats_;
@@ -104,6 +110,7 @@ private:
   uint32_t width_ = 0;
   uint32_t height_ = 0;
   bool initialized_ = false;
+  bool lastSceneCut_ = false;
 };
 
 } 
\ No newline at end of file
@@ -0,0 +1,387 @@
+#include "OnnxSession.h"
+#include "../compute/Log.h"
+#include "../compute/TensorConvert.h"
+#include <chrono>
+
+namespace DeepFrame {
+
+OnnxSession::~OnnxSession() noexcept { Destroy(); }
+
+bool OnnxSession::SetInput(size_t index, const FrameView &bgra,
+                           SceneThumbnail *thumbnail,
+                           ThreadPool *pool) noexcept {
+  if (index >= kInputs || !bgra.IsValid() ||
+      bgra.format != PixelFormat::BGRA8 ||
+      (modelWidth_ && bgra.width > modelWidth_) ||
+      (modelHeight_ && bgra.height > modelHeight_)) {
+    return false;
+  }
+
+  // A model exported at a fixed size takes smaller frames padded out.
+  const uint32_t planeWidth = modelWidth_ ? modelWidth_ : bgra.width;
+  const uint32_t planeHeight = modelHeight_ ? modelHeight_ : bgra.height;
+  if (!EnsureTensors(PlanarRgbSize(planeWidth, planeHeight)))
+    return false;
+  float *tensor = inputs_[index];
+  frameSizes_[index] = {bgra.width, bgra.height};
+
+  if (thumbnail && thumbnailBuilder_.Begin(bgra.width, bgra.height)) {
+    const size_t plane = static_cast<size_t>(planeWidth) * planeHeight;
+    for (uint32_t y = 0; y < bgra.height; y++) {
+      const uint8_t *row = bgra.Row(y);
+      float *r = tensor + static_cast<size_t>(y) * planeWidth;
+      BgraRowToPlanarRgb(row, bgra.width, r, r + plane, r + 2 * plane);
+      thumbnailBuilder_.AddBgraRow(y, row);
+    }
+    thumbnailBuilder_.Finish(*thumbnail);
+    PadPlanarRgb(tensor, bgra.width, bgra.height, planeWidth, planeHeight,
+                 pool);
+    return true;
+  }
+  return BgraToPlanarRgbPadded(bgra, tensor, planeWidth, planeHeight, pool);
+}
+
+bool OnnxSession::UpdateInput(size_t index, const FrameView &bgra,
+                              const RectList &changed,
+                              ThreadPool *pool) noexcept {
+  if (index >= kInputs || changed.IsFull() ||
+      frameSizes_[index] != FrameSize{bgra.width, bgra.height} ||
+      !inputs_[index]) {
+    return SetInput(index, bgra, nullptr, pool);
+  }
+  const uint32_t planeWidth = modelWidth_ ? modelWidth_ : bgra.width;
+  const uint32_t planeHeight = modelHeight_ ? modelHeight_ : bgra.height;
+  return BgraRectsToPlanarRgbPadded(bgra, inputs_[index], planeWidth,
+                                    planeHeight, changed, pool);
+}
+
+bool OnnxSession::EnsureTensors(size_t size) noexcept {
+  if (size == tensorSize_)
+    return true;
+  // Only a new frame or model size gets here; the old contents go.
+  ReleaseTensors();
+  const size_t bytes = FrameArena::AlignedSize(size * sizeof(float));
+  if (!tensorArena_.Reserve(bytes * (kInputs + 1), options_.hugePages
+                                                       ? ArenaPages::Huge
+                                                       : ArenaPages::Normal)) {
+    return false;
+  }
+  for (float *&tensor : inputs_)
+    tensor = tensorArena_.AllocateArray<float>(size);
+  outputData_ = tensorArena_.AllocateArray<float>(size);
+  tensorSize_ = size;
+  return true;
+}
+
+void OnnxSession::ReleaseTensors() noexcept {
+#ifdef HAS_ONNX
+  for (Ort::Value &value : inputValues_)
+    value = Ort::Value{nullptr};
+  outputValue_ = Ort::Value{nullptr};
+  boundSize_ = {};
+  hasOutput_ = hasOutput_ && !outputBound_;
+#endif
+  tensorArena_.Release();
+  inputs_ = {};
+  outputData_ = nullptr;
+  tensorSize_ = 0;
+  frameSizes_ = {};
+}
+
+#ifdef HAS_ONNX
+
+bool OnnxSession::Create(const std::filesystem::path &model,
+                         const OnnxSessionOptions &options) noexcept {
+  Destroy();
+  options_ = options;
+
+  try {
+    env_ = std::make_unique<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "DeepFrame");
+    if (!CreateSession(model)) {
+      env_.reset();
+      return false;
+    }
+
+    auto shape =
+        session_->GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
+    if (shape.size() >= 4) {
+      modelHeight_ = shape[2] > 0 ? static_cast<uint32_t>(shape[2]) : 0;
+      modelWidth_ = shape[3] > 0 ? static_cast<uint32_t>(shape[3]) : 0;
+    }
+
+    if (session_->GetInputCount() < kInputs ||
+        session_->GetOutputCount() < 1) {
+      Log::Error("[OnnxSession] Model needs %zu frame inputs and an "
+                 "output\n",
+                 kInputs);
+      Destroy();
+      return false;
+    }
+    Ort::AllocatorWithDefaultOptions allocator;
+    for (size_t i = 0; i < kInputs; i++)
+      inputNames_[i] = session_->GetInputNameAllocated(i, allocator).get();
+    outputName_ = session_->GetOutputNameAllocated(0, allocator).get();
+    return true;
+  } catch (const Ort::Exception &e) {
+    Log::Error("[OnnxSession] ONNX Error: %s\n", e.what());
+  } catch (...) {
+    Log::Error("[OnnxSession] Unknown error\n");
+  }
+  Destroy();
+  return false;
+}
+
+Ort::SessionOptions
+OnnxSession::MakeOptions(GraphOptimizationLevel level,
+                         std::string &providers) const {
+  Ort::SessionOptions opts;
+  opts.SetIntraOpNumThreads(options_.intraOpThreads);
+  opts.SetGraphOptimizationLevel(level);
+  providers = "cpu";
+  if (!options_.gpu)
+    return opts;
+
+#ifdef _WIN32
+  OrtDmlDeviceOptions dmlOpts = {};
+  dmlOpts.device_id = 0;
+  opts.AppendExecutionProvider_DML(dmlOpts);
+  providers = "dml:0";
+#endif
+
+  OrtCUDAProviderOptions cudaOpts{};
+  cudaOpts.device_id = 0;
+  cudaOpts.arena_extend_strategy = 0;
+  cudaOpts.gpu_mem_limit = 512 * 1024 * 1024;
+  cudaOpts.cudnn_conv_algo_search = OrtCudnnConvAlgoSearchExhaustive;
+
+  try {
+    opts.AppendExecutionProvider_CUDA(cudaOpts);
+    providers += ",cuda:0";
+  } catch (...) {
+  }
+  return opts;
+}
+
+bool OnnxSession::CreateSession(const std::filesystem::path &model) {
+  auto startTime = std::chrono::high_resolution_clock::now();
+
+  MappedFile source;
+  if (!source.Open(model)) {
+    Log::Error("[OnnxSession] Failed to map model file\n");
+    return false;
+  }
+
+  // The optimized graph depends on the providers it was partitioned for and
+  // on the ORT build, so both are part of the key next to the model bytes.
+  std::string providers;
+  Ort::SessionOptions warmOpts = MakeOptions(ORT_DISABLE_ALL, providers);
+  ModelCacheKey key;
+  key.modelHash = ModelCache::HashBytes(source.Data(), source.Size());
+  key.providers = providers;
+  key.options = "opt=all;intra=" + std::to_string(options_.intraOpThreads) +
+                ";ort=" + OrtGetApiBase()->GetVersionString();
+
+  try {
+    if (!options_.cacheDirectory.empty()) {
+      modelCache_.SetDirectory(options_.cacheDirectory);
+    } else {
+      modelCache_.SetDirectory(std::filesystem::temp_directory_path() /
+                               "DeepFrame" / "ModelCache");
+    }
+  } catch (...) {
+  }
+
+  stats_.modelCacheHit = false;
+  CachedModelFormat format = modelCache_.Lookup(key, cachedModel_);
+  if (format != CachedModelFormat::None) {
+    try {
+      if (format == CachedModelFormat::Ort) {
+        warmOpts.AddConfigEntry("session.load_model_format", "ORT");
+        warmOpts.AddConfigEntry("session.use_ort_model_bytes_directly", "1");
+      }
+      session_ = std::make_unique<Ort::Session>(
+          *env_, cachedModel_.Data(), cachedModel_.Size(), warmOpts);
+      stats_.modelCacheHit = true;
+    } catch (const Ort::Exception &e) {
+      Log::Warn("[OnnxSession] Cached model rejected (%s), rebuilding\n",
+                e.what());
+      session_.reset();
+      cachedModel_.Close();
+      modelCache_.Evict(key);
+    }
+  }
+
+  if (!session_) {
+    bool cacheable = !modelCache_.IsUncacheable(key);
+    for (CachedModelFormat saveAs :
+         {CachedModelFormat::Ort, CachedModelFormat::Onnx,
+          CachedModelFormat::None}) {
+      if (saveAs != CachedModelFormat::None && !cacheable)
+        continue;
+
+      try {
+        Ort::SessionOptions opts = MakeOptions(ORT_ENABLE_ALL, providers);
+        if (saveAs != CachedModelFormat::None) {
+          std::filesystem::path staging = modelCache_.StagingPath(key, saveAs);
+          opts.SetOptimizedModelFilePath(staging.c_str());
+          if (saveAs == CachedModelFormat::Ort)
+            opts.AddConfigEntry("session.save_model_format", "ORT");
+        }
+
+        session_ = std::make_unique<Ort::Session>(*env_, source.Data(),
+                                                  source.Size(), opts);
+
+        if (saveAs != CachedModelFormat::None) {
+          modelCache_.Publish(key, saveAs);
+        } else if (cacheable) {
+          modelCache_.MarkUncacheable(key);
+        }
+        break;
+      } catch (const Ort::Exception &e) {
+        session_.reset();
+        if (saveAs == CachedModelFormat::None) {
+          Log::Error("[OnnxSession] ONNX Error: %s\n", e.what());
+          return false;
+        }
+      }
+    }
+  }
+
+  auto endTime = std::chrono::high_resolution_clock::now();
+  stats_.sessionCreateMs =
+      std::chrono::duration<float, std::milli>(endTime - startTime).count();
+
+  if (stats_.modelCacheHit) {
+    stats_.coldSessionCreateMs = modelCache_.LoadColdCreateMs(key);
+  } else {
+    stats_.coldSessionCreateMs = stats_.sessionCreateMs;
+    modelCache_.StoreColdCreateMs(key, stats_.sessionCreateMs);
+  }
+
+  Log::Info("[OnnxSession] Session created in %.1f ms (%s, cold %.1f ms)\n",
+            stats_.sessionCreateMs, stats_.modelCacheHit ? "cached" : "cold",
+            stats_.coldSessionCreateMs);
+  return true;
+}
+
+void OnnxSession::Destroy() noexcept {
+  ReleaseTensors();
+  output_ = Ort::Value{nullptr};
+  hasOutput_ = false;
+  outputBound_ = true;
+  session_.reset();
+  cachedModel_.Close();
+  env_.reset();
+  outputSize_ = {};
+  modelWidth_ = 0;
+  modelHeight_ = 0;
+  width_ = 0;
+  height_ = 0;
+}
+
+bool OnnxSession::IsReady() const noexcept { return session_ != nullptr; }
+
+bool OnnxSession::Run(size_t first) noexcept {
+  // Both frames have to be the same size.
+  const FrameSize frame = frameSizes_[0];
+  if (!session_ || first >= kInputs || frame.width == 0 ||
+      frameSizes_[1] != frame) {
+    return false;
+  }
+  width_ = modelWidth_ ? modelWidth_ : frame.width;
+  height_ = modelHeight_ ? modelHeight_ : frame.height;
+  const size_t size = PlanarRgbSize(width_, height_);
+  if (size != tensorSize_)
+    return false;
+
+  auto startTime = std::chrono::high_resolution_clock::now();
+  try {
+    if (boundSize_ != FrameSize{width_, height_})
+      BindTensors();
+    // Inputs bind by name, so swapping the names swaps which frame the
+    // model sees first without touching the values.
+    const char *inputNames[kInputs] = {inputNames_[first].c_str(),
+                                       inputNames_[1 - first].c_str()};
+    const char *outputNames[] = {outputName_.c_str()};
+
+    bool done = false;
+    if (outputBound_) {
+      try {
+        session_->Run(Ort::RunOptions{nullptr}, inputNames,
+                      inputValues_.data(), kInputs, outputNames,
+                      &outputValue_, 1);
+        done = true;
+      } catch (const Ort::Exception &e) {
+        Log::Warn("[OnnxSession] Output does not fit the input shape (%s); "
+                  "letting ORT allocate it\n",
+                  e.what());
+        outputBound_ = false;
+      }
+    }
+    if (!done) {
+      auto outputs =
+          session_->Run(Ort::RunOptions{nullptr}, inputNames,
+                        inputValues_.data(), kInputs, outputNames, 1);
+      if (outputs[0].GetTensorTypeAndShapeInfo().GetElementCount() < size)
+        return false;
+      output_ = std::move(outputs[0]);
+    }
+    outputSize_ = frame;
+    hasOutput_ = true;
+  } catch (const Ort::Exception &e) {
+    Log::Error("[OnnxSession] Run failed: %s\n", e.what());
+    return false;
+  } catch (...) {
+    return false;
+  }
+
+  auto endTime = std::chrono::high_resolution_clock::now();
+  stats_.lastRunMs =
+      std::chrono::duration<float, std::milli>(endTime - startTime).count();
+  return true;
+}
+
+void OnnxSession::BindTensors() {
+  const std::array<int64_t, 4> shape = {1, 3, height_, width_};
+  auto memoryInfo =
+      Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+  for (size_t i = 0; i < kInputs; i++) {
+    inputValues_[i] = Ort::Value::CreateTensor<float>(
+        memoryInfo, inputs_[i], tensorSize_, shape.data(), shape.size());
+  }
+  outputValue_ = Ort::Value::CreateTensor<float>(
+      memoryInfo, outputData_, tensorSize_, shape.data(), shape.size());
+  boundSize_ = {width_, height_};
+}
+
+bool OnnxSession::GetOutput(const FrameView &bgra,
+                            ThreadPool *pool) const noexcept {
+  if (!hasOutput_ || outputSize_ != FrameSize{bgra.width, bgra.height})
+    return false;
+  const float *output =
+      outputBound_ ? outputData_ : output_.GetTensorData<float>();
+  return PlanarRgbToBgraCropped(output, width_, height_, bgra, pool);
+}
+
+#else
+
+bool OnnxSession::Create(const std::filesystem::path &,
+                         const OnnxSessionOptions &) noexcept {
+  Log::Info("[OnnxSession] ONNX Runtime not available - AI interpolation "
+            "disabled\n");
+  return false;
+}
+
+void OnnxSession::Destroy() noexcept { ReleaseTensors(); }
+
+bool OnnxSession::IsReady() const noexcept { return false; }
+
+bool OnnxSession::Run(size_t) noexcept { return false; }
+
+bool OnnxSession::GetOutput(const FrameView &, ThreadPool *) const noexcept {
+  return false;
+}
+
+#endif
+
+} // namespace DeepFrame
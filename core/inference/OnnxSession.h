@@ -0,0 +1,150 @@
+#pragma once
+
+#include "../compute/FrameArena.h"
+#include "../compute/FrameView.h"
+#include "../compute/RectList.h"
+#include "../compute/SceneCutDetector.h"
+#include "ModelCache.h"
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if __has_include(<onnxruntime_cxx_api.h>)
+#define HAS_ONNX 1
+#include <onnxruntime_cxx_api.h>
+#endif
+
+namespace DeepFrame {
+
+class ThreadPool;
+
+struct OnnxSessionOptions {
+  // DirectML (Windows) and CUDA ahead of the CPU provider when available.
+  bool gpu = true;
+  int intraOpThreads = 1;
+  // Back the tensors with huge pages where the OS grants them.
+  bool hugePages = true;
+  // Empty selects <temp>/DeepFrame/ModelCache.
+  std::filesystem::path cacheDirectory;
+};
+
+struct OnnxSessionStats {
+  float sessionCreateMs = 0.f;
+  float coldSessionCreateMs = 0.f;
+  bool modelCacheHit = false;
+  float lastRunMs = 0.f;
+};
+
+// Platform-neutral half of the model path: session creation through the
+// model cache, BGRA frames in and out as NCHW float RGB, and the run
+// itself. Frames are plain CPU views, so the GPU front end only has to map
+// its staging textures.
+class OnnxSession {
+public:
+  static constexpr size_t kInputs = 2;
+
+  OnnxSession() noexcept = default;
+  ~OnnxSession() noexcept;
+
+  OnnxSession(const OnnxSession &) = delete;
+  OnnxSession &operator=(const OnnxSession &) = delete;
+
+  [[nodiscard]] bool Create(const std::filesystem::path &model,
+                            const OnnxSessionOptions &options = {}) noexcept;
+  void Destroy() noexcept;
+  [[nodiscard]] bool IsReady() const noexcept;
+
+  // Input size the model was exported with, 0 along a dynamic axis.
+  [[nodiscard]] uint32_t InputWidth() const noexcept { return modelWidth_; }
+  [[nodiscard]] uint32_t InputHeight() const noexcept {
+    return modelHeight_;
+  }
+
+  // Converts frame `index` into its input tensor. With `thumbnail` the
+  // scene-cut thumbnail is built in the same pass over the frame. A model
+  // with a fixed input size takes frames up to that size, padded out;
+  // GetOutput crops the result back.
+  [[nodiscard]] bool SetInput(size_t index, const FrameView &bgra,
+                              SceneThumbnail *thumbnail = nullptr,
+                              ThreadPool *pool = nullptr) noexcept;
+  // Converts only `changed` of a frame whose input already holds an older
+  // frame of the same size; falls back to SetInput otherwise.
+  [[nodiscard]] bool UpdateInput(size_t index, const FrameView &bgra,
+                                 const RectList &changed,
+                                 ThreadPool *pool = nullptr) noexcept;
+  // Feeds input `first` as the model's first frame and the other as its
+  // second, so callers can alternate which input holds the older frame.
+  [[nodiscard]] bool Run(size_t first = 0) noexcept;
+  // Writes the last Run's result; `bgra` must match the frame size.
+  [[nodiscard]] bool GetOutput(const FrameView &bgra,
+                               ThreadPool *pool = nullptr) const noexcept;
+
+  [[nodiscard]] const OnnxSessionStats &GetStats() const noexcept {
+    return stats_;
+  }
+
+private:
+  struct FrameSize {
+    uint32_t width = 0;
+    uint32_t height = 0;
+
+    bool operator!=(const FrameSize &other) const noexcept {
+      return width != other.width || height != other.height;
+    }
+  };
+
+#ifdef HAS_ONNX
+  [[nodiscard]] Ort::SessionOptions
+  MakeOptions(GraphOptimizationLevel level, std::string &providers) const;
+  // Throws Ort::Exception; Create catches.
+  [[nodiscard]] bool CreateSession(const std::filesystem::path &model);
+  // Wraps the arena tensors as ORT values of the current tensor shape.
+  // Throws Ort::Exception.
+  void BindTensors();
+
+  std::unique_ptr<Ort::Env> env_;
+  std::unique_ptr<Ort::Session> session_;
+  std::array<Ort::Value, kInputs> inputValues_{Ort::Value{nullptr},
+                                               Ort::Value{nullptr}};
+  Ort::Value outputValue_{nullptr};
+  FrameSize boundSize_;
+  // The model writes straight into outputData_; cleared for models whose
+  // output shape differs from the input's, which ORT then allocates into
+  // output_ on every run.
+  bool outputBound_ = true;
+  Ort::Value output_{nullptr};
+  FrameSize outputSize_;
+  bool hasOutput_ = false;
+#endif
+
+  // Replaces the tensors when `size` (floats each) changes.
+  [[nodiscard]] bool EnsureTensors(size_t size) noexcept;
+  void ReleaseTensors() noexcept;
+
+  OnnxSessionOptions options_;
+  ModelCache modelCache_;
+  MappedFile cachedModel_;
+  std::array<std::string, kInputs> inputNames_;
+  std::string outputName_;
+
+  // Both inputs and the output, 64-byte aligned in one mapping that is
+  // only replaced when the tensor size changes.
+  FrameArena tensorArena_{MemorySubsystem::Tensors};
+  std::array<float *, kInputs> inputs_{};
+  float *outputData_ = nullptr;
+  size_t tensorSize_ = 0;
+  std::array<FrameSize, kInputs> frameSizes_{};
+  SceneThumbnailBuilder thumbnailBuilder_;
+  // Tensor size of the last Run.
+  uint32_t width_ = 0;
+  uint32_t height_ = 0;
+  uint32_t modelWidth_ = 0;
+  uint32_t modelHeight_ = 0;
+
+  OnnxSessionStats stats_;
+};
+
+} // namespace DeepFrame
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "../compute/InterpolationMode.h"
+#include "../compute/MotionField.h"
+#include "../compute/TelemetryRing.h"
+#include "../pipeline/PipelineStats.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace DeepFrame {
+
+struct PipelineConfig {
+  InterpolationMode mode = InterpolationMode::FAST;
+  std::wstring modelPath;
+  std::wstring modelCacheDir;
+  bool showStats = true;
+  void *targetWindow = nullptr;
+  MotionParams motion;
+  std::string sharedFrameName;
+};
+
+// FramePipeline's interface without capture or presentation, so the addon
+// builds and loads where there is no D3D11. The calls that block on
+// Windows - device creation, joining the pipeline threads, rebuilding the
+// ONNX session - sleep for DEEPFRAME_STUB_DELAY_MS (default 250) instead.
+// While running, a thread writes synthetic telemetry at 240 fps and holds
+// the engine lock for a simulated inference on each frame, as the real
+// inference stage does; SetMode fails if its rebuild overlaps one.
+class StubPipeline {
+public:
+  StubPipeline() noexcept {
+    if (const char *env = std::getenv("DEEPFRAME_STUB_DELAY_MS"))
+      delay_ = std::chrono::milliseconds(std::atoi(env));
+  }
+  ~StubPipeline() noexcept { Shutdown(); }
+
+  StubPipeline(const StubPipeline &) = delete;
+  StubPipeline &operator=(const StubPipeline &) = delete;
+
+  [[nodiscard]] bool Initialize(const PipelineConfig &config) noexcept {
+    if (initialized_)
+      return true;
+    std::this_thread::sleep_for(delay_);
+    config_ = config;
+    initialized_ = true;
+    return true;
+  }
+
+  void Shutdown() noexcept {
+    Stop();
+    initialized_ = false;
+  }
+
+  [[nodiscard]] bool Start() noexcept {
+    if (!initialized_ || running_)
+      return false;
+    {
+      std::lock_guard<std::mutex> lock(statsMutex_);
+      stats_ = PipelineStats{};
+      stats_.captureFps = 60.f;
+      stats_.presentFps = 120.f;
+    }
+    running_ = true;
+    try {
+      frames_ = std::thread(&StubPipeline::FrameThread, this);
+    } catch (...) {
+      running_ = false;
+      return false;
+    }
+    return true;
+  }
+
+  void Stop() noexcept {
+    if (!running_)
+      return;
+    running_ = false;
+    frames_.join();
+    std::this_thread::sleep_for(delay_);
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    stats_ = PipelineStats{};
+  }
+
+  void SetTargetWindow(void *target) noexcept { config_.targetWindow = target; }
+  void SetShowStats(bool show) noexcept { config_.showStats = show; }
+  void SetMotionParams(const MotionParams &params) noexcept {
+    config_.motion = params;
+  }
+  void SetTelemetry(TelemetryRing *ring) noexcept {
+    telemetry_.store(ring, std::memory_order_release);
+  }
+  [[nodiscard]] bool SetMode(InterpolationMode mode,
+                             const std::wstring &modelPath) noexcept {
+    config_.mode = mode;
+    config_.modelPath = modelPath;
+    std::lock_guard<std::mutex> lock(engineMutex_);
+    bool overlapped = inferring_.load();
+    if (initialized_ && UsesModel(mode))
+      std::this_thread::sleep_for(delay_);
+    overlapped |= inferring_.load();
+    return !overlapped;
+  }
+
+  [[nodiscard]] PipelineStats GetStats() const noexcept {
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    return stats_;
+  }
+  [[nodiscard]] bool IsRunning() const noexcept { return running_.load(); }
+  [[nodiscard]] bool IsInitialized() const noexcept { return initialized_; }
+
+private:
+  void FrameThread() noexcept {
+    using Clock = std::chrono::steady_clock;
+    const auto period = std::chrono::microseconds(1000000 / 240);
+    auto due = Clock::now();
+    while (running_) {
+      std::unique_lock<std::mutex> engines(engineMutex_, std::try_to_lock);
+      if (engines.owns_lock()) {
+        inferring_ = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        inferring_ = false;
+        engines.unlock();
+      }
+      if (TelemetryRing *ring = telemetry_.load(std::memory_order_acquire)) {
+        const uint32_t n = frameIndex_++;
+        TelemetryRecord record;
+        record.frameIndex = n;
+        record.captureMs =
+            std::chrono::duration<double, std::milli>(
+                Clock::now().time_since_epoch())
+                .count();
+        record.flags = kTelemetryInterpolated;
+        if (n % 120 == 0)
+          record.flags |= kTelemetrySceneCut;
+        record.queueMs = 0.5f + static_cast<float>(n % 4) * 0.25f;
+        record.inferenceMs = 3.0f + static_cast<float>(n % 7) * 0.5f;
+        record.submitMs = 0.2f;
+        ring->Write(record);
+      }
+      due += period;
+      std::this_thread::sleep_until(due);
+    }
+  }
+
+  std::chrono::milliseconds delay_{250};
+  std::atomic<bool> running_{false};
+  bool initialized_ = false;
+  std::thread frames_;
+  std::mutex engineMutex_;
+  std::atomic<bool> inferring_{false};
+  std::atomic<TelemetryRing *> telemetry_{nullptr};
+  uint32_t frameIndex_ = 0;
+  PipelineConfig config_;
+  mutable std::mutex statsMutex_;
+  PipelineStats stats_;
+};
+
+} // namespace DeepFrame
@@ -2,10 +2,32 @@
 
 
 #define NAPI_VERSION 8
+#ifdef DEEPFRAME_STUB_PIPELINE
+#include "StubPipeline.h"
+#else
 #include "../pipeline/FramePipeline.h"
+#endif
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <napi.h>
+#include <optional>
 #include <string>
+#include <thread>
 
+#ifdef DEEPFRAME_STUB_PIPELINE
+using Pipeline = DeepFrame::StubPipeline;
+using WindowHandle = void *;
+#else
+using Pipeline = DeepFrame::FramePipeline;
+using WindowHandle = HWND;
+#endif
+
+#ifndef DEEPFRAME_STUB_PIPELINE
 
 static std::string WideToUtf8(const std::wstring &wstr) {
   if (wstr.empty())
@@ -49,6 +71,190 @@ static BOOL CALLBACK EnumWindowsProc(HWND hwnd, LPARAM lParam) {
   windows->push_back({hwnd, title, className});
   return TRUE;
 }
+#endif
+
+static Napi::Object StatsToObject(Napi::Env env,
+                                  const DeepFrame::PipelineStats &stats) {
+  Napi::Object result = Napi::Object::New(env);
+  result.Set("captureFps", Napi::Number::New(env, stats.captureFps));
+  result.Set("presentFps", Napi::Number::New(env, stats.presentFps));
+  result.Set("inferenceTimeMs", Napi::Number::New(env, stats.inferenceTimeMs));
+  result.Set("droppedFrames",
+             Napi::Number::New(env, static_cast<double>(stats.droppedFrames)));
+  result.Set("vramUsageMB",
+             Napi::Number::New(env, static_cast<double>(stats.vramUsageMB)));
+  result.Set("e2eLatencyMs", Napi::Number::New(env, stats.e2eLatencyMs));
+  result.Set("sessionCreateMs", Napi::Number::New(env, stats.sessionCreateMs));
+  result.Set("coldSessionCreateMs",
+             Napi::Number::New(env, stats.coldSessionCreateMs));
+  result.Set("modelCacheHit", Napi::Boolean::New(env, stats.modelCacheHit));
+  result.Set("skippedTileFraction",
+             Napi::Number::New(env, stats.skippedTileFraction));
+  result.Set("sceneCuts",
+             Napi::Number::New(env, static_cast<double>(stats.sceneCuts)));
+  result.Set("blendFallbacks",
+             Napi::Number::New(env, static_cast<double>(stats.blendFallbacks)));
+  result.Set("speculativeUpgrades",
+             Napi::Number::New(
+                 env, static_cast<double>(stats.speculativeUpgrades)));
+  result.Set("speculativeMisses",
+             Napi::Number::New(
+                 env, static_cast<double>(stats.speculativeMisses)));
+  result.Set("upgradeRate", Napi::Number::New(env, stats.upgradeRate));
+  result.Set("missRate", Napi::Number::New(env, stats.missRate));
+  result.Set(
+      "duplicateFrames",
+      Napi::Number::New(env, static_cast<double>(stats.duplicateFrames)));
+  result.Set("idle", Napi::Boolean::New(env, stats.idle));
+  result.Set("idleEntries",
+             Napi::Number::New(env, static_cast<double>(stats.idleEntries)));
+  Napi::Object memory = Napi::Object::New(env);
+  for (size_t i = 0; i < DeepFrame::kMemorySubsystems; i++) {
+    Napi::Object usage = Napi::Object::New(env);
+    usage.Set("cpuMB", Napi::Number::New(env, stats.memory.cpuBytes[i] / 1e6));
+    usage.Set("gpuMB", Napi::Number::New(env, stats.memory.gpuBytes[i] / 1e6));
+    memory.Set(DeepFrame::MemorySubsystemName(
+                   static_cast<DeepFrame::MemorySubsystem>(i)),
+               usage);
+  }
+  result.Set("memory", memory);
+  
+  result.Set("fps", Napi::Number::New(env, stats.presentFps));
+  result.Set("latencyMs", Napi::Number::New(env, stats.inferenceTimeMs));
+
+  return result;
+}
+
+// Samples the pipeline off the JS thread and pushes a snapshot through a
+// thread-safe function whenever it changed, at most once per interval.
+// While one snapshot waits for the JS thread, newer ones replace it rather
+// than queue behind it.
+class StatsSubscription {
+public:
+  static std::shared_ptr<StatsSubscription>
+  Create(Napi::Env env, Napi::Function callback, const Pipeline &pipeline,
+         std::chrono::milliseconds interval) {
+    std::shared_ptr<StatsSubscription> subscription(
+        new StatsSubscription(pipeline, interval));
+    // The thread-safe function owns a reference until it is finalized,
+    // which is after the last queued delivery.
+    auto *owner = new std::shared_ptr<StatsSubscription>(subscription);
+    subscription->tsfn_ = Napi::ThreadSafeFunction::New(
+        env, callback, "DeepFrame.stats", 0, 1, owner,
+        [](Napi::Env, std::shared_ptr<StatsSubscription> *owner) {
+          (*owner)->Join();
+          (*owner)->released_ = true;
+          delete owner;
+        });
+    try {
+      subscription->sampler_ =
+          std::thread(&StatsSubscription::Sample, subscription.get());
+    } catch (...) {
+      subscription->Stop();
+      return nullptr;
+    }
+    return subscription;
+  }
+
+  StatsSubscription(const StatsSubscription &) = delete;
+  StatsSubscription &operator=(const StatsSubscription &) = delete;
+
+  // Samples now instead of at the end of the interval, after calls that
+  // change the running state.
+  void Poke() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      poked_ = true;
+    }
+    wake_.notify_all();
+  }
+
+  // JS thread only.
+  void Stop() {
+    Join();
+    if (!released_) {
+      released_ = true;
+      tsfn_.Release();
+    }
+  }
+
+private:
+  struct Snapshot {
+    bool running = false;
+    DeepFrame::PipelineStats stats;
+  };
+
+  StatsSubscription(const Pipeline &pipeline,
+                    std::chrono::milliseconds interval)
+      : pipeline_(pipeline), interval_(interval) {}
+
+  void Join() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    if (sampler_.joinable())
+      sampler_.join();
+  }
+
+  void Sample() noexcept {
+    Snapshot last;
+    bool sent = false;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+      poked_ = false;
+      lock.unlock();
+      Snapshot now;
+      now.running = pipeline_.IsRunning();
+      now.stats = pipeline_.GetStats();
+      lock.lock();
+
+      if (!sent || now.running != last.running || now.stats != last.stats) {
+        last = now;
+        sent = true;
+        latest_ = now;
+        if (!queued_) {
+          queued_ = tsfn_.NonBlockingCall(
+                        [this](Napi::Env env, Napi::Function callback) {
+                          Deliver(env, callback);
+                        }) == napi_ok;
+        }
+      }
+      wake_.wait_for(lock, interval_, [this] { return stop_ || poked_; });
+    }
+  }
+
+  void Deliver(Napi::Env env, Napi::Function callback) {
+    // Deliveries already queued when the subscriber unsubscribed.
+    if (released_)
+      return;
+    Snapshot snapshot;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      snapshot = latest_;
+      queued_ = false;
+    }
+    Napi::Object update = Napi::Object::New(env);
+    update.Set("running", Napi::Boolean::New(env, snapshot.running));
+    update.Set("stats", StatsToObject(env, snapshot.stats));
+    callback.Call({update});
+  }
+
+  const Pipeline &pipeline_;
+  const std::chrono::milliseconds interval_;
+  Napi::ThreadSafeFunction tsfn_;
+  std::thread sampler_;
+  bool released_ = false;
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  bool stop_ = false;
+  bool poked_ = false;
+  // Newest snapshot not yet delivered; queued_ while a delivery is pending.
+  Snapshot latest_;
+  bool queued_ = false;
+};
 
 class DeepFrameAddon : public Napi::ObjectWrap<DeepFrameAddon> {
 public:
@@ -65,6 +271,11 @@ public:
             InstanceMethod("getOpenWindows", &DeepFrameAddon::GetOpenWindows),
             InstanceMethod("setShowStats", &DeepFrameAddon::SetShowStats),
             InstanceMethod("setMode", &DeepFrameAddon::SetMode),
+            InstanceMethod("cancel", &DeepFrameAddon::Cancel),
+            InstanceMethod("subscribeStats", &DeepFrameAddon::SubscribeStats),
+            InstanceMethod("unsubscribeStats",
+                           &DeepFrameAddon::UnsubscribeStats),
+            InstanceMethod("telemetryBuffer", &DeepFrameAddon::TelemetryBuffer),
         });
 
     Napi::FunctionReference *constructor = new Napi::FunctionReference();
@@ -78,94 +289,168 @@ public:
   DeepFrameAddon(const Napi::CallbackInfo &info)
       : Napi::ObjectWrap<DeepFrameAddon>(info) {}
 
-  ~DeepFrameAddon() { pipeline_.Shutdown(); }
+  ~DeepFrameAddon() {
+    if (stats_)
+      stats_->Stop();
+    pipeline_.Shutdown();
+  }
 
-  
+  // initialize, start, stop and setMode can block for a long time (device
+  // creation, thread joins, session builds), so they run on the libuv pool
+  // and return promises. They run one at a time in call order.
   Napi::Value Initialize(const Napi::CallbackInfo &info) {
-    Napi::Env env = info.Env();
-
-    if (pipeline_.IsInitialized()) {
-      return Napi::Boolean::New(env, true);
+    std::string sharedFrames;
+    if (info.Length() > 0 && info[0].IsObject()) {
+      Napi::Value name = info[0].As<Napi::Object>().Get("sharedFrames");
+      if (name.IsString())
+        sharedFrames = name.As<Napi::String>().Utf8Value();
     }
 
-    DeepFrame::PipelineConfig config;
-    config.mode = DeepFrame::InterpolationMode::FAST;
-    config.showStats = true;
-    config.targetWindow = nullptr;
-
-    
-    
-    config.modelPath = L""; 
+    return Enqueue(info.Env(), OpKind::Initialize,
+                   [this, sharedFrames](std::string &) {
+                     if (pipeline_.IsInitialized())
+                       return true;
 
-    if (!pipeline_.Initialize(config)) {
-      return Napi::Boolean::New(env, false);
-    }
+                     DeepFrame::PipelineConfig config;
+                     config.mode = DeepFrame::InterpolationMode::FAST;
+                     config.showStats = true;
+                     config.targetWindow = nullptr;
+                     config.sharedFrameName = sharedFrames;
+                     config.modelPath = L"";
 
-    return Napi::Boolean::New(env, true);
+                     return pipeline_.Initialize(config);
+                   });
   }
 
   
   Napi::Value Start(const Napi::CallbackInfo &info) {
-    Napi::Env env = info.Env();
-
-    if (!pipeline_.IsInitialized()) {
-      Napi::Error::New(env, "Not initialized").ThrowAsJavaScriptException();
-      return env.Undefined();
-    }
-
-    if (pipeline_.IsRunning()) {
-      return Napi::Boolean::New(env, true);
-    }
-
-    
+    // The config object is read now; the pipeline may not be initialized
+    // until the operations queued ahead of this one have run.
+    std::optional<bool> showStats;
+    std::optional<DeepFrame::MotionParams> motion;
     if (info.Length() > 0 && info[0].IsObject()) {
       Napi::Object config = info[0].As<Napi::Object>();
 
       if (config.Has("showStats")) {
-        bool show = config.Get("showStats").As<Napi::Boolean>().Value();
-        pipeline_.SetShowStats(show);
+        showStats = config.Get("showStats").As<Napi::Boolean>().Value();
       }
-    }
 
-    if (!pipeline_.Start()) {
-      return Napi::Boolean::New(env, false);
+      motion.emplace();
+      if (config.Get("searchRadius").IsNumber()) {
+        motion->searchRadius =
+            config.Get("searchRadius").As<Napi::Number>().Int32Value();
+      }
+      if (config.Get("diffThreshold").IsNumber()) {
+        motion->diffThreshold =
+            config.Get("diffThreshold").As<Napi::Number>().FloatValue();
+      }
+      if (config.Get("temporalBlend").IsNumber()) {
+        motion->temporalBlend =
+            config.Get("temporalBlend").As<Napi::Number>().FloatValue();
+      }
     }
 
-    return Napi::Boolean::New(env, true);
+    return Enqueue(info.Env(), OpKind::Start,
+                   [this, showStats, motion](std::string &error) {
+                     if (!pipeline_.IsInitialized()) {
+                       error = "Not initialized";
+                       return false;
+                     }
+                     if (pipeline_.IsRunning())
+                       return true;
+                     if (showStats)
+                       pipeline_.SetShowStats(*showStats);
+                     if (motion)
+                       pipeline_.SetMotionParams(*motion);
+                     return pipeline_.Start();
+                   });
   }
 
   
   Napi::Value Stop(const Napi::CallbackInfo &info) {
-    pipeline_.Stop();
-    return Napi::Boolean::New(info.Env(), true);
+    return Enqueue(info.Env(), OpKind::Stop, [this](std::string &) {
+      pipeline_.Stop();
+      return true;
+    });
+  }
+
+  // Rejects every queued operation that has not started with an
+  // ECANCELED error and returns how many there were. The running one, if
+  // any, still completes.
+  Napi::Value Cancel(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    const size_t cancelled = CancelPending(
+        env, [](OpKind kind) { return kind != OpKind::Setting; }, "Cancelled");
+    Pump();
+    return Napi::Number::New(env, static_cast<double>(cancelled));
   }
 
   
   Napi::Value GetStats(const Napi::CallbackInfo &info) {
+    return StatsToObject(info.Env(), pipeline_.GetStats());
+  }
+
+  Napi::Value IsRunning(const Napi::CallbackInfo &info) {
+    return Napi::Boolean::New(info.Env(), pipeline_.IsRunning());
+  }
+
+  // subscribeStats(callback, { intervalMs }) calls back with
+  // { running, stats } whenever either changed, at most every intervalMs
+  // (default 50) and promptly after start and stop. Replaces any previous
+  // subscription.
+  Napi::Value SubscribeStats(const Napi::CallbackInfo &info) {
     Napi::Env env = info.Env();
 
-    auto stats = pipeline_.GetStats();
-
-    Napi::Object result = Napi::Object::New(env);
-    result.Set("captureFps", Napi::Number::New(env, stats.captureFps));
-    result.Set("presentFps", Napi::Number::New(env, stats.presentFps));
-    result.Set("inferenceTimeMs",
-               Napi::Number::New(env, stats.inferenceTimeMs));
-    result.Set(
-        "droppedFrames",
-        Napi::Number::New(env, static_cast<double>(stats.droppedFrames)));
-    result.Set("vramUsageMB",
-               Napi::Number::New(env, static_cast<double>(stats.vramUsageMB)));
-    result.Set("e2eLatencyMs", Napi::Number::New(env, stats.e2eLatencyMs));
-    
-    result.Set("fps", Napi::Number::New(env, stats.presentFps));
-    result.Set("latencyMs", Napi::Number::New(env, stats.inferenceTimeMs));
+    if (info.Length() < 1 || !info[0].IsFunction()) {
+      Napi::TypeError::New(env, "Expected a callback")
+          .ThrowAsJavaScriptException();
+      return env.Undefined();
+    }
 
-    return result;
+    int32_t intervalMs = 50;
+    if (info.Length() > 1 && info[1].IsObject()) {
+      Napi::Value interval = info[1].As<Napi::Object>().Get("intervalMs");
+      if (interval.IsNumber())
+        intervalMs = interval.As<Napi::Number>().Int32Value();
+    }
+    intervalMs = std::clamp(intervalMs, 10, 1000);
+
+    if (stats_)
+      stats_->Stop();
+    stats_ = StatsSubscription::Create(env, info[0].As<Napi::Function>(),
+                                       pipeline_,
+                                       std::chrono::milliseconds(intervalMs));
+    return Napi::Boolean::New(env, stats_ != nullptr);
   }
 
-  Napi::Value IsRunning(const Napi::CallbackInfo &info) {
-    return Napi::Boolean::New(info.Env(), pipeline_.IsRunning());
+  Napi::Value UnsubscribeStats(const Napi::CallbackInfo &info) {
+    if (stats_) {
+      stats_->Stop();
+      stats_.reset();
+    }
+    return info.Env().Undefined();
+  }
+
+  // The per-frame telemetry ring (layout in TelemetryRing.h), created on
+  // the first call; every call returns the same ArrayBuffer. JS reads it
+  // in place (telemetry.js), so it must never be transferred or detached.
+  // It lives in V8's heap because Electron refuses external buffers.
+  Napi::Value TelemetryBuffer(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+
+    if (telemetryBuffer_.IsEmpty()) {
+      const size_t bytes =
+          DeepFrame::TelemetryRing::BytesFor(kTelemetryCapacity);
+      Napi::ArrayBuffer buffer = Napi::ArrayBuffer::New(env, bytes);
+      if (!telemetry_.Attach(buffer.Data(), bytes, kTelemetryCapacity)) {
+        Napi::Error::New(env, "Telemetry buffer is misaligned")
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+      }
+      telemetryBuffer_ = Napi::Persistent(buffer);
+      pipeline_.SetTelemetry(&telemetry_);
+    }
+    return telemetryBuffer_.Value();
   }
 
   
@@ -173,7 +458,7 @@ public:
     Napi::Env env = info.Env();
 
     if (info.Length() < 1) {
-      pipeline_.SetTargetWindow(nullptr);
+      Apply([this] { pipeline_.SetTargetWindow(nullptr); });
       return Napi::Boolean::New(env, true);
     }
 
@@ -181,8 +466,9 @@ public:
       return Napi::Boolean::New(env, false);
     }
 
-    HWND hwnd = reinterpret_cast<HWND>(info[0].As<Napi::Number>().Int64Value());
-    pipeline_.SetTargetWindow(hwnd);
+    WindowHandle hwnd = reinterpret_cast<WindowHandle>(
+        info[0].As<Napi::Number>().Int64Value());
+    Apply([this, hwnd] { pipeline_.SetTargetWindow(hwnd); });
 
     return Napi::Boolean::New(env, true);
   }
@@ -191,6 +477,9 @@ public:
   Napi::Value GetOpenWindows(const Napi::CallbackInfo &info) {
     Napi::Env env = info.Env();
 
+#ifdef DEEPFRAME_STUB_PIPELINE
+    return Napi::Array::New(env);
+#else
     std::vector<WindowInfo> windows;
     EnumWindows(EnumWindowsProc, reinterpret_cast<LPARAM>(&windows));
 
@@ -206,6 +495,7 @@ public:
     }
 
     return result;
+#endif
   }
 
   
@@ -217,7 +507,7 @@ public:
     }
 
     bool show = info[0].As<Napi::Boolean>().Value();
-    pipeline_.SetShowStats(show);
+    Apply([this, show] { pipeline_.SetShowStats(show); });
     return Napi::Boolean::New(env, true);
   }
 
@@ -226,7 +516,9 @@ public:
     Napi::Env env = info.Env();
 
     if (info.Length() < 1 || !info[0].IsString()) {
-      return Napi::Boolean::New(env, false);
+      Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+      deferred.Resolve(Napi::Boolean::New(env, false));
+      return deferred.Promise();
     }
 
     std::string modeStr = info[0].As<Napi::String>().Utf8Value();
@@ -236,16 +528,156 @@ public:
       mode = DeepFrame::InterpolationMode::BALANCED;
     } else if (modeStr == "quality") {
       mode = DeepFrame::InterpolationMode::QUALITY;
+    } else if (modeStr == "flow") {
+      mode = DeepFrame::InterpolationMode::OPTICAL_FLOW;
+    } else if (modeStr == "blend") {
+      mode = DeepFrame::InterpolationMode::BLEND;
+    } else if (modeStr == "extrapolate") {
+      mode = DeepFrame::InterpolationMode::EXTRAPOLATE;
     }
 
     
     std::wstring modelPath = L""; 
 
-    return Napi::Boolean::New(env, pipeline_.SetMode(mode, modelPath));
+    return Enqueue(env, OpKind::SetMode,
+                   [this, mode, modelPath](std::string &) {
+                     return pipeline_.SetMode(mode, modelPath);
+                   });
   }
 
 private:
-  DeepFrame::FramePipeline pipeline_;
+  // About four seconds of frames at 240 fps.
+  static constexpr uint32_t kTelemetryCapacity = 1024;
+
+  enum class OpKind { Initialize, Start, Stop, SetMode, Setting };
+
+  // Runs on a pool thread; setting `error` rejects the promise.
+  using OpBody = std::function<bool(std::string &error)>;
+
+  struct PendingOp {
+    OpKind kind;
+    OpBody body;
+    // Absent for setters deferred behind a running operation.
+    std::optional<Napi::Promise::Deferred> deferred;
+  };
+
+  class OpWorker : public Napi::AsyncWorker {
+  public:
+    OpWorker(DeepFrameAddon &addon, PendingOp op)
+        : Napi::AsyncWorker(op.deferred->Env(), "DeepFrame.op"),
+          addon_(addon), op_(std::move(op)) {}
+
+    void Execute() override {
+      std::string error;
+      result_ = op_.body(error);
+      if (!error.empty())
+        SetError(error);
+    }
+
+    void OnOK() override {
+      op_.deferred->Resolve(Napi::Boolean::New(Env(), result_));
+      addon_.Finished();
+    }
+
+    void OnError(const Napi::Error &error) override {
+      op_.deferred->Reject(error.Value());
+      addon_.Finished();
+    }
+
+  private:
+    DeepFrameAddon &addon_;
+    PendingOp op_;
+    bool result_ = false;
+  };
+
+  Napi::Value Enqueue(Napi::Env env, OpKind kind, OpBody body) {
+    Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+    // Only the last of a burst of mode changes is worth a session build.
+    if (kind == OpKind::SetMode) {
+      CancelPending(
+          env, [](OpKind queued) { return queued == OpKind::SetMode; },
+          "Superseded by a later setMode");
+    }
+    pending_.push_back({kind, std::move(body), deferred});
+    Pump();
+    return deferred.Promise();
+  }
+
+  // Setters are cheap, but must not touch the pipeline while an operation
+  // is running on the pool; they then run after it, in call order.
+  void Apply(std::function<void()> setter) {
+    if (!opRunning_ && pending_.empty()) {
+      setter();
+      return;
+    }
+    pending_.push_back({OpKind::Setting,
+                        [setter = std::move(setter)](std::string &) {
+                          setter();
+                          return true;
+                        },
+                        std::nullopt});
+  }
+
+  template <typename Match>
+  size_t CancelPending(Napi::Env env, Match match, const char *message) {
+    size_t cancelled = 0;
+    for (auto it = pending_.begin(); it != pending_.end();) {
+      if (!match(it->kind)) {
+        ++it;
+        continue;
+      }
+      Napi::Error error = Napi::Error::New(env, message);
+      error.Set("code", "ECANCELED");
+      it->deferred->Reject(error.Value());
+      it = pending_.erase(it);
+      cancelled++;
+    }
+    return cancelled;
+  }
+
+  // Starts the next queued operation unless one is running. The wrapper is
+  // kept alive while anything is queued or running.
+  void Pump() {
+    if (opRunning_)
+      return;
+    while (!pending_.empty() && pending_.front().kind == OpKind::Setting) {
+      std::string unused;
+      pending_.front().body(unused);
+      pending_.pop_front();
+    }
+    if (pending_.empty()) {
+      if (held_) {
+        held_ = false;
+        Unref();
+      }
+      return;
+    }
+    if (!held_) {
+      held_ = true;
+      Ref();
+    }
+    opRunning_ = true;
+    PendingOp op = std::move(pending_.front());
+    pending_.pop_front();
+    (new OpWorker(*this, std::move(op)))->Queue();
+  }
+
+  void Finished() {
+    opRunning_ = false;
+    if (stats_)
+      stats_->Poke();
+    Pump();
+  }
+
+  // Declared before the pipeline, so they outlive its threads.
+  DeepFrame::TelemetryRing telemetry_;
+  Napi::Reference<Napi::ArrayBuffer> telemetryBuffer_;
+  Pipeline pipeline_;
+  std::shared_ptr<StatsSubscription> stats_;
+  // Touched on the JS thread only.
+  std::deque<PendingOp> pending_;
+  bool opRunning_ = false;
+  bool held_ = false;
 };
 
 Napi::Object Init(Napi::Env env, Napi::Object exports) {
@@ -1,11 +1,39 @@
 
 
+export interface MemoryUsage {
+    cpuMB: number;
+    gpuMB: number;
+}
+
 export interface FrameStats {
     fps: number;
     latencyMs: number;
     framesGenerated: number;
     width: number;
     height: number;
+    sessionCreateMs?: number;
+    coldSessionCreateMs?: number;
+    modelCacheHit?: boolean;
+    skippedTileFraction?: number;
+    sceneCuts?: number;
+    blendFallbacks?: number;
+    // Model frames that replaced the stand-in queued for them in time,
+    // and those that did not; the rates cover the last stats interval.
+    speculativeUpgrades?: number;
+    speculativeMisses?: number;
+    upgradeRate?: number;
+    missRate?: number;
+    duplicateFrames?: number;
+    idle?: boolean;
+    idleEntries?: number;
+    vramUsageMB?: number;
+    memory?: {
+        capture: MemoryUsage;
+        interpolation: MemoryUsage;
+        tensors: MemoryUsage;
+        present: MemoryUsage;
+        export: MemoryUsage;
+    };
 }
 
 export interface FrameGenConfig {
@@ -17,11 +45,49 @@ export interface FrameGenConfig {
     performanceMode?: boolean;
 }
 
+export interface InitializeOptions {
+    // Publish every presented frame to a shared frame ring of this name
+    // (compute/SharedFrameRing.h) for recording and analysis tools. Frame
+    // indices run at twice the capture rate; odd ones are generated frames.
+    sharedFrames?: string;
+}
+
+export interface StatsUpdate {
+    running: boolean;
+    stats: FrameStats;
+}
+
+export interface StatsSubscriptionOptions {
+    // Shortest time between updates, 10-1000 ms; default 50.
+    intervalMs?: number;
+}
+
+// 'extrapolate' shows each captured frame at once and predicts the next
+// one from motion, instead of holding it back to interpolate.
+export type InterpolationMode =
+    'fast' | 'balanced' | 'quality' | 'flow' | 'blend' | 'extrapolate';
+
+// initialize, start, stop and setMode run off the event loop, one at a time
+// in call order. Calls rejected by cancel() or superseded by a later
+// setMode reject with an Error whose code is 'ECANCELED'.
 export class DeepFrame {
     constructor();
-    initialize(): boolean;
-    start(config?: FrameGenConfig): boolean;
-    stop(): boolean;
+    initialize(options?: InitializeOptions): Promise<boolean>;
+    start(config?: FrameGenConfig): Promise<boolean>;
+    stop(): Promise<boolean>;
+    setMode(mode: InterpolationMode): Promise<boolean>;
+    // Rejects queued calls that have not started; returns how many.
+    cancel(): number;
     getStats(): FrameStats | null;
     isRunning(): boolean;
+    // Calls back with the running state and stats whenever either changes,
+    // replacing any earlier subscription. Keeps the process alive until
+    // unsubscribeStats().
+    subscribeStats(callback: (update: StatsUpdate) => void,
+                   options?: StatsSubscriptionOptions): boolean;
+    unsubscribeStats(): void;
+    // The per-frame telemetry ring (layout in compute/TelemetryRing.h),
+    // created on first call and the same buffer after. Read it with
+    // TelemetryReader from ./telemetry.
+    telemetryBuffer(): ArrayBuffer;
 }
\ No newline at end of file
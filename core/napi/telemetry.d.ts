@@ -0,0 +1,29 @@
+export declare const TelemetryFlags: Readonly<{
+    INTERPOLATED: number;
+    MODEL: number;
+    BLEND_FALLBACK: number;
+    DUPLICATE: number;
+    SCENE_CUT: number;
+    PASSTHROUGH: number;
+    PRESENT_DROPPED: number;
+    IDLE: number;
+}>;
+
+export declare class TelemetrySeries {
+    constructor(capacity: number);
+    readonly capacity: number;
+    length: number;
+    readonly frameIndex: Uint32Array;
+    readonly flags: Uint32Array;
+    readonly captureMs: Float64Array;
+    readonly queueMs: Float32Array;
+    readonly inferenceMs: Float32Array;
+    readonly submitMs: Float32Array;
+}
+
+export declare class TelemetryReader {
+    constructor(buffer: ArrayBuffer | SharedArrayBuffer);
+    readonly capacity: number;
+    lost: number;
+    read(series: TelemetrySeries): number;
+}
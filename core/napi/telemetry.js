@@ -0,0 +1,97 @@
+// Reader for the per-frame telemetry ring from DeepFrame#telemetryBuffer().
+// The layout is documented in core/compute/TelemetryRing.h. Reading makes
+// no native calls and, after construction, no allocations: records are
+// copied into a caller-owned TelemetrySeries.
+'use strict';
+
+const MAGIC = 0x4C544644;
+const VERSION = 1;
+const HEADER_BYTES = 64;
+const RECORD_BYTES = 32;
+const HEAD_WORD = 4;
+
+const TelemetryFlags = Object.freeze({
+    INTERPOLATED: 1 << 0,
+    MODEL: 1 << 1,
+    BLEND_FALLBACK: 1 << 2,
+    DUPLICATE: 1 << 3,
+    SCENE_CUT: 1 << 4,
+    PASSTHROUGH: 1 << 5,
+    PRESENT_DROPPED: 1 << 6,
+    IDLE: 1 << 7,
+});
+
+// Struct-of-arrays buffer for up to `capacity` records; `length` is how
+// many the last read() filled.
+class TelemetrySeries {
+    constructor(capacity) {
+        this.capacity = capacity;
+        this.length = 0;
+        this.frameIndex = new Uint32Array(capacity);
+        this.flags = new Uint32Array(capacity);
+        this.captureMs = new Float64Array(capacity);
+        this.queueMs = new Float32Array(capacity);
+        this.inferenceMs = new Float32Array(capacity);
+        this.submitMs = new Float32Array(capacity);
+    }
+}
+
+class TelemetryReader {
+    constructor(buffer) {
+        this.u32 = new Uint32Array(buffer);
+        this.f32 = new Float32Array(buffer);
+        this.f64 = new Float64Array(buffer);
+        if (this.u32[0] !== MAGIC || this.u32[1] !== VERSION ||
+            this.u32[3] !== RECORD_BYTES) {
+            throw new Error('Not a version 1 telemetry ring');
+        }
+        this.capacity = this.u32[2];
+        // Records from before the reader was created are skipped.
+        this.next = Atomics.load(this.u32, HEAD_WORD);
+        // Records the writer overwrote before they were read.
+        this.lost = 0;
+    }
+
+    // Copies records written since the last call into `series`, oldest
+    // first, and returns how many. Whatever does not fit is left for the
+    // next call.
+    read(series) {
+        const { u32, f32, f64, capacity } = this;
+        const head = Atomics.load(u32, HEAD_WORD);
+        let next = this.next;
+        const behind = (head - next) >>> 0;
+        if (behind > capacity) {
+            this.lost += behind - capacity;
+            next = (head - capacity) >>> 0;
+        }
+
+        let count = 0;
+        while (next !== head && count < series.capacity) {
+            const byte = HEADER_BYTES + (next & (capacity - 1)) * RECORD_BYTES;
+            const word = byte >> 2;
+            const seq = (next + 1) >>> 0;
+            next = seq;
+            if (Atomics.load(u32, word) !== seq) {
+                this.lost++;
+                continue;
+            }
+            series.flags[count] = u32[word + 1];
+            series.captureMs[count] = f64[(byte >> 3) + 1];
+            series.queueMs[count] = f32[word + 4];
+            series.inferenceMs[count] = f32[word + 5];
+            series.submitMs[count] = f32[word + 6];
+            series.frameIndex[count] = u32[word + 7];
+            // Rewritten while being copied: the writer lapped this reader.
+            if (Atomics.load(u32, word) !== seq) {
+                this.lost++;
+                continue;
+            }
+            count++;
+        }
+        this.next = next;
+        series.length = count;
+        return count;
+    }
+}
+
+module.exports = { TelemetryReader, TelemetrySeries, TelemetryFlags };
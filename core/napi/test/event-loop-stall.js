@@ -0,0 +1,107 @@
+// Measures how long each pipeline call blocks the event loop. Build the
+// addon against the stub pipeline first (any non-Windows cmake-js build),
+// whose blocking calls sleep for DEEPFRAME_STUB_DELAY_MS:
+//
+//   npx cmake-js compile && node test/event-loop-stall.js
+//
+// Every call must return at once and settle later, with the loop free to
+// run timers in between.
+const assert = require('node:assert');
+const path = require('node:path');
+
+const DELAY_MS = 200;
+// A stall this long would be a frame or more of UI jank.
+const MAX_STALL_MS = 20;
+
+process.env.DEEPFRAME_STUB_DELAY_MS = String(DELAY_MS);
+const nativePath = process.env.DEEPFRAME_NATIVE ||
+    path.join(__dirname, '../build/Release/deepframe_native.node');
+const { DeepFrame } = require(nativePath);
+
+function nowMs() {
+    return Number(process.hrtime.bigint()) / 1e6;
+}
+
+// Longest gap between setImmediate turns while `fn` runs and settles.
+async function measure(name, fn) {
+    let last = nowMs();
+    let maxGap = 0;
+    let ticking = true;
+    const tick = () => {
+        const now = nowMs();
+        maxGap = Math.max(maxGap, now - last);
+        last = now;
+        if (ticking) setImmediate(tick);
+    };
+    setImmediate(tick);
+
+    const begin = nowMs();
+    const pending = fn();
+    const returnedMs = nowMs() - begin;
+    const result = await pending;
+    const settledMs = nowMs() - begin;
+    ticking = false;
+
+    console.log(`${name.padEnd(22)} returned in ${returnedMs.toFixed(2)} ms, ` +
+        `settled in ${settledMs.toFixed(1)} ms, ` +
+        `longest stall ${maxGap.toFixed(2)} ms -> ${result}`);
+    assert.ok(maxGap < MAX_STALL_MS, `${name} stalled the loop ${maxGap} ms`);
+    return { result, settledMs };
+}
+
+async function expectCancelled(promise) {
+    await assert.rejects(promise, (error) => error.code === 'ECANCELED');
+}
+
+async function main() {
+    const df = new DeepFrame();
+
+    const init = await measure('initialize()', () => df.initialize());
+    assert.strictEqual(init.result, true);
+    assert.ok(init.settledMs >= DELAY_MS * 0.9, 'initialize did not reach the pipeline');
+
+    assert.strictEqual((await measure('start()', () => df.start({ showStats: false }))).result, true);
+    assert.strictEqual(df.isRunning(), true);
+    // The stub's setMode resolves false if the session rebuild ran while
+    // its frame thread was inside a simulated inference.
+    assert.strictEqual((await measure('setMode("quality")', () => df.setMode('quality'))).result, true);
+    assert.strictEqual((await measure('setMode("flow")', () => df.setMode('flow'))).result, true);
+    assert.strictEqual((await measure('stop()', () => df.stop())).result, true);
+    assert.strictEqual(df.isRunning(), false);
+
+    // A burst of mode changes builds one session: the queued ones are
+    // superseded, the running one completes.
+    const first = df.setMode('balanced');
+    const second = df.setMode('quality');
+    const third = df.setMode('balanced');
+    await expectCancelled(second);
+    assert.strictEqual(await first, true);
+    assert.strictEqual(await third, true);
+
+    // cancel() drops what has not started and leaves the running call be.
+    const start = df.start();
+    const stop = df.stop();
+    const mode = df.setMode('quality');
+    assert.strictEqual(df.cancel(), 2);
+    await expectCancelled(stop);
+    await expectCancelled(mode);
+    assert.strictEqual(await start, true);
+    assert.strictEqual(df.isRunning(), true);
+
+    // Calls made while another runs are served in order.
+    const order = [];
+    await Promise.all([
+        df.stop().then(() => order.push('stop')),
+        df.start().then(() => order.push('start')),
+        df.stop().then(() => order.push('stop')),
+    ]);
+    assert.deepStrictEqual(order, ['stop', 'start', 'stop']);
+    assert.strictEqual(df.isRunning(), false);
+
+    console.log('ok');
+}
+
+main().catch((error) => {
+    console.error(error);
+    process.exit(1);
+});
@@ -0,0 +1,69 @@
+// Checks the pushed stats stream against the stub pipeline (see
+// event-loop-stall.js for building it): one update per change, promptly
+// after start and stop, and nothing while the stats hold still.
+const assert = require('node:assert');
+const path = require('node:path');
+
+process.env.DEEPFRAME_STUB_DELAY_MS = '50';
+const nativePath = process.env.DEEPFRAME_NATIVE ||
+    path.join(__dirname, '../build/Release/deepframe_native.node');
+const { DeepFrame } = require(nativePath);
+
+const INTERVAL_MS = 40;
+
+function sleep(ms) {
+    return new Promise((resolve) => setTimeout(resolve, ms));
+}
+
+async function main() {
+    const df = new DeepFrame();
+    const updates = [];
+    let waiter = null;
+    df.subscribeStats((update) => {
+        updates.push({ at: performance.now(), ...update });
+        if (waiter) waiter();
+    }, { intervalMs: INTERVAL_MS });
+
+    const nextUpdate = () => new Promise((resolve) => { waiter = resolve; });
+
+    // The first sample is always delivered.
+    await nextUpdate();
+    assert.strictEqual(updates.length, 1);
+    assert.strictEqual(updates[0].running, false);
+
+    await df.initialize();
+    const next = nextUpdate();
+    const startedAt = performance.now();
+    await df.start();
+    await next;
+    const last = updates[updates.length - 1];
+    assert.strictEqual(last.running, true);
+    assert.ok(last.stats.presentFps > 0);
+    console.log(`start -> update in ${(last.at - startedAt).toFixed(1)} ms`);
+    assert.ok(last.at - startedAt < 100, 'running state pushed late');
+
+    // Steady stats: no traffic.
+    const before = updates.length;
+    await sleep(INTERVAL_MS * 10);
+    assert.strictEqual(updates.length, before, 'pushed unchanged stats');
+
+    const stopped = nextUpdate();
+    await df.stop();
+    await stopped;
+    assert.strictEqual(updates[updates.length - 1].running, false);
+
+    df.unsubscribeStats();
+    const after = updates.length;
+    await df.start();
+    await sleep(INTERVAL_MS * 3);
+    assert.strictEqual(updates.length, after, 'delivered after unsubscribe');
+    await df.stop();
+
+    console.log(`${updates.length} updates`);
+    console.log('ok');
+}
+
+main().catch((error) => {
+    console.error(error);
+    process.exit(1);
+});
@@ -0,0 +1,77 @@
+// Reads the telemetry ring while the stub pipeline writes 240 records a
+// second (see event-loop-stall.js for building it): every record arrives
+// once, in order and intact, and a reader that falls behind counts losses.
+const assert = require('node:assert');
+const path = require('node:path');
+const { TelemetryReader, TelemetrySeries, TelemetryFlags } =
+    require('../telemetry');
+
+process.env.DEEPFRAME_STUB_DELAY_MS = '0';
+const nativePath = process.env.DEEPFRAME_NATIVE ||
+    path.join(__dirname, '../build/Release/deepframe_native.node');
+const { DeepFrame } = require(nativePath);
+
+function sleep(ms) {
+    return new Promise((resolve) => setTimeout(resolve, ms));
+}
+
+async function main() {
+    const df = new DeepFrame();
+    const buffer = df.telemetryBuffer();
+    assert.strictEqual(df.telemetryBuffer(), buffer, 'buffer is created once');
+
+    const reader = new TelemetryReader(buffer);
+    const series = new TelemetrySeries(64);
+    await df.initialize();
+    await df.start();
+
+    let expected = 0;
+    let records = 0;
+    let cuts = 0;
+    const readOnce = () => {
+        const n = reader.read(series);
+        for (let i = 0; i < n; i++) {
+            assert.strictEqual(series.frameIndex[i], expected++);
+            assert.ok(series.flags[i] & TelemetryFlags.INTERPOLATED);
+            if (series.flags[i] & TelemetryFlags.SCENE_CUT) cuts++;
+            assert.strictEqual(series.inferenceMs[i],
+                3 + (series.frameIndex[i] % 7) * 0.5);
+        }
+        records += n;
+    };
+
+    // Polled at display rate, as a dashboard would.
+    const begin = performance.now();
+    while (performance.now() - begin < 1000) {
+        readOnce();
+        await sleep(16);
+    }
+    await df.stop();
+    readOnce();
+
+    console.log(`${records} records, ${cuts} scene cuts, ${reader.lost} lost`);
+    assert.ok(records > 150, 'too few records for 240 fps');
+    assert.strictEqual(reader.lost, 0);
+    assert.ok(cuts >= 1);
+
+    // A reader that falls more than a ring behind counts what it missed.
+    const slow = new TelemetryReader(buffer);
+    await df.start();
+    await sleep(5000);
+    await df.stop();
+    const big = new TelemetrySeries(4096);
+    const n = slow.read(big);
+    console.log(`slow reader: ${n} read, ${slow.lost} lost`);
+    assert.strictEqual(n, slow.capacity);
+    assert.ok(slow.lost > 0);
+    for (let i = 1; i < n; i++) {
+        assert.strictEqual(big.frameIndex[i], big.frameIndex[i - 1] + 1);
+    }
+
+    console.log('ok');
+}
+
+main().catch((error) => {
+    console.error(error);
+    process.exit(1);
+});
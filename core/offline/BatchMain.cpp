@@ -0,0 +1,156 @@
+// Pre-renders 2x/4x clips with the live engines for side-by-side QA:
+// reads a Y4M or raw BGRA file, interpolates every pair as fast as the
+// machine allows and writes the result in the output's format (by
+// extension) at the multiplied frame rate.
+//
+//   deepframe_batch --input in.y4m --output out.y4m [--factor 2]
+//                   [--mode fast|balanced|quality|flow|blend|extrapolate]
+//                   [--model interp.onnx] [--search-radius 16]
+//                   [--threads 0] [--decode-threads 1] [--no-scene-cuts]
+//                   [--width W --height H --fps 60]   (raw BGRA input)
+//                   [--share NAME]   (also publish to a shared frame ring)
+
+#include "../compute/Log.h"
+#include "BatchPipeline.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using namespace DeepFrame;
+
+namespace {
+
+void Usage() {
+  fprintf(stderr,
+          "usage: deepframe_batch --input <file> --output <file> "
+          "[--factor 2]\n"
+          "         [--mode fast|balanced|quality|flow|blend|extrapolate]\n"
+          "         [--model <onnx>] [--search-radius 16] [--threads 0]\n"
+          "         [--decode-threads 1] [--no-scene-cuts]\n"
+          "         [--width W --height H --fps 60]\n"
+          "         [--share <shared memory name>]\n"
+          "Files ending in .y4m are YUV4MPEG2, anything else raw BGRA.\n");
+}
+
+bool ParseMode(const std::string &name, InterpolationMode &mode) {
+  if (name == "fast")
+    mode = InterpolationMode::FAST;
+  else if (name == "balanced")
+    mode = InterpolationMode::BALANCED;
+  else if (name == "quality")
+    mode = InterpolationMode::QUALITY;
+  else if (name == "flow")
+    mode = InterpolationMode::OPTICAL_FLOW;
+  else if (name == "blend")
+    mode = InterpolationMode::BLEND;
+  else if (name == "extrapolate")
+    mode = InterpolationMode::EXTRAPOLATE;
+  else
+    return false;
+  return true;
+}
+
+bool ParseUint(const char *text, uint32_t &value) {
+  char *end = nullptr;
+  const unsigned long v = std::strtoul(text, &end, 10);
+  if (end == text || *end || v > 0xffffffffUL)
+    return false;
+  value = static_cast<uint32_t>(v);
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  BatchConfig config;
+  for (int i = 1; i < argc; i++) {
+    const std::string flag = argv[i];
+    if (flag == "--no-scene-cuts") {
+      config.sceneCuts = false;
+      continue;
+    }
+    if (flag == "--help" || flag == "-h") {
+      Usage();
+      return 0;
+    }
+    if (i + 1 >= argc) {
+      fprintf(stderr, "%s needs a value\n", flag.c_str());
+      Usage();
+      return 2;
+    }
+    const char *value = argv[++i];
+    uint32_t radius = 0;
+    bool ok = true;
+    if (flag == "--input")
+      config.input = value;
+    else if (flag == "--output")
+      config.output = value;
+    else if (flag == "--share")
+      config.shareName = value;
+    else if (flag == "--model")
+      config.modelPath = value;
+    else if (flag == "--mode")
+      ok = ParseMode(value, config.mode);
+    else if (flag == "--factor")
+      ok = ParseUint(value, config.factor) && config.factor >= 2;
+    else if (flag == "--threads")
+      ok = ParseUint(value, config.threads);
+    else if (flag == "--decode-threads")
+      ok = ParseUint(value, config.decodeThreads);
+    else if (flag == "--width")
+      ok = ParseUint(value, config.rawWidth);
+    else if (flag == "--height")
+      ok = ParseUint(value, config.rawHeight);
+    else if (flag == "--fps")
+      ok = ParseUint(value, config.rawFpsNum) && config.rawFpsNum > 0;
+    else if (flag == "--search-radius") {
+      ok = ParseUint(value, radius);
+      config.motion.searchRadius = static_cast<int32_t>(radius);
+    } else {
+      ok = false;
+    }
+    if (!ok) {
+      fprintf(stderr, "bad argument: %s %s\n", flag.c_str(), value);
+      Usage();
+      return 2;
+    }
+  }
+  if (config.input.empty() || config.output.empty()) {
+    Usage();
+    return 2;
+  }
+
+  BatchPipeline pipeline;
+  const bool ok = pipeline.Run(config);
+  Log::Flush();
+  const BatchStats &stats = pipeline.GetStats();
+  if (!ok) {
+    fprintf(stderr, "failed after %llu input frames\n",
+            static_cast<unsigned long long>(stats.framesIn));
+    return 1;
+  }
+
+  const double in = static_cast<double>(std::max<uint64_t>(stats.framesIn, 1));
+  const double seconds = stats.wallMs / 1e3;
+  printf("%llu -> %llu frames (%ux) with %s on %u threads in %.2f s\n",
+         static_cast<unsigned long long>(stats.framesIn),
+         static_cast<unsigned long long>(stats.framesOut), config.factor,
+         stats.engine, stats.inferenceThreads, seconds);
+  printf("%.1f output frames/s, %.1f input frames/s\n",
+         static_cast<double>(stats.framesOut) / seconds,
+         static_cast<double>(stats.framesIn) / seconds);
+  printf("%-12s %8.3f ms/input frame, waited %.1f ms for buffers\n",
+         "decode", stats.decodeMs / in, stats.decodeWaitMs);
+  printf("%-12s %8.3f ms/input frame, waited %.1f ms for input\n",
+         "interpolate", stats.inferenceMs / in, stats.inferenceWaitMs);
+  printf("%-12s %llu stalls (%.1f ms), %.1f MB\n", "encode",
+         static_cast<unsigned long long>(stats.encode.stalls),
+         stats.encode.stallMs,
+         static_cast<double>(stats.encode.bytesWritten) / 1e6);
+  printf("%llu scene cuts, %llu duplicate pairs\n",
+         static_cast<unsigned long long>(stats.sceneCuts),
+         static_cast<unsigned long long>(stats.duplicatePairs));
+  return 0;
+}
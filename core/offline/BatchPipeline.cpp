@@ -0,0 +1,438 @@
+#include "BatchPipeline.h"
+#include "../compute/Blend.h"
+#include "../compute/Log.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <string>
+
+namespace DeepFrame {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+uint64_t ElapsedNs(Clock::time_point start) noexcept {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() -
+                                                           start)
+          .count());
+}
+
+bool IsY4m(const fs::path &path) {
+  std::string ext = path.extension().string();
+  std::transform(ext.begin(), ext.end(), ext.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return ext == ".y4m";
+}
+
+} // namespace
+
+BatchPipeline::~BatchPipeline() noexcept { Close(); }
+
+FrameView BatchPipeline::OutputView(size_t step) noexcept {
+  return {outputs_[step], width_, height_, width_ * 4,
+          PixelFormat::BGRA8};
+}
+
+bool BatchPipeline::Emit(const FrameView &frame) noexcept {
+  const uint64_t n = emitted_++;
+  if (shared_.IsOpen())
+    (void)shared_.Write(frame, n, static_cast<int64_t>(n) * outputFrameUs_);
+  return sink_.Write(frame);
+}
+
+bool BatchPipeline::Open() noexcept {
+  const bool opened =
+      IsY4m(config_.input)
+          ? source_.OpenY4m(config_.input)
+          : source_.OpenRaw(config_.input, config_.rawWidth,
+                            config_.rawHeight, config_.rawFpsNum,
+                            config_.rawFpsDen);
+  if (!opened)
+    return false;
+  const VideoFileInfo &info = source_.Info();
+  width_ = info.width;
+  height_ = info.height;
+  if (config_.factor < 2) {
+    Log::Error("[BatchPipeline] Factor %u makes no new frames\n",
+               config_.factor);
+    return false;
+  }
+
+  if (config_.mode == InterpolationMode::BLEND) {
+    engine_ = Engine::Blend;
+    stats_.engine = "blend";
+  } else if (config_.mode == InterpolationMode::OPTICAL_FLOW) {
+    engine_ = Engine::Flow;
+    stats_.engine = "flow";
+  } else if (config_.mode == InterpolationMode::EXTRAPOLATE) {
+    engine_ = Engine::Extrapolate;
+    stats_.engine = "flow extrapolation";
+  } else if (!config_.modelPath.empty()) {
+    engine_ = Engine::Model;
+    stats_.engine = "onnx (CPU)";
+  } else {
+    engine_ = Engine::BlockMatch;
+    stats_.engine = "block matching";
+  }
+
+  // The decode thread and the sink's writer keep a core each.
+  uint32_t threads = config_.threads;
+  if (threads == 0) {
+    const uint32_t cores = std::max(1u, std::thread::hardware_concurrency());
+    threads = cores > 3 ? cores - 2 : 1;
+  }
+  try {
+    if (threads > 1)
+      pool_ = std::make_unique<ThreadPool>(threads);
+    if (config_.decodeThreads > 1)
+      decodePool_ = std::make_unique<ThreadPool>(config_.decodeThreads);
+    blockMatch_ = std::make_unique<BlockMatchInterpolator>(pool_.get());
+    flow_ = std::make_unique<FlowInterpolator>(pool_.get());
+    outputs_.resize(config_.factor - 1);
+  } catch (...) {
+    Log::Error("[BatchPipeline] Out of memory for %ux%u frames\n", width_,
+               height_);
+    return false;
+  }
+  // Y4M input is converted into kFrames decode buffers; BGRA input is
+  // read straight from the mapping.
+  const size_t frameBytes =
+      FrameArena::AlignedSize(static_cast<size_t>(width_) * height_ * 4);
+  const bool raw = source_.Info().format == VideoFileFormat::RawBgra;
+  const size_t buffers = outputs_.size() + (raw ? 0 : kFrames);
+  if (!frameArena_.Reserve(frameBytes * buffers, ArenaPages::Huge)) {
+    Log::Error("[BatchPipeline] Out of memory for %ux%u frames\n", width_,
+               height_);
+    return false;
+  }
+  for (uint8_t *&output : outputs_)
+    output = frameArena_.AllocateArray<uint8_t>(frameBytes);
+  for (size_t i = 0; i < kFrames; i++)
+    (void)free_.Push(raw ? nullptr
+                         : frameArena_.AllocateArray<uint8_t>(frameBytes));
+  blockMatch_->SetParams(config_.motion);
+  flow_->SetParams(config_.motion);
+  stats_.inferenceThreads = pool_ ? pool_->ThreadCount() : 1;
+
+  if (engine_ == Engine::Model) {
+    if (config_.factor & (config_.factor - 1)) {
+      Log::Error("[BatchPipeline] A model only halves; factor %u is not a "
+                 "power of two\n",
+                 config_.factor);
+      return false;
+    }
+    OnnxSessionOptions options;
+    options.gpu = false;
+    options.intraOpThreads = static_cast<int>(stats_.inferenceThreads);
+    if (!session_.Create(config_.modelPath, options)) {
+      Log::Error("[BatchPipeline] Cannot load %s\n",
+                 config_.modelPath.string());
+      return false;
+    }
+    if ((session_.InputWidth() && session_.InputWidth() < width_) ||
+        (session_.InputHeight() && session_.InputHeight() < height_)) {
+      Log::Error("[BatchPipeline] Model input %ux%u is smaller than the "
+                 "%ux%u footage\n",
+                 session_.InputWidth(), session_.InputHeight(), width_,
+                 height_);
+      return false;
+    }
+  }
+
+  const VideoFileFormat format =
+      IsY4m(config_.output) ? VideoFileFormat::Y4M : VideoFileFormat::RawBgra;
+  if (!sink_.Open(config_.output, format, width_, height_,
+                  info.fpsNum * config_.factor, info.fpsDen)) {
+    return false;
+  }
+  outputFrameUs_ = static_cast<int64_t>(
+      1e6 * info.fpsDen / (static_cast<double>(info.fpsNum) * config_.factor));
+  if (!config_.shareName.empty() &&
+      !shared_.Create(config_.shareName, width_, height_)) {
+    Log::Error("[BatchPipeline] Cannot create shared frames %s\n",
+               config_.shareName);
+    return false;
+  }
+  return true;
+}
+
+void BatchPipeline::Close() noexcept {
+  if (decoder_.joinable()) {
+    failed_ = true;
+    Wake();
+    decoder_.join();
+  }
+  (void)sink_.Close();
+  shared_.Close();
+  emitted_ = 0;
+  source_.Close();
+  session_.Destroy();
+  modelPrevSlot_ = -1;
+  predicted_ = false;
+  DecodedFrame frame;
+  while (decoded_.Pop(frame)) {
+  }
+  uint8_t *buffer = nullptr;
+  while (free_.Pop(buffer)) {
+  }
+  outputs_.clear();
+  frameArena_.Release();
+  flow_.reset();
+  blockMatch_.reset();
+  decodePool_.reset();
+  pool_.reset();
+}
+
+bool BatchPipeline::Run(const BatchConfig &config) noexcept {
+  Close();
+  config_ = config;
+  stats_ = {};
+  sceneCuts_.Reset();
+  duplicates_.Reset();
+  decodeDone_ = false;
+  failed_ = false;
+  decodeNs_ = 0;
+  decodeWaitNs_ = 0;
+  inferenceWaitNs_ = 0;
+
+  const auto start = Clock::now();
+  if (!Open()) {
+    Close();
+    return false;
+  }
+  try {
+    decoder_ = std::thread(&BatchPipeline::DecodeThread, this);
+  } catch (...) {
+    Close();
+    return false;
+  }
+
+  bool ok = InferenceStage();
+  if (!ok) {
+    failed_ = true;
+    Wake();
+  }
+  decoder_.join();
+  // Waits for the writer to finish the queue.
+  ok &= sink_.Close();
+  ok &= !failed_;
+
+  stats_.wallMs =
+      std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+  stats_.decodeMs = static_cast<double>(decodeNs_.load()) / 1e6;
+  stats_.decodeWaitMs = static_cast<double>(decodeWaitNs_.load()) / 1e6;
+  stats_.inferenceWaitMs =
+      static_cast<double>(inferenceWaitNs_.load()) / 1e6;
+  stats_.encode = sink_.GetStats();
+  stats_.framesOut = stats_.encode.framesWritten;
+  Close();
+  return ok;
+}
+
+void BatchPipeline::Wake() noexcept {
+  {
+    // Taken so a waiter cannot miss the wake between check and wait.
+    std::lock_guard<std::mutex> lock(mutex_);
+  }
+  wake_.notify_all();
+}
+
+template <typename Ready>
+bool BatchPipeline::WaitUntil(const Ready &ready,
+                              std::atomic<uint64_t> &waitNs) noexcept {
+  if (ready())
+    return !failed_;
+  const auto start = Clock::now();
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    wake_.wait(lock, [&] { return ready() || failed_; });
+  }
+  waitNs += ElapsedNs(start);
+  return !failed_;
+}
+
+void BatchPipeline::DecodeThread() noexcept {
+  const uint64_t count = source_.FrameCount();
+  const bool raw = source_.Info().format == VideoFileFormat::RawBgra;
+  for (uint64_t i = 0; i < count; i++) {
+    uint8_t *buffer = nullptr;
+    if (!WaitUntil([this] { return free_.Count() > 0; }, decodeWaitNs_) ||
+        !free_.Pop(buffer)) {
+      break;
+    }
+
+    const auto start = Clock::now();
+    DecodedFrame frame;
+    frame.index = i;
+    VideoFrame video;
+    bool ok = source_.Read(i, video);
+    if (ok && raw) {
+      // Already BGRA; the mapping stays valid for the whole run.
+      frame.view = video.bgra;
+    } else if (ok) {
+      frame.view = {buffer, width_, height_, width_ * 4, PixelFormat::BGRA8};
+      ok = ok && VideoFrameToBgra(video, frame.view, decodePool_.get());
+    }
+    if (ok && config_.sceneCuts)
+      SceneCutDetector::Thumbnail(frame.view, frame.thumbnail);
+    frame.storage = buffer;
+    decodeNs_ += ElapsedNs(start);
+
+    if (!ok) {
+      Log::Error("[BatchPipeline] Cannot decode frame %llu\n",
+                 static_cast<unsigned long long>(i));
+      failed_ = true;
+      break;
+    }
+    // Never full: there are only kFrames buffers.
+    (void)decoded_.Push(std::move(frame));
+    Wake();
+  }
+  decodeDone_ = true;
+  Wake();
+}
+
+bool BatchPipeline::InferenceStage() noexcept {
+  DecodedFrame prev;
+  bool havePrev = false;
+  for (;;) {
+    if (!WaitUntil([this] { return decoded_.Count() > 0 || decodeDone_; },
+                   inferenceWaitNs_)) {
+      return false;
+    }
+    // Read first: once the decoder is done, an empty ring stays empty.
+    const bool done = decodeDone_;
+    DecodedFrame curr;
+    if (!decoded_.Pop(curr)) {
+      if (done)
+        break;
+      continue;
+    }
+
+    const auto start = Clock::now();
+    const bool extrapolate = engine_ == Engine::Extrapolate;
+    bool ok = true;
+    bool repeat = false;
+    if (havePrev) {
+      // Identical pairs and cuts repeat the new frame, as the live
+      // pipeline does.
+      repeat = duplicates_.IsDuplicate(prev.view, curr.view);
+      if (repeat) {
+        stats_.duplicatePairs++;
+      } else if (config_.sceneCuts &&
+                 sceneCuts_.IsCut(prev.thumbnail, curr.thumbnail)) {
+        stats_.sceneCuts++;
+        blockMatch_->ResetHistory();
+        repeat = true;
+      }
+      // The gap before an extrapolated frame was predicted from the pair
+      // before it, or repeats its first frame, as it would live.
+      if (extrapolate) {
+        for (size_t step = 0; ok && step < outputs_.size(); step++)
+          ok = Emit(predicted_ ? OutputView(step) : prev.view);
+      } else {
+        if (repeat)
+          modelPrevSlot_ = -1;
+        else
+          ok = Generate(prev.view, curr.view);
+        for (size_t step = 0; ok && step < outputs_.size(); step++)
+          ok = Emit(repeat ? curr.view : OutputView(step));
+      }
+    }
+    ok = ok && Emit(curr.view);
+    if (extrapolate) {
+      predicted_ = ok && havePrev && !repeat;
+      ok = ok && (!predicted_ || Generate(prev.view, curr.view));
+    }
+    stats_.inferenceMs +=
+        std::chrono::duration<double, std::milli>(Clock::now() - start)
+            .count();
+    stats_.framesIn++;
+
+    if (havePrev) {
+      (void)free_.Push(prev.storage);
+      Wake();
+    }
+    prev = std::move(curr);
+    havePrev = true;
+    if (!ok) {
+      Log::Error("[BatchPipeline] Frame %llu failed\n",
+                 static_cast<unsigned long long>(prev.index));
+      return false;
+    }
+  }
+  return true;
+}
+
+bool BatchPipeline::Generate(const FrameView &prev,
+                             const FrameView &curr) noexcept {
+  const uint32_t steps = config_.factor;
+  if (engine_ == Engine::Model)
+    return Bisect(prev, curr, 0, steps);
+
+  for (uint32_t k = 1; k < steps; k++) {
+    const float t = static_cast<float>(k) / static_cast<float>(steps);
+    const FrameView out = OutputView(k - 1);
+    bool ok = false;
+    switch (engine_) {
+    case Engine::Blend:
+      ok = BlendFrames(prev, curr, out, t, config_.motion.temporalBlend,
+                       pool_.get());
+      break;
+    case Engine::BlockMatch:
+      // Motion is searched once per pair; later steps only recompensate.
+      ok = k == 1 ? blockMatch_->Interpolate(prev, curr, out, t)
+                  : blockMatch_->Resample(prev, curr, out, t);
+      break;
+    case Engine::Flow:
+      ok = k == 1 ? flow_->Interpolate(prev, curr, out, t)
+                  : flow_->Resample(prev, curr, out, t);
+      break;
+    case Engine::Extrapolate:
+      ok = k == 1 ? flow_->Extrapolate(prev, curr, out, t)
+                  : flow_->ResampleExtrapolation(curr, out, t);
+      break;
+    case Engine::Model:
+      break;
+    }
+    if (!ok)
+      return false;
+  }
+  return true;
+}
+
+bool BatchPipeline::Bisect(const FrameView &prev, const FrameView &curr,
+                           uint32_t lo, uint32_t hi) noexcept {
+  if (hi - lo < 2)
+    return true;
+  const auto frame = [&](uint32_t i) {
+    return i == 0 ? prev : i == config_.factor ? curr : OutputView(i - 1);
+  };
+  const uint32_t mid = (lo + hi) / 2;
+  ThreadPool *pool = pool_.get();
+
+  // At 2x consecutive pairs share a frame, so the input holding the last
+  // pair's second frame is reused as this pair's first.
+  bool ok;
+  if (lo == 0 && hi == config_.factor && modelPrevSlot_ >= 0) {
+    const size_t first = static_cast<size_t>(modelPrevSlot_);
+    ok = session_.SetInput(1 - first, curr, nullptr, pool) &&
+         session_.Run(first);
+    modelPrevSlot_ = static_cast<int>(1 - first);
+  } else {
+    ok = session_.SetInput(0, frame(lo), nullptr, pool) &&
+         session_.SetInput(1, frame(hi), nullptr, pool) && session_.Run(0);
+    modelPrevSlot_ = 1;
+  }
+  ok = ok && session_.GetOutput(frame(mid), pool);
+  // The last run of the recursion is always the one ending at curr.
+  if (!ok)
+    modelPrevSlot_ = -1;
+  return ok && Bisect(prev, curr, lo, mid) && Bisect(prev, curr, mid, hi);
+}
+
+} // namespace DeepFrame
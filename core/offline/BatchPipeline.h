@@ -0,0 +1,160 @@
+#pragma once
+
+#include "../compute/BlockMatchInterpolator.h"
+#include "../compute/FrameArena.h"
+#include "../compute/FlowInterpolator.h"
+#include "../compute/FrameFingerprint.h"
+#include "../compute/InterpolationMode.h"
+#include "../compute/SceneCutDetector.h"
+#include "../compute/SharedFrameRing.h"
+#include "../compute/SpscRing.h"
+#include "../compute/ThreadPool.h"
+#include "../compute/VideoFile.h"
+#include "../inference/OnnxSession.h"
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace DeepFrame {
+
+struct BatchConfig {
+  std::filesystem::path input;
+  std::filesystem::path output;
+  // Headerless BGRA input needs its size and rate; Y4M carries both.
+  uint32_t rawWidth = 0;
+  uint32_t rawHeight = 0;
+  uint32_t rawFpsNum = 60;
+  uint32_t rawFpsDen = 1;
+  // Output frames per input frame; a model only halves, so it needs a
+  // power of two.
+  uint32_t factor = 2;
+  InterpolationMode mode = InterpolationMode::FAST;
+  // Model modes fall back to block matching without one, as live.
+  std::filesystem::path modelPath;
+  MotionParams motion;
+  // Inference pool size, 0 for every core not taken by the other stages.
+  uint32_t threads = 0;
+  // Extra threads for Y4M conversion on the decode stage.
+  uint32_t decodeThreads = 1;
+  bool sceneCuts = true;
+  // Also publishes every output frame to a shared frame ring of this name
+  // for live viewers; empty for none.
+  std::string shareName;
+};
+
+struct BatchStats {
+  uint64_t framesIn = 0;
+  uint64_t framesOut = 0;
+  uint64_t sceneCuts = 0;
+  // Pairs with identical frames, written without running the engine.
+  uint64_t duplicatePairs = 0;
+  double wallMs = 0.0;
+  double decodeMs = 0.0;
+  double inferenceMs = 0.0;
+  // Decode waiting for a free buffer means inference is the bottleneck;
+  // inference waiting for input means decode is.
+  double decodeWaitMs = 0.0;
+  double inferenceWaitMs = 0.0;
+  VideoSinkStats encode;
+  const char *engine = "";
+  uint32_t inferenceThreads = 0;
+};
+
+// The live pipeline's stages run flat out over a file instead of the
+// desktop: a decode thread maps and converts frames and builds their
+// scene thumbnails, the calling thread interpolates, and the sink's writer
+// thread converts and writes. Nothing is paced or dropped for being late.
+class BatchPipeline {
+public:
+  static constexpr size_t kFrames = 6;
+
+  BatchPipeline() noexcept = default;
+  ~BatchPipeline() noexcept;
+
+  BatchPipeline(const BatchPipeline &) = delete;
+  BatchPipeline &operator=(const BatchPipeline &) = delete;
+
+  // Processes the whole input; false on any failure, which is logged.
+  [[nodiscard]] bool Run(const BatchConfig &config) noexcept;
+
+  [[nodiscard]] const BatchStats &GetStats() const noexcept { return stats_; }
+
+private:
+  struct DecodedFrame {
+    uint64_t index = 0;
+    // Points into `storage`, or straight into the mapping for BGRA input.
+    FrameView view;
+    uint8_t *storage = nullptr;
+    SceneThumbnail thumbnail;
+  };
+
+  enum class Engine { Blend, BlockMatch, Flow, Extrapolate, Model };
+
+  [[nodiscard]] bool Open() noexcept;
+  void Close() noexcept;
+  void DecodeThread() noexcept;
+  [[nodiscard]] bool InferenceStage() noexcept;
+  // Fills outputs_ with the frames between `prev` and `curr`; when
+  // extrapolating, with the frames after `curr`.
+  [[nodiscard]] bool Generate(const FrameView &prev,
+                              const FrameView &curr) noexcept;
+  // Model midpoints of frames `lo` and `hi` of prev, outputs_..., curr.
+  [[nodiscard]] bool Bisect(const FrameView &prev, const FrameView &curr,
+                            uint32_t lo, uint32_t hi) noexcept;
+  [[nodiscard]] FrameView OutputView(size_t step) noexcept;
+  // Hands an output frame to the sink and the shared ring, if any.
+  [[nodiscard]] bool Emit(const FrameView &frame) noexcept;
+  // Blocks until `ready` holds or the run fails; adds the wait to `waitNs`.
+  template <typename Ready>
+  [[nodiscard]] bool WaitUntil(const Ready &ready,
+                               std::atomic<uint64_t> &waitNs) noexcept;
+  void Wake() noexcept;
+
+  BatchConfig config_;
+  Engine engine_ = Engine::BlockMatch;
+  VideoFileSource source_;
+  VideoFileSink sink_;
+  SharedFrameWriter shared_;
+  uint64_t emitted_ = 0;
+  int64_t outputFrameUs_ = 0;
+  uint32_t width_ = 0;
+  uint32_t height_ = 0;
+
+  std::unique_ptr<ThreadPool> pool_;
+  std::unique_ptr<ThreadPool> decodePool_;
+  std::unique_ptr<BlockMatchInterpolator> blockMatch_;
+  std::unique_ptr<FlowInterpolator> flow_;
+  OnnxSession session_;
+  // Model input that holds the last pair's second frame, -1 for neither.
+  int modelPrevSlot_ = -1;
+  // Extrapolation: outputs_ holds the frames predicted for the gap after
+  // the last frame emitted.
+  bool predicted_ = false;
+  SceneCutDetector sceneCuts_;
+  DuplicateDetector duplicates_;
+  // Decode buffers and outputs_, carved once per run.
+  FrameArena frameArena_{MemorySubsystem::Interpolation};
+  std::vector<uint8_t *> outputs_;
+
+  // Frames go decode -> inference through decoded_ and their buffers come
+  // back through free_, so at most kFrames are ever allocated.
+  SpscRing<DecodedFrame, kFrames> decoded_;
+  SpscRing<uint8_t *, kFrames> free_;
+  std::thread decoder_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::atomic<bool> decodeDone_{false};
+  std::atomic<bool> failed_{false};
+  std::atomic<uint64_t> decodeNs_{0};
+  std::atomic<uint64_t> decodeWaitNs_{0};
+  std::atomic<uint64_t> inferenceWaitNs_{0};
+
+  BatchStats stats_;
+};
+
+} // namespace DeepFrame
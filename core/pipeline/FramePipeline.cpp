@@ -1,6 +1,10 @@
 
 #include "FramePipeline.h"
+#include "../compute/FrameCrop.h"
+#include "../compute/Log.h"
+#include <algorithm>
 #include <chrono>
+#include <thread>
 
 namespace DeepFrame {
 
@@ -12,7 +16,25 @@ bool FramePipeline::Initialize(const PipelineConfig &config) noexcept {
 
   config_ = config;
 
+  // The stages and the CPU engine's kernels share these workers. Capture
+  // and present spend most of a frame blocked in the driver, so there are
+  // always at least two more.
+  try {
+    scheduler_ = std::make_unique<TaskScheduler>(
+        std::max(4u, std::thread::hardware_concurrency()));
+    captureTask_ = std::make_unique<SerialTask>(
+        *scheduler_, TaskPriority::Normal, [this] { CaptureStep(); });
+    inferenceTask_ = std::make_unique<SerialTask>(
+        *scheduler_, TaskPriority::Normal, [this] { InferenceStep(); });
+    presentTask_ = std::make_unique<SerialTask>(
+        *scheduler_, TaskPriority::High, [this] { PresentStep(); });
+  } catch (...) {
+    ReleaseScheduler();
+    return false;
+  }
+
   if (!capture_.Initialize(0, 0)) {
+    ReleaseScheduler();
     return false;
   }
 
@@ -22,20 +44,39 @@ bool FramePipeline::Initialize(const PipelineConfig &config) noexcept {
 
   if (!presenter_.Initialize(device, capture_.GetContext(), width, height)) {
     capture_.Shutdown();
+    ReleaseScheduler();
     return false;
   }
 
-  if (!captureBuffer_.Initialize(device, width, height) ||
-      !interpolatedBuffer_.Initialize(device, width, height)) {
+  if (!interpolatedBuffer_.Initialize(device, width, height)) {
     presenter_.Shutdown();
     capture_.Shutdown();
+    ReleaseScheduler();
     return false;
   }
 
-  if (!config_.modelPath.empty()) {
+  cpuInterpolator_.SetParams(config_.motion);
+  cpuInterpolator_.SetMode(config_.mode);
+  extrapolate_ = config_.mode == InterpolationMode::EXTRAPOLATE;
+  if (!cpuInterpolator_.Initialize(device, width, height, 0,
+                                   scheduler_.get())) {
+    Log::Warn("[FramePipeline] CPU interpolator unavailable, duplicating "
+              "frames\n");
+  }
+
+  inference_.SetCacheDirectory(config_.modelCacheDir);
+  if (!config_.modelPath.empty() && UsesModel(config_.mode)) {
     inference_.Initialize(device, config_.modelPath, config_.mode);
   }
 
+  // Sized for the whole output; a cropped window publishes smaller frames.
+  if (!config_.sharedFrameName.empty() &&
+      !sharedFrames_.Create(config_.sharedFrameName, width, height)) {
+    Log::Warn("[FramePipeline] Cannot create shared frames %s\n",
+              config_.sharedFrameName);
+  }
+
+  targetWindow_ = config_.targetWindow;
   if (config_.targetWindow) {
     presenter_.SetTargetWindow(config_.targetWindow);
   }
@@ -47,14 +88,34 @@ bool FramePipeline::Initialize(const PipelineConfig &config) noexcept {
 
 void FramePipeline::Shutdown() noexcept {
   Stop();
-  captureBuffer_.Shutdown();
+  // Return queued surfaces to the capture pool before it is torn down.
+  CapturedSurface queued;
+  while (captureQueue_.Pop(queued)) {
+  }
   interpolatedBuffer_.Shutdown();
+  for (ShareReadback &readback : shareReadback_)
+    readback = ShareReadback{};
+  shareHead_ = 0;
+  shareCount_ = 0;
+  shareCharge_.Set(0);
+  interpolatedFrame_.Reset();
+  interpolatedCharge_.Set(0);
+  sharedFrames_.Close();
   inference_.Shutdown();
+  cpuInterpolator_.Shutdown();
   presenter_.Shutdown();
   capture_.Shutdown();
+  ReleaseScheduler();
   initialized_ = false;
 }
 
+void FramePipeline::ReleaseScheduler() noexcept {
+  presentTask_.reset();
+  inferenceTask_.reset();
+  captureTask_.reset();
+  scheduler_.reset();
+}
+
 bool FramePipeline::Start() noexcept {
   if (!initialized_ || running_) {
     return false;
@@ -63,6 +124,19 @@ bool FramePipeline::Start() noexcept {
   running_ = true;
   capturedFrames_ = 0;
   presentedFrames_ = 0;
+  blendFallbacks_ = 0;
+  sceneCuts_ = 0;
+  speculativeUpgrades_ = 0;
+  speculativeMisses_ = 0;
+  lastUpgrades_ = 0;
+  lastMisses_ = 0;
+  duplicateFrames_ = 0;
+  idleEntries_ = 0;
+  idleTracker_.Reset();
+  idle_ = false;
+  carried_.Clear();
+  delivered_ = false;
+  lastStatsTime_ = std::chrono::steady_clock::now();
 
   {
     std::lock_guard<std::mutex> lock(statsMutex_);
@@ -71,9 +145,9 @@ bool FramePipeline::Start() noexcept {
 
   presenter_.Show();
 
-  captureThread_ = std::thread(&FramePipeline::CaptureThread, this);
-  inferenceThread_ = std::thread(&FramePipeline::InferenceThread, this);
-  presentThread_ = std::thread(&FramePipeline::PresentThread, this);
+  // Capture keeps signalling itself; inference and present run when the
+  // stage before hands them something.
+  captureTask_->Signal();
 
   return true;
 }
@@ -83,19 +157,25 @@ void FramePipeline::Stop() noexcept {
     return;
 
   running_ = false;
+  {
+    std::lock_guard<std::mutex> lock(settleMutex_);
+  }
+  settled_.notify_all();
 
-  if (captureThread_.joinable())
-    captureThread_.join();
-  if (inferenceThread_.joinable())
-    inferenceThread_.join();
-  if (presentThread_.joinable())
-    presentThread_.join();
+  // In pipeline order: each stage signals only itself and the next, so
+  // once one is idle nothing can wake it or anything before it.
+  captureTask_->WaitIdle();
+  inferenceTask_->WaitIdle();
+  presentTask_->WaitIdle();
+  inferencePrev_ = CapturedSurface{};
+  inferenceCurr_ = CapturedSurface{};
 
   presenter_.Hide();
 }
 
 void FramePipeline::SetTargetWindow(HWND target) noexcept {
   config_.targetWindow = target;
+  targetWindow_ = target;
   presenter_.SetTargetWindow(target);
 }
 
@@ -104,11 +184,28 @@ void FramePipeline::SetShowStats(bool show) noexcept {
   presenter_.SetShowStats(show);
 }
 
+void FramePipeline::SetTelemetry(TelemetryRing *ring) noexcept {
+  telemetry_.store(ring, std::memory_order_release);
+}
+
+void FramePipeline::SetMotionParams(const MotionParams &params) noexcept {
+  config_.motion = params;
+  cpuInterpolator_.SetParams(params);
+}
+
 bool FramePipeline::SetMode(InterpolationMode mode,
                             const std::wstring &modelPath) noexcept {
   config_.mode = mode;
   config_.modelPath = modelPath;
+  std::lock_guard<std::mutex> lock(engineMutex_);
+  cpuInterpolator_.SetMode(mode);
+  extrapolate_ = mode == InterpolationMode::EXTRAPOLATE;
   if (initialized_) {
+    // Model-free modes run on the CPU engine once the session is gone.
+    if (!UsesModel(mode)) {
+      inference_.Shutdown();
+      return cpuInterpolator_.IsInitialized();
+    }
     return inference_.SetMode(mode, modelPath);
   }
   return true;
@@ -119,114 +216,478 @@ PipelineStats FramePipeline::GetStats() const noexcept {
   return stats_;
 }
 
-void FramePipeline::CaptureThread() noexcept {
-  while (running_) {
-    CapturedFrame frame{};
-    auto result = capture_.AcquireFrame(frame, 10);
+TileRect FramePipeline::TargetCrop() const noexcept {
+  const HWND target = targetWindow_.load();
+  RECT client;
+  POINT origin = {0, 0};
+  if (!target || !IsWindow(target) || !GetClientRect(target, &client) ||
+      !ClientToScreen(target, &origin)) {
+    return {};
+  }
+  const int64_t left =
+      static_cast<int64_t>(origin.x) - capture_.GetOutputLeft();
+  const int64_t top = static_cast<int64_t>(origin.y) - capture_.GetOutputTop();
+  return ClipToOutput(left, top, left + client.right, top + client.bottom,
+                      capture_.GetWidth(), capture_.GetHeight());
+}
 
-    if (result == CaptureResult::Success && frame.texture) {
-      captureBuffer_.Push(capture_.GetContext(), frame.texture.Get(),
-                          frame.timestampQpc);
-      capturedFrames_++;
-    } else if (result == CaptureResult::AccessLost ||
-               result == CaptureResult::DeviceLost) {
+void FramePipeline::NoteContent(bool newContent) noexcept {
+  if (!idleTracker_.Update(newContent, IdleTracker::Clock::now()))
+    return;
+  idle_ = idleTracker_.IsIdle();
+  if (idle_) {
+    idleEntries_ = idleTracker_.Entries();
+    Log::Debug("[FramePipeline] Content static, idling\n");
+  }
+}
+
+void FramePipeline::ShareFrame(ID3D11Texture2D *frame, uint64_t frameIndex,
+                               uint64_t timestampQpc) noexcept {
+  if (!sharedFrames_.IsOpen() || !frame)
+    return;
+  ID3D11DeviceContext *context = capture_.GetContext();
+
+  // Publish finished copies oldest first, so frames go out in order; one
+  // the GPU is still drawing is retried on the next call, along with those
+  // behind it. DO_NOT_WAIT makes a slow GPU cost a shared frame, never a
+  // present.
+  while (shareCount_ > 0) {
+    ShareReadback &oldest = shareReadback_[shareHead_];
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    const HRESULT hr = context->Map(oldest.staging.Get(), 0, D3D11_MAP_READ,
+                                    D3D11_MAP_FLAG_DO_NOT_WAIT, &mapped);
+    if (hr == DXGI_ERROR_WAS_STILL_DRAWING)
       break;
+    if (SUCCEEDED(hr)) {
+      D3D11_TEXTURE2D_DESC desc;
+      oldest.staging->GetDesc(&desc);
+      const FrameView view{static_cast<uint8_t *>(mapped.pData), desc.Width,
+                           desc.Height, mapped.RowPitch, PixelFormat::BGRA8};
+      static const double qpcToUs = [] {
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        return 1e6 / static_cast<double>(frequency.QuadPart);
+      }();
+      (void)sharedFrames_.Write(
+          view, oldest.frameIndex,
+          static_cast<int64_t>(oldest.timestampQpc * qpcToUs));
+      context->Unmap(oldest.staging.Get(), 0);
     }
+    shareHead_ = (shareHead_ + 1) % kShareReadbacks;
+    shareCount_--;
   }
+
+  D3D11_TEXTURE2D_DESC desc;
+  frame->GetDesc(&desc);
+  if (desc.Width > sharedFrames_.Width() ||
+      desc.Height > sharedFrames_.Height()) {
+    return;
+  }
+  // Every copy still in flight: the oldest is given up for this one.
+  if (shareCount_ == kShareReadbacks) {
+    shareHead_ = (shareHead_ + 1) % kShareReadbacks;
+    shareCount_--;
+  }
+  ShareReadback &next =
+      shareReadback_[(shareHead_ + shareCount_) % kShareReadbacks];
+  D3D11_TEXTURE2D_DESC stagingDesc = {};
+  if (next.staging)
+    next.staging->GetDesc(&stagingDesc);
+  if (stagingDesc.Width != desc.Width || stagingDesc.Height != desc.Height) {
+    next.staging.Reset();
+    desc.Usage = D3D11_USAGE_STAGING;
+    desc.BindFlags = 0;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+    desc.MiscFlags = 0;
+    const bool created = SUCCEEDED(
+        capture_.GetDevice()->CreateTexture2D(&desc, nullptr, &next.staging));
+    size_t bytes = 0;
+    for (const ShareReadback &readback : shareReadback_) {
+      if (readback.staging)
+        bytes += static_cast<size_t>(desc.Width) * desc.Height * 4;
+    }
+    shareCharge_.Set(bytes);
+    if (!created)
+      return;
+  }
+  context->CopyResource(next.staging.Get(), frame);
+  next.frameIndex = frameIndex;
+  next.timestampQpc = timestampQpc;
+  shareCount_++;
 }
 
-void FramePipeline::InferenceThread() noexcept {
-  ID3D11Texture2D *prevFrame = nullptr;
-  uint64_t prevTs = 0;
-  ID3D11Texture2D *currFrame = nullptr;
-  uint64_t currTs = 0;
+void FramePipeline::CaptureStep() noexcept {
+  if (!running_)
+    return;
 
-  while (running_) {
-    ID3D11Texture2D *nextFrame = nullptr;
-    uint64_t nextTs = 0;
-    if (captureBuffer_.Pop(&nextFrame, &nextTs)) {
-      if (currFrame) {
-        prevFrame = currFrame;
-        prevTs = currTs;
+  // Only the window being overlaid is copied, so every later stage
+  // scales with its area rather than the desktop's.
+  capture_.SetCrop(TargetCrop());
+  CapturedFrame frame{};
+  // AcquireFrame returns as soon as the desktop changes, so the longer
+  // timeout only cuts the idle polling rate.
+  auto result = capture_.AcquireFrame(frame, idle_ ? 100 : 10);
+
+  if (result == CaptureResult::Success && frame.Texture()) {
+    carried_.Merge(frame.dirty, frame.width, frame.height);
+    // Pointer moves deliver a frame with no changes; the compositor's
+    // metadata already proves it a repeat without reading it back.
+    if (delivered_ && carried_.IsEmpty()) {
+      duplicateFrames_++;
+    } else {
+      CapturedSurface captured;
+      captured.surface = std::move(frame.surface);
+      captured.timestamp = static_cast<uint64_t>(frame.timestampQpc);
+      captured.frameIndex = frame.frameIndex;
+      captured.width = frame.width;
+      captured.height = frame.height;
+      captured.dirty = carried_;
+      // A full queue drops the frame, and its surface with it.
+      if (captureQueue_.Push(std::move(captured))) {
+        carried_.Clear();
+        delivered_ = true;
       }
-      currFrame = nextFrame;
-      currTs = nextTs;
-
-      if (prevFrame && currFrame) {
-        if (!interpolatedFrame_) {
-          D3D11_TEXTURE2D_DESC desc;
-          currFrame->GetDesc(&desc);
-          capture_.GetDevice()->CreateTexture2D(&desc, nullptr,
-                                                &interpolatedFrame_);
-        }
+      capturedFrames_++;
+    }
+  } else if (result == CaptureResult::AccessLost ||
+             result == CaptureResult::DeviceLost) {
+    return;
+  }
+
+  inferenceTask_->Signal();
+  UpdateStats();
+  captureTask_->Signal();
+}
 
-        bool generated = false;
-        if (inference_.IsInitialized()) {
-          generated = inference_.Interpolate(prevFrame, currFrame,
-                                             interpolatedFrame_.Get(), 0.5f);
+void FramePipeline::InferenceStep() noexcept {
+  CapturedSurface &prev = inferencePrev_;
+  CapturedSurface &curr = inferenceCurr_;
+  LARGE_INTEGER qpcFrequency;
+  QueryPerformanceFrequency(&qpcFrequency);
+  const double qpcToMs = 1000.0 / static_cast<double>(qpcFrequency.QuadPart);
+  using Clock = std::chrono::steady_clock;
+  auto msSince = [](Clock::time_point start) {
+    return std::chrono::duration<float, std::milli>(Clock::now() - start)
+        .count();
+  };
+
+  bool popped = false;
+  CapturedSurface next;
+  while (running_ && captureQueue_.Pop(next)) {
+    popped = true;
+    if (curr.surface)
+      prev = std::move(curr);
+    curr = std::move(next);
+
+    TelemetryRing *telemetry = telemetry_.load(std::memory_order_acquire);
+    TelemetryRecord record;
+    if (telemetry) {
+      LARGE_INTEGER now;
+      QueryPerformanceCounter(&now);
+      record.frameIndex = static_cast<uint32_t>(curr.frameIndex);
+      record.captureMs = static_cast<double>(curr.timestamp) * qpcToMs;
+      if (curr.timestamp)
+        record.queueMs = static_cast<float>(
+            static_cast<double>(now.QuadPart -
+                                static_cast<LONGLONG>(curr.timestamp)) *
+            qpcToMs);
+      if (idle_)
+        record.flags |= kTelemetryIdle;
+    }
+    // Nothing to interpolate across a resize of the target window.
+    if (prev.surface &&
+        (prev.width != curr.width || prev.height != curr.height)) {
+      prev = CapturedSurface{};
+    }
+
+    ID3D11Texture2D *prevFrame = prev.surface ? prev.surface->Get() : nullptr;
+    ID3D11Texture2D *currFrame = curr.surface ? curr.surface->Get() : nullptr;
+    const uint64_t prevTs = prev.timestamp;
+    const uint64_t currTs = curr.timestamp;
+    // Lets the interpolators refresh only what changed in the staging
+    // copies they keep from the last pair.
+    const FramePair pair = {prev.frameIndex, curr.frameIndex, &curr.dirty};
+    // Shared frames count at twice the capture rate: capture n is 2n, and
+    // the frame generated before or after it 2n - 1 or 2n + 1.
+    const uint64_t sharedIndex = curr.frameIndex * 2;
+
+    // While SetMode swaps an engine, frames go to the screen as captured.
+    std::unique_lock<std::mutex> engines(engineMutex_, std::try_to_lock);
+    if (prevFrame && currFrame && engines.owns_lock()) {
+      D3D11_TEXTURE2D_DESC desc;
+      currFrame->GetDesc(&desc);
+      D3D11_TEXTURE2D_DESC outDesc = {};
+      if (interpolatedFrame_)
+        interpolatedFrame_->GetDesc(&outDesc);
+      if (desc.Width != outDesc.Width || desc.Height != outDesc.Height) {
+        interpolatedFrame_.Reset();
+        capture_.GetDevice()->CreateTexture2D(&desc, nullptr,
+                                              &interpolatedFrame_);
+        interpolatedCharge_.Set(
+            interpolatedFrame_
+                ? static_cast<size_t>(desc.Width) * desc.Height * 4
+                : 0);
+      }
+
+      // Extrapolation predicts past the current frame, so that frame goes
+      // to the screen before the engine runs instead of after it.
+      const bool extrapolate = extrapolate_.load(std::memory_order_relaxed);
+      bool pushed = true;
+      float submitMs = 0.f;
+      if (extrapolate) {
+        const auto submitStart = Clock::now();
+        pushed = interpolatedBuffer_.Push(capture_.GetContext(), currFrame,
+                                          currTs);
+        presentTask_->Signal();
+        ShareFrame(currFrame, sharedIndex, currTs);
+        submitMs = msSince(submitStart);
+      }
+
+      bool generated = false;
+      bool duplicate = false;
+      // Queued along with the current frame before the engine ran.
+      bool speculated = false;
+      // As judged by the engine whose frame this pair produced; with a
+      // model, the CPU stand-in runs its own detector on the same pair.
+      bool cut = false;
+      const auto inferenceStart = Clock::now();
+      if (extrapolate) {
+        if (cpuInterpolator_.IsInitialized()) {
+          generated = cpuInterpolator_.Extrapolate(
+              prevFrame, currFrame, interpolatedFrame_.Get(), 0.5f, &pair);
+          duplicate = generated && cpuInterpolator_.LastWasDuplicate();
+          cut = generated && cpuInterpolator_.LastWasSceneCut();
+          if (generated && !duplicate) {
+            record.flags |=
+                cut ? kTelemetryPassthrough : kTelemetryInterpolated;
+          }
         }
+      } else if (inference_.IsInitialized() && interpolatedFrame_) {
+        // A cross-fade, or the current frame, goes to present ahead of the
+        // model and is swapped for the model's frame only if that is ready
+        // before present takes it, so the slot is never left empty.
+        const bool blended =
+            cpuInterpolator_.IsInitialized() &&
+            cpuInterpolator_.Blend(prevFrame, currFrame,
+                                   interpolatedFrame_.Get(), 0.5f, &pair);
+        duplicate = blended && cpuInterpolator_.LastWasDuplicate();
+        // Across a cut the CPU engine copies the current frame instead.
+        const bool crossFaded =
+            blended && !cpuInterpolator_.LastWasSceneCut();
+        if (!duplicate) {
+          if (!blended)
+            capture_.GetContext()->CopyResource(interpolatedFrame_.Get(),
+                                                currFrame);
+          const auto submitStart = Clock::now();
+          const uint64_t generatedTs = (prevTs + currTs) / 2;
+          const auto deadline =
+              Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                 std::chrono::duration<float, std::milli>(
+                                     inference_.GetTimeBudgetMs()));
+          RingBuffer<3>::Ticket ticket;
+          const bool queued = interpolatedBuffer_.PushSpeculative(
+              capture_.GetContext(), interpolatedFrame_.Get(), generatedTs,
+              deadline, ticket);
+          pushed = queued && interpolatedBuffer_.Push(capture_.GetContext(),
+                                                      currFrame, currTs);
+          presentTask_->Signal();
+          submitMs = msSince(submitStart);
+
+          // With the ring full present is too far behind for the model's
+          // frame to be shown; it is not run. The stand-in's verdict on a
+          // cut stands unless the model delivers its own.
+          cut = blended && cpuInterpolator_.LastWasSceneCut();
+          if (queued) {
+            const bool modelReady = inference_.Interpolate(
+                prevFrame, currFrame, interpolatedFrame_.Get(), 0.5f, &pair);
+            // On a cut the engine repeats the current frame, which still
+            // beats a cross-fade of two unrelated ones, but is neither an
+            // upgrade nor a miss.
+            const bool modelCut = modelReady && inference_.LastWasSceneCut();
+            if (modelReady)
+              cut = modelCut;
+            const bool upgraded = interpolatedBuffer_.Settle(
+                capture_.GetContext(), ticket,
+                modelReady ? interpolatedFrame_.Get() : nullptr);
+            {
+              std::lock_guard<std::mutex> lock(settleMutex_);
+            }
+            settled_.notify_all();
+            if (modelCut) {
+              record.flags |= kTelemetryPassthrough;
+            } else if (upgraded) {
+              speculativeUpgrades_++;
+              record.flags |= kTelemetryInterpolated | kTelemetryModel;
+            } else {
+              speculativeMisses_++;
+              if (crossFaded) {
+                blendFallbacks_++;
+                record.flags |=
+                    kTelemetryInterpolated | kTelemetryBlendFallback;
+              } else {
+                record.flags |= kTelemetryPassthrough;
+              }
+            }
+            ShareFrame(ticket.texture, sharedIndex - 1, generatedTs);
+          }
+          ShareFrame(currFrame, sharedIndex, currTs);
+          speculated = true;
+        }
+      } else if (cpuInterpolator_.IsInitialized()) {
+        generated = cpuInterpolator_.Interpolate(
+            prevFrame, currFrame, interpolatedFrame_.Get(), 0.5f, &pair);
+        duplicate = generated && cpuInterpolator_.LastWasDuplicate();
+        cut = generated && cpuInterpolator_.LastWasSceneCut();
+        if (generated && !duplicate)
+          record.flags |= cut ? kTelemetryPassthrough : kTelemetryInterpolated;
+      }
+      record.inferenceMs = msSince(inferenceStart);
+      if (cut) {
+        sceneCuts_++;
+        record.flags |= kTelemetrySceneCut;
+      }
+
+      NoteContent(!duplicate);
+      // The previous frame is already on its way to the screen.
+      if (duplicate) {
+        duplicateFrames_++;
+        record.submitMs = submitMs;
+        if (telemetry)
+          telemetry->Write(record);
+        continue;
+      }
 
+      const auto submitStart = Clock::now();
+      if (!speculated) {
         if (!generated && interpolatedFrame_) {
           capture_.GetContext()->CopyResource(interpolatedFrame_.Get(),
                                               currFrame);
           generated = true;
+          record.flags |= kTelemetryPassthrough;
         }
 
+        // A predicted frame is due half an interval after the current one.
+        uint64_t generatedTs = (prevTs + currTs) / 2;
+        if (extrapolate)
+          generatedTs =
+              currTs + (currTs > prevTs ? (currTs - prevTs) / 2 : 0);
         if (generated) {
-          interpolatedBuffer_.Push(capture_.GetContext(),
-                                   interpolatedFrame_.Get(),
-                                   (prevTs + currTs) / 2);
+          pushed &= interpolatedBuffer_.Push(capture_.GetContext(),
+                                             interpolatedFrame_.Get(),
+                                             generatedTs);
+          presentTask_->Signal();
+          ShareFrame(interpolatedFrame_.Get(),
+                     extrapolate ? sharedIndex + 1 : sharedIndex - 1,
+                     generatedTs);
         }
 
-        interpolatedBuffer_.Push(capture_.GetContext(), currFrame, currTs);
-      } else if (currFrame) {
-        interpolatedBuffer_.Push(capture_.GetContext(), currFrame, currTs);
+        if (!extrapolate) {
+          pushed &= interpolatedBuffer_.Push(capture_.GetContext(),
+                                             currFrame, currTs);
+          presentTask_->Signal();
+          ShareFrame(currFrame, sharedIndex, currTs);
+        }
       }
-    } else {
-      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      record.submitMs = submitMs + msSince(submitStart);
+      if (!pushed)
+        record.flags |= kTelemetryPresentDropped;
+    } else if (currFrame) {
+      NoteContent(true);
+      const auto submitStart = Clock::now();
+      if (!interpolatedBuffer_.Push(capture_.GetContext(), currFrame,
+                                    currTs)) {
+        record.flags |= kTelemetryPresentDropped;
+      }
+      presentTask_->Signal();
+      ShareFrame(currFrame, sharedIndex, currTs);
+      record.submitMs = msSince(submitStart);
+      record.flags |= kTelemetryPassthrough;
     }
+    if (telemetry)
+      telemetry->Write(record);
   }
+  // Run by a capture that timed out as well, which is how a stretch of
+  // static content is noticed.
+  if (!popped)
+    NoteContent(false);
 }
 
-void FramePipeline::PresentThread() noexcept {
-  auto lastTime = std::chrono::high_resolution_clock::now();
-  uint64_t frames = 0;
-
+void FramePipeline::PresentStep() noexcept {
+  // Held by reference; the ring may replace the slot's texture when the
+  // target window is resized.
+  ComPtr<ID3D11Texture2D> frame;
+  uint64_t ts = 0;
   while (running_) {
-    ID3D11Texture2D *frame = nullptr;
-    uint64_t ts = 0;
-    if (interpolatedBuffer_.Pop(&frame, &ts)) {
-      int baseFps, visualFps;
-      float latency;
-      {
-        std::lock_guard<std::mutex> lock(statsMutex_);
-        baseFps = static_cast<int>(stats_.captureFps);
-        visualFps = static_cast<int>(stats_.presentFps);
-        latency = stats_.inferenceTimeMs;
-      }
-
-      presenter_.DrawStats(baseFps, visualFps, latency);
-      presenter_.PresentFrame(frame);
-      presentedFrames_++;
-      frames++;
-
-      auto now = std::chrono::high_resolution_clock::now();
-      auto elapsed = std::chrono::duration<double>(now - lastTime).count();
-      if (elapsed >= 1.0) {
-        std::lock_guard<std::mutex> lock(statsMutex_);
-        stats_.captureFps =
-            static_cast<float>(capturedFrames_.exchange(0) / elapsed);
-        stats_.presentFps = static_cast<float>(frames / elapsed);
-        stats_.inferenceTimeMs = inference_.GetStats().lastInferenceMs;
-        frames = 0;
-        lastTime = now;
-      }
-    } else {
-      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    // A stand-in for a model frame is held until the model's frame
+    // replaces it or its deadline passes.
+    RingBuffer<3>::Clock::time_point deadline;
+    if (interpolatedBuffer_.PendingDeadline(deadline)) {
+      std::unique_lock<std::mutex> lock(settleMutex_);
+      settled_.wait_until(lock, deadline, [this] {
+        RingBuffer<3>::Clock::time_point pending;
+        return !running_ || !interpolatedBuffer_.PendingDeadline(pending);
+      });
+    }
+    if (!interpolatedBuffer_.Pop(frame, &ts))
+      break;
+    int baseFps, visualFps;
+    float latency;
+    {
+      std::lock_guard<std::mutex> lock(statsMutex_);
+      baseFps = static_cast<int>(stats_.captureFps);
+      visualFps = static_cast<int>(stats_.presentFps);
+      latency = stats_.inferenceTimeMs;
     }
+
+    presenter_.DrawStats(baseFps, visualFps, latency);
+    presenter_.PresentFrame(frame.Get());
+    presentedFrames_++;
   }
 }
 
-void FramePipeline::WorkerLoop() noexcept {}
+void FramePipeline::UpdateStats() noexcept {
+  // From the capture step, which runs also while idle, so the stats show
+  // the rates dropping to zero.
+  const auto now = std::chrono::steady_clock::now();
+  const double elapsed =
+      std::chrono::duration<double>(now - lastStatsTime_).count();
+  if (elapsed < 1.0)
+    return;
+  std::lock_guard<std::mutex> lock(statsMutex_);
+  stats_.captureFps = static_cast<float>(capturedFrames_.exchange(0) / elapsed);
+  stats_.presentFps =
+      static_cast<float>(presentedFrames_.exchange(0) / elapsed);
+  const InferenceStats &inferenceStats = inference_.GetStats();
+  stats_.inferenceTimeMs =
+      inference_.IsInitialized()
+          ? inferenceStats.lastInferenceMs
+          : cpuInterpolator_.GetStats().lastInferenceMs;
+  stats_.sessionCreateMs = inferenceStats.sessionCreateMs;
+  stats_.coldSessionCreateMs = inferenceStats.coldSessionCreateMs;
+  stats_.modelCacheHit = inferenceStats.modelCacheHit;
+  stats_.skippedTileFraction =
+      inference_.IsInitialized()
+          ? 0.f
+          : cpuInterpolator_.GetStats().skippedTileFraction;
+  stats_.blendFallbacks = blendFallbacks_.load();
+  const uint64_t upgrades = speculativeUpgrades_.load();
+  const uint64_t misses = speculativeMisses_.load();
+  const uint64_t raced = upgrades - lastUpgrades_ + misses - lastMisses_;
+  stats_.speculativeUpgrades = upgrades;
+  stats_.speculativeMisses = misses;
+  stats_.upgradeRate =
+      raced ? static_cast<float>(upgrades - lastUpgrades_) / raced : 0.f;
+  stats_.missRate =
+      raced ? static_cast<float>(misses - lastMisses_) / raced : 0.f;
+  lastUpgrades_ = upgrades;
+  lastMisses_ = misses;
+  stats_.sceneCuts = sceneCuts_.load();
+  stats_.duplicateFrames = duplicateFrames_.load();
+  stats_.idle = idle_.load();
+  stats_.idleEntries = idleEntries_.load();
+  stats_.memory = MemoryLedger::Snapshot();
+  stats_.vramUsageMB = static_cast<size_t>(stats_.memory.GpuTotal() >> 20);
+  lastStatsTime_ = now;
+}
 
 } // namespace DeepFrame
@@ -8,30 +8,34 @@
 #endif
 
 #include "../capture/DxgiCapture.h"
+#include "../compute/IdleTracker.h"
+#include "../compute/SharedFrameRing.h"
+#include "../compute/TaskScheduler.h"
+#include "../compute/TelemetryRing.h"
+#include "../inference/CpuInterpolator.h"
 #include "../inference/OnnxInference.h"
 #include "../present/FramePresenter.h"
+#include "PipelineStats.h"
 #include "RingBuffer.h"
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
 #include <mutex>
 #include <string>
-#include <thread>
 
 namespace DeepFrame {
 
-struct PipelineStats {
-  float captureFps = 0.f;
-  float presentFps = 0.f;
-  float inferenceTimeMs = 0.f;
-  uint64_t droppedFrames = 0;
-  size_t vramUsageMB = 0;
-  float e2eLatencyMs = 0.f;
-};
-
 struct PipelineConfig {
   InterpolationMode mode = InterpolationMode::FAST;
   std::wstring modelPath;
+  std::wstring modelCacheDir;
   bool showStats = true;
   HWND targetWindow = nullptr;
+  MotionParams motion;
+  // Publishes every presented frame to a shared frame ring of this name
+  // for recording and analysis tools; empty for none.
+  std::string sharedFrameName;
 };
 
 class FramePipeline {
@@ -53,6 +57,11 @@ public:
   
   void SetTargetWindow(HWND target) noexcept;
   void SetShowStats(bool show) noexcept;
+  void SetMotionParams(const MotionParams &params) noexcept;
+  // Per-frame records go to `ring` from the inference stage, which is its
+  // only writer; nullptr stops them. The ring must outlive the pipeline's
+  // use of it.
+  void SetTelemetry(TelemetryRing *ring) noexcept;
   [[nodiscard]] bool SetMode(InterpolationMode mode,
                              const std::wstring &modelPath) noexcept;
 
@@ -62,42 +71,115 @@ public:
   [[nodiscard]] bool IsInitialized() const noexcept { return initialized_; }
 
 private:
-  
-  void CaptureThread() noexcept;
-  void InferenceThread() noexcept;
-  void PresentThread() noexcept;
-  void WorkerLoop() noexcept; 
+  // One pass of each stage, run as SerialTasks on scheduler_: capture
+  // polls once and signals itself again, inference drains the capture
+  // queue, present shows what inference pushed.
+  void CaptureStep() noexcept;
+  void InferenceStep() noexcept;
+  void PresentStep() noexcept;
+  void UpdateStats() noexcept;
+  void ReleaseScheduler() noexcept;
+  // Target window's client area in output pixels; empty for the whole
+  // output.
+  [[nodiscard]] TileRect TargetCrop() const noexcept;
+  // Feeds the idle tracker from the inference stage.
+  void NoteContent(bool newContent) noexcept;
+  // Inference stage: reads `frame` back for the shared ring. Copies queue
+  // up to kShareReadbacks deep and are mapped on later calls once the GPU
+  // has finished them, so it is never waited on.
+  void ShareFrame(ID3D11Texture2D *frame, uint64_t frameIndex,
+                  uint64_t timestampQpc) noexcept;
 
   
   DxgiCapture capture_;
   OnnxInference inference_;
+  CpuInterpolator cpuInterpolator_;
+  // Held by the inference stage while it runs the engines and by SetMode
+  // while it replaces them, so a session is never torn down mid-frame.
+  std::mutex engineMutex_;
   FramePresenter presenter_;
 
-  
-  RingBuffer<3> captureBuffer_;      
+  // Captured surfaces are handed over by lease, not copied; the inference
+  // stage keeps its previous and current frame leased while it reads them.
+  struct CapturedSurface {
+    TextureLease surface;
+    uint64_t timestamp = 0;
+    uint64_t frameIndex = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    // Changes since the previous surface in the queue.
+    RectList dirty;
+  };
+  SpscRing<CapturedSurface, 3> captureQueue_;
+  CapturedSurface inferencePrev_;
+  CapturedSurface inferenceCurr_;
+  // Changes of frames the queue had no room for, owed to the next one.
+  RectList carried_;
+  bool delivered_ = false;
   RingBuffer<3> interpolatedBuffer_; 
+  // Present waits here on a model frame's stand-in; the inference stage
+  // notifies once it is settled.
+  std::mutex settleMutex_;
+  std::condition_variable settled_;
 
   
   ComPtr<ID3D11Texture2D> interpolatedFrame_;
-
-  
-  std::thread workerThread_; 
-  std::thread captureThread_;
-  std::thread inferenceThread_;
-  std::thread presentThread_;
+  MemoryCharge interpolatedCharge_{MemorySubsystem::Interpolation,
+                                   MemoryDomain::Gpu};
+
+  SharedFrameWriter sharedFrames_;
+  struct ShareReadback {
+    ComPtr<ID3D11Texture2D> staging;
+    uint64_t frameIndex = 0;
+    uint64_t timestampQpc = 0;
+  };
+  // A generated and a real frame are shared back to back, so a copy can
+  // still be in flight two or three calls later.
+  static constexpr uint32_t kShareReadbacks = 4;
+  ShareReadback shareReadback_[kShareReadbacks];
+  MemoryCharge shareCharge_{MemorySubsystem::Export, MemoryDomain::Gpu};
+  // FIFO of queued copies, oldest at shareHead_.
+  uint32_t shareHead_ = 0;
+  uint32_t shareCount_ = 0;
+
+  std::unique_ptr<TaskScheduler> scheduler_;
+  std::unique_ptr<SerialTask> captureTask_;
+  std::unique_ptr<SerialTask> inferenceTask_;
+  std::unique_ptr<SerialTask> presentTask_;
 
   
   std::atomic<bool> running_{false};
   std::atomic<bool> inferenceReady_{false};
+  // EXTRAPOLATE: the inference stage presents each frame before predicting
+  // the one after it.
+  std::atomic<bool> extrapolate_{false};
   std::atomic<uint64_t> lastInferenceFrame_{0};
+  // Read by the capture stage for every frame.
+  std::atomic<HWND> targetWindow_{nullptr};
+  std::atomic<TelemetryRing *> telemetry_{nullptr};
+
+  // Static content makes capture poll less often; inference and present
+  // only run when a frame comes.
+  IdleTracker idleTracker_;
+  std::atomic<bool> idle_{false};
 
   
   mutable std::mutex statsMutex_;
   PipelineStats stats_;
+  std::chrono::steady_clock::time_point lastStatsTime_;
 
   
   std::atomic<uint64_t> capturedFrames_{0};
   std::atomic<uint64_t> presentedFrames_{0};
+  std::atomic<uint64_t> blendFallbacks_{0};
+  std::atomic<uint64_t> sceneCuts_{0};
+  std::atomic<uint64_t> speculativeUpgrades_{0};
+  std::atomic<uint64_t> speculativeMisses_{0};
+  // Counts at the last stats update, for the rates; capture stage only.
+  uint64_t lastUpgrades_ = 0;
+  uint64_t lastMisses_ = 0;
+  std::atomic<uint64_t> duplicateFrames_{0};
+  std::atomic<uint64_t> idleEntries_{0};
 
   
   PipelineConfig config_;
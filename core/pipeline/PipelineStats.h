@@ -0,0 +1,63 @@
+#pragma once
+
+#include "../compute/MemoryLedger.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace DeepFrame {
+
+struct PipelineStats {
+  float captureFps = 0.f;
+  float presentFps = 0.f;
+  float inferenceTimeMs = 0.f;
+  uint64_t droppedFrames = 0;
+  // GPU side of `memory`.
+  size_t vramUsageMB = 0;
+  float e2eLatencyMs = 0.f;
+  float sessionCreateMs = 0.f;
+  float coldSessionCreateMs = 0.f;
+  bool modelCacheHit = false;
+  float skippedTileFraction = 0.f;
+  uint64_t sceneCuts = 0;
+  uint64_t blendFallbacks = 0;
+  // Model frames raced against a stand-in already queued for present:
+  // those that replaced it in time and those that did not. The rates are
+  // shares of the frames raced since the previous update.
+  uint64_t speculativeUpgrades = 0;
+  uint64_t speculativeMisses = 0;
+  float upgradeRate = 0.f;
+  float missRate = 0.f;
+  // Frames dropped for repeating the previous one, at capture or after
+  // the read-back comparison.
+  uint64_t duplicateFrames = 0;
+  // Content has been static long enough that the threads mostly sleep.
+  bool idle = false;
+  uint64_t idleEntries = 0;
+  // Large buffers held, by owner.
+  MemoryUsage memory;
+};
+
+[[nodiscard]] inline bool operator==(const PipelineStats &a,
+                                     const PipelineStats &b) noexcept {
+  return a.captureFps == b.captureFps && a.presentFps == b.presentFps &&
+         a.inferenceTimeMs == b.inferenceTimeMs &&
+         a.droppedFrames == b.droppedFrames &&
+         a.vramUsageMB == b.vramUsageMB && a.e2eLatencyMs == b.e2eLatencyMs &&
+         a.sessionCreateMs == b.sessionCreateMs &&
+         a.coldSessionCreateMs == b.coldSessionCreateMs &&
+         a.modelCacheHit == b.modelCacheHit &&
+         a.skippedTileFraction == b.skippedTileFraction &&
+         a.sceneCuts == b.sceneCuts && a.blendFallbacks == b.blendFallbacks &&
+         a.speculativeUpgrades == b.speculativeUpgrades &&
+         a.speculativeMisses == b.speculativeMisses &&
+         a.upgradeRate == b.upgradeRate && a.missRate == b.missRate &&
+         a.duplicateFrames == b.duplicateFrames && a.idle == b.idle &&
+         a.idleEntries == b.idleEntries && a.memory == b.memory;
+}
+
+[[nodiscard]] inline bool operator!=(const PipelineStats &a,
+                                     const PipelineStats &b) noexcept {
+  return !(a == b);
+}
+
+} // namespace DeepFrame
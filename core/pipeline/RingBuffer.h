@@ -7,9 +7,13 @@
 #define WIN32_LEAN_AND_MEAN
 #endif
 
+#include "../compute/MemoryLedger.h"
+#include "../compute/SpscRing.h"
 #include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <d3d11.h>
+#include <thread>
 #include <wrl/client.h>
 
 
@@ -21,10 +25,24 @@ using Microsoft::WRL::ComPtr;
 
 template <size_t SIZE = 3> class RingBuffer {
 public:
+  using Clock = std::chrono::steady_clock;
+
   struct Slot {
     ComPtr<ID3D11Texture2D> texture;
     uint64_t timestamp = 0;
     bool valid = false;
+    // Push sequence in the upper bits, kFinal/kSpeculative/kUpgrading in
+    // the low two, so a Settle for an earlier push of the slot fails.
+    std::atomic<uint64_t> state{0};
+    Clock::time_point deadline;
+  };
+
+  // A speculative push, for Settle.
+  struct Ticket {
+    size_t slot = SIZE;
+    uint64_t sequence = 0;
+    // The slot's texture; valid until the producer's next push.
+    ID3D11Texture2D *texture = nullptr;
   };
 
   RingBuffer() = default;
@@ -37,28 +55,18 @@ public:
     device_ = device;
     width_ = width;
     height_ = height;
-
-    D3D11_TEXTURE2D_DESC desc = {};
-    desc.Width = width;
-    desc.Height = height;
-    desc.MipLevels = 1;
-    desc.ArraySize = 1;
-    desc.Format = format;
-    desc.SampleDesc.Count = 1;
-    desc.Usage = D3D11_USAGE_DEFAULT;
-    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET;
+    format_ = format;
 
     for (size_t i = 0; i < SIZE; i++) {
-      if (FAILED(device->CreateTexture2D(&desc, nullptr, &slots_[i].texture))) {
+      if (!CreateSlot(width, height, slots_[i].texture)) {
         return false;
       }
       slots_[i].valid = false;
       slots_[i].timestamp = 0;
     }
+    UpdateCharge();
 
-    writeIndex_ = 0;
-    readIndex_ = 0;
-    count_ = 0;
+    cursor_.Reset();
     return true;
   }
 
@@ -67,88 +75,196 @@ public:
       slots_[i].texture.Reset();
       slots_[i].valid = false;
     }
+    charge_.Set(0);
   }
 
   
   
   [[nodiscard]] bool Push(ID3D11DeviceContext *context, ID3D11Texture2D *frame,
                           uint64_t timestamp) noexcept {
-    if (IsFull()) {
-      return false; 
-    }
-
-    size_t idx = writeIndex_.load(std::memory_order_relaxed);
+    return PushSlot(context, frame, timestamp, kFinal, Clock::time_point{},
+                    nullptr);
+  }
 
-    
-    context->CopyResource(slots_[idx].texture.Get(), frame);
-    slots_[idx].timestamp = timestamp;
-    slots_[idx].valid = true;
+  // Queues a stand-in that Settle may still replace with a better frame.
+  // The consumer should hold off popping it until `deadline` or until it
+  // is settled; see PendingDeadline.
+  [[nodiscard]] bool PushSpeculative(ID3D11DeviceContext *context,
+                                     ID3D11Texture2D *frame,
+                                     uint64_t timestamp,
+                                     Clock::time_point deadline,
+                                     Ticket &ticket) noexcept {
+    return PushSlot(context, frame, timestamp, kSpeculative, deadline,
+                    &ticket);
+  }
 
-    
-    writeIndex_.store((idx + 1) % SIZE, std::memory_order_release);
-    count_.fetch_add(1, std::memory_order_release);
+  // Producer side: ends the speculation on `ticket`, copying `frame` over
+  // the stand-in if the consumer has not taken it yet. Returns whether
+  // `frame` made it in; with no frame the stand-in is released as is.
+  [[nodiscard]] bool Settle(ID3D11DeviceContext *context,
+                            const Ticket &ticket,
+                            ID3D11Texture2D *frame) noexcept {
+    if (ticket.slot == SIZE)
+      return false;
+    Slot &slot = slots_[ticket.slot];
+    uint64_t expected = (ticket.sequence << 2) | kSpeculative;
+    if (!slot.state.compare_exchange_strong(
+            expected, (ticket.sequence << 2) | kUpgrading,
+            std::memory_order_acq_rel)) {
+      return false;
+    }
+    bool upgraded = false;
+    if (frame) {
+      D3D11_TEXTURE2D_DESC frameDesc, slotDesc;
+      frame->GetDesc(&frameDesc);
+      slot.texture->GetDesc(&slotDesc);
+      if (frameDesc.Width == slotDesc.Width &&
+          frameDesc.Height == slotDesc.Height) {
+        context->CopyResource(slot.texture.Get(), frame);
+        upgraded = true;
+      }
+    }
+    slot.state.store((ticket.sequence << 2) | kFinal,
+                     std::memory_order_release);
+    return upgraded;
+  }
 
+  // Consumer side: when the oldest frame is an unsettled stand-in, the
+  // time after which it is popped as is.
+  [[nodiscard]] bool PendingDeadline(Clock::time_point &deadline) noexcept {
+    const size_t idx = cursor_.BeginPop();
+    if (idx == SIZE ||
+        (slots_[idx].state.load(std::memory_order_acquire) & 3) == kFinal) {
+      return false;
+    }
+    deadline = slots_[idx].deadline;
     return true;
   }
 
-  
-  
-  [[nodiscard]] bool Pop(ID3D11Texture2D **outFrame,
+  // Takes the oldest frame, a stand-in included; a Settle already copying
+  // over it is waited for, and any later one fails.
+  [[nodiscard]] bool Pop(ComPtr<ID3D11Texture2D> &outFrame,
                          uint64_t *outTimestamp) noexcept {
-    if (IsEmpty()) {
+    const size_t idx = cursor_.BeginPop();
+    if (idx == SIZE || !slots_[idx].valid) {
       return false;
     }
-
-    size_t idx = readIndex_.load(std::memory_order_relaxed);
-
-    if (!slots_[idx].valid) {
-      return false;
+    std::atomic<uint64_t> &state = slots_[idx].state;
+    uint64_t current = state.load(std::memory_order_acquire);
+    for (;;) {
+      if ((current & 3) == kUpgrading) {
+        std::this_thread::yield();
+        current = state.load(std::memory_order_acquire);
+      } else if (state.compare_exchange_weak(current, current & ~uint64_t(3),
+                                             std::memory_order_acq_rel)) {
+        break;
+      }
     }
 
-    *outFrame = slots_[idx].texture.Get();
+    outFrame = slots_[idx].texture;
     *outTimestamp = slots_[idx].timestamp;
     slots_[idx].valid = false;
-
-    
-    readIndex_.store((idx + 1) % SIZE, std::memory_order_release);
-    count_.fetch_sub(1, std::memory_order_release);
-
+    cursor_.CommitPop();
     return true;
   }
 
   
   [[nodiscard]] ID3D11Texture2D *PeekLatest() noexcept {
-    if (IsEmpty())
-      return nullptr;
-
-    
-    size_t idx =
-        (writeIndex_.load(std::memory_order_acquire) + SIZE - 1) % SIZE;
-    return slots_[idx].valid ? slots_[idx].texture.Get() : nullptr;
+    const size_t idx = cursor_.Latest();
+    return idx != SIZE && slots_[idx].valid ? slots_[idx].texture.Get()
+                                            : nullptr;
   }
 
   [[nodiscard]] bool IsFull() const noexcept {
-    return count_.load(std::memory_order_acquire) >= SIZE;
+    return cursor_.Count() >= SIZE;
   }
 
-  [[nodiscard]] bool IsEmpty() const noexcept {
-    return count_.load(std::memory_order_acquire) == 0;
+  [[nodiscard]] bool IsEmpty() const noexcept { return cursor_.Count() == 0; }
+
+  [[nodiscard]] size_t Count() const noexcept { return cursor_.Count(); }
+
+private:
+  enum : uint64_t { kFinal = 0, kSpeculative = 1, kUpgrading = 2 };
+
+  [[nodiscard]] bool PushSlot(ID3D11DeviceContext *context,
+                              ID3D11Texture2D *frame, uint64_t timestamp,
+                              uint64_t state, Clock::time_point deadline,
+                              Ticket *ticket) noexcept {
+    const size_t idx = cursor_.BeginPush();
+    if (idx == SIZE) {
+      return false; 
+    }
+
+    // Frames follow the target window; the producer owns the slot until
+    // the commit, and a consumer still holding the old texture keeps its
+    // own reference.
+    D3D11_TEXTURE2D_DESC frameDesc;
+    frame->GetDesc(&frameDesc);
+    D3D11_TEXTURE2D_DESC slotDesc = {};
+    if (slots_[idx].texture)
+      slots_[idx].texture->GetDesc(&slotDesc);
+    if (frameDesc.Width != slotDesc.Width ||
+        frameDesc.Height != slotDesc.Height) {
+      slots_[idx].texture.Reset();
+      const bool created =
+          CreateSlot(frameDesc.Width, frameDesc.Height, slots_[idx].texture);
+      UpdateCharge();
+      if (!created)
+        return false;
+    }
+
+    context->CopyResource(slots_[idx].texture.Get(), frame);
+    const uint64_t sequence = ++sequence_;
+    slots_[idx].timestamp = timestamp;
+    slots_[idx].valid = true;
+    slots_[idx].deadline = deadline;
+    slots_[idx].state.store((sequence << 2) | state,
+                            std::memory_order_relaxed);
+    if (ticket)
+      *ticket = {idx, sequence, slots_[idx].texture.Get()};
+    cursor_.CommitPush();
+    return true;
   }
 
-  [[nodiscard]] size_t Count() const noexcept {
-    return count_.load(std::memory_order_acquire);
+  [[nodiscard]] bool CreateSlot(uint32_t width, uint32_t height,
+                                ComPtr<ID3D11Texture2D> &texture) noexcept {
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = width;
+    desc.Height = height;
+    desc.MipLevels = 1;
+    desc.ArraySize = 1;
+    desc.Format = format_;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET;
+    return SUCCEEDED(device_->CreateTexture2D(&desc, nullptr, &texture));
+  }
+
+  // Slots are resized one at a time, so sizes can differ for a while.
+  // Every format the pipeline uses is 4 bytes per pixel.
+  void UpdateCharge() noexcept {
+    size_t bytes = 0;
+    for (const Slot &slot : slots_) {
+      if (!slot.texture)
+        continue;
+      D3D11_TEXTURE2D_DESC desc;
+      slot.texture->GetDesc(&desc);
+      bytes += static_cast<size_t>(desc.Width) * desc.Height * 4;
+    }
+    charge_.Set(bytes);
   }
 
-private:
   Slot slots_[SIZE];
   ID3D11Device *device_ = nullptr;
+  // Producer only.
+  uint64_t sequence_ = 0;
 
-  std::atomic<size_t> writeIndex_{0};
-  std::atomic<size_t> readIndex_{0};
-  std::atomic<size_t> count_{0};
+  RingCursor<SIZE> cursor_;
 
   uint32_t width_ = 0;
   uint32_t height_ = 0;
+  DXGI_FORMAT format_ = DXGI_FORMAT_B8G8R8A8_UNORM;
+  MemoryCharge charge_{MemorySubsystem::Present, MemoryDomain::Gpu};
 };
 
 } 
\ No newline at end of file
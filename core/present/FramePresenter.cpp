@@ -1,7 +1,9 @@
 
 
 #include "FramePresenter.h"
+#include "../compute/Log.h"
 #include <string>
+#include <utility>
 
 #pragma comment(lib, "d2d1.lib")
 #pragma comment(lib, "dwrite.lib")
@@ -36,7 +38,7 @@ bool FramePresenter::Initialize(ID3D11Device *device,
   if (initialized_)
     return true;
 
-  printf("[FramePresenter] Initialize: %ux%u\n", width, height);
+  Log::Info("[FramePresenter] Initialize: %ux%u\n", width, height);
 
   device_ = device;
   context_ = context;
@@ -46,38 +48,32 @@ bool FramePresenter::Initialize(ID3D11Device *device,
   g_presenterInstance = this;
 
   if (!CreateOverlayWindow()) {
-    printf("[FramePresenter] CreateOverlayWindow FAILED\n");
+    Log::Error("[FramePresenter] CreateOverlayWindow FAILED\n");
     return false;
   }
-  printf("[FramePresenter] CreateOverlayWindow OK, hwnd=%p\n", overlayWindow_);
+  Log::Info("[FramePresenter] CreateOverlayWindow OK, hwnd=%p\n",
+            overlayWindow_);
 
   if (!CreateSwapChain()) {
-    printf("[FramePresenter] CreateSwapChain FAILED\n");
+    Log::Error("[FramePresenter] CreateSwapChain FAILED\n");
     Shutdown();
     return false;
   }
-  printf("[FramePresenter] CreateSwapChain OK\n");
+  Log::Info("[FramePresenter] CreateSwapChain OK\n");
 
   if (!CreateD2DResources()) {
-    printf("[FramePresenter] CreateD2DResources FAILED\n");
+    Log::Error("[FramePresenter] CreateD2DResources FAILED\n");
     Shutdown();
     return false;
   }
-  printf("[FramePresenter] CreateD2DResources OK\n");
+  Log::Info("[FramePresenter] CreateD2DResources OK\n");
 
   initialized_ = true;
-  printf("[FramePresenter] Initialized successfully\n");
+  Log::Info("[FramePresenter] Initialized successfully\n");
   return true;
 }
 
 void FramePresenter::Shutdown() noexcept {
-  if (overlayWindow_) {
-    DestroyWindow(overlayWindow_);
-    overlayWindow_ = nullptr;
-  }
-
-  UnregisterClassW(OVERLAY_CLASS_NAME, hInstance_);
-
   whiteBrush_.Reset();
   blackBrush_.Reset();
   textFormat_.Reset();
@@ -88,11 +84,40 @@ void FramePresenter::Shutdown() noexcept {
   backBuffer_.Reset();
   swapChain_.Reset();
 
+  // The window thread destroys the window on its way out.
+  if (windowThread_.joinable()) {
+    PostThreadMessageW(windowThreadId_, WM_QUIT, 0, 0);
+    windowThread_.join();
+  }
+  overlayWindow_ = nullptr;
+  visible_ = false;
+
   initialized_ = false;
   g_presenterInstance = nullptr;
 }
 
 bool FramePresenter::CreateOverlayWindow() noexcept {
+  // The window gets a thread of its own that pumps its messages, so it
+  // does not depend on whichever thread initialized the presenter running
+  // a message loop; the present stage moves and shows it cross-thread.
+  std::promise<HWND> created;
+  std::future<HWND> window = created.get_future();
+  try {
+    windowThread_ =
+        std::thread(&FramePresenter::WindowThread, this, std::move(created));
+  } catch (...) {
+    return false;
+  }
+
+  overlayWindow_ = window.get();
+  if (!overlayWindow_) {
+    windowThread_.join();
+    return false;
+  }
+  return true;
+}
+
+void FramePresenter::WindowThread(std::promise<HWND> created) noexcept {
   WNDCLASSEXW wc = {};
   wc.cbSize = sizeof(wc);
   wc.style = CS_HREDRAW | CS_VREDRAW;
@@ -104,42 +129,50 @@ bool FramePresenter::CreateOverlayWindow() noexcept {
   if (!RegisterClassExW(&wc)) {
     DWORD err = GetLastError();
     if (err != ERROR_CLASS_ALREADY_EXISTS) {
-      return false;
+      created.set_value(nullptr);
+      return;
     }
   }
 
   
-  overlayWindow_ = CreateWindowExW(
+  HWND hwnd = CreateWindowExW(
       WS_EX_LAYERED | WS_EX_TRANSPARENT | WS_EX_TOPMOST | WS_EX_NOACTIVATE,
       OVERLAY_CLASS_NAME, L"Deep Frame Overlay", WS_POPUP, 0, 0, width_,
       height_, nullptr, nullptr, hInstance_, nullptr);
 
-  if (!overlayWindow_) {
-    return false;
+  if (hwnd) {
+    SetLayeredWindowAttributes(hwnd, 0, 255, LWA_ALPHA);
   }
 
-  
-  SetLayeredWindowAttributes(overlayWindow_, 0, 255, LWA_ALPHA);
-
-  return true;
+  windowThreadId_ = GetCurrentThreadId();
+  created.set_value(hwnd);
+  if (hwnd) {
+    MSG msg;
+    while (GetMessageW(&msg, nullptr, 0, 0) > 0) {
+      TranslateMessage(&msg);
+      DispatchMessageW(&msg);
+    }
+    DestroyWindow(hwnd);
+  }
+  UnregisterClassW(OVERLAY_CLASS_NAME, hInstance_);
 }
 
 bool FramePresenter::CreateSwapChain() noexcept {
   ComPtr<IDXGIDevice> dxgiDevice;
   if (FAILED(device_->QueryInterface(IID_PPV_ARGS(&dxgiDevice)))) {
-    printf("[FramePresenter] QueryInterface for IDXGIDevice failed\n");
+    Log::Error("[FramePresenter] QueryInterface for IDXGIDevice failed\n");
     return false;
   }
 
   ComPtr<IDXGIAdapter> adapter;
   if (FAILED(dxgiDevice->GetAdapter(&adapter))) {
-    printf("[FramePresenter] GetAdapter failed\n");
+    Log::Error("[FramePresenter] GetAdapter failed\n");
     return false;
   }
 
   ComPtr<IDXGIFactory2> factory;
   if (FAILED(adapter->GetParent(IID_PPV_ARGS(&factory)))) {
-    printf("[FramePresenter] GetParent for IDXGIFactory2 failed\n");
+    Log::Error("[FramePresenter] GetParent for IDXGIFactory2 failed\n");
     return false;
   }
 
@@ -160,14 +193,14 @@ bool FramePresenter::CreateSwapChain() noexcept {
   HRESULT hr = factory->CreateSwapChainForHwnd(device_, overlayWindow_, &desc,
                                                nullptr, nullptr, &swapChain_);
   if (FAILED(hr)) {
-    printf("[FramePresenter] CreateSwapChainForHwnd failed: 0x%lx\n", hr);
+    Log::Error("[FramePresenter] CreateSwapChainForHwnd failed: 0x%lx\n", hr);
     return false;
   }
 
   
   hr = swapChain_->GetBuffer(0, IID_PPV_ARGS(&backBuffer_));
   if (FAILED(hr)) {
-    printf("[FramePresenter] GetBuffer failed: 0x%lx\n", hr);
+    Log::Error("[FramePresenter] GetBuffer failed: 0x%lx\n", hr);
     return false;
   }
 
@@ -175,13 +208,47 @@ bool FramePresenter::CreateSwapChain() noexcept {
   hr = device_->CreateRenderTargetView(backBuffer_.Get(), nullptr,
                                        &renderTargetView_);
   if (FAILED(hr)) {
-    printf("[FramePresenter] CreateRenderTargetView failed: 0x%lx\n", hr);
+    Log::Error("[FramePresenter] CreateRenderTargetView failed: 0x%lx\n", hr);
     return false;
   }
 
   return true;
 }
 
+bool FramePresenter::Resize(uint32_t width, uint32_t height) noexcept {
+  // ResizeBuffers fails while anything still references the old buffers.
+  whiteBrush_.Reset();
+  blackBrush_.Reset();
+  d2dTarget_.Reset();
+  renderTargetView_.Reset();
+  backBuffer_.Reset();
+
+  HRESULT hr =
+      swapChain_->ResizeBuffers(0, width, height, DXGI_FORMAT_UNKNOWN, 0);
+  if (FAILED(hr)) {
+    Log::Error("[FramePresenter] ResizeBuffers(%ux%u) failed: 0x%lx\n",
+               width, height, hr);
+    width_ = 0;
+    height_ = 0;
+    return false;
+  }
+
+  hr = swapChain_->GetBuffer(0, IID_PPV_ARGS(&backBuffer_));
+  if (FAILED(hr) || FAILED(device_->CreateRenderTargetView(
+                        backBuffer_.Get(), nullptr, &renderTargetView_))) {
+    Log::Error("[FramePresenter] Back buffer views failed after resize\n");
+    width_ = 0;
+    height_ = 0;
+    return false;
+  }
+  width_ = width;
+  height_ = height;
+  // The stats overlay is optional; frames still present without it.
+  if (!CreateD2DTarget())
+    Log::Warn("[FramePresenter] Stats overlay unavailable after resize\n");
+  return true;
+}
+
 bool FramePresenter::CreateD2DResources() noexcept {
   
   if (FAILED(D2D1CreateFactory(D2D1_FACTORY_TYPE_SINGLE_THREADED,
@@ -204,7 +271,10 @@ bool FramePresenter::CreateD2DResources() noexcept {
     return false;
   }
 
-  
+  return CreateD2DTarget();
+}
+
+bool FramePresenter::CreateD2DTarget() noexcept {
   ComPtr<IDXGISurface> surface;
   if (FAILED(swapChain_->GetBuffer(0, IID_PPV_ARGS(&surface)))) {
     return false;
@@ -258,43 +328,53 @@ void FramePresenter::UpdatePosition() noexcept {
   if (!overlayWindow_)
     return;
 
-  if (targetWindow_) {
-    RECT rect;
-    if (GetWindowRect(targetWindow_, &rect)) {
-      SetWindowPos(overlayWindow_, HWND_TOPMOST, rect.left, rect.top,
-                   rect.right - rect.left, rect.bottom - rect.top,
-                   SWP_NOACTIVATE);
-    }
-  } else {
-    
-    int screenWidth = GetSystemMetrics(SM_CXSCREEN);
-    int screenHeight = GetSystemMetrics(SM_CYSCREEN);
-    SetWindowPos(overlayWindow_, HWND_TOPMOST, 0, 0, screenWidth, screenHeight,
-                 SWP_NOACTIVATE);
+  // The same rect the capture is cropped to, so frames land 1:1.
+  const RECT screen = {0, 0, GetSystemMetrics(SM_CXSCREEN),
+                       GetSystemMetrics(SM_CYSCREEN)};
+  RECT rect = screen;
+  RECT client;
+  POINT origin = {0, 0};
+  if (targetWindow_ && IsWindow(targetWindow_) &&
+      GetClientRect(targetWindow_, &client) &&
+      ClientToScreen(targetWindow_, &origin)) {
+    OffsetRect(&client, origin.x, origin.y);
+    if (!IntersectRect(&rect, &client, &screen))
+      rect = screen;
   }
+  SetWindowPos(overlayWindow_, HWND_TOPMOST, rect.left, rect.top,
+               rect.right - rect.left, rect.bottom - rect.top,
+               SWP_NOACTIVATE);
 }
 
 void FramePresenter::PresentFrame(ID3D11Texture2D *frame) noexcept {
   static int presentCount = 0;
+  static Log::RateLimiter notReadyLog(1000);
 
   if (!initialized_ || !swapChain_ || !frame) {
-    if (presentCount == 0) {
-      printf("[FramePresenter] PresentFrame called but not ready: init=%d, "
-             "swapChain=%p, frame=%p\n",
-             initialized_, swapChain_.Get(), frame);
-    }
+    notReadyLog.Write(LogLevel::Warn,
+                      "[FramePresenter] PresentFrame called but not ready: "
+                      "init=%d, swapChain=%p, frame=%p\n",
+                      initialized_, swapChain_.Get(), frame);
     return;
   }
 
   
   if (!visible_) {
-    printf("[FramePresenter] Showing overlay window\n");
+    Log::Info("[FramePresenter] Showing overlay window\n");
     Show();
   }
 
   
   UpdatePosition();
 
+  // Frames follow the target window's client area.
+  D3D11_TEXTURE2D_DESC desc;
+  frame->GetDesc(&desc);
+  if ((desc.Width != width_ || desc.Height != height_) &&
+      !Resize(desc.Width, desc.Height)) {
+    return;
+  }
+
   
   context_->CopyResource(backBuffer_.Get(), frame);
 
@@ -308,8 +388,8 @@ void FramePresenter::PresentFrame(ID3D11Texture2D *frame) noexcept {
 
   presentCount++;
   if (presentCount == 1 || presentCount % 100 == 0) {
-    printf("[FramePresenter] Presented frame #%d, hr=0x%lx\n", presentCount,
-           hr);
+    Log::Debug("[FramePresenter] Presented frame #%d, hr=0x%lx\n",
+               presentCount, hr);
   }
 }
 
@@ -12,6 +12,8 @@
 #include <d3d11.h>
 #include <dwrite.h>
 #include <dxgi1_2.h>
+#include <future>
+#include <thread>
 #include <wrl/client.h>
 
 
@@ -41,7 +43,8 @@ public:
   void Show() noexcept;
   void Hide() noexcept;
 
-  
+  // Over the target window's client area, clipped to the captured output,
+  // or the whole output without a target.
   void UpdatePosition() noexcept;
 
   
@@ -55,8 +58,15 @@ private:
                                      LPARAM lParam);
 
   bool CreateOverlayWindow() noexcept;
+  // Creates the overlay window, hands it back through `created` and runs
+  // its message loop until Shutdown posts WM_QUIT.
+  void WindowThread(std::promise<HWND> created) noexcept;
   bool CreateSwapChain() noexcept;
   bool CreateD2DResources() noexcept;
+  // D2D target and brushes over the back buffer; rebuilt by Resize.
+  bool CreateD2DTarget() noexcept;
+  // Matches the swap chain to the size of the frames being presented.
+  bool Resize(uint32_t width, uint32_t height) noexcept;
 
   ID3D11Device *device_ = nullptr;
   ID3D11DeviceContext *context_ = nullptr;
@@ -74,6 +84,8 @@ private:
   ComPtr<IDWriteTextFormat> textFormat_;
 
   HWND overlayWindow_ = nullptr;
+  std::thread windowThread_;
+  DWORD windowThreadId_ = 0;
   HWND targetWindow_ = nullptr;
   HINSTANCE hInstance_ = nullptr;
 
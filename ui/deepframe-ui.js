@@ -114,7 +114,7 @@ const html = `<!DOCTYPE html>
 </body>
 </html>`;
 
-const server = http.createServer((req, res) => {
+const server = http.createServer(async (req, res) => {
     const parsed = url.parse(req.url, true);
 
     if (parsed.pathname === '/api') {
@@ -124,7 +124,7 @@ const server = http.createServer((req, res) => {
         try {
             switch (action) {
                 case 'init':
-                    res.end(JSON.stringify({ success: df.initialize() }));
+                    res.end(JSON.stringify({ success: await df.initialize() }));
                     break;
                 case 'windows':
                     res.end(JSON.stringify({ windows: df.getOpenWindows() }));
@@ -134,10 +134,10 @@ const server = http.createServer((req, res) => {
                     res.end(JSON.stringify({ success: true }));
                     break;
                 case 'start':
-                    res.end(JSON.stringify({ success: df.start({ showStats: true }) }));
+                    res.end(JSON.stringify({ success: await df.start({ showStats: true }) }));
                     break;
                 case 'stop':
-                    df.stop();
+                    await df.stop();
                     res.end(JSON.stringify({ success: true }));
                     break;
                 case 'stats':
@@ -33,8 +33,12 @@ ipcMain.handle('deepframe:initialize', async () => {
             return { success: false, error: 'Native module not found' };
         }
 
+        deepframeInstance?.unsubscribeStats();
         deepframeInstance = new native.DeepFrame();
-        const result = deepframeInstance.initialize();
+        deepframeInstance.subscribeStats((update: unknown) => {
+            win?.webContents.send('deepframe:stats', update);
+        });
+        const result = await deepframeInstance.initialize();
         return { success: result };
     } catch (error) {
         return { success: false, error: String(error) };
@@ -47,7 +51,7 @@ ipcMain.handle('deepframe:start', async (event, config) => {
     }
 
     try {
-        const result = deepframeInstance.start(config || {});
+        const result = await deepframeInstance.start(config || {});
         return { success: result };
     } catch (error) {
         return { success: false, error: String(error) };
@@ -60,7 +64,7 @@ ipcMain.handle('deepframe:stop', async () => {
     }
 
     try {
-        deepframeInstance.stop();
+        await deepframeInstance.stop();
         return { success: true };
     } catch (error) {
         return { success: false, error: String(error) };
@@ -135,10 +139,10 @@ function createWindow() {
     });
 }
 
-app.on('window-all-closed', () => {
-    
+app.on('window-all-closed', async () => {
+    deepframeInstance?.unsubscribeStats();
     if (deepframeInstance && deepframeInstance.isRunning()) {
-        deepframeInstance.stop();
+        await deepframeInstance.stop();
     }
 
     if (process.platform !== 'darwin') {
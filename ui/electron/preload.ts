@@ -8,6 +8,11 @@ contextBridge.exposeInMainWorld('deepframe', {
     stop: () => ipcRenderer.invoke('deepframe:stop'),
     getStats: () => ipcRenderer.invoke('deepframe:getStats'),
     isRunning: () => ipcRenderer.invoke('deepframe:isRunning'),
+    onStats: (listener: (update: unknown) => void) => {
+        const handler = (_event: unknown, update: unknown) => listener(update);
+        ipcRenderer.on('deepframe:stats', handler);
+        return () => ipcRenderer.removeListener('deepframe:stats', handler);
+    },
 });
 
 
@@ -34,6 +34,8 @@ function startNativeWorker() {
                 if (msg.error) resolver.reject(new Error(msg.error));
                 else resolver.resolve(msg.result);
             }
+        } else if (msg.type === 'stats') {
+            win?.webContents.send('deepframe:stats', msg.update);
         } else if (msg.type === 'error') {
             console.error('Native worker error:', msg.error);
         }
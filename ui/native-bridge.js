@@ -7,24 +7,26 @@ let native, df;
 try {
     native = require(nativePath);
     df = new native.DeepFrame();
+    // Pushed only when the stats or running state change.
+    df.subscribeStats((update) => process.send({ type: 'stats', update }));
     process.send({ type: 'ready' });
 } catch (err) {
     process.send({ type: 'error', error: err.message });
     process.exit(1);
 }
 
-process.on('message', (msg) => {
+process.on('message', async (msg) => {
     try {
         let result;
         switch (msg.action) {
             case 'initialize':
-                result = { success: df.initialize() };
+                result = { success: await df.initialize() };
                 break;
             case 'start':
-                result = { success: df.start(msg.config || { showStats: true }) };
+                result = { success: await df.start(msg.config || { showStats: true }) };
                 break;
             case 'stop':
-                df.stop();
+                await df.stop();
                 result = { success: true };
                 break;
             case 'getStats':
@@ -43,7 +45,7 @@ process.on('message', (msg) => {
                 result = df.setShowStats(msg.show);
                 break;
             case 'setMode':
-                result = df.setMode(msg.mode);
+                result = await df.setMode(msg.mode);
                 break;
             default:
                 result = { error: 'Unknown action' };
@@ -55,6 +57,7 @@ process.on('message', (msg) => {
 });
 
 process.on('disconnect', () => {
-    if (df) df.stop();
-    process.exit(0);
+    if (!df) process.exit(0);
+    df.unsubscribeStats();
+    df.stop().finally(() => process.exit(0));
 });
@@ -10,6 +10,11 @@ contextBridge.exposeInMainWorld('deepframe', {
     setTargetWindow: (hwnd) => ipcRenderer.invoke('deepframe:setTargetWindow', hwnd),
     setShowStats: (show) => ipcRenderer.invoke('deepframe:setShowStats', show),
     setMode: (mode) => ipcRenderer.invoke('deepframe:setMode', mode),
+    onStats: (listener) => {
+        const handler = (_event, update) => listener(update);
+        ipcRenderer.on('deepframe:stats', handler);
+        return () => ipcRenderer.removeListener('deepframe:stats', handler);
+    },
 });
 
 contextBridge.exposeInMainWorld('windowControls', {
@@ -36,7 +36,7 @@ function showMenu() {
     console.log('  5. Stop frame generation');
     console.log('  6. Get stats');
     console.log('  7. Toggle stats overlay');
-    console.log('  8. Set mode (fast/balanced/quality)');
+    console.log('  8. Set mode (fast/balanced/quality/flow/blend)');
     console.log('  0. Exit');
     console.log('─────────────────────────────────────────');
     rl.question('\nEnter command: ', handleCommand);
@@ -50,7 +50,7 @@ async function handleCommand(cmd) {
     switch (cmd.trim()) {
         case '1':
             console.log('Initializing DeepFrame...');
-            const initResult = df.initialize();
+            const initResult = await df.initialize();
             console.log(initResult ? '✓ Initialized successfully!' : '✗ Failed to initialize');
             break;
 
@@ -82,13 +82,13 @@ async function handleCommand(cmd) {
 
         case '4':
             console.log('Starting frame generation...');
-            const startResult = df.start({ showStats: true });
+            const startResult = await df.start({ showStats: true });
             console.log(startResult ? '✓ Started!' : '✗ Failed to start');
             break;
 
         case '5':
             console.log('Stopping...');
-            df.stop();
+            await df.stop();
             console.log('✓ Stopped');
             break;
 
@@ -110,16 +110,17 @@ async function handleCommand(cmd) {
             return;
 
         case '8':
-            rl.question('Enter mode (fast/balanced/quality): ', (mode) => {
-                df.setMode(mode.toLowerCase());
-                console.log(`✓ Mode set to: ${mode}`);
-                showMenu();
+            rl.question('Enter mode (fast/balanced/quality/flow/blend): ', (mode) => {
+                df.setMode(mode.toLowerCase()).then((ok) => {
+                    console.log(ok ? `✓ Mode set to: ${mode}` : `✗ Failed to set mode: ${mode}`);
+                    showMenu();
+                });
             });
             return;
 
         case '0':
             console.log('Stopping DeepFrame...');
-            df.stop();
+            await df.stop();
             console.log('Goodbye!');
             rl.close();
             process.exit(0);
@@ -134,8 +135,7 @@ async function handleCommand(cmd) {
 
 // Handle Ctrl+C gracefully
 rl.on('close', () => {
-    df.stop();
-    process.exit(0);
+    df.stop().finally(() => process.exit(0));
 });
 
 showMenu();
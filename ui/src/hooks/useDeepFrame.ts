@@ -22,6 +22,12 @@ interface DeepFrameResult {
     error?: string;
 }
 
+// Pushed by the native side whenever either field changes.
+interface StatsUpdate {
+    running: boolean;
+    stats: FrameStats;
+}
+
 
 declare global {
     interface Window {
@@ -31,6 +37,7 @@ declare global {
             stop: () => Promise<DeepFrameResult>;
             getStats: () => Promise<FrameStats | null>;
             isRunning: () => Promise<boolean>;
+            onStats: (listener: (update: StatsUpdate) => void) => () => void;
         };
         windowControls?: {
             minimize: () => void;
@@ -74,37 +81,13 @@ export function useDeepFrame() {
 
     
     useEffect(() => {
-        if (!isRunning || !window.deepframe) return;
-
-        const interval = setInterval(async () => {
-            try {
-                const newStats = await window.deepframe!.getStats();
-                setStats(newStats);
-            } catch {
-                
-            }
-        }, 100);
-
-        return () => clearInterval(interval);
-    }, [isRunning]);
-
-    
-    useEffect(() => {
-        if (!isInitialized || !window.deepframe) return;
-
-        const checkRunning = async () => {
-            try {
-                const running = await window.deepframe!.isRunning();
-                setIsRunning(running);
-            } catch {
-                
-            }
-        };
+        if (!window.deepframe) return;
 
-        checkRunning();
-        const interval = setInterval(checkRunning, 1000);
-        return () => clearInterval(interval);
-    }, [isInitialized]);
+        return window.deepframe.onStats((update) => {
+            setIsRunning(update.running);
+            setStats(update.running ? update.stats : null);
+        });
+    }, []);
 
     const start = useCallback(async (config: FrameGenConfig = {}) => {
         if (!window.deepframe) {
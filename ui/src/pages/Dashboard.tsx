@@ -8,6 +8,8 @@ import { useDeepFrame } from '../hooks/useDeepFrame';
 import type { FrameGenConfig } from '../hooks/useDeepFrame';
 import '../styles/components.css';
 
+type AiMode = 'fast' | 'balanced' | 'quality' | 'flow' | 'blend';
+
 interface WindowInfo {
     hwnd: number;
     title: string;
@@ -25,7 +27,8 @@ export const Dashboard: React.FC = () => {
     const [captureApi, setCaptureApi] = useState<'DXGI' | 'WGC' | 'GDI'>('DXGI');
 
     
-    const [aiMode, setAiMode] = useState<'fast' | 'balanced' | 'quality'>('fast');
+    const [aiMode, setAiMode] = useState<AiMode>('fast');
+    const [temporalBlend, setTemporalBlend] = useState(true);
 
     
     const [windowList, setWindowList] = useState<WindowInfo[]>([]);
@@ -65,6 +68,7 @@ export const Dashboard: React.FC = () => {
             scaleFactor,
             captureApi,
             performanceMode: perfMode,
+            temporalBlend: temporalBlend ? 1 : 0,
         };
         await start(config);
     };
@@ -151,7 +155,7 @@ export const Dashboard: React.FC = () => {
                                 <select
                                     value={aiMode}
                                     onChange={async (e) => {
-                                        const mode = e.target.value as 'fast' | 'balanced' | 'quality';
+                                        const mode = e.target.value as AiMode;
                                         setAiMode(mode);
                                         if (window.deepframe?.setMode) {
                                             await window.deepframe.setMode(mode);
@@ -161,6 +165,8 @@ export const Dashboard: React.FC = () => {
                                     <option value="fast">RIFE (Fast - 8ms)</option>
                                     <option value="balanced">IFRNet (Balanced - 12ms)</option>
                                     <option value="quality">FILM (Quality - 20ms)</option>
+                                    <option value="flow">Optical Flow (CPU, no model)</option>
+                                    <option value="blend">Blend (CPU, no model)</option>
                                 </select>
                             </ConfigRow>
                             <ConfigRow label="Mode">
@@ -173,6 +179,9 @@ export const Dashboard: React.FC = () => {
                                     <option value="X4">X4</option>
                                 </select>
                             </ConfigRow>
+                            <ConfigRow label="Temporal Blend">
+                                <ToggleSwitch checked={temporalBlend} onChange={setTemporalBlend} />
+                            </ConfigRow>
                             <ConfigRow label="Performance">
                                 <ToggleSwitch checked={perfMode} onChange={setPerfMode} />
                             </ConfigRow>
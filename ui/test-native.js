@@ -21,13 +21,14 @@ try {
         console.log('✓ DeepFrame instance created!');
 
         // Try to initialize
-        const initResult = df.initialize();
-        console.log('Initialize result:', initResult);
+        df.initialize().then((initResult) => {
+            console.log('Initialize result:', initResult);
 
-        if (initResult) {
-            console.log('✓ DeepFrame initialized successfully!');
-            df.stop();
-        }
+            if (initResult) {
+                console.log('✓ DeepFrame initialized successfully!');
+                return df.stop();
+            }
+        }).catch((err) => console.error('✗ Initialize failed:', err.message));
     }
 } catch (err) {
     console.error('✗ Failed to load native module:', err.message);